@@ -20,6 +20,7 @@
 #include <vlib/pci/pci.h>
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/devices/devices.h>
+#include <vnet/latency.h>
 
 #include <avf/avf.h>
 
@@ -393,16 +394,20 @@ no_more_desc:
 	  vlib_buffer_t *b;
 	  avf_input_trace_t *tr;
 	  b = vlib_get_buffer (vm, bi[0]);
-	  vlib_trace_buffer (vm, node, next_index, b, /* follow_chain */ 0);
-	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-	  tr->next_index = next_index;
-	  tr->hw_if_index = ad->hw_if_index;
-	  tr->qw1s[0] = ptd->qw1s[i];
-	  for (j = 1; j < AVF_RX_MAX_DESC_IN_CHAIN; j++)
-	    tr->qw1s[j] = ptd->tails[i].qw1s[j - 1];
+	  if (PREDICT_TRUE
+	      (vlib_trace_buffer
+	       (vm, node, next_index, b, /* follow_chain */ 0)))
+	    {
+	      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+	      tr->next_index = next_index;
+	      tr->hw_if_index = ad->hw_if_index;
+	      tr->qw1s[0] = ptd->qw1s[i];
+	      for (j = 1; j < AVF_RX_MAX_DESC_IN_CHAIN; j++)
+		tr->qw1s[j] = ptd->tails[i].qw1s[j - 1];
+	      n_trace--;
+	    }
 
 	  /* next */
-	  n_trace--;
 	  n_left--;
 	  bi++;
 	  i++;
@@ -428,6 +433,7 @@ no_more_desc:
       vlib_frame_no_append (f);
     }
 
+  vnet_latency_stamp (vm, to_next, n_rx_packets);
   n_left_to_next -= n_rx_packets;
   vlib_put_next_frame (vm, node, next_index, n_left_to_next);
 
@@ -40,6 +40,7 @@ dpdk_flow_add (dpdk_device_t * xd, vnet_flow_t * f, dpdk_flow_entry_t * fe)
   struct rte_flow_item_ipv6 ip6[2] = { };
   struct rte_flow_item_udp udp[2] = { };
   struct rte_flow_item_tcp tcp[2] = { };
+  struct rte_flow_item_gtp gtp[2] = { };
   struct rte_flow_action_mark mark = { 0 };
   struct rte_flow_action_queue queue = { 0 };
   struct rte_flow_item *item, *items = 0;
@@ -72,7 +73,8 @@ dpdk_flow_add (dpdk_device_t * xd, vnet_flow_t * f, dpdk_flow_entry_t * fe)
   item->mask = any_eth + 1;
 
   /* VLAN */
-  if (f->type != VNET_FLOW_TYPE_IP4_VXLAN)
+  if (f->type != VNET_FLOW_TYPE_IP4_VXLAN
+      && f->type != VNET_FLOW_TYPE_IP4_GTPU)
     {
       vec_add2 (items, item, 1);
       item->type = RTE_FLOW_ITEM_TYPE_VLAN;
@@ -133,6 +135,23 @@ dpdk_flow_add (dpdk_device_t * xd, vnet_flow_t * f, dpdk_flow_entry_t * fe)
       src_port_mask = 0;
       protocol = IP_PROTOCOL_UDP;
     }
+  else if (f->type == VNET_FLOW_TYPE_IP4_GTPU)
+    {
+      vnet_flow_ip4_gtpu_t *g4 = &f->ip4_gtpu;
+      ip4[0].hdr.src_addr = g4->src_addr.as_u32;
+      ip4[1].hdr.src_addr = -1;
+      ip4[0].hdr.dst_addr = g4->dst_addr.as_u32;
+      ip4[1].hdr.dst_addr = -1;
+      item->type = RTE_FLOW_ITEM_TYPE_IPV4;
+      item->spec = ip4;
+      item->mask = ip4 + 1;
+
+      dst_port = g4->dst_port;
+      dst_port_mask = -1;
+      src_port = 0;
+      src_port_mask = 0;
+      protocol = IP_PROTOCOL_UDP;
+    }
   else
     {
       rv = VNET_FLOW_ERROR_NOT_SUPPORTED;
@@ -194,6 +213,16 @@ dpdk_flow_add (dpdk_device_t * xd, vnet_flow_t * f, dpdk_flow_entry_t * fe)
       item->spec = raw;
       item->mask = raw + 1;
     }
+  else if (f->type == VNET_FLOW_TYPE_IP4_GTPU)
+    {
+      gtp[0].teid = clib_host_to_net_u32 (f->ip4_gtpu.teid);
+      gtp[1].teid = ~0;
+
+      vec_add2 (items, item, 1);
+      item->type = RTE_FLOW_ITEM_TYPE_GTPU;
+      item->spec = gtp;
+      item->mask = gtp + 1;
+    }
 
   vec_add2 (items, item, 1);
   item->type = RTE_FLOW_ITEM_TYPE_END;
@@ -342,6 +371,7 @@ dpdk_flow_ops_fn (vnet_main_t * vnm, vnet_flow_dev_op_t op, u32 dev_instance,
     case VNET_FLOW_TYPE_IP4_N_TUPLE:
     case VNET_FLOW_TYPE_IP6_N_TUPLE:
     case VNET_FLOW_TYPE_IP4_VXLAN:
+    case VNET_FLOW_TYPE_IP4_GTPU:
       if ((rv = dpdk_flow_add (xd, flow, fe)))
 	goto done;
       break;
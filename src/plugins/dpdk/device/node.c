@@ -26,6 +26,7 @@
 #include <vnet/handoff.h>
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
+#include <vnet/latency.h>
 
 #include <dpdk/device/dpdk_priv.h>
 
@@ -358,6 +359,7 @@ dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
       vlib_get_buffer_indices_with_offset (vm, (void **) ptd->mbufs,
 					   ptd->buffers, n_rx_packets,
 					   sizeof (struct rte_mbuf));
+      vnet_latency_stamp (vm, ptd->buffers, n_rx_packets);
 
       vlib_buffer_enqueue_to_next (vm, node, ptd->buffers, ptd->next,
 				   n_rx_packets);
@@ -370,6 +372,7 @@ dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
       vlib_get_buffer_indices_with_offset (vm, (void **) ptd->mbufs, to_next,
 					   n_rx_packets,
 					   sizeof (struct rte_mbuf));
+      vnet_latency_stamp (vm, to_next, n_rx_packets);
 
       if (PREDICT_TRUE (next_index == VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT))
 	{
@@ -415,21 +418,24 @@ dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
 	  b0 = vlib_get_buffer (vm, buffers[0]);
 	  if (single_next == 0)
 	    next_index = next[0];
-	  vlib_trace_buffer (vm, node, next_index, b0, /* follow_chain */ 0);
-
-	  dpdk_rx_trace_t *t0 = vlib_add_trace (vm, node, b0, sizeof t0[0]);
-	  t0->queue_index = queue_id;
-	  t0->device_index = xd->device_index;
-	  t0->buffer_index = vlib_get_buffer_index (vm, b0);
-
-	  clib_memcpy_fast (&t0->mb, mb[0], sizeof t0->mb);
-	  clib_memcpy_fast (&t0->buffer, b0,
-			    sizeof b0[0] - sizeof b0->pre_data);
-	  clib_memcpy_fast (t0->buffer.pre_data, b0->data,
-			    sizeof t0->buffer.pre_data);
-	  clib_memcpy_fast (&t0->data, mb[0]->buf_addr + mb[0]->data_off,
-			    sizeof t0->data);
-	  n_trace--;
+	  if (PREDICT_TRUE (vlib_trace_buffer (vm, node, next_index, b0,
+					       /* follow_chain */ 0)))
+	    {
+	      dpdk_rx_trace_t *t0 =
+		vlib_add_trace (vm, node, b0, sizeof t0[0]);
+	      t0->queue_index = queue_id;
+	      t0->device_index = xd->device_index;
+	      t0->buffer_index = vlib_get_buffer_index (vm, b0);
+
+	      clib_memcpy_fast (&t0->mb, mb[0], sizeof t0->mb);
+	      clib_memcpy_fast (&t0->buffer, b0,
+				sizeof b0[0] - sizeof b0->pre_data);
+	      clib_memcpy_fast (t0->buffer.pre_data, b0->data,
+				sizeof t0->buffer.pre_data);
+	      clib_memcpy_fast (&t0->data, mb[0]->buf_addr + mb[0]->data_off,
+				sizeof t0->data);
+	      n_trace--;
+	    }
 	  n_left--;
 	  buffers++;
 	  mb++;
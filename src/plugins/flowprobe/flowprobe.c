@@ -483,24 +483,22 @@ flowprobe_create_state_tables (u32 active_timer)
   /* Decide how many worker threads we have */
   num_threads = 1 /* main thread */  + tm->n_threads;
 
-  /* Hash table per worker */
-  fm->ht_log2len = FLOWPROBE_LOG2_HASHSIZE;
-
   /* Init per worker flow state and timer wheels */
   if (active_timer)
     {
       vec_validate (fm->timers_per_worker, num_threads - 1);
       vec_validate (fm->expired_passive_per_worker, num_threads - 1);
-      vec_validate (fm->hash_per_worker, num_threads - 1);
+      vec_validate (fm->cache_per_worker, num_threads - 1);
       vec_validate (fm->pool_per_worker, num_threads - 1);
 
       for (i = 0; i < num_threads; i++)
 	{
-	  int j;
+	  u32 n_sets = 1 << (fm->ht_log2len - FLOWPROBE_CACHE_LOG2_N_WAYS);
 	  pool_alloc (fm->pool_per_worker[i], 1 << fm->ht_log2len);
-	  vec_resize (fm->hash_per_worker[i], 1 << fm->ht_log2len);
-	  for (j = 0; j < (1 << fm->ht_log2len); j++)
-	    fm->hash_per_worker[i][j] = ~0;
+	  vec_validate_aligned (fm->cache_per_worker[i], n_sets - 1,
+				CLIB_CACHE_LINE_BYTES);
+	  clib_memset (fm->cache_per_worker[i], 0xff,
+		       n_sets * sizeof (flowprobe_cache_set_t));
 	  fm->timers_per_worker[i] =
 	    clib_mem_alloc (sizeof (TWT (tw_timer_wheel)));
 	  tw_timer_wheel_init_2t_1w_2048sl (fm->timers_per_worker[i],
@@ -817,17 +815,89 @@ flowprobe_show_stats_fn (vlib_main_t * vm,
 			 unformat_input_t * input, vlib_cli_command_t * cm)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_per_worker_t *pw;
+  f64 dt;
   int i;
 
   vlib_cli_output (vm, "IPFIX table statistics");
   vlib_cli_output (vm, "Flow entry size: %d\n", sizeof (flowprobe_entry_t));
   vlib_cli_output (vm, "Flow pool size per thread: %d\n",
-		   0x1 << FLOWPROBE_LOG2_HASHSIZE);
+		   0x1 << fm->ht_log2len);
+  vlib_cli_output (vm, "Flow cache per thread: %d sets of %d flows\n",
+		   0x1 << (fm->ht_log2len - FLOWPROBE_CACHE_LOG2_N_WAYS),
+		   FLOWPROBE_CACHE_N_WAYS);
+  if (fm->sampling_interval > 1)
+    vlib_cli_output (vm, "Sampling: %s 1 in %u packets\n",
+		     fm->sampling_random ? "random" : "deterministic",
+		     fm->sampling_interval);
 
   for (i = 0; i < vec_len (fm->pool_per_worker); i++)
     vlib_cli_output (vm, "Pool utilisation thread %d is %d%%\n", i,
 		     (100 * pool_elts (fm->pool_per_worker[i])) /
-		     (0x1 << FLOWPROBE_LOG2_HASHSIZE));
+		     (0x1 << fm->ht_log2len));
+
+  dt = vlib_time_now (vm) - fm->stats_time_0;
+  for (i = 0; i < vec_len (fm->per_worker); i++)
+    {
+      pw = vec_elt_at_index (fm->per_worker, i);
+      vlib_cli_output (vm, "Thread %d: %llu packets, %llu sampled, "
+		       "%llu evictions", i, pw->packets, pw->sampled,
+		       pw->evictions);
+      vlib_cli_output (vm, "  %llu records, %.2f records/sec, "
+		       "%.2f clocks/packet", pw->records,
+		       dt > 0 ? (f64) pw->records / dt : 0.0,
+		       pw->packets ? (f64) pw->clocks / pw->packets : 0.0);
+    }
+  return 0;
+}
+
+static clib_error_t *
+flowprobe_clear_stats_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cm)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_per_worker_t *pw;
+
+  vec_foreach (pw, fm->per_worker)
+  {
+    pw->packets = pw->sampled = pw->clocks = 0;
+    pw->records = pw->evictions = 0;
+  }
+  fm->stats_time_0 = vlib_time_now (vm);
+  return 0;
+}
+
+static clib_error_t *
+flowprobe_sampling_command_fn (vlib_main_t * vm,
+			       unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_per_worker_t *pw;
+  u32 interval = ~0;
+  bool random = false;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "off"))
+	interval = 0;
+      else if (unformat (input, "random"))
+	random = true;
+      else if (unformat (input, "%u", &interval))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (interval == ~0)
+    return clib_error_return (0, "Please specify a sampling interval...");
+
+  fm->sampling_interval = interval;
+  fm->sampling_random = random;
+
+  /* The first packet is sampled, then one every interval packets */
+  vec_foreach (pw, fm->per_worker) pw->sampling_countdown = 1;
   return 0;
 }
 
@@ -942,6 +1012,19 @@ flowprobe_params_command_fn (vlib_main_t * vm,
   return 0;
 }
 
+/*?
+ * '<em>flowprobe sampling</em>' accounts only one in every <n> packets in
+ * the flow records, either deterministically or at random. The packet
+ * and octet counts of the sampled packets are scaled by <n>, so that the
+ * records estimate the traffic of the flows.
+ *
+ * @cliexpar
+ * To account one packet in every 100 picked at random:
+ * @cliexcmd{flowprobe sampling 100 random}
+ * To account every packet again:
+ * @cliexcmd{flowprobe sampling off}
+?*/
+
 /*?
  * '<em>flowprobe feature add-del</em>' commands to enable/disable
  * per-packet IPFIX flow record generation on an interface
@@ -974,11 +1057,21 @@ VLIB_CLI_COMMAND (flowprobe_show_table_command, static) = {
     .short_help = "show flowprobe table",
     .function = flowprobe_show_table_fn,
 };
+VLIB_CLI_COMMAND (flowprobe_sampling_command, static) = {
+    .path = "flowprobe sampling",
+    .short_help = "flowprobe sampling <n> [random] | off",
+    .function = flowprobe_sampling_command_fn,
+};
 VLIB_CLI_COMMAND (flowprobe_show_stats_command, static) = {
     .path = "show flowprobe statistics",
     .short_help = "show flowprobe statistics",
     .function = flowprobe_show_stats_fn,
 };
+VLIB_CLI_COMMAND (flowprobe_clear_stats_command, static) = {
+    .path = "clear flowprobe statistics",
+    .short_help = "clear flowprobe statistics",
+    .function = flowprobe_clear_stats_fn,
+};
 /* *INDENT-ON* */
 
 /**
@@ -1123,20 +1216,56 @@ flowprobe_init (vlib_main_t * vm)
   /* Allocate per worker thread vectors per flavour */
   for (i = 0; i < FLOW_N_VARIANTS; i++)
     {
-      vec_validate (fm->context[i].buffers_per_worker, num_threads - 1);
-      vec_validate (fm->context[i].frames_per_worker, num_threads - 1);
-      vec_validate (fm->context[i].next_record_offset_per_worker,
+      vec_validate (fm->context[i].record_buffers_per_worker,
 		    num_threads - 1);
     }
 
+  vec_validate_aligned (fm->per_worker, num_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < num_threads; i++)
+    {
+      fm->per_worker[i].sampling_countdown = 1;
+      fm->per_worker[i].sampling_seed = random_default_seed () + i;
+    }
+  fm->stats_time_0 = fm->vlib_time_0;
+
   fm->active_timer = FLOWPROBE_TIMER_ACTIVE;
   fm->passive_timer = FLOWPROBE_TIMER_PASSIVE;
 
+  /* Flow cache per worker */
+  fm->ht_log2len = FLOWPROBE_LOG2_HASHSIZE;
+
   return error;
 }
 
 VLIB_INIT_FUNCTION (flowprobe_init);
 
+static clib_error_t *
+flowprobe_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  u32 log2_size = fm->ht_log2len;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "log2-cache-size %u", &log2_size))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  /* At least one set */
+  if (log2_size < FLOWPROBE_CACHE_LOG2_N_WAYS || log2_size > 24)
+    return clib_error_return (0, "log2-cache-size must be in [%d, 24]",
+			      FLOWPROBE_CACHE_LOG2_N_WAYS);
+
+  fm->ht_log2len = log2_size;
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (flowprobe_config, "flowprobe");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -32,6 +32,10 @@
 #define FLOWPROBE_TIMER_PASSIVE  120	// XXXX: FOR TESTING (30*60)
 #define FLOWPROBE_LOG2_HASHSIZE  (18)
 
+/* The flow cache is made of sets of 2^FLOWPROBE_CACHE_LOG2_N_WAYS flows */
+#define FLOWPROBE_CACHE_LOG2_N_WAYS (3)
+#define FLOWPROBE_CACHE_N_WAYS   (1 << FLOWPROBE_CACHE_LOG2_N_WAYS)
+
 typedef enum
 {
   FLOW_RECORD_L2 = 1 << 0,
@@ -64,12 +68,8 @@ typedef struct
 {
   /* what to collect per variant */
   flowprobe_record_t flags;
-  /** ipfix buffers under construction, per-worker thread */
-  vlib_buffer_t **buffers_per_worker;
-  /** frames containing ipfix buffers, per-worker thread */
-  vlib_frame_t **frames_per_worker;
-  /** next record offset, per worker thread */
-  u16 *next_record_offset_per_worker;
+  /** ipfix records under construction, per-worker thread */
+  flow_report_record_buffer_t *record_buffers_per_worker;
 } flowprobe_protocol_context_t;
 
 /* *INDENT-OFF* */
@@ -113,6 +113,41 @@ typedef struct
   } prot;
 } flowprobe_entry_t;
 
+/*
+ * A set of the per worker flow cache. A flow hashes to one set and can
+ * be held in any of its ways, ways in use come first and are kept in
+ * most recently used order. When a new flow hashes to a full set, the
+ * least recently used flow of the set is exported and its entry reused.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** pool indices of the flows, ~0 for a free way */
+  u32 pool_index[FLOWPROBE_CACHE_N_WAYS];
+  /** hash bits not used to select the set, checked before the key */
+  u16 signature[FLOWPROBE_CACHE_N_WAYS];
+} flowprobe_cache_set_t;
+
+/* Per worker sampling state and statistics */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** packets until the next sampled one, in deterministic mode */
+  u32 sampling_countdown;
+  /** random sampling seed */
+  u32 sampling_seed;
+  /** packets seen by the flowprobe nodes */
+  u64 packets;
+  /** packets accounted in flows */
+  u64 sampled;
+  /** cpu clocks spent in the flowprobe nodes */
+  u64 clocks;
+  /** flow records exported */
+  u64 records;
+  /** flows exported early, to make room in a full set */
+  u64 evictions;
+} flowprobe_per_worker_t;
+
 /**
  * @file
  * @brief flow-per-packet plugin header file
@@ -131,8 +166,8 @@ typedef struct
   f64 vlib_time_0;
 
   /** Per CPU flow-state */
-  u8 ht_log2len;		/* Hash table size is 2^log2len */
-  u32 **hash_per_worker;
+  u8 ht_log2len;		/* Flow cache size is 2^log2len */
+  flowprobe_cache_set_t **cache_per_worker;
   flowprobe_entry_t **pool_per_worker;
   /* *INDENT-OFF* */
   TWT (tw_timer_wheel) ** timers_per_worker;
@@ -144,6 +179,14 @@ typedef struct
   u32 passive_timer;
   flowprobe_entry_t *stateless_entry;
 
+  /** Account 1 in sampling_interval packets, 0 or 1 for all packets */
+  u32 sampling_interval;
+  /** Sample at random rather than every sampling_interval packets */
+  bool sampling_random;
+  flowprobe_per_worker_t *per_worker;
+  /** Time the per worker statistics were cleared */
+  f64 stats_time_0;
+
   bool initialized;
   bool disabled;
 
@@ -103,9 +103,7 @@ vlib_node_registration_t flowprobe_l2_node;
 
 /* No counters at the moment */
 #define foreach_flowprobe_error			\
-_(COLLISION, "Hash table collisions")		\
-_(BUFFER, "Buffer allocation error")		\
-_(EXPORTED_PACKETS, "Exported packets")		\
+_(COLLISION, "Flows evicted from a full set")	\
 _(INPATH, "Exported packets in path")
 
 typedef enum
@@ -285,7 +283,6 @@ flowprobe_l4_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
 static inline u32
 flowprobe_hash (flowprobe_key_t * k)
 {
-  flowprobe_main_t *fm = &flowprobe_main;
   u32 h = 0;
 
 #ifdef clib_crc32c_uses_intrinsics
@@ -299,62 +296,120 @@ flowprobe_hash (flowprobe_key_t * k)
   h = clib_xxhash (tmp);
 #endif
 
-  return h >> (32 - fm->ht_log2len);
+  return h;
+}
+
+/*
+ * The upper hash bits select the set, the lower ones are the signature.
+ * Shift as u64 so that a cache of a single set is indexed by 0.
+ */
+static inline flowprobe_cache_set_t *
+flowprobe_cache_set (u32 my_cpu_number, u32 h)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  u8 log2_n_sets = fm->ht_log2len - FLOWPROBE_CACHE_LOG2_N_WAYS;
+
+  return fm->cache_per_worker[my_cpu_number] +
+    ((u64) h >> (32 - log2_n_sets));
+}
+
+/* Move way i of the set to the front */
+static inline void
+flowprobe_cache_promote (flowprobe_cache_set_t * s, int i, u32 poolindex,
+			 u16 signature)
+{
+  for (; i > 0; i--)
+    {
+      s->pool_index[i] = s->pool_index[i - 1];
+      s->signature[i] = s->signature[i - 1];
+    }
+  s->pool_index[0] = poolindex;
+  s->signature[0] = signature;
 }
 
 flowprobe_entry_t *
-flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex,
-		  bool * collision)
+flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t * k, u32 h)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_cache_set_t *s = flowprobe_cache_set (my_cpu_number, h);
   flowprobe_entry_t *e;
-  u32 h;
-
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
+  u16 signature = h;
+  u32 poolindex;
+  int i;
 
-  /* Lookup in the flow state pool */
-  *poolindex = fm->hash_per_worker[my_cpu_number][h];
-  if (*poolindex != ~0)
+  for (i = 0; i < FLOWPROBE_CACHE_N_WAYS; i++)
     {
-      e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], *poolindex);
-      if (e)
-	{
-	  /* Verify key or report collision */
-	  if (memcmp (k, &e->key, sizeof (flowprobe_key_t)))
-	    *collision = true;
-	  return e;
-	}
+      poolindex = s->pool_index[i];
+      /* Ways in use come first */
+      if (poolindex == ~0)
+	break;
+      if (s->signature[i] != signature)
+	continue;
+      e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], poolindex);
+      if (memcmp (k, &e->key, sizeof (flowprobe_key_t)))
+	continue;
+      if (i)
+	flowprobe_cache_promote (s, i, poolindex, signature);
+      return e;
     }
 
   return 0;
 }
 
+/*
+ * Add a flow to its set, returns the least recently used flow of the set
+ * with *evicted set when the set is full. The caller exports the evicted
+ * flow before reusing its entry.
+ */
 flowprobe_entry_t *
-flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex)
+flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 h,
+		  bool * evicted)
 {
   flowprobe_main_t *fm = &flowprobe_main;
-  u32 h;
-
+  flowprobe_cache_set_t *s = flowprobe_cache_set (my_cpu_number, h);
+  u32 poolindex = s->pool_index[FLOWPROBE_CACHE_N_WAYS - 1];
   flowprobe_entry_t *e;
 
-  /* Get my index */
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
+  if (poolindex != ~0)
+    {
+      *evicted = true;
+      flowprobe_cache_promote (s, FLOWPROBE_CACHE_N_WAYS - 1, poolindex, h);
+      return pool_elt_at_index (fm->pool_per_worker[my_cpu_number],
+				poolindex);
+    }
 
   pool_get (fm->pool_per_worker[my_cpu_number], e);
-  *poolindex = e - fm->pool_per_worker[my_cpu_number];
-  fm->hash_per_worker[my_cpu_number][h] = *poolindex;
+  clib_memset (e, 0, sizeof (*e));
+  poolindex = e - fm->pool_per_worker[my_cpu_number];
+  flowprobe_cache_promote (s, FLOWPROBE_CACHE_N_WAYS - 1, poolindex, h);
 
   e->key = *k;
 
   if (fm->passive_timer > 0)
     {
       e->passive_timer_handle = tw_timer_start_2t_1w_2048sl
-	(fm->timers_per_worker[my_cpu_number], *poolindex, 0,
+	(fm->timers_per_worker[my_cpu_number], poolindex, 0,
 	 fm->passive_timer);
     }
   return e;
 }
 
+/* Returns non-zero if the packet is to be accounted in its flow */
+static inline int
+flowprobe_sample (flowprobe_main_t * fm, flowprobe_per_worker_t * pw)
+{
+  if (PREDICT_TRUE (fm->sampling_interval <= 1))
+    return 1;
+
+  if (fm->sampling_random)
+    return random_u32 (&pw->sampling_seed) % fm->sampling_interval == 0;
+
+  if (--pw->sampling_countdown)
+    return 0;
+  pw->sampling_countdown = fm->sampling_interval;
+  return 1;
+}
+
 static inline void
 add_to_flow_record_state (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  flowprobe_main_t * fm, vlib_buffer_t * b,
@@ -365,8 +420,23 @@ add_to_flow_record_state (vlib_main_t * vm, vlib_node_runtime_t * node,
     return;
 
   u32 my_cpu_number = vm->thread_index;
+  flowprobe_per_worker_t *pw = vec_elt_at_index (fm->per_worker,
+						 my_cpu_number);
+  u32 weight = clib_max (fm->sampling_interval, 1);
   u16 octets = 0;
 
+  /* Sampled packets stand for the ones which were skipped */
+  if (!flowprobe_sample (fm, pw))
+    {
+      if (t)
+	{
+	  clib_memset (t, 0, sizeof (*t));
+	  t->which = which;
+	}
+      return;
+    }
+  pw->sampled++;
+
   flowprobe_record_t flags = fm->context[which].flags;
   bool collect_ip4 = false, collect_ip6 = false;
   ASSERT (b);
@@ -465,23 +535,24 @@ add_to_flow_record_state (vlib_main_t * vm, vlib_node_runtime_t * node,
   f64 now = vlib_time_now (vm);
   if (fm->active_timer > 0)
     {
-      u32 poolindex = ~0;
-      bool collision = false;
+      u32 h = flowprobe_hash (&k);
+      bool evicted = false;
 
-      e = flowprobe_lookup (my_cpu_number, &k, &poolindex, &collision);
-      if (collision)
-	{
-	  /* Flush data and clean up entry for reuse. */
-	  if (e->packetcount)
-	    flowprobe_export_entry (vm, e);
-	  e->key = k;
-	  e->flow_start = timestamp;
-	  vlib_node_increment_counter (vm, node->node_index,
-				       FLOWPROBE_ERROR_COLLISION, 1);
-	}
+      e = flowprobe_lookup (my_cpu_number, &k, h);
       if (!e)			/* Create new entry */
 	{
-	  e = flowprobe_create (my_cpu_number, &k, &poolindex);
+	  e = flowprobe_create (my_cpu_number, &k, h, &evicted);
+	  if (evicted)
+	    {
+	      /* Flush data and clean up entry for reuse. */
+	      if (e->packetcount)
+		flowprobe_export_entry (vm, e);
+	      e->key = k;
+	      e->prot.tcp.flags = 0;
+	      pw->evictions++;
+	      vlib_node_increment_counter (vm, node->node_index,
+					   FLOWPROBE_ERROR_COLLISION, 1);
+	    }
 	  e->last_exported = now;
 	  e->flow_start = timestamp;
 	}
@@ -495,8 +566,8 @@ add_to_flow_record_state (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (e)
     {
       /* Updating entry */
-      e->packetcount++;
-      e->octetcount += octets;
+      e->packetcount += weight;
+      e->octetcount += (u64) octets *weight;
       e->last_updated = now;
       e->flow_end = timestamp;
       e->prot.tcp.flags |= tcp_flags;
@@ -506,162 +577,35 @@ add_to_flow_record_state (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 }
 
-static u16
-flowprobe_get_headersize (void)
+/* Size of the record of an entry, as written by the flowprobe_*_add */
+static inline u16
+flowprobe_record_size (flowprobe_record_t flags, bool collect_ip4,
+		       bool collect_ip6)
 {
-  return sizeof (ip4_header_t) + sizeof (udp_header_t) +
-    sizeof (ipfix_message_header_t) + sizeof (ipfix_set_header_t);
-}
-
-static void
-flowprobe_export_send (vlib_main_t * vm, vlib_buffer_t * b0,
-		       flowprobe_variant_t which)
-{
-  flowprobe_main_t *fm = &flowprobe_main;
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  ip4_ipfix_template_packet_t *tp;
-  ipfix_set_header_t *s;
-  ipfix_message_header_t *h;
-  ip4_header_t *ip;
-  udp_header_t *udp;
-  flowprobe_record_t flags = fm->context[which].flags;
-  u32 my_cpu_number = vm->thread_index;
-
-  /* Fill in header */
-  flow_report_stream_t *stream;
-
-  /* Nothing to send */
-  if (fm->context[which].next_record_offset_per_worker[my_cpu_number] <=
-      flowprobe_get_headersize ())
-    return;
-
-  u32 i, index = vec_len (frm->streams);
-  for (i = 0; i < index; i++)
-    if (frm->streams[i].domain_id == 1)
-      {
-	index = i;
-	break;
-      }
-  if (i == vec_len (frm->streams))
-    {
-      vec_validate (frm->streams, index);
-      frm->streams[index].domain_id = 1;
-    }
-  stream = &frm->streams[index];
-
-  tp = vlib_buffer_get_current (b0);
-  ip = (ip4_header_t *) & tp->ip4;
-  udp = (udp_header_t *) (ip + 1);
-  h = (ipfix_message_header_t *) (udp + 1);
-  s = (ipfix_set_header_t *) (h + 1);
-
-  ip->ip_version_and_header_length = 0x45;
-  ip->ttl = 254;
-  ip->protocol = IP_PROTOCOL_UDP;
-  ip->flags_and_fragment_offset = 0;
-  ip->src_address.as_u32 = frm->src_address.as_u32;
-  ip->dst_address.as_u32 = frm->ipfix_collector.as_u32;
-  udp->src_port = clib_host_to_net_u16 (UDP_DST_PORT_ipfix);
-  udp->dst_port = clib_host_to_net_u16 (UDP_DST_PORT_ipfix);
-  udp->checksum = 0;
-
-  /* FIXUP: message header export_time */
-  h->export_time = (u32)
-    (((f64) frm->unix_time_0) +
-     (vlib_time_now (frm->vlib_main) - frm->vlib_time_0));
-  h->export_time = clib_host_to_net_u32 (h->export_time);
-  h->domain_id = clib_host_to_net_u32 (stream->domain_id);
-
-  /* FIXUP: message header sequence_number */
-  h->sequence_number = stream->sequence_number++;
-  h->sequence_number = clib_host_to_net_u32 (h->sequence_number);
-
-  s->set_id_length = ipfix_set_id_length (fm->template_reports[flags],
-					  b0->current_length -
-					  (sizeof (*ip) + sizeof (*udp) +
-					   sizeof (*h)));
-  h->version_length = version_length (b0->current_length -
-				      (sizeof (*ip) + sizeof (*udp)));
-
-  ip->length = clib_host_to_net_u16 (b0->current_length);
-
-  ip->checksum = ip4_header_checksum (ip);
-  udp->length = clib_host_to_net_u16 (b0->current_length - sizeof (*ip));
-
-  if (frm->udp_checksum)
-    {
-      /* RFC 7011 section 10.3.2. */
-      udp->checksum = ip4_tcp_udp_compute_checksum (vm, b0, ip);
-      if (udp->checksum == 0)
-	udp->checksum = 0xffff;
-    }
+  u16 size = 2 * sizeof (u32) + sizeof (u64) + 2 * sizeof (timestamp_nsec_t);
 
-  ASSERT (ip->checksum == ip4_header_checksum (ip));
-
-  /* Find or allocate a frame */
-  f = fm->context[which].frames_per_worker[my_cpu_number];
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      fm->context[which].frames_per_worker[my_cpu_number] = f;
-      u32 bi0 = vlib_get_buffer_index (vm, b0);
-
-      /* Enqueue the buffer */
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
-    }
-
-  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
-  vlib_node_increment_counter (vm, flowprobe_l2_node.index,
-			       FLOWPROBE_ERROR_EXPORTED_PACKETS, 1);
-
-  fm->context[which].frames_per_worker[my_cpu_number] = 0;
-  fm->context[which].buffers_per_worker[my_cpu_number] = 0;
-  fm->context[which].next_record_offset_per_worker[my_cpu_number] =
-    flowprobe_get_headersize ();
+  if (flags & FLOW_RECORD_L2)
+    size += 2 * 6 + sizeof (u16);
+  if (collect_ip6)
+    size += 2 * sizeof (ip6_address_t) + 1 + sizeof (u64);
+  if (collect_ip4)
+    size += 2 * sizeof (ip4_address_t) + 1 + sizeof (u64);
+  if (flags & FLOW_RECORD_L4)
+    size += 3 * sizeof (u16);
+  return size;
 }
 
-static vlib_buffer_t *
-flowprobe_get_buffer (vlib_main_t * vm, flowprobe_variant_t which)
+/* Index of the stream the flowprobe templates are in, or ~0 */
+static inline u32
+flowprobe_stream_index (void)
 {
-  flowprobe_main_t *fm = &flowprobe_main;
   flow_report_main_t *frm = &flow_report_main;
-  vlib_buffer_t *b0;
-  u32 bi0;
-  u32 my_cpu_number = vm->thread_index;
-
-  /* Find or allocate a buffer */
-  b0 = fm->context[which].buffers_per_worker[my_cpu_number];
-
-  /* Need to allocate a buffer? */
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  vlib_node_increment_counter (vm, flowprobe_l2_node.index,
-				       FLOWPROBE_ERROR_BUFFER, 1);
-	  return 0;
-	}
-
-      /* Initialize the buffer */
-      b0 = fm->context[which].buffers_per_worker[my_cpu_number] =
-	vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-
-      b0->current_data = 0;
-      b0->current_length = flowprobe_get_headersize ();
-      b0->flags |=
-	(VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_FLOW_REPORT);
-      vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
-      vnet_buffer (b0)->sw_if_index[VLIB_TX] = frm->fib_index;
-      fm->context[which].next_record_offset_per_worker[my_cpu_number] =
-	b0->current_length;
-    }
+  u32 i;
 
-  return b0;
+  for (i = 0; i < vec_len (frm->streams); i++)
+    if (frm->streams[i].domain_id == 1)
+      return i;
+  return ~0;
 }
 
 static void
@@ -669,21 +613,14 @@ flowprobe_export_entry (vlib_main_t * vm, flowprobe_entry_t * e)
 {
   u32 my_cpu_number = vm->thread_index;
   flowprobe_main_t *fm = &flowprobe_main;
-  flow_report_main_t *frm = &flow_report_main;
+  flow_report_record_buffer_t *rb;
   vlib_buffer_t *b0;
   bool collect_ip4 = false, collect_ip6 = false;
   flowprobe_variant_t which = e->key.which;
   flowprobe_record_t flags = fm->context[which].flags;
-  u16 offset =
-    fm->context[which].next_record_offset_per_worker[my_cpu_number];
-
-  if (offset < flowprobe_get_headersize ())
-    offset = flowprobe_get_headersize ();
-
-  b0 = flowprobe_get_buffer (vm, which);
-  /* No available buffer, what to do... */
-  if (b0 == 0)
-    return;
+  u32 stream_index = flowprobe_stream_index ();
+  u16 offset, start, size;
+  u8 *record;
 
   if (flags & FLOW_RECORD_L3)
     {
@@ -691,28 +628,37 @@ flowprobe_export_entry (vlib_main_t * vm, flowprobe_entry_t * e)
       collect_ip6 = which == FLOW_VARIANT_L2_IP6 || which == FLOW_VARIANT_IP6;
     }
 
-  offset += flowprobe_common_add (b0, e, offset);
-
-  if (flags & FLOW_RECORD_L2)
-    offset += flowprobe_l2_add (b0, e, offset);
-  if (collect_ip6)
-    offset += flowprobe_l3_ip6_add (b0, e, offset);
-  if (collect_ip4)
-    offset += flowprobe_l3_ip4_add (b0, e, offset);
-  if (flags & FLOW_RECORD_L4)
-    offset += flowprobe_l4_add (b0, e, offset);
+  /* Records dropped for lack of buffers or over the rate limit are lost */
+  rb = vec_elt_at_index (fm->context[which].record_buffers_per_worker,
+			 my_cpu_number);
+  size = flowprobe_record_size (flags, collect_ip4, collect_ip6);
+  record = stream_index == ~0 ? 0 :
+    vnet_flow_report_record_add (vm, rb, stream_index,
+				 fm->template_reports[flags], size);
+  if (record)
+    {
+      b0 = rb->buffer;
+      start = offset = record - b0->data;
+
+      offset += flowprobe_common_add (b0, e, offset);
+
+      if (flags & FLOW_RECORD_L2)
+	offset += flowprobe_l2_add (b0, e, offset);
+      if (collect_ip6)
+	offset += flowprobe_l3_ip6_add (b0, e, offset);
+      if (collect_ip4)
+	offset += flowprobe_l3_ip4_add (b0, e, offset);
+      if (flags & FLOW_RECORD_L4)
+	offset += flowprobe_l4_add (b0, e, offset);
+
+      ASSERT (offset - start == size);
+      fm->per_worker[my_cpu_number].records++;
+    }
 
   /* Reset per flow-export counters */
   e->packetcount = 0;
   e->octetcount = 0;
   e->last_exported = vlib_time_now (vm);
-
-  b0->current_length = offset;
-
-  fm->context[which].next_record_offset_per_worker[my_cpu_number] = offset;
-  /* Time to flush the buffer? */
-  if (offset + fm->template_size[flags] > frm->path_mtu)
-    flowprobe_export_send (vm, b0, which);
 }
 
 uword
@@ -723,6 +669,9 @@ flowprobe_node_fn (vlib_main_t * vm,
   u32 n_left_from, *from, *to_next;
   flowprobe_next_t next_index;
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_per_worker_t *pw = vec_elt_at_index (fm->per_worker,
+						 vm->thread_index);
+  u64 start = clib_cpu_time_now ();
   timestamp_nsec_t timestamp;
 
   unix_time_now_nsec_fraction (&timestamp.sec, &timestamp.nsec);
@@ -843,6 +792,11 @@ flowprobe_node_fn (vlib_main_t * vm,
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
+
+  vnet_flow_report_put_frame (vm);
+
+  pw->packets += frame->n_vectors;
+  pw->clocks += clib_cpu_time_now () - start;
   return frame->n_vectors;
 }
 
@@ -871,9 +825,12 @@ static inline void
 flush_record (flowprobe_variant_t which)
 {
   vlib_main_t *vm = vlib_get_main ();
-  vlib_buffer_t *b = flowprobe_get_buffer (vm, which);
-  if (b)
-    flowprobe_export_send (vm, b, which);
+  flowprobe_main_t *fm = &flowprobe_main;
+
+  vnet_flow_report_record_buffer_send
+    (vm, vec_elt_at_index (fm->context[which].record_buffers_per_worker,
+			   vm->thread_index));
+  vnet_flow_report_put_frame (vm);
 }
 
 void
@@ -901,16 +858,26 @@ static void
 flowprobe_delete_by_index (u32 my_cpu_number, u32 poolindex)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_cache_set_t *s;
   flowprobe_entry_t *e;
-  u32 h;
+  int i;
 
   e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], poolindex);
+  s = flowprobe_cache_set (my_cpu_number, flowprobe_hash (&e->key));
 
-  /* Get my index */
-  h = flowprobe_hash (&e->key);
-
-  /* Reset hash */
-  fm->hash_per_worker[my_cpu_number][h] = ~0;
+  /* Remove the flow from its set, keeping the ways in use first */
+  for (i = 0; i < FLOWPROBE_CACHE_N_WAYS; i++)
+    {
+      if (s->pool_index[i] != poolindex)
+	continue;
+      for (; i < FLOWPROBE_CACHE_N_WAYS - 1; i++)
+	{
+	  s->pool_index[i] = s->pool_index[i + 1];
+	  s->signature[i] = s->signature[i + 1];
+	}
+      s->pool_index[FLOWPROBE_CACHE_N_WAYS - 1] = ~0;
+      break;
+    }
 
   pool_put_index (fm->pool_per_worker[my_cpu_number], poolindex);
 }
@@ -993,6 +960,8 @@ flowprobe_walker_process (vlib_main_t * vm,
   vec_foreach (i, to_be_removed) flowprobe_delete_by_index (cpu_index, *i);
   vec_free (to_be_removed);
 
+  vnet_flow_report_put_frame (vm);
+
   return 0;
 }
 
@@ -27,6 +27,7 @@
 #include <vnet/mfib/mfib_table.h>
 #include <vnet/adj/adj_mcast.h>
 #include <vnet/dpo/dpo.h>
+#include <vnet/flow/flow.h>
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 #include <gtpu/gtpu.h>
@@ -99,6 +100,10 @@ format_gtpu_tunnel (u8 * s, va_list * args)
   if (PREDICT_FALSE (ip46_address_is_multicast (&t->dst)))
     s = format (s, "mcast-sw-if-idx %d ", t->mcast_sw_if_index);
 
+  if (t->flow_index != ~0)
+    s = format (s, "flow-index %d [%U]", t->flow_index,
+		format_flow_enabled_hw, t->flow_index);
+
   return s;
 }
 
@@ -415,6 +420,7 @@ int vnet_gtpu_add_del_tunnel
 #define _(x) t->x = a->x;
       foreach_copy_field;
 #undef _
+      t->flow_index = ~0;
 
       ip_udp_gtpu_rewrite (t, is_ip6);
 
@@ -612,6 +618,9 @@ int vnet_gtpu_add_del_tunnel
 	  mcast_shared_remove (&t->dst);
 	}
 
+      if (t->flow_index != ~0)
+	vnet_flow_del (vnm, t->flow_index);
+
       fib_node_deinit (&t->node);
       vec_free (t->rewrite);
       pool_put (gtm->tunnels, t);
@@ -675,6 +684,7 @@ gtpu_add_del_tunnel_command_fn (vlib_main_t * vm,
   u8 ipv6_set = 0;
   u32 encap_fib_index = 0;
   u32 mcast_sw_if_index = ~0;
+  u32 offload_hw_if_index = ~0;
   u32 decap_next_index = GTPU_INPUT_NEXT_L2_INPUT;
   u32 teid = 0;
   u32 tmp;
@@ -752,6 +762,10 @@ gtpu_add_del_tunnel_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "teid %d", &teid))
 	;
+      else if (unformat (line_input, "offload %U",
+			 unformat_vnet_hw_interface, vnet_get_main (),
+			 &offload_hw_if_index))
+	;
       else
 	{
 	  error = clib_error_return (0, "parse error: '%U'",
@@ -808,6 +822,13 @@ gtpu_add_del_tunnel_command_fn (vlib_main_t * vm,
       goto done;
     }
 
+  if (offload_hw_if_index != ~0 && (ipv6_set || grp_set))
+    {
+      error =
+	clib_error_return (0, "offload only supports ip4 unicast tunnels");
+      goto done;
+    }
+
   clib_memset (a, 0, sizeof (*a));
 
   a->is_add = is_add;
@@ -825,6 +846,14 @@ gtpu_add_del_tunnel_command_fn (vlib_main_t * vm,
       if (is_add)
 	vlib_cli_output (vm, "%U\n", format_vnet_sw_if_index_name,
 			 vnet_get_main (), tunnel_sw_if_index);
+      if (is_add && offload_hw_if_index != ~0 &&
+	  vnet_gtpu_add_del_rx_flow (offload_hw_if_index,
+				     vnet_gtpu_get_tunnel_index
+				     (tunnel_sw_if_index), 1 /* is_add */ ))
+	{
+	  error = clib_error_return (0, "error enabling flow");
+	  goto done;
+	}
       break;
 
     case VNET_API_ERROR_TUNNEL_EXIST:
@@ -864,6 +893,9 @@ done:
  * @cliexpar
  * Example of how to create a GTPU Tunnel:
  * @cliexcmd{create gtpu tunnel src 10.0.3.1 dst 10.0.3.3 teid 13 encap-vrf-id 7}
+ * Example of how to create a GTPU Tunnel which rx packets are marked by
+ * a flow on the underlay interface, for an O(1) tunnel lookup on decap:
+ * @cliexcmd{create gtpu tunnel src 10.0.3.1 dst 10.0.3.3 teid 13 offload GigabitEthernet0/8/0}
  * Example of how to delete a GTPU Tunnel:
  * @cliexcmd{create gtpu tunnel src 10.0.3.1 dst 10.0.3.3 teid 13 del}
  ?*/
@@ -873,7 +905,8 @@ VLIB_CLI_COMMAND (create_gtpu_tunnel_command, static) = {
   .short_help =
   "create gtpu tunnel src <local-vtep-addr>"
   " {dst <remote-vtep-addr>|group <mcast-vtep-addr> <intf-name>} teid <nn>"
-  " [encap-vrf-id <nn>] [decap-next [l2|ip4|ip6|node <name>]] [del]",
+  " [encap-vrf-id <nn>] [decap-next [l2|ip4|ip6|node <name>]]"
+  " [offload <hw-intf-name>] [del]",
   .function = gtpu_add_del_tunnel_command_fn,
 };
 /* *INDENT-ON* */
@@ -916,6 +949,126 @@ VLIB_CLI_COMMAND (show_gtpu_tunnel_command, static) = {
 };
 /* *INDENT-ON* */
 
+int
+vnet_gtpu_add_del_rx_flow (u32 hw_if_index, u32 t_index, int is_add)
+{
+  gtpu_main_t *gtm = &gtpu_main;
+  gtpu_tunnel_t *t = pool_elt_at_index (gtm->tunnels, t_index);
+  vnet_main_t *vnm = vnet_get_main ();
+
+  if (is_add)
+    {
+      if (t->flow_index == ~0)
+	{
+	  /* mark only, gtpu4-input trusts the mark for its tunnel lookup */
+	  vnet_flow_t flow = {
+	    .actions = VNET_FLOW_ACTION_MARK,
+	    .mark_flow_id = t_index + gtm->flow_id_start,
+	    .type = VNET_FLOW_TYPE_IP4_GTPU,
+	    .ip4_gtpu = {
+			 .src_addr = t->dst.ip4,
+			 .dst_addr = t->src.ip4,
+			 .dst_port = UDP_DST_PORT_GTPU,
+			 .teid = t->teid,
+			 }
+	    ,
+	  };
+	  vnet_flow_add (vnm, &flow, &t->flow_index);
+	}
+      return vnet_flow_enable (vnm, t->flow_index, hw_if_index);
+    }
+  /* flow index is removed when the tunnel is deleted */
+  return vnet_flow_disable (vnm, t->flow_index, hw_if_index);
+}
+
+u32
+vnet_gtpu_get_tunnel_index (u32 sw_if_index)
+{
+  gtpu_main_t *gtm = &gtpu_main;
+
+  if (sw_if_index >= vec_len (gtm->tunnel_index_by_sw_if_index))
+    return ~0;
+  return gtm->tunnel_index_by_sw_if_index[sw_if_index];
+}
+
+static clib_error_t *
+gtpu_offload_command_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  gtpu_main_t *gtm = &gtpu_main;
+  clib_error_t *error;
+  u32 rx_sw_if_index = ~0;
+  u32 hw_if_index = ~0;
+  int is_add = 1;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "hw %U", unformat_vnet_hw_interface, vnm,
+		    &hw_if_index))
+	continue;
+      if (unformat (line_input, "rx %U", unformat_vnet_sw_interface, vnm,
+		    &rx_sw_if_index))
+	continue;
+      if (unformat (line_input, "del"))
+	{
+	  is_add = 0;
+	  continue;
+	}
+      error = clib_error_return (0, "unknown input `%U'",
+				 format_unformat_error, line_input);
+      unformat_free (line_input);
+      return error;
+    }
+  unformat_free (line_input);
+
+  if (rx_sw_if_index == ~0)
+    return clib_error_return (0, "missing rx interface");
+  if (hw_if_index == ~0)
+    return clib_error_return (0, "missing hw interface");
+
+  u32 t_index = vnet_gtpu_get_tunnel_index (rx_sw_if_index);
+  if (t_index == ~0)
+    return clib_error_return (0, "%U is not a gtpu tunnel",
+			      format_vnet_sw_if_index_name, vnm,
+			      rx_sw_if_index);
+
+  gtpu_tunnel_t *t = pool_elt_at_index (gtm->tunnels, t_index);
+
+  if (!ip46_address_is_ip4 (&t->dst) || ip46_address_is_multicast (&t->dst))
+    return clib_error_return (0, "only ip4 unicast tunnels are supported");
+
+  if (!is_add && t->flow_index == ~0)
+    return clib_error_return (0, "no flow on this tunnel");
+
+  if (vnet_gtpu_add_del_rx_flow (hw_if_index, t_index, is_add))
+    return clib_error_return (0, "error %s flow",
+			      is_add ? "enabling" : "disabling");
+
+  return 0;
+}
+
+/*?
+ * Mark the packets of a GTPU tunnel received on a hardware interface with
+ * a flow, so that the decap node finds the tunnel without a hash lookup.
+ *
+ * @cliexpar
+ * @cliexcmd{set flow-offload gtpu hw GigabitEthernet0/8/0 rx gtpu_tunnel0}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (gtpu_offload_command, static) = {
+    .path = "set flow-offload gtpu",
+    .short_help =
+    "set flow-offload gtpu hw <interface-name> rx <tunnel-name> [del]",
+    .function = gtpu_offload_command_fn,
+};
+/* *INDENT-ON* */
+
 void
 vnet_int_gtpu_bypass_mode (u32 sw_if_index, u8 is_ip6, u8 is_enable)
 {
@@ -1093,6 +1246,9 @@ gtpu_init (vlib_main_t * vm)
   gtm->vnet_main = vnet_get_main ();
   gtm->vlib_main = vm;
 
+  vnet_flow_get_range (gtm->vnet_main, "gtpu", 1024 * 1024,
+		       &gtm->flow_id_start);
+
   /* initialize the ip6 hash */
   gtm->gtpu6_tunnel_by_key = hash_create_mem (0,
 					      sizeof (gtpu6_tunnel_key_t),
@@ -173,6 +173,9 @@ typedef struct
    * The tunnels sibling index on the FIB entry's dependency list.
    */
   u32 sibling_index;
+
+  /* rx flow marking packets with the tunnel index, ~0 if none */
+  u32 flow_index;
 } gtpu_tunnel_t;
 
 #define foreach_gtpu_input_next        \
@@ -228,6 +231,9 @@ typedef struct
   /* API message ID base */
   u16 msg_id_base;
 
+  /* flow marks of offloaded tunnels are flow_id_start + tunnel index */
+  u32 flow_id_start;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -263,6 +269,10 @@ typedef struct
 } gtpu_encap_trace_t;
 
 void vnet_int_gtpu_bypass_mode (u32 sw_if_index, u8 is_ip6, u8 is_enable);
+
+int vnet_gtpu_add_del_rx_flow (u32 hw_if_index, u32 t_index, int is_add);
+
+u32 vnet_gtpu_get_tunnel_index (u32 sw_if_index);
 #endif /* included_vnet_gtpu_h */
 
 
@@ -18,6 +18,7 @@
 #include <vlib/vlib.h>
 #include <vnet/pg/pg.h>
 #include <gtpu/gtpu.h>
+#include <vppinfra/lookup_cache_16_8.h>
 
 extern vlib_node_registration_t gtpu4_input_node;
 extern vlib_node_registration_t gtpu6_input_node;
@@ -67,6 +68,31 @@ validate_gtpu_fib (vlib_buffer_t *b, gtpu_tunnel_t *t, u32 is_ip4)
   return (fib_index == t->encap_fib_index);
 }
 
+/* Tunnel index marked by an offloaded rx flow, ~0 if none */
+always_inline u32
+gtpu4_flow_tunnel_index (gtpu_main_t * gtm, vlib_buffer_t * b)
+{
+  u32 t_index = b->flow_id - gtm->flow_id_start;
+
+  if (PREDICT_TRUE (b->flow_id == 0) || t_index >= pool_len (gtm->tunnels)
+      || pool_is_free_index (gtm->tunnels, t_index))
+    return ~0;
+
+  b->flow_id = 0;
+  return t_index;
+}
+
+/*
+ * Node runtime data. The first byte keeps the stats sw_if_index of the
+ * last packet of the previous frame.
+ */
+typedef struct
+{
+  u8 stats_sw_if_index;
+  /* ip4 tunnel lookup cache gate, kept across frames */
+  clib_lookup_cache_16_8_gate_t gate4;
+} gtpu_input_runtime_t;
+
 always_inline uword
 gtpu_input (vlib_main_t * vm,
              vlib_node_runtime_t * node,
@@ -79,13 +105,19 @@ gtpu_input (vlib_main_t * vm,
   vnet_interface_main_t * im = &vnm->interface_main;
   u32 last_tunnel_index = ~0;
   gtpu4_tunnel_key_t last_key4;
+  gtpu_input_runtime_t *rt = (void *) node->runtime_data;
+  clib_lookup_cache_16_8_t cache4;
+  u32 n_key_changes4 = 0;
   gtpu6_tunnel_key_t last_key6;
-  u32 pkts_decapsulated = 0;
+  u32 pkts_decapsulated = 0, pkts_flow_marked = 0;
   u32 thread_index = vlib_get_thread_index();
   u32 stats_sw_if_index, stats_n_packets, stats_n_bytes;
 
   if (is_ip4)
-    last_key4.as_u64 = ~0;
+    {
+      last_key4.as_u64 = ~0;
+      clib_lookup_cache_16_8_init (&cache4, &rt->gate4);
+    }
   else
     clib_memset (&last_key6, 0xff, sizeof (last_key6));
 
@@ -115,6 +147,7 @@ gtpu_input (vlib_main_t * vm,
           u32 tunnel_index0, tunnel_index1;
           gtpu_tunnel_t * t0, * t1, * mt0 = NULL, * mt1 = NULL;
           gtpu4_tunnel_key_t key4_0, key4_1;
+          clib_bihash_kv_16_8_t kv0, kv1;
           gtpu6_tunnel_key_t key6_0, key6_1;
           u32 error0, error1;
 	  u32 sw_if_index0, sw_if_index1, len0, len1;
@@ -195,22 +228,39 @@ gtpu_input (vlib_main_t * vm,
             key4_0.src = ip4_0->src_address.as_u32;
             key4_0.teid = gtpu0->teid;
 
+	    /* Trust the tunnel index marked by an offloaded rx flow */
+	    tunnel_index0 = gtpu4_flow_tunnel_index (gtm, b0);
+	    if (tunnel_index0 != ~0)
+	      {
+		t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
+		pkts_flow_marked++;
+		goto next0;
+	      }
+
  	    /* Make sure GTPU tunnel exist according to packet SIP and teid
  	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-           if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-              {
-                p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace0;
-                  }
-                last_key4.as_u64 = key4_0.as_u64;
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
+	    if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
+	      {
+		kv0.key[0] = key4_0.as_u64;
+		kv0.key[1] = 0;
+		n_key_changes4++;
+		if (clib_lookup_cache_16_8_search (&cache4, &kv0))
+		  {
+		    p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
+		    if (PREDICT_FALSE (p0 == NULL))
+		      {
+			error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+			next0 = GTPU_INPUT_NEXT_DROP;
+			goto trace0;
+		      }
+		    kv0.value = p0[0];
+		    clib_lookup_cache_16_8_add (&cache4, &kv0);
+		  }
+		last_key4.as_u64 = key4_0.as_u64;
+		tunnel_index0 = last_tunnel_index = kv0.value;
+	      }
+	    else
+	      tunnel_index0 = last_tunnel_index;
 	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
 
 	    /* Validate GTPU tunnel encap-fib index against packet */
@@ -369,22 +419,39 @@ gtpu_input (vlib_main_t * vm,
             key4_1.src = ip4_1->src_address.as_u32;
             key4_1.teid = gtpu1->teid;
 
+	    /* Trust the tunnel index marked by an offloaded rx flow */
+	    tunnel_index1 = gtpu4_flow_tunnel_index (gtm, b1);
+	    if (tunnel_index1 != ~0)
+	      {
+		t1 = pool_elt_at_index (gtm->tunnels, tunnel_index1);
+		pkts_flow_marked++;
+		goto next1;
+	      }
+
  	    /* Make sure GTPU tunnel exist according to packet SIP and teid
  	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
 	    if (PREDICT_FALSE (key4_1.as_u64 != last_key4.as_u64))
-              {
-                p1 = hash_get (gtm->gtpu4_tunnel_by_key, key4_1.as_u64);
-                if (PREDICT_FALSE (p1 == NULL))
-                  {
-                    error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next1 = GTPU_INPUT_NEXT_DROP;
-                    goto trace1;
-                  }
-                last_key4.as_u64 = key4_1.as_u64;
-                tunnel_index1 = last_tunnel_index = p1[0];
-              }
-            else
-              tunnel_index1 = last_tunnel_index;
+	      {
+		kv1.key[0] = key4_1.as_u64;
+		kv1.key[1] = 0;
+		n_key_changes4++;
+		if (clib_lookup_cache_16_8_search (&cache4, &kv1))
+		  {
+		    p1 = hash_get (gtm->gtpu4_tunnel_by_key, key4_1.as_u64);
+		    if (PREDICT_FALSE (p1 == NULL))
+		      {
+			error1 = GTPU_ERROR_NO_SUCH_TUNNEL;
+			next1 = GTPU_INPUT_NEXT_DROP;
+			goto trace1;
+		      }
+		    kv1.value = p1[0];
+		    clib_lookup_cache_16_8_add (&cache4, &kv1);
+		  }
+		last_key4.as_u64 = key4_1.as_u64;
+		tunnel_index1 = last_tunnel_index = kv1.value;
+	      }
+	    else
+	      tunnel_index1 = last_tunnel_index;
  	    t1 = pool_elt_at_index (gtm->tunnels, tunnel_index1);
 
 	    /* Validate GTPU tunnel encap-fib index against packet */
@@ -551,6 +618,7 @@ gtpu_input (vlib_main_t * vm,
           u32 tunnel_index0;
           gtpu_tunnel_t * t0, * mt0 = NULL;
           gtpu4_tunnel_key_t key4_0;
+          clib_bihash_kv_16_8_t kv0;
           gtpu6_tunnel_key_t key6_0;
           u32 error0;
 	  u32 sw_if_index0, len0;
@@ -598,22 +666,39 @@ gtpu_input (vlib_main_t * vm,
             key4_0.src = ip4_0->src_address.as_u32;
             key4_0.teid = gtpu0->teid;
 
+	    /* Trust the tunnel index marked by an offloaded rx flow */
+	    tunnel_index0 = gtpu4_flow_tunnel_index (gtm, b0);
+	    if (tunnel_index0 != ~0)
+	      {
+		t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
+		pkts_flow_marked++;
+		goto next0;
+	      }
+
  	    /* Make sure GTPU tunnel exist according to packet SIP and teid
  	     * SIP identify a GTPU path, and teid identify a tunnel in a given GTPU path */
-            if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
-              {
-                p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
-                if (PREDICT_FALSE (p0 == NULL))
-                  {
-                    error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
-                    next0 = GTPU_INPUT_NEXT_DROP;
-                    goto trace00;
-                  }
-                last_key4.as_u64 = key4_0.as_u64;
-                tunnel_index0 = last_tunnel_index = p0[0];
-              }
-            else
-              tunnel_index0 = last_tunnel_index;
+	    if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
+	      {
+		kv0.key[0] = key4_0.as_u64;
+		kv0.key[1] = 0;
+		n_key_changes4++;
+		if (clib_lookup_cache_16_8_search (&cache4, &kv0))
+		  {
+		    p0 = hash_get (gtm->gtpu4_tunnel_by_key, key4_0.as_u64);
+		    if (PREDICT_FALSE (p0 == NULL))
+		      {
+			error0 = GTPU_ERROR_NO_SUCH_TUNNEL;
+			next0 = GTPU_INPUT_NEXT_DROP;
+			goto trace00;
+		      }
+		    kv0.value = p0[0];
+		    clib_lookup_cache_16_8_add (&cache4, &kv0);
+		  }
+		last_key4.as_u64 = key4_0.as_u64;
+		tunnel_index0 = last_tunnel_index = kv0.value;
+	      }
+	    else
+	      tunnel_index0 = last_tunnel_index;
 	    t0 = pool_elt_at_index (gtm->tunnels, tunnel_index0);
 
 	    /* Validate GTPU tunnel encap-fib index against packet */
@@ -771,6 +856,9 @@ gtpu_input (vlib_main_t * vm,
 			       gtpu4_input_node.index:gtpu6_input_node.index,
                                GTPU_ERROR_DECAPSULATED,
                                pkts_decapsulated);
+  if (pkts_flow_marked)
+    vlib_node_increment_counter (vm, gtpu4_input_node.index,
+				 GTPU_ERROR_FLOW_MARKED, pkts_flow_marked);
 
   /* Increment any remaining batch stats */
   if (stats_n_packets)
@@ -781,6 +869,10 @@ gtpu_input (vlib_main_t * vm,
       node->runtime_data[0] = stats_sw_if_index;
     }
 
+  if (is_ip4)
+    clib_lookup_cache_16_8_gate_update (&rt->gate4, &cache4,
+					from_frame->n_vectors, n_key_changes4);
+
   return from_frame->n_vectors;
 }
 
@@ -809,6 +901,7 @@ VLIB_REGISTER_NODE (gtpu4_input_node) = {
   .name = "gtpu4-input",
   /* Takes a vector of packets. */
   .vector_size = sizeof (u32),
+  .runtime_data_bytes = sizeof (gtpu_input_runtime_t),
 
   .n_errors = GTPU_N_ERROR,
   .error_strings = gtpu_error_strings,
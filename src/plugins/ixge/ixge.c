@@ -731,19 +731,21 @@ ixge_rx_next_and_error_from_status_x2 (ixge_device_t * xd,
   *flags1 = f1;
 }
 
-static void
+/* Returns the number of descriptors traced, at most n_trace. */
+static u32
 ixge_rx_trace (ixge_main_t * xm,
 	       ixge_device_t * xd,
 	       ixge_dma_queue_t * dq,
 	       ixge_descriptor_t * before_descriptors,
 	       u32 * before_buffers,
-	       ixge_descriptor_t * after_descriptors, uword n_descriptors)
+	       ixge_descriptor_t * after_descriptors, uword n_descriptors,
+	       u32 n_trace)
 {
   vlib_main_t *vm = xm->vlib_main;
   vlib_node_runtime_t *node = dq->rx.node;
   ixge_rx_from_hw_descriptor_t *bd;
   ixge_rx_to_hw_descriptor_t *ad;
-  u32 *b, n_left, is_sop, next_index_sop;
+  u32 *b, n_left, is_sop, next_index_sop, n_traced = 0;
 
   n_left = n_descriptors;
   b = before_buffers;
@@ -752,61 +754,7 @@ ixge_rx_trace (ixge_main_t * xm,
   is_sop = dq->rx.is_start_of_packet;
   next_index_sop = dq->rx.saved_start_of_packet_next_index;
 
-  while (n_left >= 2)
-    {
-      u32 bi0, bi1, flags0, flags1;
-      vlib_buffer_t *b0, *b1;
-      ixge_rx_dma_trace_t *t0, *t1;
-      u8 next0, error0, next1, error1;
-
-      bi0 = b[0];
-      bi1 = b[1];
-      n_left -= 2;
-
-      b0 = vlib_get_buffer (vm, bi0);
-      b1 = vlib_get_buffer (vm, bi1);
-
-      ixge_rx_next_and_error_from_status_x2 (xd,
-					     bd[0].status[0], bd[0].status[2],
-					     bd[1].status[0], bd[1].status[2],
-					     &next0, &error0, &flags0,
-					     &next1, &error1, &flags1);
-
-      next_index_sop = is_sop ? next0 : next_index_sop;
-      vlib_trace_buffer (vm, node, next_index_sop, b0, /* follow_chain */ 0);
-      t0 = vlib_add_trace (vm, node, b0, sizeof (t0[0]));
-      t0->is_start_of_packet = is_sop;
-      is_sop = (b0->flags & VLIB_BUFFER_NEXT_PRESENT) == 0;
-
-      next_index_sop = is_sop ? next1 : next_index_sop;
-      vlib_trace_buffer (vm, node, next_index_sop, b1, /* follow_chain */ 0);
-      t1 = vlib_add_trace (vm, node, b1, sizeof (t1[0]));
-      t1->is_start_of_packet = is_sop;
-      is_sop = (b1->flags & VLIB_BUFFER_NEXT_PRESENT) == 0;
-
-      t0->queue_index = dq->queue_index;
-      t1->queue_index = dq->queue_index;
-      t0->device_index = xd->device_index;
-      t1->device_index = xd->device_index;
-      t0->before.rx_from_hw = bd[0];
-      t1->before.rx_from_hw = bd[1];
-      t0->after.rx_to_hw = ad[0];
-      t1->after.rx_to_hw = ad[1];
-      t0->buffer_index = bi0;
-      t1->buffer_index = bi1;
-      memcpy (&t0->buffer, b0, sizeof (b0[0]) - sizeof (b0->pre_data));
-      memcpy (&t1->buffer, b1, sizeof (b1[0]) - sizeof (b0->pre_data));
-      memcpy (t0->buffer.pre_data, b0->data + b0->current_data,
-	      sizeof (t0->buffer.pre_data));
-      memcpy (t1->buffer.pre_data, b1->data + b1->current_data,
-	      sizeof (t1->buffer.pre_data));
-
-      b += 2;
-      bd += 2;
-      ad += 2;
-    }
-
-  while (n_left >= 1)
+  while (n_left >= 1 && n_traced < n_trace)
     {
       u32 bi0, flags0;
       vlib_buffer_t *b0;
@@ -823,24 +771,29 @@ ixge_rx_trace (ixge_main_t * xm,
 					     &next0, &error0, &flags0);
 
       next_index_sop = is_sop ? next0 : next_index_sop;
-      vlib_trace_buffer (vm, node, next_index_sop, b0, /* follow_chain */ 0);
-      t0 = vlib_add_trace (vm, node, b0, sizeof (t0[0]));
-      t0->is_start_of_packet = is_sop;
+      if (vlib_trace_buffer (vm, node, next_index_sop, b0,
+			     /* follow_chain */ 0))
+	{
+	  t0 = vlib_add_trace (vm, node, b0, sizeof (t0[0]));
+	  t0->is_start_of_packet = is_sop;
+	  t0->queue_index = dq->queue_index;
+	  t0->device_index = xd->device_index;
+	  t0->before.rx_from_hw = bd[0];
+	  t0->after.rx_to_hw = ad[0];
+	  t0->buffer_index = bi0;
+	  memcpy (&t0->buffer, b0, sizeof (b0[0]) - sizeof (b0->pre_data));
+	  memcpy (t0->buffer.pre_data, b0->data + b0->current_data,
+		  sizeof (t0->buffer.pre_data));
+	  n_traced++;
+	}
       is_sop = (b0->flags & VLIB_BUFFER_NEXT_PRESENT) == 0;
 
-      t0->queue_index = dq->queue_index;
-      t0->device_index = xd->device_index;
-      t0->before.rx_from_hw = bd[0];
-      t0->after.rx_to_hw = ad[0];
-      t0->buffer_index = bi0;
-      memcpy (&t0->buffer, b0, sizeof (b0[0]) - sizeof (b0->pre_data));
-      memcpy (t0->buffer.pre_data, b0->data + b0->current_data,
-	      sizeof (t0->buffer.pre_data));
-
       b += 1;
       bd += 1;
       ad += 1;
     }
+
+  return n_traced;
 }
 
 typedef struct
@@ -1368,16 +1321,17 @@ ixge_rx_queue_no_wrap (ixge_main_t * xm,
   b_last = bi_last != ~0 ? vlib_get_buffer (vm, bi_last) : &b_dummy;
   next_index = dq->rx.next_index;
 
+  /* save every descriptor: when a trace filter rejects packets, the
+     ones traced can be anywhere among the descriptors done */
   if (n_trace > 0)
     {
-      u32 n = clib_min (n_trace, n_descriptors);
       if (d_trace_save)
 	{
 	  _vec_len (d_trace_save) = 0;
 	  _vec_len (d_trace_buffers) = 0;
 	}
-      vec_add (d_trace_save, (ixge_descriptor_t *) d, n);
-      vec_add (d_trace_buffers, to_rx, n);
+      vec_add (d_trace_save, (ixge_descriptor_t *) d, n_descriptors);
+      vec_add (d_trace_buffers, to_rx, n_descriptors);
     }
 
   {
@@ -1781,11 +1735,11 @@ found_hw_owned_descriptor_x1:
 
     if (n_trace > 0 && n_done > 0)
       {
-	u32 n = clib_min (n_trace, n_done);
-	ixge_rx_trace (xm, xd, dq,
-		       d_trace_save,
-		       d_trace_buffers,
-		       &dq->descriptors[start_descriptor_index], n);
+	u32 n = ixge_rx_trace (xm, xd, dq,
+			       d_trace_save,
+			       d_trace_buffers,
+			       &dq->descriptors[start_descriptor_index],
+			       n_done, n_trace);
 	vlib_set_trace_count (vm, node, n_trace - n);
       }
     if (d_trace_save)
@@ -91,11 +91,10 @@ lacp_node_fn (vlib_main_t * vm,
       b0->error = node->errors[error0];
 
       /* If this pkt is traced, snapshoot the data */
-      if (PREDICT_FALSE (n_trace > 0))
+      if (PREDICT_FALSE (n_trace > 0) &&
+	  vlib_trace_buffer (vm, node, next0, b0, /* follow_chain */ 0))
 	{
 	  int len;
-	  vlib_trace_buffer (vm, node, next0, b0,
-			     /* follow_chain */ 0);
 	  vlib_set_trace_count (vm, node, --n_trace);
 	  t0 = vlib_add_trace (vm, node, b0, sizeof (*t0));
 	  len = (b0->current_length < sizeof (t0->pkt))
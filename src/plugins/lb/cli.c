@@ -15,6 +15,7 @@
 
 #include <lb/lb.h>
 #include <lb/util.h>
+#include <lb/lb_sync.h>
 
 static clib_error_t *
 lb_vip_command_fn (vlib_main_t * vm,
@@ -371,6 +372,133 @@ VLIB_CLI_COMMAND (lb_show_command, static) =
   .function = lb_show_command_fn,
 };
 
+static clib_error_t *
+lb_sync_listener_command_fn (vlib_main_t * vm,
+              unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  ip4_address_t addr;
+  u32 port = 0, path_mtu = 0;
+  u8 del = 0;
+  int ret;
+  clib_error_t *error = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  if (!unformat(line_input, "%U", unformat_ip4_address, &addr)) {
+    error = clib_error_return (0, "invalid listener address");
+    goto done;
+  }
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+  {
+    if (unformat(line_input, "port %d", &port))
+      ;
+    else if (unformat(line_input, "path-mtu %d", &path_mtu))
+      ;
+    else if (unformat(line_input, "del"))
+      del = 1;
+    else {
+      error = clib_error_return (0, "parse error: '%U'",
+                                 format_unformat_error, line_input);
+      goto done;
+    }
+  }
+
+  if (!del && (port == 0 || port > 65535)) {
+    error = clib_error_return (0, "invalid port");
+    goto done;
+  }
+
+  if ((ret = lb_sync_set_listener (&addr, del ? 0 : port, path_mtu))) {
+    error = clib_error_return (0, "lb_sync_set_listener error %d", ret);
+    goto done;
+  }
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+VLIB_CLI_COMMAND (lb_sync_listener_command, static) =
+{
+  .path = "lb sync listener",
+  .short_help = "lb sync listener <ip4-address> port <n> [path-mtu <n>] [del]",
+  .function = lb_sync_listener_command_fn,
+};
+
+static clib_error_t *
+lb_sync_peer_command_fn (vlib_main_t * vm,
+              unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  ip4_address_t addr;
+  u32 port = 0;
+  u8 del = 0;
+  int ret;
+  clib_error_t *error = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  if (!unformat(line_input, "%U", unformat_ip4_address, &addr)) {
+    error = clib_error_return (0, "invalid peer address");
+    goto done;
+  }
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+  {
+    if (unformat(line_input, "port %d", &port))
+      ;
+    else if (unformat(line_input, "del"))
+      del = 1;
+    else {
+      error = clib_error_return (0, "parse error: '%U'",
+                                 format_unformat_error, line_input);
+      goto done;
+    }
+  }
+
+  if (port == 0 || port > 65535) {
+    error = clib_error_return (0, "invalid port");
+    goto done;
+  }
+
+  if ((ret = lb_sync_add_del_peer (&addr, port, !del))) {
+    error = clib_error_return (0, "lb_sync_add_del_peer error %d", ret);
+    goto done;
+  }
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+VLIB_CLI_COMMAND (lb_sync_peer_command, static) =
+{
+  .path = "lb sync peer",
+  .short_help = "lb sync peer <ip4-address> port <n> [del]",
+  .function = lb_sync_peer_command_fn,
+};
+
+static clib_error_t *
+lb_show_sync_command_fn (vlib_main_t * vm,
+              unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_cli_output(vm, "%U", format_lb_sync);
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (lb_show_sync_command, static) =
+{
+  .path = "show lb sync",
+  .short_help = "show lb sync",
+  .function = lb_show_sync_command_fn,
+};
+
 static clib_error_t *
 lb_show_vips_command_fn (vlib_main_t * vm,
               unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -14,6 +14,7 @@
  */
 
 #include <lb/lb.h>
+#include <lb/lb_sync.h>
 #include <vnet/plugin/plugin.h>
 #include <vpp/app/version.h>
 #include <vnet/api_errno.h>
@@ -27,9 +28,6 @@
 
 lb_main_t lb_main;
 
-#define lb_get_writer_lock() do {} while(clib_atomic_test_and_set (lb_main.writer_lock))
-#define lb_put_writer_lock() clib_atomic_release (lb_main.writer_lock)
-
 static void lb_as_stack (lb_as_t *as);
 
 
@@ -108,9 +106,17 @@ u8 *format_lb_main (u8 * s, va_list * args)
   for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
     lb_hash_t *h = lbm->per_cpu[thread_index].sticky_ht;
     if (h) {
+      u32 i;
       s = format(s, "core %d\n", thread_index);
       s = format(s, "  timeout: %ds\n", h->timeout);
       s = format(s, "  usage: %d / %d\n", lb_hash_elts(h, lb_hash_time_now(vlib_get_main())),  lb_hash_size(h));
+      if (lbm->per_cpu[thread_index].old_sticky_ht)
+        s = format(s, "  resizing: %d / %d buckets migrated\n",
+                   lbm->per_cpu[thread_index].sweep_bucket,
+                   lb_hash_nbuckets(lbm->per_cpu[thread_index].old_sticky_ht));
+      for (i = 0; i < LB_N_STICKY_COUNTERS; i++)
+        s = format(s, "  %s: %Lu\n", lbm->sticky_counters[i].name,
+                   lbm->sticky_counters[i].counters[thread_index][0]);
     }
   }
 
@@ -521,7 +527,6 @@ int lb_vip_port_find_index(ip46_address_t *prefix, u8 plen,
   return VNET_API_ERROR_NO_SUCH_ENTRY;
 }
 
-static
 int lb_vip_port_find_index_with_lock(ip46_address_t *prefix, u8 plen,
                                      u8 protocol, u16 port, u32 *vip_index)
 {
@@ -576,6 +581,16 @@ static int lb_as_find_index_vip(lb_vip_t *vip, ip46_address_t *address, u32 *as_
   return -1;
 }
 
+int lb_as_find_index_with_lock(u32 vip_index, ip46_address_t *address,
+                               u32 *as_index)
+{
+  lb_main_t *lbm = &lb_main;
+  if (lb_as_find_index_vip(&lbm->vips[vip_index], address, as_index)
+      || !(lbm->ass[*as_index].flags & LB_AS_FLAGS_USED))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  return 0;
+}
+
 int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n)
 {
   lb_main_t *lbm = &lb_main;
@@ -760,29 +775,40 @@ lb_flush_vip_as (u32 vip_index, u32 as_index)
   lb_main_t *lbm = &lb_main;
 
   for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
-    lb_hash_t *h = lbm->per_cpu[thread_index].sticky_ht;
-    if (h != NULL) {
-        u32 i;
-        lb_hash_bucket_t *b;
-
-        lb_hash_foreach_entry(h, b, i) {
-          if ((vip_index == ~0)
-              || ((b->vip[i] == vip_index) && (as_index == ~0))
-              || ((b->vip[i] == vip_index) && (b->value[i] == as_index)))
-            {
-              vlib_refcount_add(&lbm->as_refcount, thread_index, b->value[i], -1);
-              vlib_refcount_add(&lbm->as_refcount, thread_index, 0, 1);
-              b->vip[i] = ~0;
-              b->value[i] = ~0;
-            }
-        }
-        if (vip_index == ~0)
+    lb_per_cpu_t *pc = &lbm->per_cpu[thread_index];
+    //A resize may be in progress, flush both tables
+    lb_hash_t *tables[2] = { pc->sticky_ht, pc->old_sticky_ht };
+    u32 t;
+    for (t = 0; t < 2; t++) {
+      lb_hash_t *h = tables[t];
+      u32 i;
+      lb_hash_bucket_t *b;
+
+      if (h == NULL)
+        continue;
+
+      lb_hash_foreach_entry(h, b, i) {
+        if (b->value[i] == ~0)
+          continue; //Already flushed
+        if ((vip_index == ~0)
+            || ((b->vip[i] == vip_index) && (as_index == ~0))
+            || ((b->vip[i] == vip_index) && (b->value[i] == as_index)))
           {
-            lb_hash_free(h);
-            lbm->per_cpu[thread_index].sticky_ht = 0;
+            vlib_refcount_add(&lbm->as_refcount, thread_index, b->value[i], -1);
+            vlib_refcount_add(&lbm->as_refcount, thread_index, 0, 1);
+            b->vip[i] = ~0;
+            b->value[i] = ~0;
           }
       }
+      if (vip_index == ~0)
+        lb_hash_free(h);
     }
+    if (vip_index == ~0)
+      {
+        pc->sticky_ht = 0;
+        pc->old_sticky_ht = 0;
+      }
+  }
 
   return 0;
 }
@@ -1361,6 +1387,7 @@ lb_init (vlib_main_t * vm)
 
   lb_vip_t *default_vip;
   lb_as_t *default_as;
+  u32 i;
   fib_node_vft_t lb_fib_node_vft = {
       .fnv_get = lb_fib_node_get_node,
       .fnv_last_lock = lb_fib_node_last_lock_gone,
@@ -1436,7 +1463,17 @@ lb_init (vlib_main_t * vm)
 #define _(a,b,c) lbm->vip_counters[c].name = b;
   lb_foreach_vip_counter
 #undef _
-  return NULL;
+
+#define _(a,b,c,d) lbm->sticky_counters[d].name = b; \
+  lbm->sticky_counters[d].stat_segment_name = c;
+  lb_foreach_sticky_counter
+#undef _
+  for (i = 0; i < LB_N_STICKY_COUNTERS; i++)
+    {
+      vlib_validate_simple_counter (&lbm->sticky_counters[i], 0);
+      vlib_zero_simple_counter (&lbm->sticky_counters[i], 0);
+    }
+  return lb_sync_init (vm);
 }
 
 VLIB_INIT_FUNCTION (lb_init);
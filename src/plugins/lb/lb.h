@@ -44,6 +44,12 @@
 
 #define LB_DEFAULT_PER_CPU_STICKY_BUCKETS 1 << 10
 #define LB_DEFAULT_FLOW_TIMEOUT 40
+
+/* Sticky tables may grow up to 2^LB_STICKY_MAX_GROWTH_LOG2 times the
+ * configured size. */
+#define LB_STICKY_MAX_GROWTH_LOG2 4
+/* Number of sticky table buckets migrated or garbage collected per frame */
+#define LB_STICKY_SWEEP_BUCKETS 64
 #define LB_MAPPING_BUCKETS  1024
 #define LB_MAPPING_MEMORY_SIZE  64<<20
 
@@ -180,6 +186,25 @@ typedef enum {
   LB_N_VIP_COUNTERS
 } lb_vip_counter_t;
 
+/**
+ * Per-thread sticky table statistics.
+ * Occupancy and size are gauges refreshed after each garbage collection
+ * pass, the others are event counters.
+ */
+#define lb_foreach_sticky_counter \
+ _(OCCUPANCY, "sticky table entries", "/lb/sticky/occupancy", 0) \
+ _(SIZE, "sticky table size", "/lb/sticky/size", 1) \
+ _(COLLISION, "untracked flows (bucket full)", "/lb/sticky/collisions", 2) \
+ _(EVICTION, "entries evicted by resize", "/lb/sticky/evictions", 3) \
+ _(RESIZE, "table resizes", "/lb/sticky/resizes", 4)
+
+typedef enum {
+#define _(a,b,c,d) LB_STICKY_COUNTER_##a = d,
+  lb_foreach_sticky_counter
+#undef _
+  LB_N_STICKY_COUNTERS
+} lb_sticky_counter_t;
+
 typedef enum {
   LB_ENCAP_TYPE_GRE4,
   LB_ENCAP_TYPE_GRE6,
@@ -464,6 +489,30 @@ typedef struct {
    * One single table is used for all VIPs.
    */
   lb_hash_t *sticky_ht;
+
+  /**
+   * Previous sticky table while it is being migrated into sticky_ht
+   * after a resize. NULL when no migration is in progress.
+   */
+  lb_hash_t *old_sticky_ht;
+
+  /**
+   * Next bucket to visit, in old_sticky_ht during a migration,
+   * in sticky_ht otherwise.
+   */
+  u32 sweep_bucket;
+
+  /**
+   * Valid entries and collisions seen during the current
+   * garbage collection pass.
+   */
+  u32 sweep_valid;
+  u32 sweep_collisions;
+
+  /**
+   * Value of per_cpu_sticky_buckets the table was created for.
+   */
+  u32 sticky_buckets_conf;
 } lb_per_cpu_t;
 
 typedef struct {
@@ -530,6 +579,11 @@ typedef struct {
    */
   vlib_simple_counter_main_t vip_counters[LB_N_VIP_COUNTERS];
 
+  /**
+   * Per-thread sticky table statistics, all at index 0
+   */
+  vlib_simple_counter_main_t sticky_counters[LB_N_STICKY_COUNTERS];
+
   /**
    * DPO used to send packet from IP4/6 lookup to LB node.
    */
@@ -580,6 +634,10 @@ typedef struct {
 } lb_vip_add_args_t;
 
 extern lb_main_t lb_main;
+
+#define lb_get_writer_lock() do {} while(clib_atomic_test_and_set (lb_main.writer_lock))
+#define lb_put_writer_lock() clib_atomic_release (lb_main.writer_lock)
+
 extern vlib_node_registration_t lb4_node;
 extern vlib_node_registration_t lb6_node;
 extern vlib_node_registration_t lb4_nodeport_node;
@@ -605,12 +663,33 @@ int lb_vip_find_index(ip46_address_t *prefix, u8 plen, u8 protocol,
 
 #define lb_vip_get_by_index(index) (pool_is_free_index(lb_main.vips, index)?NULL:pool_elt_at_index(lb_main.vips, index))
 
+/**
+ * Find a VIP, or one of its used ASs, from their configuration.
+ * Indexes are local to an instance, this is how entries learnt
+ * from a peer are resolved. Must be called with the writer lock owned,
+ * so that a batch of entries is resolved under a single lock.
+ */
+int lb_vip_port_find_index_with_lock(ip46_address_t *prefix, u8 plen,
+                                     u8 protocol, u16 port, u32 *vip_index);
+int lb_as_find_index_with_lock(u32 vip_index, ip46_address_t *address,
+                               u32 *as_index);
+
 int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n);
 int lb_vip_del_ass(u32 vip_index, ip46_address_t *addresses, u32 n, u8 flush);
 int lb_flush_vip_as (u32 vip_index, u32 as_index);
 
 u32 lb_hash_time_now(vlib_main_t * vm);
 
+lb_hash_t *lb_get_sticky_table (u32 thread_index);
+
+/**
+ * Insert a flow learnt from a peer in the sticky table of a thread.
+ * A valid local entry for the same flow is kept as is.
+ * @return 0 on success, -1 if the bucket is full.
+ */
+int lb_sticky_import (u32 thread_index, u32 hash, u32 vip_index,
+                      u32 as_index, u32 time_now);
+
 void lb_garbage_collection();
 
 int lb_nat4_interface_add_del (u32 sw_if_index, int is_del);
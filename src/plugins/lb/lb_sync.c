@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <lb/lb.h>
+#include <lb/lb_sync.h>
+#include <vnet/udp/udp.h>
+#include <vppinfra/atomics.h>
+
+#define foreach_lb_sync_counter                 \
+_(SEND_ADD, "add-event-send", 0)                \
+_(RECV_ADD, "add-event-recv", 1)                \
+_(IMPORTED, "imported", 2)                      \
+_(UNKNOWN, "unknown-vip-or-as", 3)              \
+_(TABLE_FULL, "table-full", 4)
+
+/* LB sync protocol version */
+#define LB_SYNC_VERSION 0x01
+
+/* LB sync protocol header */
+typedef struct
+{
+  /* version */
+  u8 version;
+  /* flags, unused */
+  u8 flags;
+  /* event count */
+  u16 count;
+  /* sequence number */
+  u32 sequence_number;
+  /* thread index where events originated */
+  u32 thread_index;
+} __attribute__ ((packed)) lb_sync_message_header_t;
+
+/* LB sync protocol event: a new sticky entry */
+typedef struct
+{
+  /* VIP prefix, as configured */
+  ip46_address_t vip_prefix;
+  /* AS address */
+  ip46_address_t as_address;
+  /* flow hash */
+  u32 hash;
+  /* VIP port, network byte order */
+  u16 vip_port;
+  u8 vip_plen;
+  u8 vip_protocol;
+} __attribute__ ((packed)) lb_sync_event_t;
+
+typedef enum
+{
+#define _(N, s, v) LB_SYNC_COUNTER_##N = v,
+  foreach_lb_sync_counter
+#undef _
+  LB_SYNC_N_COUNTERS
+} lb_sync_counter_t;
+
+/* per thread data */
+typedef struct
+{
+  /* buffer under construction */
+  vlib_buffer_t *buffer;
+  /* frame containing LB sync buffers */
+  vlib_frame_t *frame;
+  /* number of events */
+  u16 count;
+  /* next event offset */
+  u32 next_event_offset;
+} lb_sync_per_thread_data_t;
+
+typedef struct
+{
+  ip4_address_t addr;
+  u16 port;
+} lb_sync_peer_t;
+
+/* LB sync settings */
+typedef struct
+{
+  /* local IP address and UDP port */
+  ip4_address_t src_ip_address;
+  u16 src_port;
+  /* path MTU between local and peers */
+  u32 path_mtu;
+  /* peers new entries are exported to */
+  lb_sync_peer_t *peers;
+  /* counters */
+  vlib_simple_counter_main_t counters[LB_SYNC_N_COUNTERS];
+  vlib_main_t *vlib_main;
+  /* sequence number counter */
+  u32 sequence_number;
+  /* per thread data */
+  u32 num_workers;
+  lb_sync_per_thread_data_t *per_thread_data;
+  /* worker handoff frame-queue index */
+  u32 fq_index;
+} lb_sync_main_t;
+
+lb_sync_main_t lb_sync_main;
+vlib_node_registration_t lb_sync_process_node;
+vlib_node_registration_t lb_sync_worker_node;
+vlib_node_registration_t lb_sync_node;
+vlib_node_registration_t lb_sync_handoff_node;
+
+clib_error_t *
+lb_sync_init (vlib_main_t * vm)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_thread_registration_t *tr;
+  uword *p;
+
+  sm->vlib_main = vm;
+  sm->path_mtu = 512;
+  sm->num_workers = 0;
+  vec_validate (sm->per_thread_data, tm->n_vlib_mains - 1);
+  sm->fq_index = ~0;
+  p = hash_get_mem (tm->thread_registrations_by_name, "workers");
+  if (p)
+    {
+      tr = (vlib_thread_registration_t *) p[0];
+      if (tr)
+	sm->num_workers = tr->count;
+    }
+
+#define _(N, s, v) sm->counters[v].name = s;           \
+  sm->counters[v].stat_segment_name = "/lb/sync/" s;   \
+  vlib_validate_simple_counter(&sm->counters[v], 0);   \
+  vlib_zero_simple_counter(&sm->counters[v], 0);
+  foreach_lb_sync_counter
+#undef _
+  return 0;
+}
+
+int
+lb_sync_set_listener (ip4_address_t * addr, u16 port, u32 path_mtu)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+
+  /* peers keep getting exports, from the listener address and port */
+  if (port == 0 && vec_len (sm->peers))
+    return VNET_API_ERROR_INSTANCE_IN_USE;
+
+  /* a batch is built in a single buffer, headers included */
+  if (path_mtu && path_mtu < sizeof (ip4_header_t) + sizeof (udp_header_t)
+      + sizeof (lb_sync_message_header_t) + sizeof (lb_sync_event_t))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* unregister previously set UDP port */
+  if (sm->src_port)
+    udp_unregister_dst_port (sm->vlib_main, sm->src_port, 1);
+
+  sm->src_ip_address.as_u32 = addr->as_u32;
+  sm->src_port = port;
+  if (path_mtu)
+    sm->path_mtu = clib_min (path_mtu,
+			     vlib_buffer_get_default_data_size (sm->vlib_main));
+
+  if (port)
+    {
+      /* if multiple worker threads first go to handoff node */
+      if (sm->num_workers > 1)
+	{
+	  if (sm->fq_index == ~0)
+	    sm->fq_index = vlib_frame_queue_main_init (lb_sync_node.index, 0);
+	  udp_register_dst_port (sm->vlib_main, port,
+				 lb_sync_handoff_node.index, 1);
+	}
+      else
+	{
+	  udp_register_dst_port (sm->vlib_main, port, lb_sync_node.index, 1);
+	}
+    }
+
+  return 0;
+}
+
+int
+lb_sync_add_del_peer (ip4_address_t * addr, u16 port, u8 is_add)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_peer_t *peer;
+  u32 n_peers = vec_len (sm->peers);
+
+  vec_foreach (peer, sm->peers)
+  {
+    if (peer->addr.as_u32 == addr->as_u32 && peer->port == port)
+      break;
+  }
+
+  if (!is_add)
+    {
+      if (peer == vec_end (sm->peers))
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+      vec_del1 (sm->peers, peer - sm->peers);
+      return 0;
+    }
+
+  if (peer != vec_end (sm->peers))
+    return VNET_API_ERROR_VALUE_EXIST;
+
+  if (!sm->src_port)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  vec_add2 (sm->peers, peer, 1);
+  peer->addr.as_u32 = addr->as_u32;
+  peer->port = port;
+
+  /* start periodic flushes with the first peer */
+  if (n_peers == 0)
+    vlib_process_signal_event (sm->vlib_main, lb_sync_process_node.index, 1,
+			       0);
+
+  return 0;
+}
+
+/* messages are only accepted from peers, sent from their listener */
+static_always_inline int
+lb_sync_is_peer (ip4_address_t * addr, u16 port)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_peer_t *peer;
+
+  vec_foreach (peer, sm->peers)
+  {
+    if (peer->addr.as_u32 == addr->as_u32 && peer->port == port)
+      return 1;
+  }
+  return 0;
+}
+
+static void
+lb_sync_ip_udp_set_dst (ip4_header_t * ip, lb_sync_peer_t * peer)
+{
+  udp_header_t *udp = ip4_next_header (ip);
+
+  ip->dst_address.as_u32 = peer->addr.as_u32;
+  ip->checksum = ip4_header_checksum (ip);
+  udp->dst_port = clib_host_to_net_u16 (peer->port);
+}
+
+static inline void
+lb_sync_header_create (vlib_buffer_t * b, u32 * offset, u32 thread_index)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_message_header_t *h;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  u32 sequence_number;
+
+  b->current_data = 0;
+  b->current_length = sizeof (*ip) + sizeof (*udp) + sizeof (*h);
+  b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+  b->flags |= VNET_BUFFER_F_LOCALLY_ORIGINATED;
+  vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = 0;
+  ip = vlib_buffer_get_current (b);
+  udp = (udp_header_t *) (ip + 1);
+  h = (lb_sync_message_header_t *) (udp + 1);
+
+  /* IP header */
+  ip->ip_version_and_header_length = 0x45;
+  ip->ttl = 254;
+  ip->protocol = IP_PROTOCOL_UDP;
+  ip->flags_and_fragment_offset =
+    clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT);
+  ip->src_address.as_u32 = sm->src_ip_address.as_u32;
+  /* UDP header, destination set when sent */
+  udp->src_port = clib_host_to_net_u16 (sm->src_port);
+  udp->checksum = 0;
+
+  /* LB sync protocol header */
+  h->version = LB_SYNC_VERSION;
+  h->flags = 0;
+  h->count = 0;
+  h->thread_index = clib_host_to_net_u32 (thread_index);
+  sequence_number = clib_atomic_fetch_add (&sm->sequence_number, 1);
+  h->sequence_number = clib_host_to_net_u32 (sequence_number);
+
+  *offset =
+    sizeof (ip4_header_t) + sizeof (udp_header_t) +
+    sizeof (lb_sync_message_header_t);
+}
+
+/* finalize the batch and send one copy to each peer */
+static inline void
+lb_sync_send (vlib_frame_t * f, vlib_buffer_t * b, u32 thread_index)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_per_thread_data_t *td = &sm->per_thread_data[thread_index];
+  lb_sync_message_header_t *h;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  vlib_main_t *vm = vlib_mains[thread_index];
+  u32 *to_next = vlib_frame_vector_args (f);
+  u32 i;
+
+  ip = vlib_buffer_get_current (b);
+  udp = ip4_next_header (ip);
+  h = (lb_sync_message_header_t *) (udp + 1);
+
+  h->count = clib_host_to_net_u16 (td->count);
+  ip->length = clib_host_to_net_u16 (b->current_length);
+  udp->length = clib_host_to_net_u16 (b->current_length - sizeof (*ip));
+
+  /* peers may have been removed since the batch was started */
+  if (PREDICT_FALSE (vec_len (sm->peers) == 0))
+    {
+      vlib_buffer_free (vm, to_next, f->n_vectors);
+      f->n_vectors = 0;
+      vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+      return;
+    }
+
+  for (i = 1; i < vec_len (sm->peers) && f->n_vectors < VLIB_FRAME_SIZE; i++)
+    {
+      vlib_buffer_t *c = vlib_buffer_copy (vm, b);
+
+      if (PREDICT_FALSE (c == 0))
+	break;
+      lb_sync_ip_udp_set_dst (vlib_buffer_get_current (c), &sm->peers[i]);
+      to_next[f->n_vectors++] = vlib_get_buffer_index (vm, c);
+    }
+  lb_sync_ip_udp_set_dst (ip, &sm->peers[0]);
+
+  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+}
+
+/* add LB sync protocol event, or flush the batch under construction */
+static_always_inline void
+lb_sync_event_add (lb_sync_event_t * event, u8 do_flush, u32 thread_index)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_per_thread_data_t *td = &sm->per_thread_data[thread_index];
+  vlib_main_t *vm = vlib_mains[thread_index];
+  vlib_buffer_t *b = 0;
+  vlib_frame_t *f;
+  u32 bi = ~0, offset;
+
+  b = td->buffer;
+
+  if (PREDICT_FALSE (b == 0))
+    {
+      if (do_flush)
+	return;
+
+      if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+	{
+	  clib_warning ("LB sync can't allocate buffer");
+	  return;
+	}
+
+      b = td->buffer = vlib_get_buffer (vm, bi);
+      clib_memset (vnet_buffer (b), 0, sizeof (*vnet_buffer (b)));
+      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b);
+      offset = 0;
+    }
+  else
+    {
+      bi = vlib_get_buffer_index (vm, b);
+      offset = td->next_event_offset;
+    }
+
+  f = td->frame;
+  if (PREDICT_FALSE (f == 0))
+    {
+      u32 *to_next;
+      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
+      td->frame = f;
+      to_next = vlib_frame_vector_args (f);
+      to_next[0] = bi;
+      f->n_vectors = 1;
+    }
+
+  if (PREDICT_FALSE (td->count == 0))
+    lb_sync_header_create (b, &offset, thread_index);
+
+  if (PREDICT_TRUE (do_flush == 0))
+    {
+      clib_memcpy_fast (b->data + offset, event, sizeof (*event));
+      offset += sizeof (*event);
+      td->count++;
+      b->current_length += sizeof (*event);
+      vlib_increment_simple_counter (&sm->counters[LB_SYNC_COUNTER_SEND_ADD],
+				     thread_index, 0, 1);
+    }
+
+  if (PREDICT_FALSE
+      (do_flush || offset + (sizeof (*event)) > sm->path_mtu))
+    {
+      lb_sync_send (f, b, thread_index);
+      td->buffer = 0;
+      td->frame = 0;
+      td->count = 0;
+      offset = 0;
+    }
+
+  td->next_event_offset = offset;
+}
+
+void
+lb_sync_flow_add (u32 thread_index, u32 hash, u32 vip_index, u32 as_index)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_main_t *lbm = &lb_main;
+  lb_sync_event_t event;
+  lb_vip_t *vip;
+
+  if (PREDICT_TRUE (vec_len (sm->peers) == 0) || as_index == 0)
+    return;
+
+  vip = &lbm->vips[vip_index];
+  event.vip_prefix = vip->prefix;
+  event.as_address = lbm->ass[as_index].address;
+  event.hash = clib_host_to_net_u32 (hash);
+  event.vip_port = clib_host_to_net_u16 (vip->port);
+  event.vip_plen = vip->plen;
+  event.vip_protocol = vip->protocol;
+  lb_sync_event_add (&event, 0, thread_index);
+}
+
+static_always_inline int
+lb_sync_event_same_vip (lb_sync_event_t * e0, lb_sync_event_t * e1)
+{
+  return (ip46_address_is_equal (&e0->vip_prefix, &e1->vip_prefix)
+	  && e0->vip_port == e1->vip_port && e0->vip_plen == e1->vip_plen
+	  && e0->vip_protocol == e1->vip_protocol);
+}
+
+/* import the events of one message in the sticky table of this thread.
+ * The configuration is looked up under a single writer lock, and the VIP
+ * only when it differs from the one of the previous event. */
+static_always_inline void
+lb_sync_events_process (lb_sync_event_t * e, u16 count, u32 time_now,
+			u32 thread_index)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_event_t *vip_event = 0;
+  ip46_address_t prefix;
+  u32 vip_index = ~0, as_index;
+  lb_sync_counter_t c;
+
+  vlib_increment_simple_counter (&sm->counters[LB_SYNC_COUNTER_RECV_ADD],
+				 thread_index, 0, count);
+
+  lb_get_writer_lock ();
+  for (; count; count--, e++)
+    {
+      if (!vip_event || !lb_sync_event_same_vip (vip_event, e))
+	{
+	  vip_event = e;
+	  prefix = e->vip_prefix;
+	  if (lb_vip_port_find_index_with_lock (&prefix, e->vip_plen,
+						e->vip_protocol,
+						clib_net_to_host_u16
+						(e->vip_port), &vip_index))
+	    vip_index = ~0;
+	}
+
+      c = LB_SYNC_COUNTER_IMPORTED;
+      if (vip_index == ~0
+	  || lb_as_find_index_with_lock (vip_index, &e->as_address,
+					 &as_index))
+	c = LB_SYNC_COUNTER_UNKNOWN;
+      else if (lb_sticky_import (thread_index, clib_net_to_host_u32 (e->hash),
+				 vip_index, as_index, time_now))
+	c = LB_SYNC_COUNTER_TABLE_FULL;
+
+      vlib_increment_simple_counter (&sm->counters[c], thread_index, 0, 1);
+    }
+  lb_put_writer_lock ();
+}
+
+/* per thread process waiting for interrupt */
+static uword
+lb_sync_worker_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		   vlib_frame_t * f)
+{
+  /* flush LB sync data under construction */
+  lb_sync_event_add (0, 1, vm->thread_index);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (lb_sync_worker_node) = {
+    .function = lb_sync_worker_fn,
+    .type = VLIB_NODE_TYPE_INPUT,
+    .state = VLIB_NODE_STATE_INTERRUPT,
+    .name = "lb-sync-worker",
+};
+/* *INDENT-ON* */
+
+/* periodically send interrupt to each thread */
+static uword
+lb_sync_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		 vlib_frame_t * f)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  uword *event_data = 0;
+  u32 ti;
+
+  vlib_process_wait_for_event (vm);
+  vlib_process_get_events (vm, &event_data);
+  vec_reset_length (event_data);
+
+  while (1)
+    {
+      vlib_process_wait_for_event_or_clock (vm, 1.0);
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+      for (ti = 0; ti < vec_len (vlib_mains); ti++)
+	{
+	  if (ti >= vec_len (sm->per_thread_data))
+	    continue;
+
+	  vlib_node_set_interrupt_pending (vlib_mains[ti],
+					   lb_sync_worker_node.index);
+	}
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (lb_sync_process_node) = {
+    .function = lb_sync_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "lb-sync-process",
+};
+/* *INDENT-ON* */
+
+u8 *
+format_lb_sync (u8 * s, va_list * args)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  lb_sync_peer_t *peer;
+  u32 i;
+
+  if (!sm->src_port)
+    return format (s, "lb sync disabled\n");
+
+  s = format (s, "listener: %U:%u path-mtu %u\n", format_ip4_address,
+	      &sm->src_ip_address, sm->src_port, sm->path_mtu);
+  vec_foreach (peer, sm->peers)
+    s = format (s, "peer: %U:%u\n", format_ip4_address, &peer->addr,
+		peer->port);
+  for (i = 0; i < LB_SYNC_N_COUNTERS; i++)
+    s = format (s, "%s: %Lu\n", sm->counters[i].name,
+		vlib_get_simple_counter (&sm->counters[i], 0));
+
+  return s;
+}
+
+typedef struct
+{
+  ip4_address_t addr;
+  u32 event_count;
+} lb_sync_trace_t;
+
+static u8 *
+format_lb_sync_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  lb_sync_trace_t *t = va_arg (*args, lb_sync_trace_t *);
+
+  s = format (s, "lb-sync: %u events from %U", t->event_count,
+	      format_ip4_address, &t->addr);
+
+  return s;
+}
+
+#define foreach_lb_sync_error   \
+_(PROCESSED, "pkts-processed")  \
+_(BAD_VERSION, "bad-version")   \
+_(TRUNCATED, "truncated")       \
+_(UNKNOWN_PEER, "unknown-peer")
+
+typedef enum
+{
+#define _(sym, str) LB_SYNC_ERROR_##sym,
+  foreach_lb_sync_error
+#undef _
+    LB_SYNC_N_ERROR,
+} lb_sync_error_t;
+
+static char *lb_sync_error_strings[] = {
+#define _(sym, str) str,
+  foreach_lb_sync_error
+#undef _
+};
+
+/* process received LB sync protocol messages, there is no reply */
+static uword
+lb_sync_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+		 vlib_frame_t * frame)
+{
+  u32 n_left_from, *from;
+  u32 thread_index = vm->thread_index;
+  u32 time_now = lb_hash_time_now (vm);
+  u32 pkts_processed = 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+
+  while (n_left_from > 0)
+    {
+      vlib_buffer_t *b0;
+      lb_sync_message_header_t *h0;
+      lb_sync_event_t *e0;
+      ip4_header_t *ip0;
+      udp_header_t *udp0;
+      u16 event_count0;
+
+      b0 = vlib_get_buffer (vm, from[0]);
+      h0 = vlib_buffer_get_current (b0);
+      ip0 = (void *) (b0->data + vnet_buffer (b0)->l3_hdr_offset);
+      udp0 = ip4_next_header (ip0);
+      event_count0 = clib_net_to_host_u16 (h0->count);
+
+      if (!lb_sync_is_peer (&ip0->src_address,
+			    clib_net_to_host_u16 (udp0->src_port)))
+	{
+	  vlib_node_increment_counter (vm, node->node_index,
+				       LB_SYNC_ERROR_UNKNOWN_PEER, 1);
+	  goto done0;
+	}
+      if (h0->version != LB_SYNC_VERSION)
+	{
+	  vlib_node_increment_counter (vm, node->node_index,
+				       LB_SYNC_ERROR_BAD_VERSION, 1);
+	  goto done0;
+	}
+      if (b0->current_length <
+	  sizeof (*h0) + (u32) event_count0 * sizeof (*e0))
+	{
+	  vlib_node_increment_counter (vm, node->node_index,
+				       LB_SYNC_ERROR_TRUNCATED, 1);
+	  goto done0;
+	}
+
+      e0 = (lb_sync_event_t *) (h0 + 1);
+      lb_sync_events_process (e0, event_count0, time_now, thread_index);
+      pkts_processed++;
+
+    done0:
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  lb_sync_trace_t *t = vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->event_count = clib_net_to_host_u16 (h0->count);
+	  t->addr.as_u32 = ip0->src_address.data_u32;
+	}
+
+      from += 1;
+      n_left_from -= 1;
+    }
+
+  vlib_buffer_free (vm, vlib_frame_vector_args (frame), frame->n_vectors);
+  vlib_node_increment_counter (vm, node->node_index,
+			       LB_SYNC_ERROR_PROCESSED, pkts_processed);
+
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (lb_sync_node) = {
+  .function = lb_sync_node_fn,
+  .name = "lb-sync",
+  .vector_size = sizeof (u32),
+  .format_trace = format_lb_sync_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (lb_sync_error_strings),
+  .error_strings = lb_sync_error_strings,
+  .n_next_nodes = 1,
+  .next_nodes = {
+    [0] = "error-drop",
+  },
+};
+/* *INDENT-ON* */
+
+typedef struct
+{
+  u32 next_worker_index;
+} lb_sync_handoff_trace_t;
+
+#define foreach_lb_sync_handoff_error  \
+_(CONGESTION_DROP, "congestion drop")  \
+_(SAME_WORKER, "same worker")          \
+_(DO_HANDOFF, "do handoff")
+
+typedef enum
+{
+#define _(sym,str) LB_SYNC_HANDOFF_ERROR_##sym,
+  foreach_lb_sync_handoff_error
+#undef _
+    LB_SYNC_HANDOFF_N_ERROR,
+} lb_sync_handoff_error_t;
+
+static char *lb_sync_handoff_error_strings[] = {
+#define _(sym,string) string,
+  foreach_lb_sync_handoff_error
+#undef _
+};
+
+static u8 *
+format_lb_sync_handoff_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  lb_sync_handoff_trace_t *t = va_arg (*args, lb_sync_handoff_trace_t *);
+
+  s = format (s, "LB_SYNC_WORKER_HANDOFF: next-worker %d",
+	      t->next_worker_index);
+
+  return s;
+}
+
+/*
+ * Hand off to the thread with the same index as the sender's,
+ * whose sticky table the flows are most likely to hit.
+ */
+static uword
+lb_sync_handoff_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+			 vlib_frame_t * frame)
+{
+  lb_sync_main_t *sm = &lb_sync_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u32 n_enq, n_left_from, *from;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti;
+  u32 thread_index = vm->thread_index;
+  u32 do_handoff = 0, same_worker = 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+
+  b = bufs;
+  ti = thread_indices;
+
+  while (n_left_from > 0)
+    {
+      lb_sync_message_header_t *h0;
+
+      h0 = vlib_buffer_get_current (b[0]);
+      ti[0] = clib_net_to_host_u32 (h0->thread_index);
+      /* the peer may run more threads than we do */
+      if (PREDICT_FALSE (ti[0] >= tm->n_vlib_mains))
+	ti[0] = thread_index;
+
+      if (ti[0] != thread_index)
+	do_handoff++;
+      else
+	same_worker++;
+
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b[0]->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  lb_sync_handoff_trace_t *t =
+	    vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->next_worker_index = ti[0];
+	}
+
+      n_left_from -= 1;
+      ti += 1;
+      b += 1;
+    }
+
+  n_enq =
+    vlib_buffer_enqueue_to_thread (vm, sm->fq_index, from, thread_indices,
+				   frame->n_vectors, 1);
+
+  if (n_enq < frame->n_vectors)
+    vlib_node_increment_counter (vm, node->node_index,
+				 LB_SYNC_HANDOFF_ERROR_CONGESTION_DROP,
+				 frame->n_vectors - n_enq);
+  vlib_node_increment_counter (vm, node->node_index,
+			       LB_SYNC_HANDOFF_ERROR_SAME_WORKER,
+			       same_worker);
+  vlib_node_increment_counter (vm, node->node_index,
+			       LB_SYNC_HANDOFF_ERROR_DO_HANDOFF, do_handoff);
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (lb_sync_handoff_node) = {
+  .function = lb_sync_handoff_node_fn,
+  .name = "lb-sync-handoff",
+  .vector_size = sizeof (u32),
+  .format_trace = format_lb_sync_handoff_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN(lb_sync_handoff_error_strings),
+  .error_strings = lb_sync_handoff_error_strings,
+  .n_next_nodes = 1,
+  .next_nodes = {
+    [0] = "error-drop",
+  },
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
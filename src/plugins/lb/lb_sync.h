@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ * @brief Sticky flow state synchronization between LB instances.
+ *
+ * New sticky table entries are exported in batches over UDP to a set of
+ * peers, which insert them in their own sticky tables. When a VIP is
+ * served by several instances (e.g. ECMP) and one of them fails, the
+ * flows it was tracking keep going to the same AS on the survivors,
+ * even if the AS set changed since the flows were established.
+ *
+ * VIPs and ASs are identified by their configuration (prefix, protocol,
+ * port and AS address) so peers do not need identical indexes. Flow
+ * hashes are portable, but entries are only useful to a peer when a
+ * flow lands on the same thread index there, as with NAT HA.
+ *
+ * Messages are only imported from the configured peers, sent from the
+ * address and port they are configured with, i.e. those of their own
+ * listener. The listener cannot be removed while peers are configured.
+ */
+
+#ifndef LB_PLUGIN_LB_LB_SYNC_H_
+#define LB_PLUGIN_LB_LB_SYNC_H_
+
+#include <vnet/vnet.h>
+#include <vnet/ip/ip.h>
+
+clib_error_t *lb_sync_init (vlib_main_t * vm);
+
+int lb_sync_set_listener (ip4_address_t * addr, u16 port, u32 path_mtu);
+
+int lb_sync_add_del_peer (ip4_address_t * addr, u16 port, u8 is_add);
+
+format_function_t format_lb_sync;
+
+/**
+ * Export a new sticky entry to the peers, if any are configured.
+ * Entries pointing to the default AS (no server) are not exported.
+ */
+void lb_sync_flow_add (u32 thread_index, u32 hash, u32 vip_index,
+		       u32 as_index);
+
+#endif /* LB_PLUGIN_LB_LB_SYNC_H_ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
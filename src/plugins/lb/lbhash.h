@@ -170,17 +170,48 @@ u32 lb_hash_available_value(lb_hash_t *h, u32 hash, u32 available_index)
   return h->buckets[hash & h->buckets_mask].value[available_index];
 }
 
+/*
+ * @brief Look for a flow without refreshing its timeout.
+ * Returns 1 if a valid entry matches. Otherwise returns 0 and sets
+ * available_index to the first expired entry of the bucket, or ~0.
+ */
 static_always_inline
-void lb_hash_put(lb_hash_t *h, u32 hash, u32 value, u32 vip,
-		 u32 available_index, u32 time_now)
+int lb_hash_lookup(lb_hash_t *h, u32 hash, u32 vip, u32 time_now,
+		   u32 *available_index)
+{
+  lb_hash_bucket_t *bucket = &h->buckets[hash & h->buckets_mask];
+  u32 i;
+  *available_index = ~0;
+  for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++) {
+      if (clib_u32_loop_gt(time_now, bucket->timeout[i])) {
+	  *available_index = (*available_index == ~0)?i:*available_index;
+	  continue;
+      }
+      if (bucket->hash[i] == hash && bucket->vip[i] == vip)
+	return 1;
+  }
+  return 0;
+}
+
+static_always_inline
+void lb_hash_put_timeout(lb_hash_t *h, u32 hash, u32 value, u32 vip,
+			 u32 available_index, u32 timeout)
 {
   lb_hash_bucket_t *bucket = &h->buckets[hash & h->buckets_mask];
   bucket->hash[available_index] = hash;
   bucket->value[available_index] = value;
-  bucket->timeout[available_index] = time_now + h->timeout;
+  bucket->timeout[available_index] = timeout;
   bucket->vip[available_index] = vip;
 }
 
+static_always_inline
+void lb_hash_put(lb_hash_t *h, u32 hash, u32 value, u32 vip,
+		 u32 available_index, u32 time_now)
+{
+  lb_hash_put_timeout(h, hash, value, vip, available_index,
+		      time_now + h->timeout);
+}
+
 static_always_inline
 u32 lb_hash_elts(lb_hash_t *h, u32 time_now)
 {
@@ -18,6 +18,7 @@
 
 #include <vnet/gre/packet.h>
 #include <lb/lbhash.h>
+#include <lb/lb_sync.h>
 
 #define foreach_lb_error \
  _(NONE, "no error") \
@@ -123,34 +124,64 @@ format_lb_nat_trace (u8 * s, va_list * args)
   return s;
 }
 
+static_always_inline void
+lb_sticky_ref_swap (lb_main_t *lbm, u32 thread_index, u32 old_value,
+                    u32 new_value)
+{
+  //Flushed entries (~0) are already accounted to AS 0
+  old_value = (old_value == ~0) ? 0 : old_value;
+  vlib_refcount_add (&lbm->as_refcount, thread_index, old_value, -1);
+  vlib_refcount_add (&lbm->as_refcount, thread_index, new_value, 1);
+}
+
+static_always_inline void
+lb_sticky_entry_release (lb_main_t *lbm, u32 thread_index,
+                         lb_hash_bucket_t *b, u32 i, u32 time_now)
+{
+  lb_sticky_ref_swap (lbm, thread_index, b->value[i], 0);
+  b->value[i] = 0;
+  b->timeout[i] = time_now;
+}
+
+static void
+lb_sticky_table_free (lb_main_t *lbm, u32 thread_index, lb_hash_t *ht)
+{
+  lb_hash_bucket_t *b;
+  u32 i;
+
+  //Dereference everything in there
+  lb_hash_foreach_entry(ht, b, i)
+    lb_sticky_ref_swap (lbm, thread_index, b->value[i], 0);
+  lb_hash_free (ht);
+}
+
 lb_hash_t *
 lb_get_sticky_table (u32 thread_index)
 {
   lb_main_t *lbm = &lb_main;
-  lb_hash_t *sticky_ht = lbm->per_cpu[thread_index].sticky_ht;
-  //Check if size changed
+  lb_per_cpu_t *pc = &lbm->per_cpu[thread_index];
+  lb_hash_t *sticky_ht = pc->sticky_ht;
+  //Check if configured size changed
   if (PREDICT_FALSE(
-      sticky_ht && (lbm->per_cpu_sticky_buckets != lb_hash_nbuckets(sticky_ht))))
+      sticky_ht && (lbm->per_cpu_sticky_buckets != pc->sticky_buckets_conf)))
     {
-      //Dereference everything in there
-      lb_hash_bucket_t *b;
-      u32 i;
-      lb_hash_foreach_entry(sticky_ht, b, i)
-        {
-          vlib_refcount_add (&lbm->as_refcount, thread_index, b->value[i], -1);
-          vlib_refcount_add (&lbm->as_refcount, thread_index, 0, 1);
-        }
-
-      lb_hash_free (sticky_ht);
+      lb_sticky_table_free (lbm, thread_index, sticky_ht);
+      if (pc->old_sticky_ht)
+        lb_sticky_table_free (lbm, thread_index, pc->old_sticky_ht);
+      pc->old_sticky_ht = NULL;
       sticky_ht = NULL;
     }
 
   //Create if necessary
   if (PREDICT_FALSE(sticky_ht == NULL))
     {
-      lbm->per_cpu[thread_index].sticky_ht = lb_hash_alloc (
-          lbm->per_cpu_sticky_buckets, lbm->flow_timeout);
-      sticky_ht = lbm->per_cpu[thread_index].sticky_ht;
+      pc->sticky_ht = lb_hash_alloc (lbm->per_cpu_sticky_buckets,
+                                     lbm->flow_timeout);
+      pc->sticky_buckets_conf = lbm->per_cpu_sticky_buckets;
+      pc->sweep_bucket = 0;
+      pc->sweep_valid = 0;
+      pc->sweep_collisions = 0;
+      sticky_ht = pc->sticky_ht;
       clib_warning("Regenerated sticky table %p", sticky_ht);
     }
 
@@ -161,6 +192,169 @@ lb_get_sticky_table (u32 thread_index)
   return sticky_ht;
 }
 
+int
+lb_sticky_import (u32 thread_index, u32 hash, u32 vip_index, u32 as_index,
+                  u32 time_now)
+{
+  lb_main_t *lbm = &lb_main;
+  lb_hash_t *sticky_ht = lb_get_sticky_table (thread_index);
+  lb_hash_t *old_sticky_ht = lbm->per_cpu[thread_index].old_sticky_ht;
+  u32 available_index, old_available_index;
+
+  if (lb_hash_lookup (sticky_ht, hash, vip_index, time_now, &available_index))
+    return 0;
+
+  //During a resize, the local entry may not have been migrated yet
+  if (old_sticky_ht
+      && lb_hash_lookup (old_sticky_ht, hash, vip_index, time_now,
+                         &old_available_index))
+    return 0;
+
+  if (available_index == ~0)
+    return -1;
+
+  lb_sticky_ref_swap (lbm, thread_index,
+                      lb_hash_available_value (sticky_ht, hash,
+                                               available_index),
+                      as_index);
+  lb_hash_put (sticky_ht, hash, as_index, vip_index, available_index,
+               time_now);
+  return 0;
+}
+
+/**
+ * End of a garbage collection pass over the sticky table.
+ * Publishes occupancy and decides whether the table must be resized.
+ * Resizing only allocates the new table, entries are migrated
+ * incrementally by lb_sticky_table_sweep.
+ */
+static void
+lb_sticky_table_pass_done (lb_main_t *lbm, u32 thread_index)
+{
+  lb_per_cpu_t *pc = &lbm->per_cpu[thread_index];
+  lb_hash_t *ht = pc->sticky_ht;
+  u32 nbuckets = lb_hash_nbuckets (ht);
+  u32 size = nbuckets * LBHASH_ENTRY_PER_BUCKET;
+  u32 max_nbuckets = pc->sticky_buckets_conf << LB_STICKY_MAX_GROWTH_LOG2;
+  u32 new_nbuckets = nbuckets;
+
+  vlib_set_simple_counter (
+      &lbm->sticky_counters[LB_STICKY_COUNTER_OCCUPANCY], thread_index, 0,
+      pc->sweep_valid);
+  vlib_set_simple_counter (
+      &lbm->sticky_counters[LB_STICKY_COUNTER_SIZE], thread_index, 0, size);
+
+  //Grow above 3/4 occupancy, or above 1/2 if flows could not be tracked
+  if ((pc->sweep_valid > size / 4 * 3
+       || (pc->sweep_collisions && pc->sweep_valid > size / 2))
+      && nbuckets < max_nbuckets)
+    new_nbuckets = nbuckets << 1;
+  //Shrink back towards the configured size below 1/8 occupancy
+  else if (pc->sweep_valid < size / 8 && nbuckets > pc->sticky_buckets_conf)
+    new_nbuckets = nbuckets >> 1;
+
+  if (new_nbuckets != nbuckets)
+    {
+      pc->old_sticky_ht = ht;
+      pc->sticky_ht = lb_hash_alloc (new_nbuckets, ht->timeout);
+      vlib_increment_simple_counter (
+          &lbm->sticky_counters[LB_STICKY_COUNTER_RESIZE], thread_index, 0, 1);
+    }
+
+  pc->sweep_bucket = 0;
+  pc->sweep_valid = 0;
+  pc->sweep_collisions = 0;
+}
+
+/**
+ * Bounded amount of sticky table maintenance, run once per frame.
+ * While a resize is in progress, LB_STICKY_SWEEP_BUCKETS buckets of the
+ * previous table are migrated into the new one. Otherwise, as many
+ * buckets of the current table are garbage collected: expired entries
+ * release their AS reference so that AS can be freed without waiting
+ * for the slot to be reused.
+ */
+static void
+lb_sticky_table_sweep (lb_main_t *lbm, u32 thread_index, u32 time_now)
+{
+  lb_per_cpu_t *pc = &lbm->per_cpu[thread_index];
+  lb_hash_t *ht = pc->sticky_ht;
+  lb_hash_t *old_ht = pc->old_sticky_ht;
+  lb_hash_bucket_t *b;
+  u32 n, i;
+
+  if (old_ht)
+    {
+      for (n = 0; n < LB_STICKY_SWEEP_BUCKETS
+                  && pc->sweep_bucket < lb_hash_nbuckets (old_ht); n++)
+        {
+          b = &old_ht->buckets[pc->sweep_bucket++];
+          for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++)
+            {
+              u32 available_index;
+
+              if (b->value[i] == ~0
+                  || clib_u32_loop_gt (time_now, b->timeout[i]))
+                {
+                  //Flushed or expired, nothing to migrate
+                }
+              else if (lb_hash_lookup (ht, b->hash[i], b->vip[i], time_now,
+                                       &available_index))
+                {
+                  //Already moved by the data path
+                }
+              else if (available_index != ~0)
+                {
+                  lb_sticky_ref_swap (
+                      lbm, thread_index,
+                      lb_hash_available_value (ht, b->hash[i],
+                                               available_index),
+                      b->value[i]);
+                  lb_hash_put_timeout (ht, b->hash[i], b->value[i],
+                                       b->vip[i], available_index,
+                                       b->timeout[i]);
+                }
+              else
+                {
+                  vlib_increment_simple_counter (
+                      &lbm->sticky_counters[LB_STICKY_COUNTER_EVICTION],
+                      thread_index, 0, 1);
+                }
+              lb_sticky_entry_release (lbm, thread_index, b, i, time_now);
+            }
+        }
+
+      if (pc->sweep_bucket == lb_hash_nbuckets (old_ht))
+        {
+          //All references were moved or released
+          lb_hash_free (old_ht);
+          pc->old_sticky_ht = NULL;
+          pc->sweep_bucket = 0;
+          pc->sweep_valid = 0;
+          pc->sweep_collisions = 0;
+        }
+      return;
+    }
+
+  for (n = 0; n < LB_STICKY_SWEEP_BUCKETS; n++)
+    {
+      b = &ht->buckets[pc->sweep_bucket];
+      for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++)
+        {
+          if (!clib_u32_loop_gt (time_now, b->timeout[i]))
+            pc->sweep_valid++;
+          else if (b->value[i] != 0)
+            lb_sticky_entry_release (lbm, thread_index, b, i, b->timeout[i]);
+        }
+
+      if (++pc->sweep_bucket == lb_hash_nbuckets (ht))
+        {
+          lb_sticky_table_pass_done (lbm, thread_index);
+          return;
+        }
+    }
+}
+
 u64
 lb_node_get_other_ports4 (ip4_header_t *ip40)
 {
@@ -265,6 +459,10 @@ lb_node_fn (vlib_main_t * vm,
   u32 lb_time = lb_hash_time_now (vm);
 
   lb_hash_t *sticky_ht = lb_get_sticky_table (thread_index);
+  lb_sticky_table_sweep (lbm, thread_index, lb_time);
+  //The sweep may have started a resize
+  sticky_ht = lbm->per_cpu[thread_index].sticky_ht;
+  lb_hash_t *old_sticky_ht = lbm->per_cpu[thread_index].old_sticky_ht;
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
@@ -343,6 +541,27 @@ lb_node_fn (vlib_main_t * vm,
                        vip_index0, lb_time,
                        &available_index0, &asindex0);
 
+          if (PREDICT_FALSE(asindex0 == ~0 && old_sticky_ht != NULL))
+            {
+              //The flow may not have been migrated yet
+              u32 old_available_index0;
+              lb_hash_get (old_sticky_ht, hash0,
+                           vip_index0, lb_time,
+                           &old_available_index0, &asindex0);
+              if (asindex0 != ~0 && available_index0 != ~0)
+                {
+                  //Move it now, the old entry is released by the sweep
+                  lb_sticky_ref_swap (
+                      lbm, thread_index,
+                      lb_hash_available_value (sticky_ht, hash0,
+                                               available_index0),
+                      asindex0);
+                  lb_hash_put (sticky_ht, hash0, asindex0,
+                               vip_index0,
+                               available_index0, lb_time);
+                }
+            }
+
           if (PREDICT_TRUE(asindex0 != ~0))
             {
               //Found an existing entry
@@ -372,6 +591,9 @@ lb_node_fn (vlib_main_t * vm,
               lb_hash_put (sticky_ht, hash0, asindex0,
                            vip_index0,
                            available_index0, lb_time);
+
+              //Let peers know about it
+              lb_sync_flow_add (thread_index, hash0, vip_index0, asindex0);
             }
           else
             {
@@ -379,6 +601,10 @@ lb_node_fn (vlib_main_t * vm,
               asindex0 =
                   vip0->new_flow_table[hash0 & vip0->new_flow_table_mask].as_index;
               counter = LB_VIP_COUNTER_UNTRACKED_PACKET;
+              lbm->per_cpu[thread_index].sweep_collisions++;
+              vlib_increment_simple_counter (
+                  &lbm->sticky_counters[LB_STICKY_COUNTER_COLLISION],
+                  thread_index, 0, 1);
             }
 
           vlib_increment_simple_counter (
@@ -178,13 +178,12 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   args.buffer_size = MEMIF_DEFAULT_BUFFER_SIZE;
   u32 rx_queues = MEMIF_DEFAULT_RX_QUEUES;
   u32 tx_queues = MEMIF_DEFAULT_TX_QUEUES;
+  int zero_copy = -1;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
     return 0;
 
-  args.is_zero_copy = 1;
-
   while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
     {
       if (unformat (line_input, "id %u", &args.id))
@@ -206,7 +205,9 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       else if (unformat (line_input, "slave"))
 	args.is_master = 0;
       else if (unformat (line_input, "no-zero-copy"))
-	args.is_zero_copy = 0;
+	zero_copy = 0;
+      else if (unformat (line_input, "zero-copy"))
+	zero_copy = 1;
       else if (unformat (line_input, "mode ip"))
 	args.mode = MEMIF_INTERFACE_MODE_IP;
       else if (unformat (line_input, "hw-addr %U",
@@ -234,6 +235,10 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   args.rx_queues = rx_queues;
   args.tx_queues = tx_queues;
 
+  /* zero-copy by default on slaves only, a zero-copy master needs a VPP
+     slave in copy mode */
+  args.is_zero_copy = (zero_copy == -1) ? !args.is_master : zero_copy;
+
   r = memif_create_if (vm, &args);
 
   vec_free (args.secret);
@@ -261,7 +266,20 @@ VLIB_CLI_COMMAND (memif_create_command, static) = {
                 "[ring-size <size>] [buffer-size <size>] "
 		"[hw-addr <mac-address>] "
 		"<master|slave> [rx-queues <number>] [tx-queues <number>] "
-		"[mode ip] [secret <string>]",
+		"[mode ip] [secret <string>] [zero-copy|no-zero-copy]",
+  .long_help =
+  "Create a memif interface\n"
+  "\n"
+  "zero-copy            post our buffers to the peer, the default on\n"
+  "                     slaves. The peer gets read and write access to\n"
+  "                     all our buffer pools, headers included: only use\n"
+  "                     it with a peer as trusted as this VPP instance.\n"
+  "                     A zero-copy master sends its buffer pools with\n"
+  "                     ADD_REGION after the slave's CONNECT, which is\n"
+  "                     not in the memif protocol: the slave must be a\n"
+  "                     VPP slave in copy mode.\n"
+  "no-zero-copy         copy packets to and from the shared memory the\n"
+  "                     slave creates, the default on masters\n",
   .function = memif_create_command_fn,
 };
 /* *INDENT-ON* */
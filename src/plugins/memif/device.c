@@ -96,6 +96,19 @@ memif_add_copy_op (memif_per_thread_data_t * ptd, void *data, u32 len,
   co->buffer_vec_index = buffer_vec_index;
 }
 
+/* room in a descriptor the slave copies a packet into */
+static_always_inline u32
+memif_s2m_desc_room (memif_if_t * mif, memif_desc_t * d)
+{
+  /* buffers posted by a zero-copy master have the length it set */
+  if (PREDICT_FALSE (mif->buffer_pool_region &&
+		     d->region >= mif->buffer_pool_region))
+    return clib_min (d->length, mif->run.buffer_size);
+
+  /* slave is the producer, so it should be able to reset buffer length */
+  return mif->run.buffer_size;
+}
+
 static_always_inline uword
 memif_interface_tx_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   vlib_frame_t * frame, memif_if_t * mif,
@@ -151,8 +164,8 @@ retry:
 
       dst_off = 0;
 
-      /* slave is the producer, so it should be able to reset buffer length */
-      dst_left = (type == MEMIF_RING_S2M) ? mif->run.buffer_size : d0->length;
+      dst_left = (type == MEMIF_RING_S2M) ?
+	memif_s2m_desc_room (mif, d0) : d0->length;
 
       if (PREDICT_TRUE (n_left >= 4))
 	vlib_prefetch_buffer_header (vlib_get_buffer (vm, buffers[3]), LOAD);
@@ -175,9 +188,8 @@ retry:
 		  d0->flags = MEMIF_DESC_FLAG_NEXT;
 		  d0 = &ring->desc[slot & mask];
 		  dst_off = 0;
-		  dst_left =
-		    (type ==
-		     MEMIF_RING_S2M) ? mif->run.buffer_size : d0->length;
+		  dst_left = (type == MEMIF_RING_S2M) ?
+		    memif_s2m_desc_room (mif, d0) : d0->length;
 
 		  if (PREDICT_FALSE (last_region != d0->region))
 		    {
@@ -295,7 +307,7 @@ no_free_slots:
 static_always_inline uword
 memif_interface_tx_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			      vlib_frame_t * frame, memif_if_t * mif,
-			      memif_queue_t * mq,
+			      memif_ring_type_t type, memif_queue_t * mq,
 			      memif_per_thread_data_t * ptd)
 {
   memif_ring_t *ring = mq->ring;
@@ -308,17 +320,37 @@ memif_interface_tx_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_buffer_t *b0;
 
 retry:
-  n_free = ring->tail - mq->last_tail;
-  if (n_free >= 16)
+  if (type == MEMIF_RING_S2M)
     {
-      vlib_buffer_free_from_ring_no_next (vm, mq->buffers,
-					  mq->last_tail & mask,
-					  ring_size, n_free);
-      mq->last_tail += n_free;
+      /* slave: the master consumed the slots up to the ring tail */
+      n_free = ring->tail - mq->last_tail;
+      if (n_free >= 16)
+	{
+	  vlib_buffer_free_from_ring_no_next (vm, mq->buffers,
+					      mq->last_tail & mask,
+					      ring_size, n_free);
+	  mq->last_tail += n_free;
+	}
+
+      slot = ring->head;
+      free_slots = ring_size - ring->head + mq->last_tail;
     }
+  else
+    {
+      /* master: the slave hands consumed slots back by moving the ring
+         head one ring ahead of them */
+      n_free = ring->head - ring_size - mq->last_head;
+      if ((i16) n_free >= 16)
+	{
+	  vlib_buffer_free_from_ring_no_next (vm, mq->buffers,
+					      mq->last_head & mask,
+					      ring_size, n_free);
+	  mq->last_head += n_free;
+	}
 
-  slot = ring->head;
-  free_slots = ring_size - ring->head + mq->last_tail;
+      slot = ring->tail;
+      free_slots = ring_size - ring->tail + mq->last_head;
+    }
 
   while (n_left && free_slots)
     {
@@ -341,7 +373,7 @@ retry:
       mq->buffers[s0] = bi0;
       b0 = vlib_get_buffer (vm, bi0);
 
-      d0->region = b0->buffer_pool_index + 1;
+      d0->region = b0->buffer_pool_index + mif->buffer_pool_region;
       d0->offset = (void *) b0->data + b0->current_data -
 	mif->regions[d0->region].shm;
       d0->length = b0->current_length;
@@ -376,7 +408,10 @@ retry:
 no_free_slots:
 
   CLIB_MEMORY_STORE_BARRIER ();
-  ring->head = slot;
+  if (type == MEMIF_RING_S2M)
+    ring->head = slot;
+  else
+    ring->tail = slot;
 
   if (n_left && n_retries--)
     goto retry;
@@ -423,7 +458,14 @@ VNET_DEVICE_CLASS_TX_FN (memif_device_class) (vlib_main_t * vm,
     mq = vec_elt_at_index (mif->tx_queues, thread_index);
 
   if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
-    return memif_interface_tx_zc_inline (vm, node, frame, mif, mq, ptd);
+    {
+      if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+	return memif_interface_tx_zc_inline (vm, node, frame, mif,
+					     MEMIF_RING_S2M, mq, ptd);
+      else
+	return memif_interface_tx_zc_inline (vm, node, frame, mif,
+					     MEMIF_RING_M2S, mq, ptd);
+    }
   else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_S2M,
 				      mq, ptd);
@@ -65,6 +65,36 @@ memif_queue_intfd_close (memif_queue_t * mq)
     }
 }
 
+/* give back the buffers a zero-copy queue still has on its ring, using
+   only the ring index we own, the other one may be garbage by now */
+static void
+memif_queue_free_buffers (memif_if_t * mif, memif_queue_t * mq, int is_rx)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u16 ring_size, mask, first, n;
+
+  if (mq->ring && vec_len (mq->buffers))
+    {
+      ring_size = 1 << mq->log2_ring_size;
+      mask = ring_size - 1;
+      if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+	{
+	  first = mq->last_tail;
+	  n = mq->ring->head - first;
+	}
+      else
+	{
+	  first = mq->last_head;
+	  n = mq->ring->tail - first + (is_rx ? ring_size : 0);
+	}
+
+      if (n <= ring_size)
+	vlib_buffer_free_from_ring_no_next (vm, mq->buffers, first & mask,
+					    ring_size, n);
+    }
+  vec_free (mq->buffers);
+}
+
 void
 memif_disconnect (memif_if_t * mif, clib_error_t * err)
 {
@@ -126,6 +156,8 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
 	    memif_log_warn (mif,
 			   "Unable to unassign interface %d, queue %d: rc=%d",
 			   mif->hw_if_index, i, rv);
+	  if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	    memif_queue_free_buffers (mif, mq, 1 /* is_rx */ );
 	  mq->ring = 0;
 	}
     }
@@ -136,7 +168,11 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
   vec_free (mif->rx_queues);
 
   vec_foreach (mq, mif->tx_queues)
-    memif_queue_intfd_close (mq);
+    {
+      if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	memif_queue_free_buffers (mif, mq, 0 /* is_rx */ );
+      memif_queue_intfd_close (mq);
+    }
   vec_free (mif->tx_queues);
 
   /* free memory regions */
@@ -152,6 +188,7 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
     }
   /* *INDENT-ON* */
   vec_free (mif->regions);
+  mif->buffer_pool_region = 0;
   vec_free (mif->remote_name);
   vec_free (mif->remote_if_name);
   clib_fifo_free (mif->msg_queue);
@@ -182,6 +219,66 @@ memif_int_fd_read_ready (clib_file_t * uf)
 }
 
 
+/* zero-copy master: export our buffer pools to the slave, as regions
+   following the ones it sent us. The slave gets access to all our
+   buffers, not only the ones we post (see memif_doc.md). */
+static void
+memif_init_master_regions (memif_if_t * mif)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp;
+  memif_region_t *r;
+
+  mif->buffer_pool_region = vec_len (mif->regions);
+
+  /* *INDENT-OFF* */
+  vec_foreach (bp, vm->buffer_main->buffer_pools)
+    {
+      vlib_physmem_map_t *pm;
+      pm = vlib_physmem_get_map (vm, bp->physmem_map_index);
+      vec_add2_aligned (mif->regions, r, 1, CLIB_CACHE_LINE_BYTES);
+      r->fd = pm->fd;
+      r->region_size = pm->n_pages << pm->log2_page_size;
+      r->shm = pm->base;
+      r->is_external = 1;
+    }
+  /* *INDENT-ON* */
+}
+
+/* zero-copy master: post a full ring of our empty buffers on a S2M ring,
+   for the slave to copy packets into */
+static clib_error_t *
+memif_master_post_buffers (memif_if_t * mif, memif_queue_t * mq)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u16 ring_size = 1 << mq->log2_ring_size;
+  u32 n_alloc;
+  int i;
+
+  vec_validate_aligned (mq->buffers, ring_size, CLIB_CACHE_LINE_BYTES);
+  n_alloc = vlib_buffer_alloc_from_pool (vm, mq->buffers, ring_size,
+					 mq->buffer_pool_index);
+  if (n_alloc != ring_size)
+    {
+      vlib_buffer_free (vm, mq->buffers, n_alloc);
+      vec_free (mq->buffers);
+      return clib_error_return (0, "buffer allocation failure");
+    }
+
+  for (i = 0; i < ring_size; i++)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, mq->buffers[i]);
+      memif_desc_t *d = &mq->ring->desc[i];
+
+      d->flags = 0;
+      d->region = b->buffer_pool_index + mif->buffer_pool_region;
+      d->length = vlib_buffer_get_default_data_size (vm);
+      d->offset = (void *) b->data - mif->regions[d->region].shm;
+    }
+
+  return 0;
+}
+
 clib_error_t *
 memif_connect (memif_if_t * mif)
 {
@@ -218,6 +315,10 @@ memif_connect (memif_if_t * mif)
     }
   /* *INDENT-ON* */
 
+  if ((mif->flags & MEMIF_IF_FLAG_IS_SLAVE) == 0 &&
+      (mif->flags & MEMIF_IF_FLAG_ZERO_COPY))
+    memif_init_master_regions (mif);
+
   template.read_function = memif_int_fd_read_ready;
 
   /* *INDENT-OFF* */
@@ -231,6 +332,11 @@ memif_connect (memif_if_t * mif)
 	  err = clib_error_return (0, "wrong cookie on tx ring %u", i);
 	  goto error;
 	}
+
+      if ((mif->flags & MEMIF_IF_FLAG_IS_SLAVE) == 0 &&
+	  (mif->flags & MEMIF_IF_FLAG_ZERO_COPY))
+	vec_validate_aligned (mq->buffers, 1 << mq->log2_ring_size,
+			      CLIB_CACHE_LINE_BYTES);
     }
 
   vec_foreach_index (i, mif->rx_queues)
@@ -259,6 +365,10 @@ memif_connect (memif_if_t * mif)
       ti = vnet_get_device_input_thread_index (vnm, mif->hw_if_index, i);
       mq->buffer_pool_index =
 	vlib_buffer_pool_get_default_for_numa (vm, vlib_mains[ti]->numa_node);
+      if ((mif->flags & MEMIF_IF_FLAG_IS_SLAVE) == 0 &&
+	  (mif->flags & MEMIF_IF_FLAG_ZERO_COPY) &&
+	  (err = memif_master_post_buffers (mif, mq)))
+	goto error;
       rv = vnet_hw_interface_set_rx_mode (vnm, mif->hw_if_index, i,
 					  VNET_HW_INTERFACE_RX_MODE_DEFAULT);
       if (rv)
@@ -342,6 +452,7 @@ memif_init_regions_and_queues (memif_if_t * mif)
   if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
     {
       vlib_buffer_pool_t *bp;
+      mif->buffer_pool_region = 1;
       /* *INDENT-OFF* */
       vec_foreach (bp, vm->buffer_main->buffer_pools)
 	{
@@ -975,11 +1086,12 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
   msf->ref_cnt++;
 
   if (args->is_master == 0)
-    {
-      mif->flags |= MEMIF_IF_FLAG_IS_SLAVE;
-      if (args->is_zero_copy)
-	mif->flags |= MEMIF_IF_FLAG_ZERO_COPY;
-    }
+    mif->flags |= MEMIF_IF_FLAG_IS_SLAVE;
+
+  /* a zero-copy master exports its buffers to the slave, which only
+     VPP slaves in copy mode accept */
+  if (args->is_zero_copy)
+    mif->flags |= MEMIF_IF_FLAG_ZERO_COPY;
 
   hw = vnet_get_hw_interface (vnm, mif->hw_if_index);
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
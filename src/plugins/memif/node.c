@@ -26,6 +26,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
+#include <vnet/latency.h>
 
 #include <memif/memif.h>
 #include <memif/private.h>
@@ -92,10 +93,10 @@ memif_trace_buffer (vlib_main_t * vm, vlib_node_runtime_t * node,
 {
   VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b);
 
-  if (PREDICT_TRUE (b != 0))
+  if (PREDICT_TRUE (b != 0) &&
+      vlib_trace_buffer (vm, node, next, b, /* follow_chain */ 0))
     {
       memif_input_trace_t *tr;
-      vlib_trace_buffer (vm, node, next, b, /* follow_chain */ 0);
       vlib_set_trace_count (vm, node, --(*n_tracep));
       tr = vlib_add_trace (vm, node, b, sizeof (*tr));
       tr->next_index = next;
@@ -170,6 +171,19 @@ memif_desc_is_invalid (memif_if_t * mif, memif_desc_t * d, u32 buffer_length)
   return 0;
 }
 
+/* length of a zero-copy rx descriptor, which the peer must keep within
+   the buffer we posted */
+static_always_inline u32
+memif_desc_length (memif_if_t * mif, memif_desc_t * d, u32 buffer_length)
+{
+  if (PREDICT_FALSE (d->length > buffer_length))
+    {
+      mif->flags |= MEMIF_IF_FLAG_ERROR;
+      return buffer_length;
+    }
+  return d->length;
+}
+
 static_always_inline uword
 memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   vlib_frame_t * frame, memif_if_t * mif,
@@ -469,6 +483,8 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       next += 1;
     }
 
+  vnet_latency_stamp (vm, to_next_bufs, n_rx_packets);
+
   /* packet trace if enabled */
   if (PREDICT_FALSE ((n_trace = vlib_get_trace_count (vm, node))))
     {
@@ -483,14 +499,17 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  if (mode != MEMIF_INTERFACE_MODE_ETHERNET)
 	    ni = next[0];
 	  b = vlib_get_buffer (vm, bi[0]);
-	  vlib_trace_buffer (vm, node, ni, b, /* follow_chain */ 0);
-	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-	  tr->next_index = ni;
-	  tr->hw_if_index = mif->hw_if_index;
-	  tr->ring = qid;
+	  if (PREDICT_TRUE
+	      (vlib_trace_buffer (vm, node, ni, b, /* follow_chain */ 0)))
+	    {
+	      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+	      tr->next_index = ni;
+	      tr->hw_if_index = mif->hw_if_index;
+	      tr->ring = qid;
+	      n_trace--;
+	    }
 
 	  /* next */
-	  n_trace--;
 	  n_left--;
 	  bi++;
 	  next++;
@@ -535,10 +554,17 @@ refill:
   return n_rx_packets;
 }
 
+/*
+ * Zero-copy receive: the rx ring descriptors point to our own buffers,
+ * posted empty to the peer. A zero-copy slave receives on M2S rings, where
+ * it owns the head, while a zero-copy master receives on S2M rings, where
+ * it owns the tail.
+ */
 static_always_inline uword
 memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			      vlib_frame_t * frame, memif_if_t * mif,
-			      u16 qid, memif_interface_mode_t mode)
+			      memif_ring_type_t type, u16 qid,
+			      memif_interface_mode_t mode)
 {
   vnet_main_t *vnm = vnet_get_main ();
   memif_main_t *mm = &memif_main;
@@ -569,12 +595,14 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     VNET_DEVICE_INPUT_NEXT_IP6_INPUT : VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
 
   /* asume that somebody will want to add ethernet header on the packet
-     so start with IP header at offset 14 */
-  start_offset = (mode == MEMIF_INTERFACE_MODE_IP) ? 14 : 0;
+     so start with IP header at offset 14. A slave writing to our buffers
+     uses its own buffer size, so a master posts the whole data area. */
+  start_offset = (mode == MEMIF_INTERFACE_MODE_IP &&
+		  type == MEMIF_RING_M2S) ? 14 : 0;
   buffer_length = vlib_buffer_get_default_data_size (vm) - start_offset;
 
-  cur_slot = mq->last_tail;
-  last_slot = ring->tail;
+  cur_slot = (type == MEMIF_RING_S2M) ? mq->last_head : mq->last_tail;
+  last_slot = (type == MEMIF_RING_S2M) ? ring->head : ring->tail;
   if (cur_slot == last_slot)
     goto refill;
   n_slots = last_slot - cur_slot;
@@ -585,6 +613,7 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   while (n_slots && n_rx_packets < MEMIF_RX_VECTOR_SZ)
     {
       vlib_buffer_t *hb;
+      u32 len0;
 
       s0 = cur_slot & mask;
       bi0 = mq->buffers[s0];
@@ -594,12 +623,10 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     CLIB_CACHE_LINE_BYTES, LOAD);
       d0 = &ring->desc[s0];
       hb = b0 = vlib_get_buffer (vm, bi0);
+      len0 = memif_desc_length (mif, d0, buffer_length);
       b0->current_data = start_offset;
-      b0->current_length = start_offset + d0->length;
-      n_rx_bytes += d0->length;
-
-      if (0 && memif_desc_is_invalid (mif, d0, buffer_length))
-	return 0;
+      b0->current_length = start_offset + len0;
+      n_rx_bytes += len0;
 
       cur_slot++;
       n_slots--;
@@ -617,10 +644,11 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  /* current buffer */
 	  b0 = vlib_get_buffer (vm, bi0);
+	  len0 = memif_desc_length (mif, d0, buffer_length);
 	  b0->current_data = start_offset;
-	  b0->current_length = start_offset + d0->length;
-	  hb->total_length_not_including_first_buffer += d0->length;
-	  n_rx_bytes += d0->length;
+	  b0->current_length = start_offset + len0;
+	  hb->total_length_not_including_first_buffer += len0;
+	  n_rx_bytes += len0;
 
 	  cur_slot++;
 	  n_slots--;
@@ -630,7 +658,10 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 
   /* release slots from the ring */
-  mq->last_tail = cur_slot;
+  if (type == MEMIF_RING_S2M)
+    mq->last_head = cur_slot;
+  else
+    mq->last_tail = cur_slot;
 
   n_from = n_rx_packets;
   buffers = ptd->buffers;
@@ -778,8 +809,18 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 refill:
   vec_reset_length (ptd->buffers);
 
-  head = ring->head;
-  n_slots = ring_size - head + mq->last_tail;
+  /* slots consumed above are refilled in batches; a slave posts them at
+     the head, a master at the tail, behind the slots the slave may fill */
+  if (type == MEMIF_RING_S2M)
+    {
+      head = ring->tail;
+      n_slots = mq->last_head - head;
+    }
+  else
+    {
+      head = ring->head;
+      n_slots = ring_size - head + mq->last_tail;
+    }
 
   if (n_slots < 32)
     goto done;
@@ -829,10 +870,10 @@ refill:
       b2 = vlib_get_buffer (vm, mq->buffers[s2]);
       b3 = vlib_get_buffer (vm, mq->buffers[s3]);
 
-      d0->region = b0->buffer_pool_index + 1;
-      d1->region = b1->buffer_pool_index + 1;
-      d2->region = b2->buffer_pool_index + 1;
-      d3->region = b3->buffer_pool_index + 1;
+      d0->region = b0->buffer_pool_index + mif->buffer_pool_region;
+      d1->region = b1->buffer_pool_index + mif->buffer_pool_region;
+      d2->region = b2->buffer_pool_index + mif->buffer_pool_region;
+      d3->region = b3->buffer_pool_index + mif->buffer_pool_region;
 
       d0->offset =
 	(void *) b0->data - mif->regions[d0->region].shm + start_offset;
@@ -851,7 +892,7 @@ refill:
       d0 = &ring->desc[s0];
       clib_memcpy_fast (d0, dt, sizeof (memif_desc_t));
       b0 = vlib_get_buffer (vm, mq->buffers[s0]);
-      d0->region = b0->buffer_pool_index + 1;
+      d0->region = b0->buffer_pool_index + mif->buffer_pool_region;
       d0->offset =
 	(void *) b0->data - mif->regions[d0->region].shm + start_offset;
 
@@ -859,7 +900,10 @@ refill:
     }
 
   CLIB_MEMORY_STORE_BARRIER ();
-  ring->head = head;
+  if (type == MEMIF_RING_S2M)
+    ring->tail = head;
+  else
+    ring->head = head;
 
 done:
   return n_rx_packets;
@@ -886,12 +930,16 @@ VLIB_NODE_FN (memif_input_node) (vlib_main_t * vm,
       {
 	if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
 	  {
+	    memif_ring_type_t type = (mif->flags & MEMIF_IF_FLAG_IS_SLAVE) ?
+	      MEMIF_RING_M2S : MEMIF_RING_S2M;
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
 	      n_rx += memif_device_input_zc_inline (vm, node, frame, mif,
-						    dq->queue_id, mode_ip);
+						    type, dq->queue_id,
+						    mode_ip);
 	    else
 	      n_rx += memif_device_input_zc_inline (vm, node, frame, mif,
-						    dq->queue_id, mode_eth);
+						    type, dq->queue_id,
+						    mode_eth);
 	  }
 	else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
 	  {
@@ -170,6 +170,9 @@ typedef struct
   u8 *secret;
 
   memif_region_t *regions;
+  /* in zero-copy mode, region exporting buffer pool 0, followed by the
+     other buffer pools */
+  memif_region_index_t buffer_pool_region;
 
   memif_queue_t *rx_queues;
   memif_queue_t *tx_queues;
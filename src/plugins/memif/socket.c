@@ -310,6 +310,18 @@ memif_msg_receive_add_region (memif_if_t * mif, memif_msg_t * msg, int fd)
   if (ar->index > MEMIF_MAX_REGION)
     return clib_error_return (0, "too many regions");
 
+  /* the master sends regions only when exporting its buffers */
+  if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+    {
+      if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	return clib_error_return (0,
+				  "zero-copy on both sides not supported");
+
+      /* the master sizes the buffers it posts in these regions */
+      if (mif->buffer_pool_region == 0)
+	mif->buffer_pool_region = ar->index;
+    }
+
   vec_validate_aligned (mif->regions, ar->index, CLIB_CACHE_LINE_BYTES);
   mr = vec_elt_at_index (mif->regions, ar->index);
   mr->fd = fd;
@@ -474,6 +486,10 @@ memif_msg_receive (memif_if_t ** mifp, clib_socket_t * sock, clib_file_t * uf)
     case MEMIF_MSG_TYPE_CONNECT:
       if ((err = memif_msg_receive_connect (mif, &msg)))
 	goto error;
+      /* a zero-copy master exports its buffer pools before connecting */
+      if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	for (i = mif->buffer_pool_region; i < vec_len (mif->regions); i++)
+	  memif_msg_enq_add_region (mif, i);
       memif_msg_enq_connected (mif);
       break;
 
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include <nat/dslite.h>
+#include <nat/nat_ipfix_logging.h>
 #include <nat/nat_inlines.h>
 #include <nat/nat_syslog.h>
 
@@ -439,6 +440,8 @@ dslite_in2out_node_fn_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1561,6 +1561,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
   vlib_node_increment_counter (vm, stats_node_index,
 			       SNAT_IN2OUT_ERROR_FRAGMENTS, fragments);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1968,6 +1970,9 @@ VLIB_NODE_FN (nat44_in2out_reass_node) (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1659,6 +1659,8 @@ nat44_ed_in2out_node_fn_inline (vlib_main_t * vm,
   vlib_node_increment_counter (vm, stats_node_index,
 			       NAT_IN2OUT_ED_ERROR_FRAGMENTS, fragments);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -2108,6 +2110,9 @@ nat44_ed_in2out_reass_node_fn_inline (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
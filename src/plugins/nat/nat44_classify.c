@@ -21,6 +21,7 @@
 #include <vnet/vnet.h>
 #include <vnet/fib/ip4_fib.h>
 #include <nat/nat.h>
+#include <nat/nat_ipfix_logging.h>
 #include <nat/nat_reass.h>
 #include <nat/nat_inlines.h>
 
@@ -410,6 +411,8 @@ nat44_classify_node_fn_inline (vlib_main_t * vm,
   vlib_node_increment_counter (vm, node->node_index,
 			       NAT44_CLASSIFY_ERROR_FRAG_CACHED, frag_cached);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -18,6 +18,7 @@
  */
 
 #include <nat/nat64.h>
+#include <nat/nat_ipfix_logging.h>
 #include <nat/nat_reass.h>
 #include <nat/nat_inlines.h>
 #include <vnet/ip/ip6_to_ip4.h>
@@ -1166,6 +1167,8 @@ nat64_in2out_node_fn_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_node_increment_counter (vm, stats_node_index,
 			       NAT64_IN2OUT_ERROR_FRAGMENTS, fragments);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1652,6 +1655,9 @@ VLIB_NODE_FN (nat64_in2out_reass_node) (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
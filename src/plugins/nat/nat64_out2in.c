@@ -18,6 +18,7 @@
  */
 
 #include <nat/nat64.h>
+#include <nat/nat_ipfix_logging.h>
 #include <nat/nat_reass.h>
 #include <nat/nat_inlines.h>
 #include <vnet/ip/ip4_to_ip6.h>
@@ -570,6 +571,8 @@ VLIB_NODE_FN (nat64_out2in_node) (vlib_main_t * vm,
   vlib_node_increment_counter (vm, nm->out2in_node_index,
 			       NAT64_OUT2IN_ERROR_FRAGMENTS, fragments);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -924,6 +927,9 @@ VLIB_NODE_FN (nat64_out2in_reass_node) (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -852,6 +852,9 @@ VLIB_NODE_FN (snat_det_in2out_node) (vlib_main_t * vm,
   vlib_node_increment_counter (vm, sm->det_in2out_node_index,
 			       NAT_DET_IN2OUT_ERROR_IN2OUT_PACKETS,
 			       pkts_processed);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -552,95 +552,16 @@ nat_template_rewrite_nat64_session (flow_report_main_t * frm,
 				collector_port, NAT64_SESSION_CREATE, 0);
 }
 
-static inline void
-snat_ipfix_header_create (flow_report_main_t * frm,
-			  vlib_buffer_t * b0, u32 * offset)
+/* Reserve room for a record, in the data set of template_id */
+static inline u8 *
+snat_ipfix_record_add (vlib_main_t * vm, flow_report_record_buffer_t * rb,
+                       u16 template_id, u16 record_len)
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
-  flow_report_stream_t *stream;
-  ip4_ipfix_template_packet_t *tp;
-  ipfix_message_header_t *h = 0;
-  ipfix_set_header_t *s = 0;
-  u32 sequence_number;
-  u32 stream_index;
-  ip4_header_t *ip;
-  udp_header_t *udp;
-  
-  stream_index = clib_atomic_fetch_or(&silm->stream_index, 0);
-  stream = &frm->streams[stream_index];
-
-  b0->current_data = 0;
-  b0->current_length = sizeof (*ip) + sizeof (*udp) + sizeof (*h) +
-    sizeof (*s);
-  b0->flags |= (VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_FLOW_REPORT);
-  vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
-  vnet_buffer (b0)->sw_if_index[VLIB_TX] = frm->fib_index;
-  tp = vlib_buffer_get_current (b0);
-  ip = (ip4_header_t *) & tp->ip4;
-  udp = (udp_header_t *) (ip + 1);
-  h = (ipfix_message_header_t *) (udp + 1);
-  s = (ipfix_set_header_t *) (h + 1);
-
-  ip->ip_version_and_header_length = 0x45;
-  ip->ttl = 254;
-  ip->protocol = IP_PROTOCOL_UDP;
-  ip->flags_and_fragment_offset = 0;
-  ip->src_address.as_u32 = frm->src_address.as_u32;
-  ip->dst_address.as_u32 = frm->ipfix_collector.as_u32;
-  udp->src_port = clib_host_to_net_u16 (stream->src_port);
-  udp->dst_port = clib_host_to_net_u16 (frm->collector_port);
-  udp->checksum = 0;
-
-  h->export_time = clib_host_to_net_u32 ((u32)
-					 (((f64) frm->unix_time_0) +
-					  (vlib_time_now (frm->vlib_main) -
-					   frm->vlib_time_0)));
-
-  sequence_number = clib_atomic_fetch_add (&stream->sequence_number, 1);
-  h->sequence_number = clib_host_to_net_u32 (sequence_number);
-  h->domain_id = clib_host_to_net_u32 (stream->domain_id);
-
-  *offset = (u32) (((u8 *) (s + 1)) - (u8 *) tp);
-}
-
-static inline void
-snat_ipfix_send (flow_report_main_t * frm,
-		 vlib_frame_t * f, vlib_buffer_t * b0, u16 template_id)
-{
-  ip4_ipfix_template_packet_t *tp;
-  ipfix_message_header_t *h = 0;
-  ipfix_set_header_t *s = 0;
-  ip4_header_t *ip;
-  udp_header_t *udp;
-  vlib_main_t *vm = frm->vlib_main;
-
-  tp = vlib_buffer_get_current (b0);
-  ip = (ip4_header_t *) & tp->ip4;
-  udp = (udp_header_t *) (ip + 1);
-  h = (ipfix_message_header_t *) (udp + 1);
-  s = (ipfix_set_header_t *) (h + 1);
+  u32 stream_index = clib_atomic_fetch_or (&silm->stream_index, 0);
 
-  s->set_id_length = ipfix_set_id_length (template_id,
-					  b0->current_length -
-					  (sizeof (*ip) + sizeof (*udp) +
-					   sizeof (*h)));
-  h->version_length = version_length (b0->current_length -
-				      (sizeof (*ip) + sizeof (*udp)));
-
-  ip->length = clib_host_to_net_u16 (b0->current_length);
-  ip->checksum = ip4_header_checksum (ip);
-  udp->length = clib_host_to_net_u16 (b0->current_length - sizeof (*ip));
-
-  if (frm->udp_checksum)
-    {
-      udp->checksum = ip4_tcp_udp_compute_checksum (vm, b0, ip);
-      if (udp->checksum == 0)
-	udp->checksum = 0xffff;
-    }
-
-  ASSERT (ip->checksum == ip4_header_checksum (ip));
-
-  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+  return vnet_flow_report_record_add (vm, rb, stream_index, template_id,
+                                      record_len);
 }
 
 static void
@@ -651,100 +572,52 @@ snat_ipfix_logging_nat44_ses (u32 thread_index, u8 nat_event, u32 src_ip,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 proto = ~0;
   u16 template_id;
 
-  proto = snat_proto_to_ip_proto (snat_proto);
-
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->nat44_session_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->nat44_session_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->nat44_session_next_record_offset;
-    }
-
-  f = sitd->nat44_session_frame;
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->nat44_session_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->nat44_session);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
+  proto = snat_proto_to_ip_proto (snat_proto);
 
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->nat44_session_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->nat44_session, template_id,
+                                  NAT44_SESSION_CREATE_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &src_ip, sizeof (src_ip));
-      offset += sizeof (src_ip);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_ip, sizeof (nat_src_ip));
-      offset += sizeof (nat_src_ip);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, &proto, sizeof (proto));
-      offset += sizeof (proto);
+  clib_memcpy_fast (record, &src_ip, sizeof (src_ip));
+  record += sizeof (src_ip);
 
-      clib_memcpy_fast (b0->data + offset, &src_port, sizeof (src_port));
-      offset += sizeof (src_port);
+  clib_memcpy_fast (record, &nat_src_ip, sizeof (nat_src_ip));
+  record += sizeof (nat_src_ip);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_port, sizeof (nat_src_port));
-      offset += sizeof (nat_src_port);
+  clib_memcpy_fast (record, &proto, sizeof (proto));
+  record += sizeof (proto);
 
-      clib_memcpy_fast (b0->data + offset, &vrf_id, sizeof (vrf_id));
-      offset += sizeof (vrf_id);
+  clib_memcpy_fast (record, &src_port, sizeof (src_port));
+  record += sizeof (src_port);
 
-      b0->current_length += NAT44_SESSION_CREATE_LEN;
-    }
+  clib_memcpy_fast (record, &nat_src_port, sizeof (nat_src_port));
+  record += sizeof (nat_src_port);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + NAT44_SESSION_CREATE_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->nat44_session_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->nat44_session_frame = 0;
-      sitd->nat44_session_buffer = 0;
-      offset = 0;
-    }
-  sitd->nat44_session_next_record_offset = offset;
+  clib_memcpy_fast (record, &vrf_id, sizeof (vrf_id));
 }
 
 static void
@@ -752,83 +625,35 @@ snat_ipfix_logging_addr_exhausted (u32 thread_index, u32 pool_id, int do_flush)
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = NAT_ADDRESSES_EXHAUTED;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->addr_exhausted_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->addr_exhausted_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->addr_exhausted_next_record_offset;
-    }
-
-  f = sitd->addr_exhausted_frame;
-  if (PREDICT_FALSE (f == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->addr_exhausted_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->addr_exhausted);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->addr_exhausted_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->addr_exhausted, template_id,
+                                  NAT_ADDRESSES_EXHAUTED_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &pool_id, sizeof (pool_id));
-      offset += sizeof (pool_id);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      b0->current_length += NAT_ADDRESSES_EXHAUTED_LEN;
-    }
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + NAT_ADDRESSES_EXHAUTED_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-          &silm->addr_exhausted_template_id,
-          0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->addr_exhausted_frame = 0;
-      sitd->addr_exhausted_buffer = 0;
-      offset = 0;
-    }
-  sitd->addr_exhausted_next_record_offset = offset;
+  clib_memcpy_fast (record, &pool_id, sizeof (pool_id));
 }
 
 static void
@@ -837,90 +662,42 @@ snat_ipfix_logging_max_entries_per_usr (u32 thread_index,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = QUOTA_EXCEEDED;
   u32 quota_event = MAX_ENTRIES_PER_USER;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->max_entries_per_user_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->max_entries_per_user_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->max_entries_per_user_next_record_offset;
-    }
-
-  f = sitd->max_entries_per_user_frame;
-  if (PREDICT_FALSE (f == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->max_entries_per_user_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->max_entries_per_user);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->max_entries_per_user_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->max_entries_per_user, template_id,
+                                  MAX_ENTRIES_PER_USER_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &quota_event, sizeof (quota_event));
-      offset += sizeof (quota_event);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &limit, sizeof (limit));
-      offset += sizeof (limit);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, &src_ip, sizeof (src_ip));
-      offset += sizeof (src_ip);
+  clib_memcpy_fast (record, &quota_event, sizeof (quota_event));
+  record += sizeof (quota_event);
 
-      b0->current_length += MAX_ENTRIES_PER_USER_LEN;
-    }
+  clib_memcpy_fast (record, &limit, sizeof (limit));
+  record += sizeof (limit);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + MAX_ENTRIES_PER_USER_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-          &silm->max_entries_per_user_template_id,
-          0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->max_entries_per_user_frame = 0;
-      sitd->max_entries_per_user_buffer = 0;
-      offset = 0;
-    }
-  sitd->max_entries_per_user_next_record_offset = offset;
+  clib_memcpy_fast (record, &src_ip, sizeof (src_ip));
 }
 
 static void
@@ -928,87 +705,39 @@ nat_ipfix_logging_max_ses (u32 thread_index, u32 limit, int do_flush)
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = QUOTA_EXCEEDED;
   u32 quota_event = MAX_SESSION_ENTRIES;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->max_sessions_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->max_sessions_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->max_sessions_next_record_offset;
-    }
-
-  f = sitd->max_sessions_frame;
-  if (PREDICT_FALSE (f == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->max_sessions_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->max_sessions);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->max_sessions_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->max_sessions, template_id,
+                                  MAX_SESSIONS_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &quota_event, sizeof (quota_event));
-      offset += sizeof (quota_event);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &limit, sizeof (limit));
-      offset += sizeof (limit);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      b0->current_length += MAX_SESSIONS_LEN;
-    }
+  clib_memcpy_fast (record, &quota_event, sizeof (quota_event));
+  record += sizeof (quota_event);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + MAX_SESSIONS_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->max_sessions_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->max_sessions_frame = 0;
-      sitd->max_sessions_buffer = 0;
-      offset = 0;
-    }
-  sitd->max_sessions_next_record_offset = offset;
+  clib_memcpy_fast (record, &limit, sizeof (limit));
 }
 
 static void
@@ -1016,87 +745,39 @@ nat_ipfix_logging_max_bib (u32 thread_index, u32 limit, int do_flush)
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = QUOTA_EXCEEDED;
   u32 quota_event = MAX_BIB_ENTRIES;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->max_bibs_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->max_bibs_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->max_bibs_next_record_offset;
+      vnet_flow_report_record_buffer_send (vm, &sitd->max_bibs);
+      return;
     }
 
-  f = sitd->max_bibs_frame;
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->max_bibs_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
-    }
-
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->max_bibs_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->max_bibs, template_id,
+                                  MAX_BIBS_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &quota_event, sizeof (quota_event));
-      offset += sizeof (quota_event);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &limit, sizeof (limit));
-      offset += sizeof (limit);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      b0->current_length += MAX_BIBS_LEN;
-    }
+  clib_memcpy_fast (record, &quota_event, sizeof (quota_event));
+  record += sizeof (quota_event);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->max_bibs_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->max_bibs_frame = 0;
-      sitd->max_bibs_buffer = 0;
-      offset = 0;
-    }
-  sitd->max_bibs_next_record_offset = offset;
+  clib_memcpy_fast (record, &limit, sizeof (limit));
 }
 
 static void
@@ -1105,90 +786,42 @@ nat_ipfix_logging_max_frag_ip4 (u32 thread_index,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = QUOTA_EXCEEDED;
   u32 quota_event = MAX_FRAGMENTS_PENDING_REASSEMBLY;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->max_frags_ip4_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->max_frags_ip4_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->max_frags_ip4_next_record_offset;
-    }
-
-  f = sitd->max_frags_ip4_frame;
-  if (PREDICT_FALSE (f == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->max_frags_ip4_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->max_frags_ip4);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->max_frags_ip4_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->max_frags_ip4, template_id,
+                                  MAX_FRAGMENTS_IP4_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &quota_event, sizeof (quota_event));
-      offset += sizeof (quota_event);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &limit, sizeof (limit));
-      offset += sizeof (limit);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, &src, sizeof (src));
-      offset += sizeof (src);
+  clib_memcpy_fast (record, &quota_event, sizeof (quota_event));
+  record += sizeof (quota_event);
 
-      b0->current_length += MAX_FRAGMENTS_IP4_LEN;
-    }
+  clib_memcpy_fast (record, &limit, sizeof (limit));
+  record += sizeof (limit);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->max_frags_ip4_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->max_frags_ip4_frame = 0;
-      sitd->max_frags_ip4_buffer = 0;
-      offset = 0;
-    }
-  sitd->max_frags_ip4_next_record_offset = offset;
+  clib_memcpy_fast (record, &src, sizeof (src));
 }
 
 static void
@@ -1197,90 +830,42 @@ nat_ipfix_logging_max_frag_ip6 (u32 thread_index,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u8 nat_event = QUOTA_EXCEEDED;
   u32 quota_event = MAX_FRAGMENTS_PENDING_REASSEMBLY;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->max_frags_ip6_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->max_frags_ip6_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->max_frags_ip6_next_record_offset;
+      vnet_flow_report_record_buffer_send (vm, &sitd->max_frags_ip6);
+      return;
     }
 
-  f = sitd->max_frags_ip6_frame;
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->max_frags_ip6_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
-    }
-
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->max_frags_ip6_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->max_frags_ip6, template_id,
+                                  MAX_FRAGMENTS_IP6_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, &quota_event, sizeof (quota_event));
-      offset += sizeof (quota_event);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &limit, sizeof (limit));
-      offset += sizeof (limit);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, src, sizeof (ip6_address_t));
-      offset += sizeof (ip6_address_t);
+  clib_memcpy_fast (record, &quota_event, sizeof (quota_event));
+  record += sizeof (quota_event);
 
-      b0->current_length += MAX_FRAGMENTS_IP6_LEN;
-    }
+  clib_memcpy_fast (record, &limit, sizeof (limit));
+  record += sizeof (limit);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + MAX_BIBS_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->max_frags_ip6_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->max_frags_ip6_frame = 0;
-      sitd->max_frags_ip6_buffer = 0;
-      offset = 0;
-    }
-  sitd->max_frags_ip6_next_record_offset = offset;
+  clib_memcpy_fast (record, src, sizeof (ip6_address_t));
 }
 
 static void
@@ -1291,97 +876,49 @@ nat_ipfix_logging_nat64_bibe (u32 thread_index, u8 nat_event,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->nat64_bib_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->nat64_bib_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
+      vnet_flow_report_record_buffer_send (vm, &sitd->nat64_bib);
+      return;
     }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->nat64_bib_next_record_offset;
-    }
-
-  f = sitd->nat64_bib_frame;
-  if (PREDICT_FALSE (f == 0))
-    {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->nat64_bib_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
-    }
-
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
 
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->nat64_bib_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->nat64_bib, template_id,
+                                  NAT64_BIB_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, src_ip, sizeof (ip6_address_t));
-      offset += sizeof (ip6_address_t);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_ip, sizeof (nat_src_ip));
-      offset += sizeof (nat_src_ip);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, &proto, sizeof (proto));
-      offset += sizeof (proto);
+  clib_memcpy_fast (record, src_ip, sizeof (ip6_address_t));
+  record += sizeof (ip6_address_t);
 
-      clib_memcpy_fast (b0->data + offset, &src_port, sizeof (src_port));
-      offset += sizeof (src_port);
+  clib_memcpy_fast (record, &nat_src_ip, sizeof (nat_src_ip));
+  record += sizeof (nat_src_ip);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_port, sizeof (nat_src_port));
-      offset += sizeof (nat_src_port);
+  clib_memcpy_fast (record, &proto, sizeof (proto));
+  record += sizeof (proto);
 
-      clib_memcpy_fast (b0->data + offset, &vrf_id, sizeof (vrf_id));
-      offset += sizeof (vrf_id);
+  clib_memcpy_fast (record, &src_port, sizeof (src_port));
+  record += sizeof (src_port);
 
-      b0->current_length += NAT64_BIB_LEN;
-    }
+  clib_memcpy_fast (record, &nat_src_port, sizeof (nat_src_port));
+  record += sizeof (nat_src_port);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + NAT64_BIB_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->nat64_bib_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->nat64_bib_frame = 0;
-      sitd->nat64_bib_buffer = 0;
-      offset = 0;
-    }
-  sitd->nat64_bib_next_record_offset = offset;
+  clib_memcpy_fast (record, &vrf_id, sizeof (vrf_id));
 }
 
 static void
@@ -1394,109 +931,61 @@ nat_ipfix_logging_nat64_ses (u32 thread_index, u8 nat_event,
 {
   snat_ipfix_logging_main_t *silm = &snat_ipfix_logging_main;
   snat_ipfix_per_thread_data_t *sitd = &silm->per_thread_data[thread_index];
-  flow_report_main_t *frm = &flow_report_main;
-  vlib_frame_t *f;
-  vlib_buffer_t *b0 = 0;
-  u32 bi0 = ~0;
-  u32 offset;
-  vlib_main_t *vm = frm->vlib_main;
-  u64 now;
+  vlib_main_t *vm = vlib_get_main ();
+  u64 now, time_stamp;
+  u8 *record;
   u16 template_id;
 
-  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
-  now += silm->milisecond_time_0;
-
-  b0 = sitd->nat64_ses_buffer;
-
-  if (PREDICT_FALSE (b0 == 0))
-    {
-      if (do_flush)
-	return;
-
-      if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
-	{
-	  nat_log_err ("can't allocate buffer for NAT IPFIX event");
-	  return;
-	}
-
-      b0 = sitd->nat64_ses_buffer = vlib_get_buffer (vm, bi0);
-      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
-      offset = 0;
-    }
-  else
-    {
-      bi0 = vlib_get_buffer_index (vm, b0);
-      offset = sitd->nat64_ses_next_record_offset;
-    }
-
-  f = sitd->nat64_ses_frame;
-  if (PREDICT_FALSE (f == 0))
+  if (PREDICT_FALSE (do_flush))
     {
-      u32 *to_next;
-      f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
-      sitd->nat64_ses_frame = f;
-      to_next = vlib_frame_vector_args (f);
-      to_next[0] = bi0;
-      f->n_vectors = 1;
+      vnet_flow_report_record_buffer_send (vm, &sitd->nat64_ses);
+      return;
     }
 
-  if (PREDICT_FALSE (offset == 0))
-    snat_ipfix_header_create (frm, b0, &offset);
-
-  if (PREDICT_TRUE (do_flush == 0))
-    {
-      u64 time_stamp = clib_host_to_net_u64 (now);
-      clib_memcpy_fast (b0->data + offset, &time_stamp, sizeof (time_stamp));
-      offset += sizeof (time_stamp);
+  now = (u64) ((vlib_time_now (vm) - silm->vlib_time_0) * 1e3);
+  now += silm->milisecond_time_0;
 
-      clib_memcpy_fast (b0->data + offset, &nat_event, sizeof (nat_event));
-      offset += sizeof (nat_event);
+  template_id = clib_atomic_fetch_or (&silm->nat64_ses_template_id, 0);
+  record = snat_ipfix_record_add (vm, &sitd->nat64_ses, template_id,
+                                  NAT64_SES_LEN);
+  if (PREDICT_FALSE (record == 0))
+    return;
 
-      clib_memcpy_fast (b0->data + offset, src_ip, sizeof (ip6_address_t));
-      offset += sizeof (ip6_address_t);
+  time_stamp = clib_host_to_net_u64 (now);
+  clib_memcpy_fast (record, &time_stamp, sizeof (time_stamp));
+  record += sizeof (time_stamp);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_ip, sizeof (nat_src_ip));
-      offset += sizeof (nat_src_ip);
+  clib_memcpy_fast (record, &nat_event, sizeof (nat_event));
+  record += sizeof (nat_event);
 
-      clib_memcpy_fast (b0->data + offset, &proto, sizeof (proto));
-      offset += sizeof (proto);
+  clib_memcpy_fast (record, src_ip, sizeof (ip6_address_t));
+  record += sizeof (ip6_address_t);
 
-      clib_memcpy_fast (b0->data + offset, &src_port, sizeof (src_port));
-      offset += sizeof (src_port);
+  clib_memcpy_fast (record, &nat_src_ip, sizeof (nat_src_ip));
+  record += sizeof (nat_src_ip);
 
-      clib_memcpy_fast (b0->data + offset, &nat_src_port, sizeof (nat_src_port));
-      offset += sizeof (nat_src_port);
+  clib_memcpy_fast (record, &proto, sizeof (proto));
+  record += sizeof (proto);
 
-      clib_memcpy_fast (b0->data + offset, dst_ip, sizeof (ip6_address_t));
-      offset += sizeof (ip6_address_t);
+  clib_memcpy_fast (record, &src_port, sizeof (src_port));
+  record += sizeof (src_port);
 
-      clib_memcpy_fast (b0->data + offset, &nat_dst_ip, sizeof (nat_dst_ip));
-      offset += sizeof (nat_dst_ip);
+  clib_memcpy_fast (record, &nat_src_port, sizeof (nat_src_port));
+  record += sizeof (nat_src_port);
 
-      clib_memcpy_fast (b0->data + offset, &dst_port, sizeof (dst_port));
-      offset += sizeof (dst_port);
+  clib_memcpy_fast (record, dst_ip, sizeof (ip6_address_t));
+  record += sizeof (ip6_address_t);
 
-      clib_memcpy_fast (b0->data + offset, &nat_dst_port, sizeof (nat_dst_port));
-      offset += sizeof (nat_dst_port);
+  clib_memcpy_fast (record, &nat_dst_ip, sizeof (nat_dst_ip));
+  record += sizeof (nat_dst_ip);
 
-      clib_memcpy_fast (b0->data + offset, &vrf_id, sizeof (vrf_id));
-      offset += sizeof (vrf_id);
+  clib_memcpy_fast (record, &dst_port, sizeof (dst_port));
+  record += sizeof (dst_port);
 
-      b0->current_length += NAT64_SES_LEN;
-    }
+  clib_memcpy_fast (record, &nat_dst_port, sizeof (nat_dst_port));
+  record += sizeof (nat_dst_port);
 
-  if (PREDICT_FALSE
-      (do_flush || (offset + NAT64_SES_LEN) > frm->path_mtu))
-    {
-      template_id = clib_atomic_fetch_or (
-        &silm->nat64_ses_template_id,
-        0);
-      snat_ipfix_send (frm, f, b0, template_id);
-      sitd->nat64_ses_frame = 0;
-      sitd->nat64_ses_buffer = 0;
-      offset = 0;
-    }
-  sitd->nat64_ses_next_record_offset = offset;
+  clib_memcpy_fast (record, &vrf_id, sizeof (vrf_id));
 }
 
 void
@@ -1516,6 +1005,7 @@ snat_ipfix_flush (u32 thread_index)
                                 0, 0, 0, 0, 0, 0, 0, do_flush);
   nat_ipfix_logging_nat64_ses (thread_index,
                                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, do_flush);
+  vnet_flow_report_put_frame (vlib_get_main ());
 }
 
 void
@@ -18,6 +18,7 @@
 #define __included_nat_ipfix_logging_h__
 
 #include <nat/nat.h>
+#include <vnet/ipfix-export/flow_report.h>
 
 typedef enum {
   NAT_ADDRESSES_EXHAUTED = 3,
@@ -41,38 +42,16 @@ typedef enum {
 
 typedef struct {
 
-  /** ipfix buffers under construction */
-  vlib_buffer_t *nat44_session_buffer;
-  vlib_buffer_t *addr_exhausted_buffer;
-  vlib_buffer_t *max_entries_per_user_buffer;
-  vlib_buffer_t *max_sessions_buffer;
-  vlib_buffer_t *max_bibs_buffer;
-  vlib_buffer_t *max_frags_ip4_buffer;
-  vlib_buffer_t *max_frags_ip6_buffer;
-  vlib_buffer_t *nat64_bib_buffer;
-  vlib_buffer_t *nat64_ses_buffer;
-
-  /** frames containing ipfix buffers */
-  vlib_frame_t *nat44_session_frame;
-  vlib_frame_t *addr_exhausted_frame;
-  vlib_frame_t *max_entries_per_user_frame;
-  vlib_frame_t *max_sessions_frame;
-  vlib_frame_t *max_bibs_frame;
-  vlib_frame_t *max_frags_ip4_frame;
-  vlib_frame_t *max_frags_ip6_frame;
-  vlib_frame_t *nat64_bib_frame;
-  vlib_frame_t *nat64_ses_frame;
-
-  /** next record offset */
-  u32 nat44_session_next_record_offset;
-  u32 addr_exhausted_next_record_offset;
-  u32 max_entries_per_user_next_record_offset;
-  u32 max_sessions_next_record_offset;
-  u32 max_bibs_next_record_offset;
-  u32 max_frags_ip4_next_record_offset;
-  u32 max_frags_ip6_next_record_offset;
-  u32 nat64_bib_next_record_offset;
-  u32 nat64_ses_next_record_offset;
+  /** ipfix records under construction, by event */
+  flow_report_record_buffer_t nat44_session;
+  flow_report_record_buffer_t addr_exhausted;
+  flow_report_record_buffer_t max_entries_per_user;
+  flow_report_record_buffer_t max_sessions;
+  flow_report_record_buffer_t max_bibs;
+  flow_report_record_buffer_t max_frags_ip4;
+  flow_report_record_buffer_t max_frags_ip6;
+  flow_report_record_buffer_t nat64_bib;
+  flow_report_record_buffer_t nat64_ses;
 
 } snat_ipfix_per_thread_data_t;
 
@@ -1334,6 +1334,8 @@ VLIB_NODE_FN (snat_out2in_node) (vlib_main_t * vm,
   vlib_node_increment_counter (vm, sm->out2in_node_index,
 			       SNAT_OUT2IN_ERROR_FRAGMENTS, fragments);
 
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1669,6 +1671,9 @@ VLIB_NODE_FN (nat44_out2in_reass_node) (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1554,6 +1554,9 @@ nat44_ed_out2in_node_fn_inline (vlib_main_t * vm,
 			       other_packets);
   vlib_node_increment_counter (vm, stats_node_index,
 			       NAT_OUT2IN_ED_ERROR_FRAGMENTS, fragments);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
@@ -1962,6 +1965,9 @@ VLIB_NODE_FN (nat44_ed_out2in_reass_node) (vlib_main_t * vm,
 
   vec_free (fragments_to_drop);
   vec_free (fragments_to_loopback);
+
+  vnet_flow_report_put_frame (vm);
+
   return frame->n_vectors;
 }
 
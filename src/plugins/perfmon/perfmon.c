@@ -90,6 +90,23 @@ perfmon_find_table_by_model_stepping (perfmon_main_t * pm,
   return 0;
 }
 
+/* Number of general purpose counters, per logical processor */
+static u32
+perfmon_get_n_counters (void)
+{
+  u32 n_counters = 0;
+#if defined(__x86_64__)
+  u32 eax, ebx, ecx, edx;
+
+  /* Architectural performance monitoring leaf */
+  if (clib_get_cpuid (0xa, &eax, &ebx, &ecx, &edx))
+    n_counters = (eax >> 8) & 0xff;
+#endif
+  if (n_counters == 0)
+    n_counters = 2;
+  return clib_min (n_counters, PERFMON_MAX_EVENTS_PER_GROUP);
+}
+
 static clib_error_t *
 perfmon_init (vlib_main_t * vm)
 {
@@ -109,17 +126,16 @@ perfmon_init (vlib_main_t * vm)
 
   /* Default data collection interval */
   pm->timeout_interval = 2.0;	/* seconds */
-  vec_validate (pm->pm_fds, 1);
-  vec_validate (pm->pm_fds[0], vec_len (vlib_mains) - 1);
-  vec_validate (pm->pm_fds[1], vec_len (vlib_mains) - 1);
-  vec_validate (pm->perf_event_pages, 1);
-  vec_validate (pm->perf_event_pages[0], vec_len (vlib_mains) - 1);
-  vec_validate (pm->perf_event_pages[1], vec_len (vlib_mains) - 1);
-  vec_validate (pm->rdpmc_indices, 1);
-  vec_validate (pm->rdpmc_indices[0], vec_len (vlib_mains) - 1);
-  vec_validate (pm->rdpmc_indices[1], vec_len (vlib_mains) - 1);
+  pm->n_counters = perfmon_get_n_counters ();
   pm->page_size = getpagesize ();
 
+#define _(sym,str)                                                      \
+  pm->metric_counters[PERFMON_METRIC_##sym].name = str;                 \
+  pm->metric_counters[PERFMON_METRIC_##sym].stat_segment_name =         \
+    "/perfmon/node/" str;
+  foreach_perfmon_metric;
+#undef _
+
   pm->perfmon_table = 0;
   pm->pmc_event_by_name = 0;
 
@@ -198,6 +214,147 @@ unformat_processor_event (unformat_input_t * input, va_list * args)
   return 1;
 }
 
+/* perf schedules these on fixed counters, software events need none */
+static int
+perfmon_event_uses_counter (perfmon_event_config_t * ec)
+{
+  if (ec->pe_type == PERF_TYPE_SOFTWARE)
+    return 0;
+  if (ec->pe_type == PERF_TYPE_HARDWARE
+      && (ec->pe_config == PERF_COUNT_HW_INSTRUCTIONS
+	  || ec->pe_config == PERF_COUNT_HW_CPU_CYCLES
+	  || ec->pe_config == PERF_COUNT_HW_REF_CPU_CYCLES))
+    return 0;
+  return 1;
+}
+
+static int
+perfmon_group_has_event (perfmon_event_config_t * group,
+			 perfmon_event_config_t * ec)
+{
+  perfmon_event_config_t *e;
+
+  vec_foreach (e, group)
+    if (e->pe_type == ec->pe_type && e->pe_config == ec->pe_config)
+    return 1;
+  return 0;
+}
+
+/* Can the group also count the events, all at once? */
+static int
+perfmon_group_fits (perfmon_main_t * pm, perfmon_event_config_t * group,
+		    perfmon_event_config_t * events, int n_events)
+{
+  perfmon_event_config_t *e;
+  int i, n_counters = 0;
+  int n_total = vec_len (group);
+
+  vec_foreach (e, group) n_counters += perfmon_event_uses_counter (e);
+
+  for (i = 0; i < n_events; i++)
+    {
+      if (perfmon_group_has_event (group, events + i))
+	continue;
+      n_total++;
+      n_counters += perfmon_event_uses_counter (events + i);
+    }
+
+  return (n_total <= PERFMON_MAX_EVENTS_PER_GROUP
+	  && n_counters <= pm->n_counters);
+}
+
+/*
+ * Pack the event sets into as few event groups as the counters allow.
+ * The events of a set are counted at the same time, unless the set is
+ * larger than a group.
+ */
+static void
+perfmon_build_event_groups (perfmon_main_t * pm,
+			    perfmon_event_config_t ** sets)
+{
+  perfmon_event_config_t *group = 0;
+  perfmon_event_config_t **set, *ec;
+
+  vec_foreach (set, sets)
+  {
+    if (!perfmon_group_fits (pm, group, *set, vec_len (*set)))
+      {
+	if (group)
+	  vec_add1 (pm->event_groups, group);
+	group = 0;
+      }
+
+    vec_foreach (ec, *set)
+    {
+      if (perfmon_group_has_event (group, ec))
+	continue;
+      if (!perfmon_group_fits (pm, group, ec, 1))
+	{
+	  vec_add1 (pm->event_groups, group);
+	  group = 0;
+	}
+      vec_add1 (group, *ec);
+    }
+  }
+
+  if (group)
+    vec_add1 (pm->event_groups, group);
+}
+
+/*
+ * Top-down event sets, one per level 2 category pair. Returns 0 when
+ * the processor table lacks the level 1 events.
+ */
+static int
+perfmon_add_topdown_events (perfmon_main_t * pm,
+			    perfmon_event_config_t *** sets)
+{
+  perfmon_event_config_t *set[PERFMON_N_TOPDOWN_GROUPS] = { 0 };
+  perfmon_event_config_t ec;
+  perfmon_intel_pmc_event_t *ev;
+  int missing[PERFMON_N_TOPDOWN_GROUPS] = { 0 };
+  hash_pair_t *hp;
+  int i;
+
+  if (pm->perfmon_table == 0 || pm->pmc_event_by_name == 0)
+    return 0;
+
+  for (i = 0; i < PERFMON_N_TOPDOWN_GROUPS; i++)
+    {
+      ec.name = "cpu-cycles";
+      ec.pe_type = PERF_TYPE_HARDWARE;
+      ec.pe_config = PERF_COUNT_HW_CPU_CYCLES;
+      vec_add1 (set[i], ec);
+    }
+
+#define _(group,event,cmask,edge)                                       \
+  hp = hash_get_pair_mem (pm->pmc_event_by_name, event);                \
+  if (hp == 0)                                                          \
+    missing[group] = 1;                                                 \
+  else                                                                  \
+    {                                                                   \
+      ev = &pm->perfmon_table[hp->value[0]];                            \
+      ec.name = (char *) hp->key;                                       \
+      ec.pe_type = PERF_TYPE_RAW;                                       \
+      ec.pe_config = ev->event_code[0] | (ev->umask << 8)               \
+        | ((edge) << 18) | ((cmask) << 24);                             \
+      vec_add1 (set[group], ec);                                        \
+    }
+  foreach_perfmon_topdown_event;
+#undef _
+
+  for (i = 0; i < PERFMON_N_TOPDOWN_GROUPS; i++)
+    {
+      /* Level 1 is required, level 2 events are optional */
+      if (missing[0] || (missing[i] && i > 0))
+	vec_free (set[i]);
+      else
+	vec_add1 (*sets, set[i]);
+    }
+
+  return missing[0] == 0;
+}
+
 static clib_error_t *
 set_pmc_command_fn (vlib_main_t * vm,
 		    unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -207,49 +364,95 @@ set_pmc_command_fn (vlib_main_t * vm,
   int num_threads = 1 + vtm->n_threads;
   unformat_input_t _line_input, *line_input = &_line_input;
   perfmon_event_config_t ec;
+  perfmon_event_config_t *set, **sets = 0;
   f64 delay;
   u32 timeout_seconds;
   u32 deadman;
   int last_set;
-  clib_error_t *error;
-
-  vec_reset_length (pm->single_events_to_collect);
-  vec_reset_length (pm->paired_events_to_collect);
-  pm->ipc_event_index = ~0;
-  pm->mispredict_event_index = ~0;
+  int i;
+  clib_error_t *error = 0;
 
   if (!unformat_user (input, unformat_line_input, line_input))
     return clib_error_return (0, "counter names required...");
 
+  if (unformat (line_input, "off"))
+    {
+      unformat_free (line_input);
+      vlib_process_signal_event (pm->vlib_main, perfmon_periodic_node.index,
+				 PERFMON_STOP, 0);
+      return 0;
+    }
+
+  if (pm->state == PERFMON_STATE_RUNNING)
+    {
+      unformat_free (line_input);
+      return clib_error_return (0, "collection in progress, "
+				"use \"set pmc off\" to stop it");
+    }
+
+  for (i = 0; i < vec_len (pm->event_groups); i++)
+    vec_free (pm->event_groups[i]);
+  vec_reset_length (pm->event_groups);
+  pm->continuous = 0;
+
   clib_bitmap_zero (pm->thread_bitmap);
 
   while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
     {
+      set = 0;
       if (unformat (line_input, "timeout %u", &timeout_seconds))
 	pm->timeout_interval = (f64) timeout_seconds;
+      else if (unformat (line_input, "continuous"))
+	pm->continuous = 1;
       else if (unformat (line_input, "instructions-per-clock"))
 	{
 	  ec.name = "instructions";
 	  ec.pe_type = PERF_TYPE_HARDWARE;
 	  ec.pe_config = PERF_COUNT_HW_INSTRUCTIONS;
-	  pm->ipc_event_index = vec_len (pm->paired_events_to_collect);
-	  vec_add1 (pm->paired_events_to_collect, ec);
+	  vec_add1 (set, ec);
 	  ec.name = "cpu-cycles";
 	  ec.pe_type = PERF_TYPE_HARDWARE;
 	  ec.pe_config = PERF_COUNT_HW_CPU_CYCLES;
-	  vec_add1 (pm->paired_events_to_collect, ec);
+	  vec_add1 (set, ec);
 	}
       else if (unformat (line_input, "branch-mispredict-rate"))
 	{
 	  ec.name = "branch-misses";
 	  ec.pe_type = PERF_TYPE_HARDWARE;
 	  ec.pe_config = PERF_COUNT_HW_BRANCH_MISSES;
-	  pm->mispredict_event_index = vec_len (pm->paired_events_to_collect);
-	  vec_add1 (pm->paired_events_to_collect, ec);
+	  vec_add1 (set, ec);
 	  ec.name = "branches";
 	  ec.pe_type = PERF_TYPE_HARDWARE;
 	  ec.pe_config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
-	  vec_add1 (pm->paired_events_to_collect, ec);
+	  vec_add1 (set, ec);
+	}
+      else if (unformat (line_input, "node-metrics"))
+	{
+	  /* instructions-per-clock, misses and mispredicts per packet */
+#define _(type,event,str)                       \
+          ec.name = str;                        \
+          ec.pe_type = type;                    \
+          ec.pe_config = event;                 \
+          vec_add1 (set, ec);
+	  _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions");
+	  _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cpu-cycles");
+	  _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses");
+	  _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+	    "branches");
+	  _(PERF_TYPE_HW_CACHE, PERFMON_HW_CACHE_MISS
+	    (PERF_COUNT_HW_CACHE_L1D), "L1-dcache-load-misses");
+	  _(PERF_TYPE_HW_CACHE, PERFMON_HW_CACHE_MISS
+	    (PERF_COUNT_HW_CACHE_LL), "LLC-load-misses");
+#undef _
+	}
+      else if (unformat (line_input, "topdown"))
+	{
+	  if (!perfmon_add_topdown_events (pm, &sets))
+	    {
+	      error = clib_error_return (0, "top-down events not available "
+					 "on this processor");
+	      goto done;
+	    }
 	}
       else if (unformat (line_input, "threads %U",
 			 unformat_bitmap_list, &pm->thread_bitmap))
@@ -259,7 +462,7 @@ set_pmc_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "%U", unformat_processor_event, pm, &ec))
 	{
-	  vec_add1 (pm->single_events_to_collect, ec);
+	  vec_add1 (set, ec);
 	}
 #define _(type,event,str)                       \
       else if (unformat (line_input, str))      \
@@ -267,7 +470,7 @@ set_pmc_command_fn (vlib_main_t * vm,
           ec.name = str;                        \
           ec.pe_type = type;                    \
           ec.pe_config = event;                 \
-          vec_add1 (pm->single_events_to_collect, ec); \
+          vec_add1 (set, ec);                   \
         }
       foreach_perfmon_event
 #undef _
@@ -275,42 +478,45 @@ set_pmc_command_fn (vlib_main_t * vm,
 	{
 	  error = clib_error_return (0, "unknown input '%U'",
 				     format_unformat_error, line_input);
-	  unformat_free (line_input);
-	  return error;
+	  goto done;
 	}
-    }
 
-  unformat_free (line_input);
+      if (set)
+	vec_add1 (sets, set);
+    }
 
   last_set = clib_bitmap_last_set (pm->thread_bitmap);
   if (last_set != ~0 && last_set >= num_threads)
-    return clib_error_return (0, "thread %d does not exist", last_set);
-
-  /* Stick paired events at the front of the (unified) list */
-  if (vec_len (pm->paired_events_to_collect) > 0)
     {
-      perfmon_event_config_t *tmp;
-      /* first 2n events are pairs... */
-      vec_append (pm->paired_events_to_collect, pm->single_events_to_collect);
-      tmp = pm->single_events_to_collect;
-      pm->single_events_to_collect = pm->paired_events_to_collect;
-      pm->paired_events_to_collect = tmp;
+      error = clib_error_return (0, "thread %d does not exist", last_set);
+      goto done;
     }
 
-  if (vec_len (pm->single_events_to_collect) == 0)
-    return clib_error_return (0, "no events specified...");
+  perfmon_build_event_groups (pm, sets);
 
-  /* Figure out how long data collection will take */
-  delay =
-    ((f64) vec_len (pm->single_events_to_collect)) * pm->timeout_interval;
-  delay /= 2.0;			/* collect 2 stats at once */
+  if (vec_len (pm->event_groups) == 0)
+    {
+      error = clib_error_return (0, "no events specified...");
+      goto done;
+    }
 
-  vlib_cli_output (vm, "Start collection for %d events, wait %.2f seconds",
-		   vec_len (pm->single_events_to_collect), delay);
+  /* Figure out how long data collection will take */
+  delay = ((f64) vec_len (pm->event_groups)) * pm->timeout_interval;
 
   vlib_process_signal_event (pm->vlib_main, perfmon_periodic_node.index,
 			     PERFMON_START, 0);
 
+  if (pm->continuous)
+    {
+      vlib_cli_output (vm, "Start continuous collection of %d event groups, "
+		       "metrics updated every %.2f seconds",
+		       vec_len (pm->event_groups), delay);
+      goto done;
+    }
+
+  vlib_cli_output (vm, "Start collection for %d event groups, "
+		   "wait %.2f seconds", vec_len (pm->event_groups), delay);
+
   /* Coarse-grained wait */
   vlib_process_suspend (vm, delay);
 
@@ -327,19 +533,32 @@ set_pmc_command_fn (vlib_main_t * vm,
     }
 
   vlib_cli_output (vm, "Data collection complete...");
-  return 0;
+
+done:
+  unformat_free (line_input);
+  for (i = 0; i < vec_len (sets); i++)
+    vec_free (sets[i]);
+  vec_free (sets);
+  return error;
 }
 
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (set_pmc_command, static) =
 {
   .path = "set pmc",
-  .short_help = "set pmc [threads n,n1-n2] c1... [see \"show pmc events\"]",
+  .short_help = "set pmc [threads n,n1-n2] [timeout <secs>] [continuous] "
+  "c1... [see \"show pmc events\"] | set pmc off",
   .function = set_pmc_command_fn,
   .is_mp_safe = 1,
 };
 /* *INDENT-ON* */
 
+static char *perfmon_metric_names[] = {
+#define _(sym,str) str,
+  foreach_perfmon_metric
+#undef _
+};
+
 static int
 capture_name_sort (void *a1, void *a2)
 {
@@ -353,10 +572,13 @@ capture_name_sort (void *a1, void *a2)
 static u8 *
 format_capture (u8 * s, va_list * args)
 {
-  perfmon_main_t *pm = va_arg (*args, perfmon_main_t *);
+  perfmon_main_t *pm __attribute__ ((unused)) =
+    va_arg (*args, perfmon_main_t *);
   perfmon_capture_t *c = va_arg (*args, perfmon_capture_t *);
   int verbose __attribute__ ((unused)) = va_arg (*args, int);
   f64 ticks_per_pkt;
+  f64 metrics[PERFMON_N_METRICS];
+  u32 valid;
   int i;
 
   if (c == 0)
@@ -378,43 +600,6 @@ format_capture (u8 * s, va_list * args)
 	  name = (u8 *) "";
 	}
 
-      /* Deal with synthetic events right here */
-      if (i == pm->ipc_event_index)
-	{
-	  f64 ipc_rate;
-	  ASSERT ((i + 1) < vec_len (c->counter_names));
-
-	  if (c->counter_values[i + 1] > 0)
-	    ipc_rate = (f64) c->counter_values[i]
-	      / (f64) c->counter_values[i + 1];
-	  else
-	    ipc_rate = 0.0;
-
-	  s = format (s, "%-40s%+20s%+16llu%+16llu%+16.2e\n",
-		      name, "instructions-per-clock",
-		      c->counter_values[i],
-		      c->counter_values[i + 1], ipc_rate);
-	  name = (u8 *) "";
-	}
-
-      if (i == pm->mispredict_event_index)
-	{
-	  f64 mispredict_rate;
-	  ASSERT (i + 1 < vec_len (c->counter_names));
-
-	  if (c->counter_values[i + 1] > 0)
-	    mispredict_rate = (f64) c->counter_values[i]
-	      / (f64) c->counter_values[i + 1];
-	  else
-	    mispredict_rate = 0.0;
-
-	  s = format (s, "%-40s%+20s%+16llu%+16llu%+16.2e\n",
-		      name, "branch-mispredict-rate",
-		      c->counter_values[i],
-		      c->counter_values[i + 1], mispredict_rate);
-	  name = (u8 *) "";
-	}
-
       if (c->vectors_this_counter[i])
 	ticks_per_pkt =
 	  ((f64) c->counter_values[i]) / ((f64) c->vectors_this_counter[i]);
@@ -426,6 +611,13 @@ format_capture (u8 * s, va_list * args)
 		  c->counter_values[i],
 		  c->vectors_this_counter[i], ticks_per_pkt);
     }
+
+  /* And the metrics derived from the counters */
+  valid = perfmon_compute_metrics (c, metrics);
+  for (i = 0; i < PERFMON_N_METRICS; i++)
+    if (valid & (1 << i))
+      s = format (s, "\n%-40s%+20s%+16s%+16s%+16.2e", "",
+		  perfmon_metric_names[i], "", "", metrics[i]);
   return s;
 }
 
@@ -539,6 +731,9 @@ show_pmc_command_fn (vlib_main_t * vm,
       vlib_cli_output (vm, "Synthetic Events");
       vlib_cli_output (vm, "  instructions-per-clock");
       vlib_cli_output (vm, "  branch-mispredict-rate");
+      vlib_cli_output (vm, "  node-metrics");
+      vlib_cli_output (vm, "  topdown");
+      vlib_cli_output (vm, "Counters per event group: %d", pm->n_counters);
       if (pm->perfmon_table)
         vlib_cli_output (vm, "Processor Events %U",
                          format_processor_events, pm, verbose);
@@ -547,7 +742,12 @@ show_pmc_command_fn (vlib_main_t * vm,
 
   if (pm->state == PERFMON_STATE_RUNNING)
     {
-      vlib_cli_output (vm, "Data collection in progress...");
+      if (pm->continuous)
+	vlib_cli_output (vm, "Continuous collection in progress, "
+			 "metrics are in the stats segment under "
+			 "/perfmon/node/");
+      else
+	vlib_cli_output (vm, "Data collection in progress...");
       return 0;
     }
 
@@ -591,13 +791,33 @@ VLIB_CLI_COMMAND (show_pmc_command, static) =
 };
 /* *INDENT-ON* */
 
+void
+perfmon_clear_captures (perfmon_main_t * pm)
+{
+  perfmon_capture_t *c;
+
+  /* *INDENT-OFF* */
+  pool_foreach (c, pm->capture_pool,
+  ({
+    /* also the hash key */
+    vec_free (c->thread_and_node_name);
+    vec_free (c->counter_names);
+    vec_free (c->counter_values);
+    vec_free (c->vectors_this_counter);
+  }));
+  /* *INDENT-ON* */
+  pool_free (pm->capture_pool);
+
+  hash_free (pm->capture_by_thread_and_node_name);
+  pm->capture_by_thread_and_node_name =
+    hash_create_string (0, sizeof (uword));
+}
+
 static clib_error_t *
 clear_pmc_command_fn (vlib_main_t * vm,
 		      unformat_input_t * input, vlib_cli_command_t * cmd)
 {
   perfmon_main_t *pm = &perfmon_main;
-  u8 *key;
-  u32 *value;
 
   if (pm->state == PERFMON_STATE_RUNNING)
     {
@@ -605,17 +825,7 @@ clear_pmc_command_fn (vlib_main_t * vm,
       return 0;
     }
 
-  pool_free (pm->capture_pool);
-
-  /* *INDENT-OFF* */
-  hash_foreach_mem (key, value, pm->capture_by_thread_and_node_name,
-  ({
-    vec_free (key);
-  }));
-  /* *INDENT-ON* */
-  hash_free (pm->capture_by_thread_and_node_name);
-  pm->capture_by_thread_and_node_name =
-    hash_create_string (0, sizeof (uword));
+  perfmon_clear_captures (pm);
   return 0;
 }
 
@@ -28,6 +28,11 @@
 #include <linux/perf_event.h>
 #include <perfmon/perfmon_intel.h>
 
+/* Generic cache event config, counting read misses */
+#define PERFMON_HW_CACHE_MISS(cache)                                    \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8)                         \
+   | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
 #define foreach_perfmon_event                                           \
 _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cpu-cycles")           \
 _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions")       \
@@ -42,6 +47,10 @@ _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND,            \
 _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND,             \
   "stall-backend")                                                      \
 _(PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES, "ref-cpu-cycles")   \
+_(PERF_TYPE_HW_CACHE, PERFMON_HW_CACHE_MISS (PERF_COUNT_HW_CACHE_L1D),   \
+  "L1-dcache-load-misses")                                              \
+_(PERF_TYPE_HW_CACHE, PERFMON_HW_CACHE_MISS (PERF_COUNT_HW_CACHE_LL),    \
+  "LLC-load-misses")                                                    \
 _(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page-faults")         \
 _(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context-switches") \
 _(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "cpu-migrations")   \
@@ -56,6 +65,59 @@ typedef struct
   int pe_config;
 } perfmon_event_config_t;
 
+/*
+ * Intel top-down analysis events, from the processor event table:
+ * group, event name, counter mask, edge detect. Each group is collected
+ * along with cpu-cycles, which runs on a fixed counter.
+ */
+#define foreach_perfmon_topdown_event                                   \
+_(0, "idq_uops_not_delivered.core", 0, 0)                               \
+_(0, "uops_issued.any", 0, 0)                                           \
+_(0, "uops_retired.retire_slots", 0, 0)                                 \
+_(0, "int_misc.recovery_cycles", 1, 0)                                  \
+_(1, "idq_uops_not_delivered.cycles_0_uops_deliv.core", 4, 0)           \
+_(1, "br_misp_retired.all_branches", 0, 0)                              \
+_(1, "machine_clears.count", 1, 1)                                      \
+_(2, "cycle_activity.stalls_mem_any", 20, 0)                            \
+_(2, "cycle_activity.stalls_total", 4, 0)
+
+#define PERFMON_N_TOPDOWN_GROUPS 3
+
+/*
+ * Metrics derived from the counters of each node, published in the
+ * stats segment as /perfmon/node/<name>, per thread and node index,
+ * scaled by PERFMON_METRIC_SCALE.
+ */
+#define foreach_perfmon_metric                                          \
+_(IPC, "instructions-per-clock")                                        \
+_(MISPREDICT_RATE, "branch-mispredict-rate")                            \
+_(L1_MISSES, "l1-misses-per-pkt")                                       \
+_(LLC_MISSES, "llc-misses-per-pkt")                                     \
+_(MISPREDICTS, "branch-mispredicts-per-pkt")                            \
+_(FRONTEND_BOUND, "frontend-bound")                                     \
+_(BAD_SPECULATION, "bad-speculation")                                   \
+_(RETIRING, "retiring")                                                 \
+_(BACKEND_BOUND, "backend-bound")                                       \
+_(FRONTEND_LATENCY, "frontend-latency")                                 \
+_(FRONTEND_BANDWIDTH, "frontend-bandwidth")                             \
+_(BRANCH_MISPREDICTS, "branch-mispredicts")                             \
+_(MACHINE_CLEARS, "machine-clears")                                     \
+_(MEMORY_BOUND, "memory-bound")                                         \
+_(CORE_BOUND, "core-bound")
+
+typedef enum
+{
+#define _(sym,name) PERFMON_METRIC_##sym,
+  foreach_perfmon_metric
+#undef _
+    PERFMON_N_METRICS,
+} perfmon_metric_t;
+
+#define PERFMON_METRIC_SCALE 1000
+
+/* Most events collected at once, in one perf_event group */
+#define PERFMON_MAX_EVENTS_PER_GROUP 8
+
 typedef enum
 {
   PERFMON_STATE_OFF = 0,
@@ -65,11 +127,39 @@ typedef enum
 typedef struct
 {
   u8 *thread_and_node_name;
+  u32 thread_index;
+  u32 node_index;
   u8 **counter_names;
   u64 *counter_values;
   u64 *vectors_this_counter;
 } perfmon_capture_t;
 
+typedef struct
+{
+  u64 counters[PERFMON_MAX_EVENTS_PER_GROUP];
+  u64 vectors;
+} perfmon_node_counters_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Counter values when the current node was dispatched */
+  u64 counters[PERFMON_MAX_EVENTS_PER_GROUP];
+
+  /* Counter totals of the current event group, by node index */
+  perfmon_node_counters_t *node_counters;
+
+  /* Number of events of the group being counted */
+  int n_active;
+
+  /* Counter widths, rdpmc indices, mmap'ed pages and perf_event fds */
+  u64 counter_masks[PERFMON_MAX_EVENTS_PER_GROUP];
+  u32 rdpmc_indices[PERFMON_MAX_EVENTS_PER_GROUP];
+  u8 *perf_event_pages[PERFMON_MAX_EVENTS_PER_GROUP];
+  int pm_fds[PERFMON_MAX_EVENTS_PER_GROUP];
+} perfmon_thread_t;
+
 typedef struct
 {
   u8 *name;
@@ -96,29 +186,28 @@ typedef struct
 
   uword *pmc_event_by_name;
 
-  /* vector of single events to collect */
-  perfmon_event_config_t *single_events_to_collect;
+  /* Event groups to collect, one at a time */
+  perfmon_event_config_t **event_groups;
 
-  /* vector of paired events to collect */
-  perfmon_event_config_t *paired_events_to_collect;
+  /* Number of general purpose counters, per logical processor */
+  u32 n_counters;
 
-  /* Base indices of synthetic event tuples */
-  u32 ipc_event_index;
-  u32 mispredict_event_index;
-
-  /* Length of time to capture a single event */
+  /* Length of time to capture a single event group */
   f64 timeout_interval;
 
-  /* Current event (index) being collected */
-  u32 current_event;
-  int n_active;
-  u32 **rdpmc_indices;
-  /* mmap base / size of (mapped) struct perf_event_mmap_page */
-  u8 ***perf_event_pages;
+  /* Keep cycling through the event groups until stopped */
+  u8 continuous;
+
+  /* Current event group (index) being collected */
+  u32 current_group;
+  /* size of (mapped) struct perf_event_mmap_page */
   u32 page_size;
 
-  /* Current perf_event file descriptors, per thread */
-  int **pm_fds;
+  /* Per-thread collection state */
+  perfmon_thread_t *threads;
+
+  /* Derived per-node metrics, in the stats segment */
+  vlib_simple_counter_main_t metric_counters[PERFMON_N_METRICS];
 
   /* thread bitmap */
   uword *thread_bitmap;
@@ -137,8 +226,13 @@ extern perfmon_main_t perfmon_main;
 extern vlib_node_registration_t perfmon_periodic_node;
 uword *perfmon_parse_table (perfmon_main_t * pm, char *path, char *filename);
 
+void perfmon_clear_captures (perfmon_main_t * pm);
+u32 perfmon_compute_metrics (perfmon_capture_t * c, f64 * metrics);
+void perfmon_publish_metrics (perfmon_main_t * pm);
+
 /* Periodic function events */
 #define PERFMON_START 1
+#define PERFMON_STOP 2
 
 #endif /* __included_perfmon_h__ */
 
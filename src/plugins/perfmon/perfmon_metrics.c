@@ -0,0 +1,185 @@
+/*
+ * perfmon_metrics.c - per-node metrics derived from the perfmon counters
+ *
+ * Copyright (c) 2019 Cisco Systems and/or its affiliates
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <perfmon/perfmon.h>
+
+/* Issue slots per cycle, on the processors with top-down events */
+#define PERFMON_TOPDOWN_SLOTS_PER_CYCLE 4
+
+/*
+ * Per packet value of an event, over all the groups it was collected
+ * in. Event groups are collected one after the other, so only per
+ * packet values can be compared across groups.
+ */
+static int
+capture_per_packet (perfmon_capture_t * c, char *name, f64 * value)
+{
+  u64 count = 0, vectors = 0;
+  int i, found = 0;
+
+  for (i = 0; i < vec_len (c->counter_names); i++)
+    {
+      if (strcmp ((char *) c->counter_names[i], name))
+	continue;
+      count += c->counter_values[i];
+      vectors += c->vectors_this_counter[i];
+      found = 1;
+    }
+
+  /* Nodes which polled without packets only have ratios */
+  *value = vectors ? (f64) count / (f64) vectors : (f64) count;
+  return found;
+}
+
+static_always_inline f64
+clamp_fraction (f64 v)
+{
+  return clib_min (clib_max (v, 0.0), 1.0);
+}
+
+/*
+ * Compute the metrics which the capture has the events for, returns the
+ * bitmap of the valid metrics.
+ */
+u32
+perfmon_compute_metrics (perfmon_capture_t * c, f64 * metrics)
+{
+  f64 cycles, slots, v0, v1, v2, v3;
+  f64 frontend, bad_spec, retiring, backend, f;
+  u32 valid = 0;
+
+#define set_metric(m, v)                        \
+  do {                                          \
+    metrics[PERFMON_METRIC_##m] = (v);          \
+    valid |= 1 << PERFMON_METRIC_##m;           \
+  } while (0)
+
+  if (!capture_per_packet (c, "cpu-cycles", &cycles))
+    cycles = 0.0;
+  slots = PERFMON_TOPDOWN_SLOTS_PER_CYCLE * cycles;
+
+  if (cycles > 0.0 && capture_per_packet (c, "instructions", &v0))
+    set_metric (IPC, v0 / cycles);
+
+  if (capture_per_packet (c, "branch-misses", &v0))
+    {
+      set_metric (MISPREDICTS, v0);
+      if (capture_per_packet (c, "branches", &v1) && v1 > 0.0)
+	set_metric (MISPREDICT_RATE, v0 / v1);
+    }
+
+  if (capture_per_packet (c, "L1-dcache-load-misses", &v0))
+    set_metric (L1_MISSES, v0);
+
+  if (capture_per_packet (c, "LLC-load-misses", &v0))
+    set_metric (LLC_MISSES, v0);
+
+  /* Top-down level 1, as fractions of the issue slots */
+  if (slots == 0.0
+      || !capture_per_packet (c, "idq_uops_not_delivered.core", &v0)
+      || !capture_per_packet (c, "uops_issued.any", &v1)
+      || !capture_per_packet (c, "uops_retired.retire_slots", &v2)
+      || !capture_per_packet (c, "int_misc.recovery_cycles", &v3))
+    return valid;
+
+  frontend = clamp_fraction (v0 / slots);
+  bad_spec = clamp_fraction ((v1 - v2 + PERFMON_TOPDOWN_SLOTS_PER_CYCLE * v3)
+			     / slots);
+  retiring = clamp_fraction (v2 / slots);
+  backend = clamp_fraction (1.0 - frontend - bad_spec - retiring);
+
+  set_metric (FRONTEND_BOUND, frontend);
+  set_metric (BAD_SPECULATION, bad_spec);
+  set_metric (RETIRING, retiring);
+  set_metric (BACKEND_BOUND, backend);
+
+  /* Level 2: split each level 1 category in two */
+  if (capture_per_packet
+      (c, "idq_uops_not_delivered.cycles_0_uops_deliv.core", &v0))
+    {
+      f = clib_min (v0 / cycles, frontend);
+      set_metric (FRONTEND_LATENCY, f);
+      set_metric (FRONTEND_BANDWIDTH, frontend - f);
+    }
+
+  if (capture_per_packet (c, "br_misp_retired.all_branches", &v0)
+      && capture_per_packet (c, "machine_clears.count", &v1)
+      && v0 + v1 > 0.0)
+    {
+      f = bad_spec * v0 / (v0 + v1);
+      set_metric (BRANCH_MISPREDICTS, f);
+      set_metric (MACHINE_CLEARS, bad_spec - f);
+    }
+
+  if (capture_per_packet (c, "cycle_activity.stalls_mem_any", &v0)
+      && capture_per_packet (c, "cycle_activity.stalls_total", &v1)
+      && v1 > 0.0)
+    {
+      f = backend * clamp_fraction (v0 / v1);
+      set_metric (MEMORY_BOUND, f);
+      set_metric (CORE_BOUND, backend - f);
+    }
+
+#undef set_metric
+
+  return valid;
+}
+
+/*
+ * Publish the metrics of the captures in the stats segment, by thread
+ * and node index. Nodes which did not run read 0.
+ */
+void
+perfmon_publish_metrics (perfmon_main_t * pm)
+{
+  vlib_main_t *vm = pm->vlib_main;
+  u32 n_nodes = vec_len (vm->node_main.nodes);
+  vlib_simple_counter_main_t *cm;
+  perfmon_capture_t *c;
+  f64 metrics[PERFMON_N_METRICS];
+  u32 valid;
+  int i, j;
+
+  for (i = 0; i < PERFMON_N_METRICS; i++)
+    {
+      cm = &pm->metric_counters[i];
+      vlib_validate_simple_counter (cm, n_nodes - 1);
+      for (j = 0; j < n_nodes; j++)
+	vlib_zero_simple_counter (cm, j);
+    }
+
+  /* *INDENT-OFF* */
+  pool_foreach (c, pm->capture_pool,
+  ({
+    valid = perfmon_compute_metrics (c, metrics);
+    for (i = 0; i < PERFMON_N_METRICS; i++)
+      if (valid & (1 << i))
+        vlib_set_simple_counter (&pm->metric_counters[i], c->thread_index,
+                                 c->node_index,
+                                 metrics[i] * PERFMON_METRIC_SCALE);
+  }));
+  /* *INDENT-ON* */
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -32,105 +32,135 @@ perf_event_open (struct perf_event_attr *hw_event, pid_t pid, int cpu,
   return ret;
 }
 
-static void
-read_current_perf_counters (vlib_main_t * vm, u64 * c0, u64 * c1)
+static int
+read_current_perf_counters (vlib_main_t * vm, perfmon_thread_t * pt,
+			    u64 * c)
 {
   int i;
-  u64 *cc;
-  perfmon_main_t *pm = &perfmon_main;
-  uword my_thread_index = vm->thread_index;
-
-  *c0 = *c1 = 0;
 
-  for (i = 0; i < pm->n_active; i++)
+  for (i = 0; i < pt->n_active; i++)
     {
-      cc = (i == 0) ? c0 : c1;
-      if (pm->rdpmc_indices[i][my_thread_index] != ~0)
-	*cc = clib_rdpmc ((int) pm->rdpmc_indices[i][my_thread_index]);
+      if (pt->rdpmc_indices[i] != ~0)
+	c[i] = clib_rdpmc ((int) pt->rdpmc_indices[i]);
       else
 	{
 	  u64 sw_value;
-	  if (read (pm->pm_fds[i][my_thread_index], &sw_value,
+	  if (read (pt->pm_fds[i], &sw_value,
 		    sizeof (sw_value)) != sizeof (sw_value))
 	    {
 	      clib_unix_warning
 		("counter read failed, disable collection...");
 	      vm->vlib_node_runtime_perf_counter_cb = 0;
-	      return;
+	      return -1;
 	    }
-	  *cc = sw_value;
+	  c[i] = sw_value;
 	}
     }
+  return 0;
+}
+
+/* Called around each node dispatch, accumulates the per-node counters */
+static void
+perfmon_node_dispatch_cb (vlib_main_t * vm, vlib_node_runtime_t * node,
+			  uword n_vectors, int is_after)
+{
+  perfmon_main_t *pm = &perfmon_main;
+  perfmon_thread_t *pt = vec_elt_at_index (pm->threads, vm->thread_index);
+  perfmon_node_counters_t *nc;
+  u64 c[PERFMON_MAX_EVENTS_PER_GROUP];
+  int i;
+
+  if (is_after == 0)
+    {
+      read_current_perf_counters (vm, pt, pt->counters);
+      return;
+    }
+
+  if (read_current_perf_counters (vm, pt, c))
+    return;
+
+  /* A node created since collection started */
+  if (PREDICT_FALSE (node->node_index >= vec_len (pt->node_counters)))
+    return;
+
+  nc = vec_elt_at_index (pt->node_counters, node->node_index);
+  for (i = 0; i < pt->n_active; i++)
+    nc->counters[i] += (c[i] - pt->counters[i]) & pt->counter_masks[i];
+  nc->vectors += n_vectors;
 }
 
 static void
 clear_counters (perfmon_main_t * pm)
 {
-  int i, j;
-  vlib_main_t *vm = pm->vlib_main;
-  vlib_main_t *stat_vm;
-  vlib_node_main_t *nm;
-  vlib_node_t *n;
+  perfmon_thread_t *pt;
+
+  vec_foreach (pt, pm->threads)
+    clib_memset (pt->node_counters, 0, vec_bytes (pt->node_counters));
+}
+
+static void
+disable_events (perfmon_main_t * pm)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  perfmon_thread_t *pt = vec_elt_at_index (pm->threads, vm->thread_index);
+  int i;
+
+  /* Stop main loop collection */
+  vm->vlib_node_runtime_perf_counter_cb = 0;
 
-  vlib_worker_thread_barrier_sync (vm);
+  /* The group leader stops the whole group */
+  if (pt->n_active && pt->pm_fds[0])
+    if (ioctl (pt->pm_fds[0], PERF_EVENT_IOC_DISABLE,
+	       PERF_IOC_FLAG_GROUP) < 0)
+      clib_unix_warning ("disable ioctl");
 
-  for (j = 0; j < vec_len (vlib_mains); j++)
+  for (i = pt->n_active - 1; i >= 0; i--)
     {
-      stat_vm = vlib_mains[j];
-      if (stat_vm == 0)
+      if (pt->pm_fds[i] == 0)
 	continue;
 
-      nm = &stat_vm->node_main;
-
-      /* Clear the node runtime perfmon counters */
-      for (i = 0; i < vec_len (nm->nodes); i++)
-	{
-	  n = nm->nodes[i];
-	  vlib_node_sync_stats (stat_vm, n);
-	}
+      if (pt->perf_event_pages[i])
+	if (munmap (pt->perf_event_pages[i], pm->page_size) < 0)
+	  clib_unix_warning ("munmap");
 
-      /* And clear the node perfmon counters */
-      for (i = 0; i < vec_len (nm->nodes); i++)
-	{
-	  n = nm->nodes[i];
-	  n->stats_total.perf_counter0_ticks = 0;
-	  n->stats_total.perf_counter1_ticks = 0;
-	  n->stats_total.perf_counter_vectors = 0;
-	  n->stats_last_clear.perf_counter0_ticks = 0;
-	  n->stats_last_clear.perf_counter1_ticks = 0;
-	  n->stats_last_clear.perf_counter_vectors = 0;
-	}
+      (void) close (pt->pm_fds[i]);
+      pt->pm_fds[i] = 0;
+      pt->perf_event_pages[i] = 0;
     }
-  vlib_worker_thread_barrier_release (vm);
+  pt->n_active = 0;
 }
 
 static void
 enable_current_events (perfmon_main_t * pm)
 {
   struct perf_event_attr pe;
-  int fd;
+  int fd, group_fd = -1;
   struct perf_event_mmap_page *p = 0;
-  perfmon_event_config_t *c;
+  perfmon_event_config_t *group, *c;
   vlib_main_t *vm = vlib_get_main ();
-  u32 my_thread_index = vm->thread_index;
+  perfmon_thread_t *pt = vec_elt_at_index (pm->threads, vm->thread_index);
   u32 index;
-  int i, limit = 1;
+  int i, limit;
   int cpu;
 
-  if ((pm->current_event + 1) < vec_len (pm->single_events_to_collect))
-    limit = 2;
+  group = pm->event_groups[pm->current_group];
+  limit = vec_len (group);
+  vec_validate (pt->node_counters, vec_len (vm->node_main.nodes) - 1);
 
   for (i = 0; i < limit; i++)
     {
-      c = vec_elt_at_index (pm->single_events_to_collect,
-			    pm->current_event + i);
+      c = vec_elt_at_index (group, i);
 
       memset (&pe, 0, sizeof (struct perf_event_attr));
       pe.type = c->pe_type;
       pe.size = sizeof (struct perf_event_attr);
       pe.config = c->pe_config;
-      pe.disabled = 1;
-      pe.pinned = 1;
+      /*
+       * The events form one group, which the kernel always schedules
+       * as a whole: the leader starts and stops the members.
+       */
+      pe.disabled = (i == 0);
+      pe.pinned = (i == 0);
       /*
        * Note: excluding the kernel makes the
        * (software) context-switch counter read 0...
@@ -144,13 +174,15 @@ enable_current_events (perfmon_main_t * pm)
 
       cpu = vm->cpu_id;
 
-      fd = perf_event_open (&pe, 0, cpu, -1, 0);
+      fd = perf_event_open (&pe, 0, cpu, group_fd, 0);
       if (fd == -1)
 	{
 	  clib_unix_warning ("event open: type %d config %d", c->pe_type,
 			     c->pe_config);
-	  return;
+	  goto error;
 	}
+      if (i == 0)
+	group_fd = fd;
 
       if (pe.type != PERF_TYPE_SOFTWARE)
 	{
@@ -159,21 +191,21 @@ enable_current_events (perfmon_main_t * pm)
 	    {
 	      clib_unix_warning ("mmap");
 	      close (fd);
-	      return;
+	      goto error;
 	    }
 	}
       else
 	p = 0;
 
-      if (ioctl (fd, PERF_EVENT_IOC_RESET, 0) < 0)
-	clib_unix_warning ("reset ioctl");
+      pt->perf_event_pages[i] = (void *) p;
+      pt->pm_fds[i] = fd;
+    }
 
-      if (ioctl (fd, PERF_EVENT_IOC_ENABLE, 0) < 0)
-	clib_unix_warning ("enable ioctl");
+  if (ioctl (group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) < 0)
+    clib_unix_warning ("reset ioctl");
 
-      pm->perf_event_pages[i][my_thread_index] = (void *) p;
-      pm->pm_fds[i][my_thread_index] = fd;
-    }
+  if (ioctl (group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0)
+    clib_unix_warning ("enable ioctl");
 
   /*
    * Hardware events must be all opened and enabled before aquiring
@@ -181,9 +213,7 @@ enable_current_events (perfmon_main_t * pm)
    */
   for (i = 0; i < limit; i++)
     {
-      p =
-	(struct perf_event_mmap_page *)
-	pm->perf_event_pages[i][my_thread_index];
+      p = (struct perf_event_mmap_page *) pt->perf_event_pages[i];
 
       /*
        * Software event counters - and others not capable of being
@@ -191,45 +221,29 @@ enable_current_events (perfmon_main_t * pm)
        * by system calls.
        */
       if (p == 0 || p->cap_user_rdpmc == 0)
-	index = ~0;
+	{
+	  index = ~0;
+	  pt->counter_masks[i] = ~0ULL;
+	}
       else
-	index = p->index - 1;
+	{
+	  index = p->index - 1;
+	  /* rdpmc returns the counter width, which wraps */
+	  pt->counter_masks[i] = p->pmc_width < 64 ?
+	    (1ULL << p->pmc_width) - 1 : ~0ULL;
+	}
 
-      pm->rdpmc_indices[i][my_thread_index] = index;
+      pt->rdpmc_indices[i] = index;
     }
 
-  pm->n_active = i;
+  pt->n_active = limit;
   /* Enable the main loop counter snapshot mechanism */
-  vm->vlib_node_runtime_perf_counter_cb = read_current_perf_counters;
-}
+  vm->vlib_node_runtime_perf_counter_cb = perfmon_node_dispatch_cb;
+  return;
 
-static void
-disable_events (perfmon_main_t * pm)
-{
-  vlib_main_t *vm = vlib_get_main ();
-  u32 my_thread_index = vm->thread_index;
-  int i;
-
-  /* Stop main loop collection */
-  vm->vlib_node_runtime_perf_counter_cb = 0;
-
-  for (i = 0; i < pm->n_active; i++)
-    {
-      if (pm->pm_fds[i][my_thread_index] == 0)
-	continue;
-
-      if (ioctl (pm->pm_fds[i][my_thread_index], PERF_EVENT_IOC_DISABLE, 0) <
-	  0)
-	clib_unix_warning ("disable ioctl");
-
-      if (pm->perf_event_pages[i][my_thread_index])
-	if (munmap (pm->perf_event_pages[i][my_thread_index],
-		    pm->page_size) < 0)
-	  clib_unix_warning ("munmap");
-
-      (void) close (pm->pm_fds[i][my_thread_index]);
-      pm->pm_fds[i][my_thread_index] = 0;
-    }
+error:
+  pt->n_active = i;
+  disable_events (pm);
 }
 
 static void
@@ -250,25 +264,14 @@ worker_thread_stop_event (vlib_main_t * vm)
 }
 
 static void
-start_event (perfmon_main_t * pm, f64 now, uword event_data)
+start_current_events (perfmon_main_t * pm)
 {
   int i;
-  int last_set;
-  int all = 0;
-  pm->current_event = 0;
-
-  if (vec_len (pm->single_events_to_collect) == 0)
-    {
-      pm->state = PERFMON_STATE_OFF;
-      return;
-    }
+  int last_set, all;
 
   last_set = clib_bitmap_last_set (pm->thread_bitmap);
   all = (last_set == ~0);
 
-  pm->state = PERFMON_STATE_RUNNING;
-  clear_counters (pm);
-
   /* Start collection on thread 0? */
   if (all || clib_bitmap_get (pm->thread_bitmap, 0))
     {
@@ -288,145 +291,8 @@ start_event (perfmon_main_t * pm, f64 now, uword event_data)
     }
 }
 
-void
-scrape_and_clear_counters (perfmon_main_t * pm)
-{
-  int i, j, k;
-  vlib_main_t *vm = pm->vlib_main;
-  vlib_main_t *stat_vm;
-  vlib_node_main_t *nm;
-  vlib_node_t ***node_dups = 0;
-  vlib_node_t **nodes;
-  vlib_node_t *n;
-  perfmon_capture_t *c;
-  perfmon_event_config_t *current_event;
-  uword *p;
-  u8 *counter_name;
-  u64 vectors_this_counter;
-
-  /* snapshoot the nodes, including pm counters */
-  vlib_worker_thread_barrier_sync (vm);
-
-  for (j = 0; j < vec_len (vlib_mains); j++)
-    {
-      stat_vm = vlib_mains[j];
-      if (stat_vm == 0)
-	continue;
-
-      nm = &stat_vm->node_main;
-
-      for (i = 0; i < vec_len (nm->nodes); i++)
-	{
-	  n = nm->nodes[i];
-	  vlib_node_sync_stats (stat_vm, n);
-	}
-
-      nodes = 0;
-      vec_validate (nodes, vec_len (nm->nodes) - 1);
-      vec_add1 (node_dups, nodes);
-
-      /* Snapshoot and clear the per-node perfmon counters */
-      for (i = 0; i < vec_len (nm->nodes); i++)
-	{
-	  n = nm->nodes[i];
-	  nodes[i] = clib_mem_alloc (sizeof (*n));
-	  clib_memcpy_fast (nodes[i], n, sizeof (*n));
-	  n->stats_total.perf_counter0_ticks = 0;
-	  n->stats_total.perf_counter1_ticks = 0;
-	  n->stats_total.perf_counter_vectors = 0;
-	  n->stats_last_clear.perf_counter0_ticks = 0;
-	  n->stats_last_clear.perf_counter1_ticks = 0;
-	  n->stats_last_clear.perf_counter_vectors = 0;
-	}
-    }
-
-  vlib_worker_thread_barrier_release (vm);
-
-  for (j = 0; j < vec_len (vlib_mains); j++)
-    {
-      stat_vm = vlib_mains[j];
-      if (stat_vm == 0)
-	continue;
-
-      nodes = node_dups[j];
-
-      for (i = 0; i < vec_len (nodes); i++)
-	{
-	  u8 *capture_name;
-
-	  n = nodes[i];
-
-	  if (n->stats_total.perf_counter0_ticks == 0 &&
-	      n->stats_total.perf_counter1_ticks == 0)
-	    goto skip_this_node;
-
-	  for (k = 0; k < 2; k++)
-	    {
-	      u64 counter_value, counter_last_clear;
-
-	      /*
-	       * We collect 2 counters at once, except for the
-	       * last counter when the user asks for an odd number of
-	       * counters
-	       */
-	      if ((pm->current_event + k)
-		  >= vec_len (pm->single_events_to_collect))
-		break;
-
-	      if (k == 0)
-		{
-		  counter_value = n->stats_total.perf_counter0_ticks;
-		  counter_last_clear =
-		    n->stats_last_clear.perf_counter0_ticks;
-		}
-	      else
-		{
-		  counter_value = n->stats_total.perf_counter1_ticks;
-		  counter_last_clear =
-		    n->stats_last_clear.perf_counter1_ticks;
-		}
-
-	      capture_name = format (0, "t%d-%v%c", j, n->name, 0);
-
-	      p = hash_get_mem (pm->capture_by_thread_and_node_name,
-				capture_name);
-
-	      if (p == 0)
-		{
-		  pool_get (pm->capture_pool, c);
-		  memset (c, 0, sizeof (*c));
-		  c->thread_and_node_name = capture_name;
-		  hash_set_mem (pm->capture_by_thread_and_node_name,
-				capture_name, c - pm->capture_pool);
-		}
-	      else
-		{
-		  c = pool_elt_at_index (pm->capture_pool, p[0]);
-		  vec_free (capture_name);
-		}
-
-	      /* Snapshoot counters, etc. into the capture */
-	      current_event = pm->single_events_to_collect
-		+ pm->current_event + k;
-	      counter_name = (u8 *) current_event->name;
-	      vectors_this_counter = n->stats_total.perf_counter_vectors -
-		n->stats_last_clear.perf_counter_vectors;
-
-	      vec_add1 (c->counter_names, counter_name);
-	      vec_add1 (c->counter_values,
-			counter_value - counter_last_clear);
-	      vec_add1 (c->vectors_this_counter, vectors_this_counter);
-	    }
-	skip_this_node:
-	  clib_mem_free (n);
-	}
-      vec_free (nodes);
-    }
-  vec_free (node_dups);
-}
-
 static void
-handle_timeout (vlib_main_t * vm, perfmon_main_t * pm, f64 now)
+stop_current_events (vlib_main_t * vm, perfmon_main_t * pm)
 {
   int i;
   int last_set, all;
@@ -466,29 +332,130 @@ handle_timeout (vlib_main_t * vm, perfmon_main_t * pm, f64 now)
 	    }
 	}
     }
-  scrape_and_clear_counters (pm);
-  pm->current_event += pm->n_active;
-  if (pm->current_event >= vec_len (pm->single_events_to_collect))
+}
+
+static void
+start_event (perfmon_main_t * pm, f64 now, uword event_data)
+{
+  pm->current_group = 0;
+
+  if (vec_len (pm->event_groups) == 0)
     {
-      pm->current_event = 0;
       pm->state = PERFMON_STATE_OFF;
       return;
     }
 
-  if (all || clib_bitmap_get (pm->thread_bitmap, 0))
-    enable_current_events (pm);
+  vec_validate_aligned (pm->threads, vec_len (vlib_mains) - 1,
+			CLIB_CACHE_LINE_BYTES);
 
-  /* And also on worker threads */
-  for (i = 1; i < vec_len (vlib_mains); i++)
+  pm->state = PERFMON_STATE_RUNNING;
+  perfmon_clear_captures (pm);
+  clear_counters (pm);
+  start_current_events (pm);
+}
+
+/*
+ * Snapshoot the per-node counters of the current event group into the
+ * captures. Collection is stopped on all threads.
+ */
+void
+scrape_and_clear_counters (perfmon_main_t * pm)
+{
+  int i, j, k;
+  vlib_main_t *vm = pm->vlib_main;
+  perfmon_event_config_t *group = pm->event_groups[pm->current_group];
+  perfmon_thread_t *pt;
+  perfmon_node_counters_t *nc;
+  vlib_node_t *n;
+  perfmon_capture_t *c;
+  uword *p;
+  u8 *capture_name;
+
+  for (j = 0; j < vec_len (pm->threads); j++)
     {
-      if (vlib_mains[i] == 0)
-	continue;
-      if (all || clib_bitmap_get (pm->thread_bitmap, i))
-	vlib_mains[i]->worker_thread_main_loop_callback = (void *)
-	  worker_thread_start_event;
+      pt = vec_elt_at_index (pm->threads, j);
+
+      for (i = 0; i < vec_len (pt->node_counters); i++)
+	{
+	  nc = vec_elt_at_index (pt->node_counters, i);
+
+	  for (k = 0; k < vec_len (group); k++)
+	    if (nc->counters[k])
+	      break;
+
+	  if (k == vec_len (group) && nc->vectors == 0)
+	    continue;
+
+	  n = vlib_get_node (vm, i);
+	  capture_name = format (0, "t%d-%v%c", j, n->name, 0);
+
+	  p = hash_get_mem (pm->capture_by_thread_and_node_name,
+			    capture_name);
+
+	  if (p == 0)
+	    {
+	      pool_get (pm->capture_pool, c);
+	      memset (c, 0, sizeof (*c));
+	      c->thread_and_node_name = capture_name;
+	      c->thread_index = j;
+	      c->node_index = i;
+	      hash_set_mem (pm->capture_by_thread_and_node_name,
+			    capture_name, c - pm->capture_pool);
+	    }
+	  else
+	    {
+	      c = pool_elt_at_index (pm->capture_pool, p[0]);
+	      vec_free (capture_name);
+	    }
+
+	  /* Snapshoot counters, etc. into the capture */
+	  for (k = 0; k < vec_len (group); k++)
+	    {
+	      vec_add1 (c->counter_names, (u8 *) group[k].name);
+	      vec_add1 (c->counter_values, nc->counters[k]);
+	      vec_add1 (c->vectors_this_counter, nc->vectors);
+	    }
+
+	  memset (nc, 0, sizeof (*nc));
+	}
     }
 }
 
+static void
+handle_timeout (vlib_main_t * vm, perfmon_main_t * pm, f64 now)
+{
+  stop_current_events (vm, pm);
+  scrape_and_clear_counters (pm);
+
+  pm->current_group++;
+  if (pm->current_group >= vec_len (pm->event_groups))
+    {
+      /* Every group was collected once, publish the derived metrics */
+      perfmon_publish_metrics (pm);
+      pm->current_group = 0;
+
+      if (pm->continuous == 0)
+	{
+	  pm->state = PERFMON_STATE_OFF;
+	  return;
+	}
+      perfmon_clear_captures (pm);
+    }
+
+  start_current_events (pm);
+}
+
+static void
+stop_event (vlib_main_t * vm, perfmon_main_t * pm)
+{
+  if (pm->state != PERFMON_STATE_RUNNING)
+    return;
+
+  stop_current_events (vm, pm);
+  clear_counters (pm);
+  pm->state = PERFMON_STATE_OFF;
+}
+
 static uword
 perfmon_periodic_process (vlib_main_t * vm,
 			  vlib_node_runtime_t * rt, vlib_frame_t * f)
@@ -517,6 +484,10 @@ perfmon_periodic_process (vlib_main_t * vm,
 	    start_event (pm, now, event_data[i]);
 	  break;
 
+	case PERFMON_STOP:
+	  stop_event (vm, pm);
+	  break;
+
 	  /* Handle timeout */
 	case ~0:
 	  handle_timeout (vm, pm, now);
@@ -153,14 +153,17 @@ rdma_device_input_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_buffer_t *b;
       rdma_input_trace_t *tr;
       b = vlib_get_buffer (vm, bi[0]);
-      vlib_trace_buffer (vm, node, rd->per_interface_next_index, b,
-			 /* follow_chain */ 0);
-      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-      tr->next_index = rd->per_interface_next_index;
-      tr->hw_if_index = rd->hw_if_index;
+      if (PREDICT_TRUE (vlib_trace_buffer (vm, node,
+					   rd->per_interface_next_index, b,
+					   /* follow_chain */ 0)))
+	{
+	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+	  tr->next_index = rd->per_interface_next_index;
+	  tr->hw_if_index = rd->hw_if_index;
+	  n_trace--;
+	}
 
       /* next */
-      n_trace--;
       n_left--;
       bi++;
       i++;
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+
+typedef struct
+{
+  /* callback run order, one entry per call */
+  u32 *calls;
+  /* a callback deferring another one */
+  int n_nested;
+} grace_period_test_main_t;
+
+static grace_period_test_main_t grace_period_test_main;
+
+static void
+grace_period_test_callback (void *arg)
+{
+  grace_period_test_main_t *gtm = &grace_period_test_main;
+
+  vec_add1 (gtm->calls, pointer_to_uword (arg));
+}
+
+static void
+grace_period_test_nested_callback (void *arg)
+{
+  grace_period_test_main_t *gtm = &grace_period_test_main;
+
+  if (gtm->n_nested++ == 0)
+    vlib_call_after_grace_period (vlib_get_main (),
+				  grace_period_test_nested_callback, arg);
+  else
+    grace_period_test_callback (arg);
+}
+
+/* Let the main loop run the callbacks, for at most a second */
+static int
+grace_period_test_wait_calls (vlib_main_t * vm, u32 n_calls)
+{
+  grace_period_test_main_t *gtm = &grace_period_test_main;
+  int i;
+
+  for (i = 0; i < 1000 && vec_len (gtm->calls) < n_calls; i++)
+    vlib_process_suspend (vm, 1e-3);
+  return vec_len (gtm->calls) == n_calls;
+}
+
+/* Every worker went through a quiescent state since the epoch started */
+static int
+grace_period_test_quiescent (u64 epoch)
+{
+  int i;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    if (vlib_mains[i] && vlib_worker_threads[i].quiescent_epoch < epoch)
+      return 0;
+  return 1;
+}
+
+static clib_error_t *
+test_grace_period_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  grace_period_test_main_t *gtm = &grace_period_test_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  clib_error_t *error = 0;
+  u64 epoch;
+
+  vec_reset_length (gtm->calls);
+  gtm->n_nested = 0;
+
+  /* Callbacks are deferred to the main loop, and run in order */
+  vlib_call_after_grace_period (vm, grace_period_test_callback,
+				uword_to_pointer (1, void *));
+  vlib_call_after_grace_period (vm, grace_period_test_callback,
+				uword_to_pointer (2, void *));
+  epoch = tm->grace_period_epoch;
+  if (vec_len (gtm->calls))
+    {
+      error = clib_error_return (0, "callback run before the grace period");
+      goto done;
+    }
+  if (!grace_period_test_wait_calls (vm, 2))
+    {
+      error = clib_error_return (0, "%d of 2 callbacks run",
+				 vec_len (gtm->calls));
+      goto done;
+    }
+  if (gtm->calls[0] != 1 || gtm->calls[1] != 2)
+    {
+      error = clib_error_return (0, "callbacks run out of order");
+      goto done;
+    }
+  if (!grace_period_test_quiescent (epoch))
+    {
+      error = clib_error_return (0, "callback run before a worker was "
+				 "quiescent");
+      goto done;
+    }
+
+  /* A callback may defer more work */
+  vlib_call_after_grace_period (vm, grace_period_test_nested_callback,
+				uword_to_pointer (3, void *));
+  if (!grace_period_test_wait_calls (vm, 3) || gtm->n_nested != 2)
+    {
+      error = clib_error_return (0, "deferred callback not run");
+      goto done;
+    }
+
+  /* The synchronous variant returns once every worker is quiescent */
+  epoch = tm->grace_period_epoch;
+  vlib_wait_for_grace_period (vm);
+  if (tm->n_vlib_mains > 1 && !grace_period_test_quiescent (epoch + 1))
+    {
+      error = clib_error_return (0, "returned before the grace period");
+      goto done;
+    }
+
+  /* With the workers at the barrier there is nothing to wait for */
+  vlib_worker_thread_barrier_sync (vm);
+  vlib_wait_for_grace_period (vm);
+  vlib_worker_thread_barrier_release (vm);
+
+  vlib_cli_output (vm, "grace period test passed, %d workers",
+		   tm->n_vlib_mains - 1);
+
+done:
+  vec_free (gtm->calls);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_grace_period_command, static) =
+{
+  .path = "test grace-period",
+  .short_help = "test grace-period",
+  .function = test_grace_period_command_fn,
+  /* workers keep running, to go through quiescent states */
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
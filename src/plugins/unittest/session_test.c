@@ -1870,6 +1870,120 @@ session_test_mq (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+static int
+session_test_lookup (vlib_main_t * vm, unformat_input_t * input)
+{
+  u32 n_sessions = 1 << 20, n_lookups = 1 << 24, thread_index;
+  transport_connection_t *tcs[VLIB_FRAME_SIZE];
+  u32 fib_indices[VLIB_FRAME_SIZE], i, j, seed;
+  session_kv4_t *kvs = 0, batch[VLIB_FRAME_SIZE];
+  clib_bihash_16_8_t saved_hash;
+  u8 results[VLIB_FRAME_SIZE];
+  u64 start, single_cycles, batch_cycles;
+  u32 n_bad_single = 0, n_bad_batch = 0;
+  int verbose = 0;
+  ip4_address_t lcl, rmt;
+  session_table_t *st;
+  u16 lcl_port, rmt_port;
+  u8 result;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else if (unformat (input, "sessions %u", &n_sessions))
+	;
+      else if (unformat (input, "lookups %u", &n_lookups))
+	;
+      else
+	{
+	  vlib_cli_output (vm, "parse error: '%U'", format_unformat_error,
+			   input);
+	  return -1;
+	}
+    }
+
+  /*
+   * Benchmark against a private, appropriately sized, established sessions
+   * table. Table values point to a different thread so lookups stop at the
+   * established table and only its cost is measured.
+   */
+  thread_index = vm->thread_index;
+  st = session_table_get (session_lookup_get_index_for_fib
+			  (FIB_PROTOCOL_IP4, 0));
+  SESSION_TEST ((st != 0), "default ip4 session table should exist");
+  saved_hash = st->v4_session_hash;
+  clib_bihash_init_16_8 (&st->v4_session_hash, "v4 session lookup test",
+			 clib_max (n_sessions >> 2, 1),
+			 clib_max ((u64) n_sessions << 7, 64 << 20));
+
+  seed = 0xdeadbeef;
+  vec_validate (kvs, n_sessions - 1);
+  for (i = 0; i < n_sessions; i++)
+    {
+      lcl.as_u32 = clib_host_to_net_u32 (0x0a000000 | (i & 0xffff));
+      rmt.as_u32 = random_u32 (&seed);
+      lcl_port = random_u32 (&seed);
+      rmt_port = i >> 16;
+      make_v4_ss_kv (&kvs[i], &lcl, &rmt, lcl_port, rmt_port,
+		     TRANSPORT_PROTO_TCP);
+      kvs[i].value = (u64) (thread_index + 1) << 32 | i;
+      clib_bihash_add_del_16_8 (&st->v4_session_hash, &kvs[i], 1);
+    }
+  if (verbose)
+    vlib_cli_output (vm, "%U", format_bihash_16_8, &st->v4_session_hash,
+		     0 /* verbose */ );
+
+  /* One lookup at a time */
+  seed = 0xdeadbeef;
+  start = clib_cpu_time_now ();
+  for (i = 0; i < n_lookups; i++)
+    {
+      session_kv4_t *kv = &kvs[random_u32 (&seed) % n_sessions];
+      lcl.as_u32 = kv->key[0];
+      rmt.as_u32 = kv->key[0] >> 32;
+      result = SESSION_LOOKUP_RESULT_NONE;
+      session_lookup_connection_wt4 (0, &lcl, &rmt, kv->key[1],
+				     kv->key[1] >> 16, TRANSPORT_PROTO_TCP,
+				     thread_index, &result);
+      n_bad_single += result != SESSION_LOOKUP_RESULT_WRONG_THREAD;
+    }
+  single_cycles = clib_cpu_time_now () - start;
+
+  /* Frames of keys, as tcp4-input does */
+  seed = 0xdeadbeef;
+  clib_memset (fib_indices, 0, sizeof (fib_indices));
+  batch_cycles = 0;
+  for (i = 0; i < n_lookups; i += VLIB_FRAME_SIZE)
+    {
+      for (j = 0; j < VLIB_FRAME_SIZE; j++)
+	batch[j] = kvs[random_u32 (&seed) % n_sessions];
+      start = clib_cpu_time_now ();
+      session_lookup_connection_wt4_batch (fib_indices, batch,
+					   VLIB_FRAME_SIZE, thread_index,
+					   tcs, results);
+      batch_cycles += clib_cpu_time_now () - start;
+      for (j = 0; j < VLIB_FRAME_SIZE; j++)
+	n_bad_batch += results[j] != SESSION_LOOKUP_RESULT_WRONG_THREAD;
+    }
+
+  vlib_cli_output (vm, "%u sessions, %u lookups", n_sessions, n_lookups);
+  vlib_cli_output (vm, "  single: %.2f clocks/lookup",
+		   (f64) single_cycles / n_lookups);
+  vlib_cli_output (vm, "  batched: %.2f clocks/lookup",
+		   (f64) batch_cycles / i);
+
+  clib_bihash_free_16_8 (&st->v4_session_hash);
+  st->v4_session_hash = saved_hash;
+  vec_free (kvs);
+
+  SESSION_TEST ((n_bad_single == 0), "all single lookups should hit, %u "
+		"missed", n_bad_single);
+  SESSION_TEST ((n_bad_batch == 0), "all batched lookups should hit, %u "
+		"missed", n_bad_batch);
+  return 0;
+}
+
 static clib_error_t *
 session_test (vlib_main_t * vm,
 	      unformat_input_t * input, vlib_cli_command_t * cmd_arg)
@@ -1894,6 +2008,8 @@ session_test (vlib_main_t * vm,
 	res = session_test_endpoint_cfg (vm, input);
       else if (unformat (input, "mq"))
 	res = session_test_mq (vm, input);
+      else if (unformat (input, "lookup"))
+	res = session_test_lookup (vm, input);
       else if (unformat (input, "all"))
 	{
 	  if ((res = session_test_basic (vm, input)))
@@ -1507,6 +1507,133 @@ tcp_test_fifo5 (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+static svm_fifo_chunk_t *
+fifo_chunk_alloc (u32 size)
+{
+  svm_fifo_chunk_t *c;
+  c = clib_mem_alloc (sizeof (*c) + size);
+  clib_memset (c, 0, sizeof (*c));
+  c->length = size;
+  return c;
+}
+
+static int
+tcp_test_fifo6 (vlib_main_t * vm, unformat_input_t * input)
+{
+  svm_fifo_t *f;
+  u32 fifo_size = 4096, j = 0;
+  int i, rv, verbose = 0;
+  u8 *test_data = 0, *data_buf = 0;
+  svm_fifo_segment_t fs[2];
+  svm_fifo_chunk_t *c;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_error_t *e = clib_error_return
+	    (0, "unknown input `%U'", format_unformat_error, input);
+	  clib_error_report (e);
+	  return -1;
+	}
+    }
+
+  vec_validate (test_data, 4 * fifo_size - 1);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+  vec_validate (data_buf, 4 * fifo_size - 1);
+
+  /*
+   * Grow fifo with unwrapped data
+   */
+  f = fifo_prepare (fifo_size);
+  svm_fifo_enqueue_nowait (f, 3000, test_data);
+  svm_fifo_dequeue_drop (f, 1000);
+
+  TCP_TEST (svm_fifo_can_grow (f), "fifo should be able to grow");
+  rv = svm_fifo_add_chunk (f, fifo_chunk_alloc (fifo_size));
+  TCP_TEST ((rv == 0), "add chunk returned %d", rv);
+  TCP_TEST ((f->size == 2 * fifo_size), "size %u expected %u", f->size,
+	    2 * fifo_size);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 2000), "max deq %u expected %u",
+	    svm_fifo_max_dequeue (f), 2000);
+
+  rv = svm_fifo_enqueue_nowait (f, 5000, &test_data[3000]);
+  TCP_TEST ((rv == 5000), "enqueued %u expected %u", rv, 5000);
+  if (verbose)
+    vlib_cli_output (vm, "fifo after grow and enqueue: %U", format_svm_fifo,
+		     f, 1 /* verbose */ );
+
+  rv = svm_fifo_segments (f, fs);
+  TCP_TEST ((rv == 7000), "segments len %u expected %u", rv, 7000);
+  TCP_TEST ((fs[0].len == fifo_size - 1000), "first segment len %u "
+	    "expected %u", fs[0].len, fifo_size - 1000);
+
+  rv = svm_fifo_dequeue_nowait (f, 7000, data_buf);
+  TCP_TEST ((rv == 7000), "dequeued %u expected %u", rv, 7000);
+  if (compare_data (data_buf, &test_data[1000], 0, 7000, &j))
+    TCP_TEST (0, "[%d] dequeued %u expected %u", j, data_buf[j],
+	      test_data[1000 + j]);
+
+  /*
+   * Enqueue and dequeue across the wrap of the grown fifo
+   */
+  rv = svm_fifo_enqueue_nowait (f, 2 * fifo_size - 1, test_data);
+  TCP_TEST ((rv == 2 * fifo_size - 1), "enqueued %u expected %u", rv,
+	    2 * fifo_size - 1);
+  TCP_TEST (!svm_fifo_can_grow (f), "full fifo should not grow");
+  rv = svm_fifo_peek (f, 100, 2 * fifo_size, data_buf);
+  TCP_TEST ((rv == 2 * fifo_size - 101), "peeked %u expected %u", rv,
+	    2 * fifo_size - 101);
+  if (compare_data (data_buf, &test_data[100], 0, rv, &j))
+    TCP_TEST (0, "[%d] peeked %u expected %u", j, data_buf[j],
+	      test_data[100 + j]);
+  svm_fifo_dequeue_drop (f, 2 * fifo_size - 1);
+
+  /*
+   * Shrink empty fifo
+   */
+  TCP_TEST ((svm_fifo_del_chunk (f) == 0), "fifo should shrink");
+  TCP_TEST ((f->size == fifo_size), "size %u expected %u", f->size,
+	    fifo_size);
+  TCP_TEST (!(f->flags & SVM_FIFO_F_MULTI_CHUNK), "single chunk");
+  TCP_TEST ((svm_fifo_reclaim_chunk (f) == 0), "consumer holds the chunk");
+  TCP_TEST ((svm_fifo_dequeue_nowait (f, 1, data_buf) == -2),
+	    "empty fifo");
+  c = svm_fifo_reclaim_chunk (f);
+  TCP_TEST ((c != 0), "consumer released the chunk");
+  TCP_TEST ((f->head_chunk == &f->default_chunk), "head chunk reset");
+  clib_mem_free (c);
+
+  rv = svm_fifo_enqueue_nowait (f, fifo_size - 1, test_data);
+  TCP_TEST ((rv == fifo_size - 1), "enqueued %u expected %u", rv,
+	    fifo_size - 1);
+  TCP_TEST ((svm_fifo_del_chunk (f) != 0), "non-empty fifo can't shrink");
+  rv = svm_fifo_dequeue_nowait (f, fifo_size, data_buf);
+  if (compare_data (data_buf, test_data, 0, rv, &j))
+    TCP_TEST (0, "[%d] dequeued %u expected %u", j, data_buf[j],
+	      test_data[j]);
+  svm_fifo_free (f);
+
+  /*
+   * Data that wraps prevents growth
+   */
+  f = fifo_prepare (fifo_size);
+  svm_fifo_init_pointers (f, fifo_size - 100);
+  svm_fifo_enqueue_nowait (f, 200, test_data);
+  TCP_TEST (!svm_fifo_can_grow (f), "wrapped fifo should not grow");
+  c = fifo_chunk_alloc (fifo_size);
+  TCP_TEST ((svm_fifo_add_chunk (f, c) != 0), "add chunk should fail");
+  clib_mem_free (c);
+  svm_fifo_free (f);
+
+  vec_free (test_data);
+  vec_free (data_buf);
+  return 0;
+}
+
 /* *INDENT-OFF* */
 svm_fifo_trace_elem_t fifo_trace[] = {};
 /* *INDENT-ON* */
@@ -1599,6 +1726,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
       res = tcp_test_fifo5 (vm, input);
       if (res)
 	return res;
+
+      res = tcp_test_fifo6 (vm, input);
+      if (res)
+	return res;
     }
   else
     {
@@ -1622,6 +1753,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
 	{
 	  res = tcp_test_fifo5 (vm, input);
 	}
+      else if (unformat (input, "fifo6"))
+	{
+	  res = tcp_test_fifo6 (vm, input);
+	}
       else if (unformat (input, "replay"))
 	{
 	  res = tcp_test_fifo_replay (vm, input);
@@ -417,13 +417,16 @@ vmxnet3_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  vmxnet3_input_trace_t *tr;
 
 	  b = vlib_get_buffer (vm, bi[0]);
-	  vlib_trace_buffer (vm, node, next[0], b, /* follow_chain */ 0);
-	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-	  tr->next_index = next[0];
-	  tr->hw_if_index = vd->hw_if_index;
-	  tr->buffer = *b;
+	  if (PREDICT_TRUE
+	      (vlib_trace_buffer (vm, node, next[0], b, /* follow_chain */ 0)))
+	    {
+	      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+	      tr->next_index = next[0];
+	      tr->hw_if_index = vd->hw_if_index;
+	      tr->buffer = *b;
+	      n_trace--;
+	    }
 
-	  n_trace--;
 	  n_left--;
 	  bi++;
 	  next++;
@@ -54,6 +54,71 @@ ooo_segment_end_pos (svm_fifo_t * f, ooo_segment_t * s)
   return s->start + s->length;
 }
 
+/**
+ * Copy data into fifo starting at position pos
+ *
+ * Lookup for the chunk that holds pos starts at chunk c. Returns the chunk
+ * that holds the last byte written.
+ */
+static inline svm_fifo_chunk_t *
+svm_fifo_copy_to_chunks (svm_fifo_chunk_t * c, u32 pos, const u8 * src,
+			 u32 len)
+{
+  u32 n_chunk, to_copy = len;
+
+  c = svm_fifo_find_chunk (c, pos);
+  pos -= c->start_byte;
+  n_chunk = c->length - pos;
+
+  if (n_chunk < to_copy)
+    {
+      clib_memcpy_fast (&c->data[pos], src, n_chunk);
+      while ((to_copy -= n_chunk))
+	{
+	  c = c->next;
+	  n_chunk = clib_min (c->length, to_copy);
+	  clib_memcpy_fast (&c->data[0], src + (len - to_copy), n_chunk);
+	}
+    }
+  else
+    {
+      clib_memcpy_fast (&c->data[pos], src, len);
+    }
+  return c;
+}
+
+/**
+ * Copy data out of fifo starting at position pos
+ *
+ * Lookup for the chunk that holds pos starts at chunk c. Returns the chunk
+ * that holds the last byte read.
+ */
+static inline svm_fifo_chunk_t *
+svm_fifo_copy_from_chunks (svm_fifo_chunk_t * c, u32 pos, u8 * dst, u32 len)
+{
+  u32 n_chunk, to_copy = len;
+
+  c = svm_fifo_find_chunk (c, pos);
+  pos -= c->start_byte;
+  n_chunk = c->length - pos;
+
+  if (n_chunk < to_copy)
+    {
+      clib_memcpy_fast (dst, &c->data[pos], n_chunk);
+      while ((to_copy -= n_chunk))
+	{
+	  c = c->next;
+	  n_chunk = clib_min (c->length, to_copy);
+	  clib_memcpy_fast (dst + (len - to_copy), &c->data[0], n_chunk);
+	}
+    }
+  else
+    {
+      clib_memcpy_fast (dst, &c->data[pos], len);
+    }
+  return c;
+}
+
 #ifndef CLIB_MARCH_VARIANT
 
 u8 *
@@ -245,14 +310,163 @@ svm_fifo_create (u32 data_size_in_bytes)
 void
 svm_fifo_free (svm_fifo_t * f)
 {
+  svm_fifo_chunk_t *c, *next;
+
   ASSERT (f->refcnt > 0);
 
   if (--f->refcnt == 0)
     {
+      /* chunks are expected to live on the same heap as the fifo */
+      c = svm_fifo_collect_chunks (f);
+      while (c)
+	{
+	  next = c->next;
+	  clib_mem_free (c);
+	  c = next;
+	}
       pool_free (f->ooo_segments);
       clib_mem_free (f);
     }
 }
+
+/**
+ * Grow fifo by adding a chunk
+ *
+ * Must be called by the producer. The chunk must be as large as the fifo,
+ * i.e., fifo size doubles, and data in the fifo must not wrap with respect
+ * to the new size. Because head and tail are free running, bytes already
+ * enqueued then map to the same locations before and after the update, so
+ * the consumer needs no synchronization.
+ *
+ * @return 0 on success, -1 if the fifo cannot grow now
+ */
+int
+svm_fifo_add_chunk (svm_fifo_t * f, svm_fifo_chunk_t * c)
+{
+  svm_fifo_chunk_t *last;
+
+  if (c->length != f->size || !svm_fifo_can_grow (f))
+    return -1;
+
+  last = &f->default_chunk;
+  while (last->next != &f->default_chunk)
+    last = last->next;
+
+  c->start_byte = f->size;
+  c->next = &f->default_chunk;
+  /* consumer may be walking the ring */
+  CLIB_MEMORY_STORE_BARRIER ();
+  last->next = c;
+
+  f->size <<= 1;
+  f->nitems = f->size - 1;
+  f->flags |= SVM_FIFO_F_MULTI_CHUNK;
+  return 0;
+}
+
+/**
+ * Shrink fifo by removing its last chunk
+ *
+ * Must be called by the producer and succeeds only if the fifo is empty,
+ * in which case no data needs to be relocated. The head chunk hint is
+ * owned by the consumer, which may still be walking the removed chunk, so
+ * the chunk is only retired: it keeps pointing back into the ring and can
+ * be freed once svm_fifo_reclaim_chunk returns it, i.e., after the
+ * consumer dropped its hint on its next operation.
+ *
+ * @return 0 on success, -1 if the fifo cannot shrink now
+ */
+int
+svm_fifo_del_chunk (svm_fifo_t * f)
+{
+  svm_fifo_chunk_t *prev, *c;
+  u32 head, tail;
+
+  if (!(f->flags & SVM_FIFO_F_MULTI_CHUNK) || f->retired_chunk
+      || f->ooos_list_head != OOO_SEGMENT_INVALID_INDEX)
+    return -1;
+
+  f_load_head_tail_prod (f, &head, &tail);
+  if (head != tail)
+    return -1;
+
+  prev = &f->default_chunk;
+  while (prev->next->next != &f->default_chunk)
+    prev = prev->next;
+
+  c = prev->next;
+  f->tail_chunk = &f->default_chunk;
+  prev->next = &f->default_chunk;
+  f->size = c->start_byte;
+  f->nitems = f->size - 1;
+  if (prev == &f->default_chunk)
+    f->flags &= ~SVM_FIFO_F_MULTI_CHUNK;
+
+  f->retired_chunk = c;
+  /* store-rel: paired with load-acq in consumer */
+  clib_atomic_store_rel_n (&f->n_retired, f->n_retired + 1);
+  return 0;
+}
+
+/**
+ * Take back chunk retired by svm_fifo_del_chunk
+ *
+ * Must be called by the producer.
+ *
+ * @return chunk, if the consumer released it, or 0
+ */
+svm_fifo_chunk_t *
+svm_fifo_reclaim_chunk (svm_fifo_t * f)
+{
+  svm_fifo_chunk_t *c = f->retired_chunk;
+
+  /* load-acq: paired with store-rel in consumer */
+  if (!c || clib_atomic_load_acq_n (&f->n_released) != f->n_retired)
+    return 0;
+
+  f->retired_chunk = 0;
+  c->next = 0;
+  return c;
+}
+
+/**
+ * Detach all chunks that were added to the fifo
+ *
+ * Fifo is reset to its default chunk. Must not be called while producer
+ * or consumer are active.
+ *
+ * @return linked-list of chunks or 0 if none were added
+ */
+svm_fifo_chunk_t *
+svm_fifo_collect_chunks (svm_fifo_t * f)
+{
+  svm_fifo_chunk_t *list, *last;
+
+  list = f->retired_chunk;
+  if (list)
+    {
+      list->next = 0;
+      f->retired_chunk = 0;
+      f->n_released = f->n_retired;
+    }
+
+  if (!(f->flags & SVM_FIFO_F_MULTI_CHUNK))
+    return list;
+
+  last = f->default_chunk.next;
+  while (last->next != &f->default_chunk)
+    last = last->next;
+  last->next = list;
+  list = f->default_chunk.next;
+
+  f->default_chunk.next = &f->default_chunk;
+  f->head_chunk = &f->default_chunk;
+  f->tail_chunk = &f->default_chunk;
+  f->size = f->default_chunk.length;
+  f->nitems = f->size - 1;
+  f->flags &= ~SVM_FIFO_F_MULTI_CHUNK;
+  return list;
+}
 #endif
 
 always_inline ooo_segment_t *
@@ -484,8 +698,7 @@ ooo_segment_try_collect (svm_fifo_t * f, u32 n_bytes_enqueued, u32 * tail)
 CLIB_MARCH_FN (svm_fifo_enqueue_nowait, int, svm_fifo_t * f, u32 len,
 	       const u8 * src)
 {
-  u32 n_chunk, to_copy, tail, head, free_count, tail_idx;
-  svm_fifo_chunk_t *c;
+  u32 tail, head, free_count;
 
   f_load_head_tail_prod (f, &head, &tail);
 
@@ -498,29 +711,10 @@ CLIB_MARCH_FN (svm_fifo_enqueue_nowait, int, svm_fifo_t * f, u32 len,
     return SVM_FIFO_FULL;
 
   /* number of bytes we're going to copy */
-  to_copy = len = clib_min (free_count, len);
+  len = clib_min (free_count, len);
 
-  c = f->tail_chunk;
-  tail_idx = tail % f->size;
-  ASSERT (tail_idx >= c->start_byte);
-  tail_idx -= c->start_byte;
-  n_chunk = c->length - tail_idx;
-
-  if (n_chunk < to_copy)
-    {
-      clib_memcpy_fast (&c->data[tail_idx], src, n_chunk);
-      while ((to_copy -= n_chunk))
-	{
-	  c = c->next;
-	  n_chunk = clib_min (c->length, to_copy);
-	  clib_memcpy_fast (&c->data[0], src + (len - to_copy), n_chunk);
-	}
-      f->tail_chunk = c;
-    }
-  else
-    {
-      clib_memcpy_fast (&c->data[tail_idx], src, to_copy);
-    }
+  f->tail_chunk = svm_fifo_copy_to_chunks (f->tail_chunk, tail % f->size,
+					   src, len);
   tail += len;
 
   svm_fifo_trace_add (f, head, n_total, 2);
@@ -557,8 +751,7 @@ svm_fifo_enqueue_nowait (svm_fifo_t * f, u32 max_bytes,
 CLIB_MARCH_FN (svm_fifo_enqueue_with_offset, int, svm_fifo_t * f,
 	       u32 offset, u32 len, u8 * src)
 {
-  u32 to_copy, n_chunk, tail, head, free_count, tail_offset_idx;
-  svm_fifo_chunk_t *c;
+  u32 tail, head, free_count;
 
   f_load_head_tail_prod (f, &head, &tail);
 
@@ -575,27 +768,8 @@ CLIB_MARCH_FN (svm_fifo_enqueue_with_offset, int, svm_fifo_t * f,
   svm_fifo_trace_add (f, offset, len, 1);
 
   ooo_segment_add (f, offset, head, tail, len);
-
-  c = f->tail_chunk;
-  tail_offset_idx = (tail + offset) % f->size;
-  tail_offset_idx -= c->start_byte;
-  n_chunk = c->length - tail_offset_idx;
-  to_copy = len;
-
-  if (n_chunk < to_copy)
-    {
-      clib_memcpy_fast (&c->data[tail_offset_idx], src, n_chunk);
-      while ((to_copy -= n_chunk))
-	{
-	  c = c->next;
-	  n_chunk = clib_min (c->length, to_copy);
-	  clib_memcpy_fast (&c->data[0], src + (len - to_copy), n_chunk);
-	}
-    }
-  else
-    {
-      clib_memcpy_fast (&c->data[tail_offset_idx], src, len);
-    }
+  svm_fifo_copy_to_chunks (f->tail_chunk, (tail + offset) % f->size, src,
+			   len);
 
   return 0;
 }
@@ -614,32 +788,19 @@ svm_fifo_enqueue_with_offset (svm_fifo_t * f, u32 offset, u32 required_bytes,
 void
 svm_fifo_overwrite_head (svm_fifo_t * f, u8 * data, u32 len)
 {
-  u32 n_chunk;
-  u32 head, tail, head_idx;
-  svm_fifo_chunk_t *c;
+  u32 head, tail;
 
   ASSERT (len <= f->nitems);
 
   f_load_head_tail_cons (f, &head, &tail);
-  c = f->head_chunk;
-  head_idx = head % f->size;
-  head_idx -= c->start_byte;
-  n_chunk = c->length - head_idx;
-  if (len <= n_chunk)
-    clib_memcpy_fast (&c->data[head_idx], data, len);
-  else
-    {
-      clib_memcpy_fast (&c->data[head_idx], data, n_chunk);
-      clib_memcpy_fast (&c->next->data[0], data + n_chunk, len - n_chunk);
-    }
+  svm_fifo_copy_to_chunks (f->head_chunk, head % f->size, data, len);
 }
 #endif
 
 CLIB_MARCH_FN (svm_fifo_dequeue_nowait, int, svm_fifo_t * f, u32 len,
 	       u8 * dst)
 {
-  u32 to_copy, n_chunk, tail, head, cursize, head_idx;
-  svm_fifo_chunk_t *c;
+  u32 tail, head, cursize;
 
   f_load_head_tail_cons (f, &head, &tail);
 
@@ -649,31 +810,13 @@ CLIB_MARCH_FN (svm_fifo_dequeue_nowait, int, svm_fifo_t * f, u32 len,
   if (PREDICT_FALSE (cursize == 0))
     return -2;			/* nothing in the fifo */
 
-  to_copy = len = clib_min (cursize, len);
-
-  c = f->head_chunk;
-  head_idx = head % f->size;
-  head_idx -= c->start_byte;
-  n_chunk = c->length - head_idx;
+  len = clib_min (cursize, len);
 
-  if (n_chunk < to_copy)
-    {
-      clib_memcpy_fast (dst, &c->data[head_idx], n_chunk);
-      while ((to_copy -= n_chunk))
-	{
-	  c = c->next;
-	  n_chunk = clib_min (c->length, to_copy);
-	  clib_memcpy_fast (dst + (len - to_copy), &c->data[0], n_chunk);
-	}
-      f->head_chunk = c;
-    }
-  else
-    {
-      clib_memcpy_fast (dst, &c->data[head_idx], to_copy);
-    }
+  f->head_chunk = svm_fifo_copy_from_chunks (f->head_chunk, head % f->size,
+					     dst, len);
   head += len;
 
-  ASSERT (cursize >= to_copy);
+  ASSERT (cursize >= len);
   /* store-rel: consumer owned index (paired with load-acq in producer) */
   clib_atomic_store_rel_n (&f->head, head);
 
@@ -693,8 +836,7 @@ svm_fifo_dequeue_nowait (svm_fifo_t * f, u32 max_bytes, u8 * copy_here)
 CLIB_MARCH_FN (svm_fifo_peek, int, svm_fifo_t * f, u32 relative_offset,
 	       u32 len, u8 * dst)
 {
-  u32 to_copy, n_chunk, tail, head, cursize, head_idx;
-  svm_fifo_chunk_t *c;
+  u32 tail, head, cursize;
 
   f_load_head_tail_cons (f, &head, &tail);
 
@@ -704,28 +846,10 @@ CLIB_MARCH_FN (svm_fifo_peek, int, svm_fifo_t * f, u32 relative_offset,
   if (PREDICT_FALSE (cursize < relative_offset))
     return -2;			/* nothing in the fifo */
 
-  to_copy = len = clib_min (cursize - relative_offset, len);
+  len = clib_min (cursize - relative_offset, len);
 
-  c = f->head_chunk;
-  head_idx = (head + relative_offset) % f->size;
-  head_idx -= c->start_byte;
-  n_chunk = c->length - head_idx;
-
-  if (n_chunk < to_copy)
-    {
-      clib_memcpy_fast (dst, &c->data[head_idx], n_chunk);
-      while ((to_copy -= n_chunk))
-	{
-	  c = c->next;
-	  n_chunk = clib_min (c->length, to_copy);
-	  clib_memcpy_fast (dst + (len - to_copy), &c->data[0], n_chunk);
-	}
-      f->head_chunk = c;
-    }
-  else
-    {
-      clib_memcpy_fast (dst, &c->data[head_idx], to_copy);
-    }
+  svm_fifo_copy_from_chunks (f->head_chunk,
+			     (head + relative_offset) % f->size, dst, len);
   return len;
 }
 
@@ -781,6 +905,7 @@ int
 svm_fifo_segments (svm_fifo_t * f, svm_fifo_segment_t * fs)
 {
   u32 cursize, head, tail, head_idx;
+  svm_fifo_chunk_t *c;
 
   f_load_head_tail_cons (f, &head, &tail);
 
@@ -791,34 +916,33 @@ svm_fifo_segments (svm_fifo_t * f, svm_fifo_segment_t * fs)
     return -2;			/* nothing in the fifo */
 
   head_idx = head % f->size;
+  c = svm_fifo_find_chunk (f->head_chunk, head_idx);
 
-  if (tail < head)
+  fs[0].len = clib_min (cursize, c->start_byte + c->length - head_idx);
+  fs[0].data = c->data + (head_idx - c->start_byte);
+  if (fs[0].len < cursize)
     {
-      fs[0].len = f->size - head_idx;
-      fs[0].data = f->head_chunk->data + head_idx;
-      fs[1].len = cursize - fs[0].len;
-      fs[1].data = f->head_chunk->data;
+      c = c->next;
+      fs[1].len = clib_min (cursize - fs[0].len, c->length);
+      fs[1].data = c->data;
     }
   else
     {
-      fs[0].len = cursize;
-      fs[0].data = f->head_chunk->data + head_idx;
       fs[1].len = 0;
       fs[1].data = 0;
     }
-  return cursize;
+  return fs[0].len + fs[1].len;
 }
 
 void
 svm_fifo_segments_free (svm_fifo_t * f, svm_fifo_segment_t * fs)
 {
-  u32 head, head_idx;
+  u32 head;
 
   /* consumer owned index */
   head = f->head;
-  head_idx = head % f->size;
 
-  ASSERT (fs[0].data == f->head_chunk->data + head_idx);
+  ASSERT (fs[0].data == svm_fifo_head (f));
   head += fs[0].len + fs[1].len;
   /* store-rel: consumer owned index (paired with load-acq in producer) */
   clib_atomic_store_rel_n (&f->head, head);
@@ -828,10 +952,29 @@ svm_fifo_segments_free (svm_fifo_t * f, svm_fifo_segment_t * fs)
 void
 svm_fifo_clone (svm_fifo_t * df, svm_fifo_t * sf)
 {
-  u32 head, tail;
-  clib_memcpy_fast (df->head_chunk->data, sf->head_chunk->data, sf->size);
+  u32 head, tail, cursize, pos, n_bytes;
+  svm_fifo_chunk_t *c, *dc;
 
   f_load_head_tail_all_acq (sf, &head, &tail);
+  cursize = f_cursize (sf, head, tail);
+  ASSERT (cursize <= df->nitems);
+
+  /* Fifos may differ in size, so copy chunk by chunk */
+  c = sf->head_chunk;
+  dc = df->tail_chunk;
+  pos = head;
+  while (cursize)
+    {
+      c = svm_fifo_find_chunk (c, pos % sf->size);
+      n_bytes = clib_min (cursize,
+			  c->start_byte + c->length - pos % sf->size);
+      dc = svm_fifo_copy_to_chunks (dc, pos % df->size,
+				    c->data + (pos % sf->size
+					       - c->start_byte), n_bytes);
+      pos += n_bytes;
+      cursize -= n_bytes;
+    }
+
   clib_atomic_store_rel_n (&df->head, head);
   clib_atomic_store_rel_n (&df->tail, tail);
 }
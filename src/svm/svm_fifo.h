@@ -62,12 +62,18 @@ typedef struct
 
 typedef struct svm_fifo_chunk_
 {
-  u32 start_byte;
-  u32 length;
-  struct svm_fifo_chunk_ *next;
-  u8 data[0];
+  u32 start_byte;		/**< chunk start byte */
+  u32 length;			/**< length of chunk in bytes */
+  struct svm_fifo_chunk_ *next;	/**< pointer to next chunk in linked-lists */
+  u8 data[0];			/**< start of chunk data */
 } svm_fifo_chunk_t;
 
+typedef enum svm_fifo_flag_
+{
+  SVM_FIFO_F_MULTI_CHUNK = 1 << 0,
+  SVM_FIFO_F_GROWABLE = 1 << 1,
+} svm_fifo_flag_t;
+
 typedef struct _svm_fifo
 {
   CLIB_CACHE_LINE_ALIGN_MARK (shared_first);
@@ -88,16 +94,22 @@ typedef struct _svm_fifo
   u32 ct_session_index;		/**< Local session index for vpp */
   u32 freelist_index;		/**< aka log2(allocated_size) - const. */
   i8 refcnt;			/**< reference count  */
+  u8 flags;			/**< fifo flags */
 
     CLIB_CACHE_LINE_ALIGN_MARK (consumer);
   u32 head;
   svm_fifo_chunk_t *head_chunk;
   volatile u32 want_tx_ntf;	/**< producer wants nudge */
   volatile u32 has_tx_ntf;
+  volatile u32 n_released;	/**< retired chunks consumer let go of */
 
     CLIB_CACHE_LINE_ALIGN_MARK (producer);
   u32 tail;
   svm_fifo_chunk_t *tail_chunk;
+  svm_fifo_chunk_t *retired_chunk;	/**< removed, not yet released */
+  volatile u32 n_retired;	/**< chunks removed by producer */
+  u32 hwm;			/**< occupancy high-water mark */
+  u8 n_low_hwm;			/**< consecutive low hwm samples */
 
   ooo_segment_t *ooo_segments;	/**< Pool of ooo segments */
   u32 ooos_list_head;		/**< Head of out-of-order linked-list */
@@ -143,6 +155,14 @@ u8 *svm_fifo_replay (u8 * s, svm_fifo_t * f, u8 no_read, u8 verbose);
 static inline void
 f_load_head_tail_cons (svm_fifo_t * f, u32 * head, u32 * tail)
 {
+  /* drop head chunk hint if the producer removed a chunk since last time,
+   * and let it reclaim the chunk, see svm_fifo_del_chunk */
+  if (PREDICT_FALSE (f->n_released != f->n_retired))
+    {
+      f->head_chunk = &f->default_chunk;
+      clib_atomic_store_rel_n (&f->n_released,
+			       clib_atomic_load_acq_n (&f->n_retired));
+    }
   /* load-relaxed: consumer owned index */
   *head = f->head;
   /* load-acq: consumer foreign index (paired with store-rel in producer) */
@@ -184,6 +204,22 @@ f_cursize (svm_fifo_t * f, u32 head, u32 tail)
   return (f->nitems - f_free_count (f, head, tail));
 }
 
+/**
+ * Find chunk that holds fifo position
+ *
+ * Chunks form a ring ordered by start byte that covers the whole fifo, so
+ * walking forward from any chunk, e.g., a head or tail hint, finds it.
+ *
+ * internal function
+ */
+static inline svm_fifo_chunk_t *
+svm_fifo_find_chunk (svm_fifo_chunk_t * c, u32 pos)
+{
+  while (pos - c->start_byte >= c->length)
+    c = c->next;
+  return c;
+}
+
 /* used by consumer */
 static inline u32
 svm_fifo_max_dequeue_cons (svm_fifo_t * f)
@@ -276,6 +312,27 @@ svm_fifo_max_enqueue (svm_fifo_t * f)
   return f_free_count (f, head, tail);
 }
 
+/**
+ * Check if fifo can grow by a chunk as large as the fifo
+ *
+ * Data must not wrap with respect to the doubled size and there must be no
+ * out-of-order segments, as their positions are normalized to the current
+ * size. Used by producer.
+ */
+static inline int
+svm_fifo_can_grow (svm_fifo_t * f)
+{
+  u32 head, tail, cursize;
+
+  if ((f->size & (1U << 31))
+      || f->ooos_list_head != OOO_SEGMENT_INVALID_INDEX)
+    return 0;
+
+  f_load_head_tail_prod (f, &head, &tail);
+  cursize = f_cursize (f, head, tail);
+  return (!cursize || (head % (f->size << 1)) + cursize <= f->size);
+}
+
 static inline int
 svm_fifo_has_event (svm_fifo_t * f)
 {
@@ -334,6 +391,10 @@ void svm_fifo_clone (svm_fifo_t * df, svm_fifo_t * sf);
 void svm_fifo_overwrite_head (svm_fifo_t * f, u8 * data, u32 len);
 void svm_fifo_add_subscriber (svm_fifo_t * f, u8 subscriber);
 void svm_fifo_del_subscriber (svm_fifo_t * f, u8 subscriber);
+int svm_fifo_add_chunk (svm_fifo_t * f, svm_fifo_chunk_t * c);
+int svm_fifo_del_chunk (svm_fifo_t * f);
+svm_fifo_chunk_t *svm_fifo_reclaim_chunk (svm_fifo_t * f);
+svm_fifo_chunk_t *svm_fifo_collect_chunks (svm_fifo_t * f);
 format_function_t format_svm_fifo;
 
 /**
@@ -342,12 +403,20 @@ format_function_t format_svm_fifo;
 always_inline u32
 svm_fifo_max_read_chunk (svm_fifo_t * f)
 {
-  u32 head, tail;
+  u32 head, tail, end;
   u32 head_idx, tail_idx;
+  svm_fifo_chunk_t *c;
+
   f_load_head_tail_cons (f, &head, &tail);
+  /* empty fifo may be shrinking under us, don't walk */
+  if (head == tail)
+    return 0;
   head_idx = head % f->size;
   tail_idx = tail % f->size;
-  return tail_idx > head_idx ? (tail_idx - head_idx) : (f->size - head_idx);
+  c = svm_fifo_find_chunk (f->head_chunk, head_idx);
+  end = c->start_byte + c->length;
+  return tail_idx > head_idx ?
+    (clib_min (tail_idx, end) - head_idx) : (end - head_idx);
 }
 
 /**
@@ -356,12 +425,17 @@ svm_fifo_max_read_chunk (svm_fifo_t * f)
 always_inline u32
 svm_fifo_max_write_chunk (svm_fifo_t * f)
 {
-  u32 head, tail;
+  u32 head, tail, end;
   u32 head_idx, tail_idx;
+  svm_fifo_chunk_t *c;
+
   f_load_head_tail_prod (f, &head, &tail);
   head_idx = head % f->size;
   tail_idx = tail % f->size;
-  return tail_idx >= head_idx ? (f->size - tail_idx) : (head_idx - tail_idx);
+  c = svm_fifo_find_chunk (f->tail_chunk, tail_idx);
+  end = c->start_byte + c->length;
+  return tail_idx >= head_idx ?
+    (end - tail_idx) : (clib_min (head_idx, end) - tail_idx);
 }
 
 /**
@@ -383,17 +457,25 @@ svm_fifo_enqueue_nocopy (svm_fifo_t * f, u32 bytes)
 always_inline u8 *
 svm_fifo_head (svm_fifo_t * f)
 {
+  svm_fifo_chunk_t *c;
+  u32 head_idx;
+
   /* load-relaxed: consumer owned index */
-  return (f->head_chunk->data
-	  + ((f->head % f->size) - f->head_chunk->start_byte));
+  head_idx = f->head % f->size;
+  c = svm_fifo_find_chunk (f->head_chunk, head_idx);
+  return (c->data + (head_idx - c->start_byte));
 }
 
 always_inline u8 *
 svm_fifo_tail (svm_fifo_t * f)
 {
+  svm_fifo_chunk_t *c;
+  u32 tail_idx;
+
   /* load-relaxed: producer owned index */
-  return (f->tail_chunk->data
-	  + ((f->tail % f->size) - f->tail_chunk->start_byte));
+  tail_idx = f->tail % f->size;
+  c = svm_fifo_find_chunk (f->tail_chunk, tail_idx);
+  return (c->data + (tail_idx - c->start_byte));
 }
 
 static inline void
@@ -431,6 +431,93 @@ done:
   return (f);
 }
 
+static inline int
+chunk_freelist_index (u32 chunk_size)
+{
+  return max_log2 (chunk_size) - max_log2 (FIFO_SEGMENT_MIN_FIFO_SIZE);
+}
+
+static void
+svm_fifo_segment_free_chunks_i (svm_fifo_segment_header_t * fsh,
+				svm_fifo_chunk_t * c)
+{
+  svm_fifo_chunk_t *next;
+  int fl_index;
+
+  while (c)
+    {
+      next = c->next;
+      fl_index = chunk_freelist_index (c->length);
+      ASSERT (fl_index < vec_len (fsh->free_chunks));
+      c->next = fsh->free_chunks[fl_index];
+      fsh->free_chunks[fl_index] = c;
+      c = next;
+    }
+}
+
+/**
+ * Allocate fifo chunk in svm segment
+ *
+ * Chunks are used to grow fifos. Their size must be a power of two and
+ * they are recycled via per size freelists.
+ */
+svm_fifo_chunk_t *
+svm_fifo_segment_alloc_chunk (svm_fifo_segment_private_t * fs,
+			      u32 chunk_size)
+{
+  ssvm_shared_header_t *sh = fs->ssvm.sh;
+  svm_fifo_segment_header_t *fsh;
+  svm_fifo_chunk_t *c;
+  void *oldheap;
+  int fl_index;
+
+  if (!is_pow2 (chunk_size) || chunk_size < FIFO_SEGMENT_MIN_FIFO_SIZE
+      || chunk_size > FIFO_SEGMENT_MAX_FIFO_SIZE)
+    return 0;
+
+  fl_index = chunk_freelist_index (chunk_size);
+
+  ssvm_lock_non_recursive (sh, 3);
+  fsh = (svm_fifo_segment_header_t *) sh->opaque[0];
+  vec_validate_init_empty (fsh->free_chunks, fl_index, 0);
+
+  c = fsh->free_chunks[fl_index];
+  if (c)
+    {
+      fsh->free_chunks[fl_index] = c->next;
+    }
+  else
+    {
+      oldheap = ssvm_push_heap (sh);
+      c = clib_mem_alloc_aligned_or_null (sizeof (*c) + chunk_size,
+					  CLIB_CACHE_LINE_BYTES);
+      ssvm_pop_heap (oldheap);
+      if (PREDICT_FALSE (!c))
+	goto done;
+      c->length = chunk_size;
+    }
+  c->start_byte = 0;
+  c->next = 0;
+
+done:
+  ssvm_unlock_non_recursive (sh);
+  return c;
+}
+
+/**
+ * Return linked-list of chunks to the segment's freelists
+ */
+void
+svm_fifo_segment_free_chunks (svm_fifo_segment_private_t * fs,
+			      svm_fifo_chunk_t * c)
+{
+  ssvm_shared_header_t *sh = fs->ssvm.sh;
+
+  ssvm_lock_non_recursive (sh, 4);
+  svm_fifo_segment_free_chunks_i (sh->opaque[0], c);
+  ssvm_unlock_non_recursive (sh);
+}
+
 void
 svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s, svm_fifo_t * f,
 			    svm_fifo_segment_freelist_t list_index)
@@ -453,6 +540,10 @@ svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s, svm_fifo_t * f,
 
   ssvm_lock_non_recursive (sh, 2);
 
+  /* Give back chunks added while the fifo was in use */
+  svm_fifo_segment_free_chunks_i (fsh, svm_fifo_collect_chunks (f));
+  f->flags = 0;
+
   switch (list_index)
     {
     case FIFO_SEGMENT_RX_FREELIST:
@@ -571,6 +662,24 @@ svm_fifo_segment_num_free_fifos (svm_fifo_segment_private_t * fifo_segment,
   return count;
 }
 
+/**
+ * Get number of bytes held by free chunks
+ */
+uword
+svm_fifo_segment_free_chunk_bytes (svm_fifo_segment_private_t * fifo_segment)
+{
+  svm_fifo_segment_header_t *fsh = fifo_segment->h;
+  svm_fifo_chunk_t *c;
+  uword n_bytes = 0;
+  int i;
+
+  for (i = 0; i < vec_len (fsh->free_chunks); i++)
+    for (c = fsh->free_chunks[i]; c; c = c->next)
+      n_bytes += c->length;
+
+  return n_bytes;
+}
+
 void
 svm_fifo_segment_info (svm_fifo_segment_private_t * seg, char **address,
 		       size_t * size)
@@ -657,6 +766,24 @@ format_svm_fifo_segment (u8 * s, va_list * args)
 		  1 << (i + max_log2 (FIFO_SEGMENT_MIN_FIFO_SIZE) - 10),
 		  count);
     }
+
+  for (i = 0; i < vec_len (fsh->free_chunks); i++)
+    {
+      svm_fifo_chunk_t *c = fsh->free_chunks[i];
+      if (c == 0)
+	continue;
+      count = 0;
+      while (c)
+	{
+	  c = c->next;
+	  count++;
+	}
+
+      s = format (s, "%U%-5u Kb: %u free chunks",
+		  format_white_space, indent + 2,
+		  1 << (i + max_log2 (FIFO_SEGMENT_MIN_FIFO_SIZE) - 10),
+		  count);
+    }
   return s;
 }
 
@@ -38,6 +38,7 @@ typedef struct
 {
   svm_fifo_t *fifos;		/**< Linked list of active RX fifos */
   svm_fifo_t **free_fifos;	/**< Freelists, by fifo size  */
+  svm_fifo_chunk_t **free_chunks;	/**< Freelists, by chunk size */
   u32 n_active_fifos;		/**< Number of active fifos */
   u8 flags;			/**< Segment flags */
 } svm_fifo_segment_header_t;
@@ -109,6 +110,10 @@ svm_fifo_t *svm_fifo_segment_alloc_fifo (svm_fifo_segment_private_t * s,
 void svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s,
 				 svm_fifo_t * f,
 				 svm_fifo_segment_freelist_t index);
+svm_fifo_chunk_t *svm_fifo_segment_alloc_chunk (svm_fifo_segment_private_t *
+						s, u32 chunk_size);
+void svm_fifo_segment_free_chunks (svm_fifo_segment_private_t * s,
+				   svm_fifo_chunk_t * c);
 void svm_fifo_segment_main_init (svm_fifo_segment_main_t * sm, u64 baseva,
 				 u32 timeout_in_seconds);
 u32 svm_fifo_segment_index (svm_fifo_segment_main_t * sm,
@@ -116,6 +121,8 @@ u32 svm_fifo_segment_index (svm_fifo_segment_main_t * sm,
 u32 svm_fifo_segment_num_fifos (svm_fifo_segment_private_t * fifo_segment);
 u32 svm_fifo_segment_num_free_fifos (svm_fifo_segment_private_t *
 				     fifo_segment, u32 fifo_size_in_bytes);
+uword svm_fifo_segment_free_chunk_bytes (svm_fifo_segment_private_t *
+					 fifo_segment);
 void svm_fifo_segment_info (svm_fifo_segment_private_t * seg, char **address,
 			    size_t * size);
 
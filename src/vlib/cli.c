@@ -1503,20 +1503,9 @@ elog_trace_command_fn (vlib_main_t * vm,
     barrier ? enable : vlib_worker_threads->barrier_elog_enabled;
   vm->elog_trace_graph_circuit_node_index = circuit_node_index;
 
-  /*
-   * Set up start-of-buffer logic-analyzer trigger
-   * for main loop event logs, which are fairly heavyweight.
-   * See src/vlib/main/vlib_elog_main_loop_event(...), which
-   * will fully disable the scheme when the elog buffer fills.
-   */
-  if (dispatch || circuit)
-    {
-      elog_main_t *em = &vm->elog_main;
-
-      em->n_total_events_disable_limit =
-	em->n_total_events + vec_len (em->event_ring);
-    }
-
+  /* Not mp-safe, the workers are at the barrier */
+  if (vm->elog_trace_graph_dispatch || vm->elog_trace_graph_circuit)
+    vlib_worker_thread_elog_rings_init (vm);
 
 print_status:
   vlib_cli_output (vm, "Current status:");
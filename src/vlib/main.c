@@ -550,41 +550,29 @@ vlib_put_next_frame (vlib_main_t * vm,
 never_inline void
 vlib_node_runtime_sync_stats (vlib_main_t * vm,
 			      vlib_node_runtime_t * r,
-			      uword n_calls, uword n_vectors, uword n_clocks,
-			      uword n_ticks0, uword n_ticks1)
+			      uword n_calls, uword n_vectors, uword n_clocks)
 {
   vlib_node_t *n = vlib_get_node (vm, r->node_index);
 
   n->stats_total.calls += n_calls + r->calls_since_last_overflow;
   n->stats_total.vectors += n_vectors + r->vectors_since_last_overflow;
   n->stats_total.clocks += n_clocks + r->clocks_since_last_overflow;
-  n->stats_total.perf_counter0_ticks += n_ticks0 +
-    r->perf_counter0_ticks_since_last_overflow;
-  n->stats_total.perf_counter1_ticks += n_ticks1 +
-    r->perf_counter1_ticks_since_last_overflow;
-  n->stats_total.perf_counter_vectors += n_vectors +
-    r->perf_counter_vectors_since_last_overflow;
   n->stats_total.max_clock = r->max_clock;
   n->stats_total.max_clock_n = r->max_clock_n;
 
   r->calls_since_last_overflow = 0;
   r->vectors_since_last_overflow = 0;
   r->clocks_since_last_overflow = 0;
-  r->perf_counter0_ticks_since_last_overflow = 0ULL;
-  r->perf_counter1_ticks_since_last_overflow = 0ULL;
-  r->perf_counter_vectors_since_last_overflow = 0ULL;
 }
 
 always_inline void __attribute__ ((unused))
 vlib_process_sync_stats (vlib_main_t * vm,
 			 vlib_process_t * p,
-			 uword n_calls, uword n_vectors, uword n_clocks,
-			 uword n_ticks0, uword n_ticks1)
+			 uword n_calls, uword n_vectors, uword n_clocks)
 {
   vlib_node_runtime_t *rt = &p->node_runtime;
   vlib_node_t *n = vlib_get_node (vm, rt->node_index);
-  vlib_node_runtime_sync_stats (vm, rt, n_calls, n_vectors, n_clocks,
-				n_ticks0, n_ticks1);
+  vlib_node_runtime_sync_stats (vm, rt, n_calls, n_vectors, n_clocks);
   n->stats_total.suspends += p->n_suspends;
   p->n_suspends = 0;
 }
@@ -610,7 +598,7 @@ vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n)
       vec_elt_at_index (vm->node_main.nodes_by_type[n->type],
 			n->runtime_index);
 
-  vlib_node_runtime_sync_stats (vm, rt, 0, 0, 0, 0, 0);
+  vlib_node_runtime_sync_stats (vm, rt, 0, 0, 0);
 
   /* Sync up runtime next frame vector counters with main node structure. */
   {
@@ -630,32 +618,21 @@ always_inline u32
 vlib_node_runtime_update_stats (vlib_main_t * vm,
 				vlib_node_runtime_t * node,
 				uword n_calls,
-				uword n_vectors, uword n_clocks,
-				uword n_ticks0, uword n_ticks1)
+				uword n_vectors, uword n_clocks)
 {
   u32 ca0, ca1, v0, v1, cl0, cl1, r;
-  u32 ptick00, ptick01, ptick10, ptick11, pvec0, pvec1;
 
   cl0 = cl1 = node->clocks_since_last_overflow;
   ca0 = ca1 = node->calls_since_last_overflow;
   v0 = v1 = node->vectors_since_last_overflow;
-  ptick00 = ptick01 = node->perf_counter0_ticks_since_last_overflow;
-  ptick10 = ptick11 = node->perf_counter1_ticks_since_last_overflow;
-  pvec0 = pvec1 = node->perf_counter_vectors_since_last_overflow;
 
   ca1 = ca0 + n_calls;
   v1 = v0 + n_vectors;
   cl1 = cl0 + n_clocks;
-  ptick01 = ptick00 + n_ticks0;
-  ptick11 = ptick10 + n_ticks1;
-  pvec1 = pvec0 + n_vectors;
 
   node->calls_since_last_overflow = ca1;
   node->clocks_since_last_overflow = cl1;
   node->vectors_since_last_overflow = v1;
-  node->perf_counter0_ticks_since_last_overflow = ptick01;
-  node->perf_counter1_ticks_since_last_overflow = ptick11;
-  node->perf_counter_vectors_since_last_overflow = pvec1;
 
   node->max_clock_n = node->max_clock > n_clocks ?
     node->max_clock_n : n_vectors;
@@ -663,30 +640,24 @@ vlib_node_runtime_update_stats (vlib_main_t * vm,
 
   r = vlib_node_runtime_update_main_loop_vector_stats (vm, node, n_vectors);
 
-  if (PREDICT_FALSE (ca1 < ca0 || v1 < v0 || cl1 < cl0) || (ptick01 < ptick00)
-      || (ptick11 < ptick10) || (pvec1 < pvec0))
+  if (PREDICT_FALSE (ca1 < ca0 || v1 < v0 || cl1 < cl0))
     {
       node->calls_since_last_overflow = ca0;
       node->clocks_since_last_overflow = cl0;
       node->vectors_since_last_overflow = v0;
-      node->perf_counter0_ticks_since_last_overflow = ptick00;
-      node->perf_counter1_ticks_since_last_overflow = ptick10;
-      node->perf_counter_vectors_since_last_overflow = pvec0;
 
-      vlib_node_runtime_sync_stats (vm, node, n_calls, n_vectors, n_clocks,
-				    n_ticks0, n_ticks1);
+      vlib_node_runtime_sync_stats (vm, node, n_calls, n_vectors, n_clocks);
     }
 
   return r;
 }
 
 static inline void
-vlib_node_runtime_perf_counter (vlib_main_t * vm, u64 * pmc0, u64 * pmc1)
+vlib_node_runtime_perf_counter (vlib_main_t * vm, vlib_node_runtime_t * node,
+				uword n_vectors, int is_after)
 {
-  *pmc0 = 0;
-  *pmc1 = 0;
   if (PREDICT_FALSE (vm->vlib_node_runtime_perf_counter_cb != 0))
-    (*vm->vlib_node_runtime_perf_counter_cb) (vm, pmc0, pmc1);
+    (*vm->vlib_node_runtime_perf_counter_cb) (vm, node, n_vectors, is_after);
 }
 
 always_inline void
@@ -695,7 +666,7 @@ vlib_process_update_stats (vlib_main_t * vm,
 			   uword n_calls, uword n_vectors, uword n_clocks)
 {
   vlib_node_runtime_update_stats (vm, &p->node_runtime,
-				  n_calls, n_vectors, n_clocks, 0ULL, 0ULL);
+				  n_calls, n_vectors, n_clocks);
 }
 
 static clib_error_t *
@@ -722,6 +693,7 @@ elog_save_buffer (vlib_main_t * vm,
   elog_main_t *em = &vm->elog_main;
   char *file, *chroot_file;
   clib_error_t *error = 0;
+  int chrome = 0;
 
   if (!unformat (input, "%s", &file))
     {
@@ -737,6 +709,9 @@ elog_save_buffer (vlib_main_t * vm,
       return 0;
     }
 
+  if (unformat (input, "chrome"))
+    chrome = 1;
+
   chroot_file = (char *) format (0, "/tmp/%s%c", file, 0);
 
   vec_free (file);
@@ -746,7 +721,10 @@ elog_save_buffer (vlib_main_t * vm,
 		   elog_buffer_capacity (em), chroot_file);
 
   vlib_worker_thread_barrier_sync (vm);
-  error = elog_write_file (em, chroot_file, 1 /* flush ring */ );
+  if (chrome)
+    error = elog_write_chrome_trace (em, chroot_file, 1 /* flush ring */ );
+  else
+    error = elog_write_file (em, chroot_file, 1 /* flush ring */ );
   vlib_worker_thread_barrier_release (vm);
   vec_free (chroot_file);
   return error;
@@ -773,7 +751,8 @@ elog_post_mortem_dump (void)
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (elog_save_cli, static) = {
   .path = "event-logger save",
-  .short_help = "event-logger save <filename> (saves log in /tmp/<filename>)",
+  .short_help = "event-logger save <filename> [chrome] "
+  "(saves log in /tmp/<filename>)",
   .function = elog_save_buffer,
 };
 /* *INDENT-ON* */
@@ -936,17 +915,19 @@ vlib_elog_main_loop_event (vlib_main_t * vm,
 	   (evm->elog_trace_graph_circuit &&
 	    node_index == evm->elog_trace_graph_circuit_node_index)))
 	{
-	  elog_track (em,
-		      /* event type */
-		      vec_elt_at_index (is_return
-					? evm->node_return_elog_event_types
-					: evm->node_call_elog_event_types,
-					node_index),
-		      /* track */
-		      (vm->thread_index ?
-		       &vlib_worker_threads[vm->thread_index].elog_track
-		       : &em->default_track),
-		      /* data to log */ n_vectors);
+	  u32 *d;
+
+	  /* Log to this thread's ring, with no atomic operation */
+	  d = elog_thread_event_data_inline
+	    (em, vm->thread_index,
+	     /* event type */
+	     vec_elt_at_index (is_return
+			       ? evm->node_return_elog_event_types
+			       : evm->node_call_elog_event_types,
+			       node_index),
+	     /* time stamp of the dispatch */ time);
+	  /* data to log */
+	  d[0] = n_vectors;
 	}
     }
 }
@@ -1130,6 +1111,22 @@ dispatch_pcap_trace (vlib_main_t * vm,
     }
 }
 
+/*
+ * Count a dispatch or main loop time in its log2 bucket: bucket 0 is
+ * below 2 clocks, bucket n covers [2^n, 2^(n+1)) clocks.
+ */
+static_always_inline void
+vlib_node_histogram_add (vlib_main_t * vm, vlib_simple_counter_main_t * cm,
+			 u32 index, u64 clocks)
+{
+  u32 bucket = min_log2 (clocks | 1);
+
+  bucket = clib_min (bucket, VLIB_NODE_HISTOGRAM_N_BUCKETS - 1);
+  vlib_increment_simple_counter (cm, vm->thread_index,
+				 index * VLIB_NODE_HISTOGRAM_N_BUCKETS +
+				 bucket, 1);
+}
+
 static_always_inline u64
 dispatch_node (vlib_main_t * vm,
 	       vlib_node_runtime_t * node,
@@ -1141,7 +1138,6 @@ dispatch_node (vlib_main_t * vm,
   u64 t;
   vlib_node_main_t *nm = &vm->node_main;
   vlib_next_frame_t *nf;
-  u64 pmc_before[2], pmc_after[2], pmc_delta[2];
 
   if (CLIB_DEBUG > 0)
     {
@@ -1181,7 +1177,7 @@ dispatch_node (vlib_main_t * vm,
 			     last_time_stamp, frame ? frame->n_vectors : 0,
 			     /* is_after */ 0);
 
-  vlib_node_runtime_perf_counter (vm, &pmc_before[0], &pmc_before[1]);
+  vlib_node_runtime_perf_counter (vm, node, 0, /* is_after */ 0);
 
   /*
    * Turn this on if you run into
@@ -1211,26 +1207,22 @@ dispatch_node (vlib_main_t * vm,
 
   t = clib_cpu_time_now ();
 
-  /*
-   * To validate accounting: pmc_delta = t - pmc_before;
-   * perf ticks should equal clocks/pkt...
-   */
-  vlib_node_runtime_perf_counter (vm, &pmc_after[0], &pmc_after[1]);
-
-  pmc_delta[0] = pmc_after[0] - pmc_before[0];
-  pmc_delta[1] = pmc_after[1] - pmc_before[1];
+  vlib_node_runtime_perf_counter (vm, node, n, /* is_after */ 1);
 
   vlib_elog_main_loop_event (vm, node->node_index, t, n, 1 /* is_after */ );
 
   vm->main_loop_vectors_processed += n;
   vm->main_loop_nodes_processed += n > 0;
 
+  if (PREDICT_FALSE (vm->node_histogram_enable))
+    vlib_node_histogram_add (vm,
+			     &vlib_thread_main.node_dispatch_histogram,
+			     node->node_index, t - last_time_stamp);
+
   v = vlib_node_runtime_update_stats (vm, node,
 				      /* n_calls */ 1,
 				      /* n_vectors */ n,
-				      /* n_clocks */ t - last_time_stamp,
-				      pmc_delta[0] /* PMC0 */ ,
-				      pmc_delta[1] /* PMC1 */ );
+				      /* n_clocks */ t - last_time_stamp);
 
   /* When in interrupt mode and vector rate crosses threshold switch to
      polling mode. */
@@ -1676,7 +1668,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   vlib_node_main_t *nm = &vm->node_main;
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   uword i;
-  u64 cpu_time_now;
+  u64 cpu_time_now, cpu_time_last_loop;
   vlib_frame_queue_main_t *fqm;
   u32 *last_node_runtime_indices = 0;
   u32 frame_queue_check_counter = 0;
@@ -1722,6 +1714,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 					 cpu_time_now);
     }
 
+  cpu_time_last_loop = cpu_time_now;
+
   while (1)
     {
       vlib_node_runtime_t *n;
@@ -1735,6 +1729,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  vlib_worker_thread_quiescent_state (vm);
 	  if (PREDICT_FALSE (vm->check_frame_queues +
 			     frame_queue_check_counter))
 	    {
@@ -1907,12 +1902,21 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 		}
 	      _vec_len (nm->data_from_advancing_timing_wheel) = 0;
 	    }
+
+	  /* Run deferred frees whose grace period has elapsed */
+	  if (PREDICT_FALSE (vec_len (tm->grace_period_callbacks) > 0))
+	    vlib_worker_thread_grace_period_poll (vm);
 	}
       vlib_increment_main_loop_counter (vm);
 
       /* Record time stamp in case there are no enabled nodes and above
          calls do not update time stamp. */
       cpu_time_now = clib_cpu_time_now ();
+
+      if (PREDICT_FALSE (vm->node_histogram_enable))
+	vlib_node_histogram_add (vm, &tm->main_loop_histogram, 0,
+				 cpu_time_now - cpu_time_last_loop);
+      cpu_time_last_loop = cpu_time_now;
     }
 }
 
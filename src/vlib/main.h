@@ -62,7 +62,13 @@ typedef struct
 {
   int pcap_enable;
   u32 pcap_sw_if_index;
+  /* first classify table of the capture filter chain, ~0 if none */
+  u32 pcap_filter_table_index;
+  /* this thread's captured packets, drained by the pcap writer process */
+  pcap_ring_t pcap_ring;
+  /* main thread only: output file */
   pcap_main_t pcap_main;
+  u32 pcap_n_files;
 } vnet_pcap_t;
 
 typedef struct vlib_main_t
@@ -93,9 +99,14 @@ typedef struct vlib_main_t
   u32 vector_counts_per_main_loop[2];
   u32 node_counts_per_main_loop[2];
 
-  /* Main loop hw / sw performance counters */
+  /* Main loop hw / sw performance counters, called before (is_after = 0)
+     and after each node dispatch with the number of vectors processed. */
   void (*vlib_node_runtime_perf_counter_cb) (struct vlib_main_t *,
-					     u64 *, u64 *);
+					     struct vlib_node_runtime_t *,
+					     uword n_vectors, int is_after);
+
+  /* Node dispatch and main loop time histograms are collected */
+  int node_histogram_enable;
 
   /* Every so often we switch to the next counter. */
 #define VLIB_LOG2_MAIN_LOOPS_PER_STATS_UPDATE 7
@@ -520,9 +520,41 @@ u32
 vlib_register_node (vlib_main_t * vm, vlib_node_registration_t * r)
 {
   register_node (vm, r);
+  if (vm->node_histogram_enable)
+    vlib_node_histogram_validate (vm);
   return r->index;
 }
 
+void
+vlib_node_histogram_validate (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+
+  vlib_validate_simple_counter (&tm->node_dispatch_histogram,
+				vec_len (vm->node_main.nodes) *
+				VLIB_NODE_HISTOGRAM_N_BUCKETS - 1);
+  vlib_validate_simple_counter (&tm->main_loop_histogram,
+				VLIB_NODE_HISTOGRAM_N_BUCKETS - 1);
+}
+
+void
+vlib_node_histogram_enable_disable (vlib_main_t * vm, int enable)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  int i;
+
+  if (enable)
+    {
+      vlib_node_histogram_validate (vm);
+      vlib_clear_simple_counters (&tm->node_dispatch_histogram);
+      vlib_clear_simple_counters (&tm->main_loop_histogram);
+    }
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    if (vlib_mains[i])
+      vlib_mains[i]->node_histogram_enable = enable;
+}
+
 static uword
 null_node_fn (vlib_main_t * vm,
 	      vlib_node_runtime_t * node, vlib_frame_t * frame)
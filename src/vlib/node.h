@@ -232,9 +232,6 @@ typedef struct
   u64 calls, vectors, clocks, suspends;
   u64 max_clock;
   u64 max_clock_n;
-  u64 perf_counter0_ticks;
-  u64 perf_counter1_ticks;
-  u64 perf_counter_vectors;
 } vlib_node_stats_t;
 
 #define foreach_vlib_node_state					\
@@ -485,10 +482,6 @@ typedef struct vlib_node_runtime_t
   u32 vectors_since_last_overflow;	/**< Number of vector elements
 					  processed by this node. */
 
-  u32 perf_counter0_ticks_since_last_overflow; /**< Perf counter 0 ticks */
-  u32 perf_counter1_ticks_since_last_overflow; /**< Perf counter 1 ticks */
-  u32 perf_counter_vectors_since_last_overflow;	/**< Perf counter vectors */
-
   u32 next_frame_index;			/**< Start of next frames for this
 					  node. */
 
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * node_bench.c: graph node microbenchmark
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/node_bench.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+static char *vlib_node_bench_pmc_names[] = {
+#define _(f, s) s,
+  foreach_vlib_node_bench_pmc
+#undef _
+};
+
+static u64 vlib_node_bench_pmc_configs[] = {
+  [VLIB_NODE_BENCH_PMC_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+  [VLIB_NODE_BENCH_PMC_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+  [VLIB_NODE_BENCH_PMC_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+  [VLIB_NODE_BENCH_PMC_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+};
+
+/*
+ * Open the hardware counters as one group, counting user space only so
+ * that the ioctls around each call are left out. Returns the group
+ * leader fd, or -1 when the kernel or the processor does not allow it.
+ */
+static int
+vlib_node_bench_pmc_open (int *fds)
+{
+  struct perf_event_attr pe;
+  int i, group_fd = -1;
+
+  for (i = 0; i < VLIB_NODE_BENCH_N_PMC; i++)
+    {
+      clib_memset (&pe, 0, sizeof (pe));
+      pe.type = PERF_TYPE_HARDWARE;
+      pe.size = sizeof (pe);
+      pe.config = vlib_node_bench_pmc_configs[i];
+      pe.disabled = (i == 0);
+      pe.exclude_kernel = 1;
+      pe.exclude_hv = 1;
+      pe.read_format = PERF_FORMAT_GROUP;
+
+      fds[i] = syscall (__NR_perf_event_open, &pe, 0 /* this thread */ ,
+			-1 /* any cpu */ , group_fd, 0);
+      if (fds[i] < 0)
+	{
+	  while (i-- > 0)
+	    close (fds[i]);
+	  return -1;
+	}
+      if (i == 0)
+	group_fd = fds[0];
+    }
+  return group_fd;
+}
+
+static void
+vlib_node_bench_pmc_close (int *fds)
+{
+  int i;
+
+  for (i = 0; i < VLIB_NODE_BENCH_N_PMC; i++)
+    close (fds[i]);
+}
+
+static int
+vlib_node_bench_pmc_read (int group_fd, u64 * pmc)
+{
+  struct
+  {
+    u64 n;
+    u64 values[VLIB_NODE_BENCH_N_PMC];
+  } data;
+
+  if (read (group_fd, &data, sizeof (data)) != sizeof (data))
+    return -1;
+  clib_memcpy_fast (pmc, data.values, sizeof (data.values));
+  return 0;
+}
+
+/* Fill the frame with fresh copies of the template buffers */
+static clib_error_t *
+vlib_node_bench_fill (vlib_main_t * vm, vlib_node_bench_args_t * a,
+		      vlib_frame_t * f, u32 * template_index)
+{
+  u32 *to = vlib_frame_vector_args (f);
+  vlib_buffer_t *b;
+  u32 i;
+
+  for (i = 0; i < a->frame_size; i++)
+    {
+      b = vlib_buffer_copy (vm, vlib_get_buffer (vm, a->template_buffers
+						 [*template_index]));
+      if (b == 0)
+	{
+	  vlib_buffer_free (vm, to, i);
+	  return clib_error_return (0, "buffer allocation failure");
+	}
+
+      b->flags &= ~VLIB_BUFFER_IS_TRACED;
+      vlib_buffer_advance (b, a->advance);
+      to[i] = vlib_get_buffer_index (vm, b);
+
+      *template_index += 1;
+      if (*template_index >= vec_len (a->template_buffers))
+	*template_index = 0;
+    }
+
+  f->n_vectors = a->frame_size;
+  f->flags = 0;
+  return 0;
+}
+
+/*
+ * Take back the frames the node enqueued, as the pending frames past
+ * n_pending, instead of dispatching them: count and free the packets,
+ * then release the frames the way dispatch_pending_node does.
+ */
+static void
+vlib_node_bench_drain (vlib_main_t * vm, u32 n_pending,
+		       vlib_node_bench_result_t * r)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_pending_frame_t *p;
+  vlib_node_runtime_t *n;
+  vlib_next_frame_t *nf;
+  vlib_frame_t *f;
+
+  for (p = nm->pending_frames + n_pending;
+       p < vec_end (nm->pending_frames); p++)
+    {
+      n = vec_elt_at_index (nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL],
+			    p->node_runtime_index);
+      f = vlib_get_frame (vm, p->frame_index);
+
+      vec_validate (r->n_vectors_by_next_node, n->node_index);
+      r->n_vectors_by_next_node[n->node_index] += f->n_vectors;
+
+      if (f->vector_size == sizeof (u32))
+	vlib_buffer_free (vm, vlib_frame_vector_args (f), f->n_vectors);
+
+      f->frame_flags &= ~(VLIB_FRAME_PENDING | VLIB_FRAME_NO_APPEND);
+
+      nf = 0;
+      if (p->next_frame_index != VLIB_PENDING_FRAME_NO_NEXT_FRAME)
+	nf = vec_elt_at_index (nm->next_frames, p->next_frame_index);
+
+      /* The next frame keeps its frame, empty */
+      if (nf && nf->frame_index == p->frame_index)
+	f->n_vectors = 0;
+      else if (f->frame_flags & VLIB_FRAME_FREE_AFTER_DISPATCH)
+	vlib_frame_free (vm, n, f);
+    }
+
+  _vec_len (nm->pending_frames) = n_pending;
+}
+
+/*
+ * Run the node over a->n_warmup_frames + a->n_frames frames, measuring
+ * the last a->n_frames. Only the node function itself is timed, the
+ * frames are filled and drained outside of the measurement.
+ */
+clib_error_t *
+vlib_node_bench (vlib_main_t * vm, vlib_node_bench_args_t * a,
+		 vlib_node_bench_result_t * r)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_node_runtime_t *rt;
+  clib_error_t *error = 0;
+  int fds[VLIB_NODE_BENCH_N_PMC];
+  int group_fd = -1;
+  u32 i, n_pending, template_index = 0;
+  vlib_node_t *node;
+  vlib_frame_t *f;
+  u64 t0, t1;
+
+  clib_memset (r, 0, sizeof (r[0]));
+  r->node_index = a->node_index;
+
+  node = vlib_get_node (vm, a->node_index);
+  if (node->type != VLIB_NODE_TYPE_INTERNAL)
+    return clib_error_return (0, "%v is not an internal node", node->name);
+  if (node->vector_size != sizeof (u32))
+    return clib_error_return (0, "%v does not take buffers", node->name);
+  if (vec_len (a->template_buffers) == 0)
+    return clib_error_return (0, "no packets to benchmark with");
+  if (a->frame_size == 0 || a->frame_size > VLIB_FRAME_SIZE)
+    return clib_error_return (0, "frame size must be 1 to %d",
+			      VLIB_FRAME_SIZE);
+
+  if (a->use_pmc)
+    group_fd = vlib_node_bench_pmc_open (fds);
+
+  rt = vlib_node_get_runtime (vm, a->node_index);
+  f = vlib_get_frame_to_node (vm, a->node_index);
+  n_pending = vec_len (nm->pending_frames);
+
+  for (i = 0; i < a->n_warmup_frames + a->n_frames; i++)
+    {
+      if (i == a->n_warmup_frames)
+	{
+	  vec_free (r->n_vectors_by_next_node);
+	  if (group_fd >= 0)
+	    ioctl (group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	}
+
+      if ((error = vlib_node_bench_fill (vm, a, f, &template_index)))
+	break;
+
+      /* Packet trace would be measured as well */
+      rt->flags &= ~VLIB_NODE_FLAG_TRACE;
+
+      if (group_fd >= 0)
+	ioctl (group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      t0 = clib_cpu_time_now ();
+      rt->function (vm, rt, f);
+      t1 = clib_cpu_time_now ();
+      if (group_fd >= 0)
+	ioctl (group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+      vlib_node_bench_drain (vm, n_pending, r);
+
+      if (i < a->n_warmup_frames)
+	continue;
+
+      r->n_calls += 1;
+      r->n_vectors += a->frame_size;
+      r->clocks += t1 - t0;
+    }
+
+  if (group_fd >= 0)
+    {
+      if (error == 0)
+	r->pmc_valid = vlib_node_bench_pmc_read (group_fd, r->pmc) == 0;
+      vlib_node_bench_pmc_close (fds);
+    }
+
+  vlib_frame_free (vm, rt, f);
+  return error;
+}
+
+void
+vlib_node_bench_result_free (vlib_node_bench_result_t * r)
+{
+  vec_free (r->n_vectors_by_next_node);
+}
+
+static f64
+vlib_node_bench_ratio (u64 a, u64 b)
+{
+  return b ? (f64) a / (f64) b : 0.0;
+}
+
+u8 *
+format_vlib_node_bench_result (u8 * s, va_list * args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  vlib_node_bench_result_t *r = va_arg (*args, vlib_node_bench_result_t *);
+  int json = va_arg (*args, int);
+  f64 clocks_per_packet = vlib_node_bench_ratio (r->clocks, r->n_vectors);
+  f64 ns_per_packet =
+    1e9 * clocks_per_packet / vm->clib_time.clocks_per_second;
+  f64 vectors_per_call = vlib_node_bench_ratio (r->n_vectors, r->n_calls);
+  char *sep = "";
+  int i;
+
+  if (json)
+    {
+      s = format (s, "{\"node\": \"%U\", \"calls\": %lld, \"packets\": %lld, "
+		  "\"clocks\": %lld, \"clocks_per_packet\": %.2f, "
+		  "\"ns_per_packet\": %.2f, \"vectors_per_call\": %.2f, "
+		  "\"next_nodes\": {", format_vlib_node_name, vm,
+		  r->node_index, r->n_calls, r->n_vectors, r->clocks,
+		  clocks_per_packet, ns_per_packet, vectors_per_call);
+      vec_foreach_index (i, r->n_vectors_by_next_node)
+      {
+	if (r->n_vectors_by_next_node[i] == 0)
+	  continue;
+	s = format (s, "%s\"%U\": %lld", sep, format_vlib_node_name, vm, i,
+		    r->n_vectors_by_next_node[i]);
+	sep = ", ";
+      }
+      s = format (s, "}, \"pmc\": {");
+      sep = "";
+      for (i = 0; r->pmc_valid && i < VLIB_NODE_BENCH_N_PMC; i++)
+	{
+	  s = format (s, "%s\"%s\": %lld", sep, vlib_node_bench_pmc_names[i],
+		      r->pmc[i]);
+	  sep = ", ";
+	}
+      return format (s, "}}");
+    }
+
+  s = format (s, "%U: %lld packets in %lld calls, %.2f vectors/call\n",
+	      format_vlib_node_name, vm, r->node_index, r->n_vectors,
+	      r->n_calls, vectors_per_call);
+  s = format (s, "  %.2f clocks/packet, %.2f ns/packet\n",
+	      clocks_per_packet, ns_per_packet);
+  s = format (s, "  next nodes:\n");
+  vec_foreach_index (i, r->n_vectors_by_next_node)
+  {
+    if (r->n_vectors_by_next_node[i])
+      s = format (s, "    %-30U %lld\n", format_vlib_node_name, vm, i,
+		  r->n_vectors_by_next_node[i]);
+  }
+  if (!r->pmc_valid)
+    return format (s, "  hardware counters not available\n");
+
+  s = format (s, "  hardware counters, per packet:\n");
+  for (i = 0; i < VLIB_NODE_BENCH_N_PMC; i++)
+    s = format (s, "    %-30s %.2f\n", vlib_node_bench_pmc_names[i],
+		vlib_node_bench_ratio (r->pmc[i], r->n_vectors));
+  return s;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
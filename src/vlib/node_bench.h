@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * node_bench.h: graph node microbenchmark
+ *
+ * Runs the function of a single internal node over frames of copies of
+ * template buffers, with no interface involved, and measures clocks per
+ * packet, vectors per call, the distribution of the packets over the
+ * next nodes and, where the kernel allows it, hardware counters.
+ * Packets the node enqueues are freed instead of being dispatched.
+ */
+
+#ifndef included_vlib_node_bench_h
+#define included_vlib_node_bench_h
+
+#include <vlib/vlib.h>
+
+#define foreach_vlib_node_bench_pmc		\
+  _(CYCLES, "cpu-cycles")			\
+  _(INSTRUCTIONS, "instructions")		\
+  _(BRANCH_MISSES, "branch-misses")		\
+  _(CACHE_MISSES, "cache-misses")
+
+typedef enum
+{
+#define _(f, s) VLIB_NODE_BENCH_PMC_##f,
+  foreach_vlib_node_bench_pmc
+#undef _
+    VLIB_NODE_BENCH_N_PMC,
+} vlib_node_bench_pmc_t;
+
+typedef struct
+{
+  /* Internal node to benchmark. */
+  u32 node_index;
+
+  /* Packets the frames are filled with, round robin. Not modified. */
+  u32 *template_buffers;
+
+  /* Bytes to advance the copies by, e.g. past the l2 header. */
+  i16 advance;
+
+  /* Number of measured frames, and of frames run beforehand to warm
+     up the caches. */
+  u32 n_frames;
+  u32 n_warmup_frames;
+
+  /* Packets per frame, at most VLIB_FRAME_SIZE. */
+  u32 frame_size;
+
+  /* Collect hardware counters, if available. */
+  u8 use_pmc;
+} vlib_node_bench_args_t;
+
+typedef struct
+{
+  u32 node_index;
+
+  u64 n_calls;
+  u64 n_vectors;
+  u64 clocks;
+
+  /* Vectors enqueued by the node, indexed by next node index. */
+  u64 *n_vectors_by_next_node;
+
+  /* Non-zero when the hardware counters were collected. */
+  u8 pmc_valid;
+  u64 pmc[VLIB_NODE_BENCH_N_PMC];
+} vlib_node_bench_result_t;
+
+clib_error_t *vlib_node_bench (vlib_main_t * vm,
+			       vlib_node_bench_args_t * a,
+			       vlib_node_bench_result_t * r);
+
+void vlib_node_bench_result_free (vlib_node_bench_result_t * r);
+
+/* Argument: 1 for JSON, 0 for text. */
+format_function_t format_vlib_node_bench_result;
+
+#endif /* included_vlib_node_bench_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -518,6 +518,9 @@ clear_node_runtime (vlib_main_t * vm,
       nm->time_last_runtime_stats_clear = vlib_time_now (vm);
     }
 
+  vlib_clear_simple_counters (&vlib_thread_main.node_dispatch_histogram);
+  vlib_clear_simple_counters (&vlib_thread_main.main_loop_histogram);
+
   vlib_worker_thread_barrier_release (vm);
 
   vec_free (stat_vms);
@@ -743,6 +746,139 @@ VLIB_CLI_COMMAND (set_node_fn_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_node_histogram (vlib_main_t * vm, unformat_input_t * input,
+		    vlib_cli_command_t * cmd)
+{
+  int enable;
+
+  if (unformat (input, "on"))
+    enable = 1;
+  else if (unformat (input, "off"))
+    enable = 0;
+  else
+    return clib_error_return (0, "expected on or off, got `%U'",
+			      format_unformat_error, input);
+
+  vlib_node_histogram_enable_disable (vm, enable);
+  return 0;
+}
+
+/*?
+ * Start or stop collecting per thread log2 histograms of the time taken
+ * by each node dispatch and by each main loop iteration. They are
+ * built from the time stamps the main loop already takes, so that they
+ * can be left on. Starting collection clears the histograms, as does
+ * '<em>clear runtime</em>'.
+ *
+ * The histograms are exported in the stats segment as
+ * /sys/node/dispatch-time, where the buckets of node index n are
+ * counters [32 * n, 32 * n + 31], and as /sys/main-loop/time. Bucket 0
+ * counts times below 2 clocks, bucket b times in [2^b, 2^(b+1)) clocks.
+ *
+ * @cliexpar
+ * @cliexcmd{set node histogram on}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_histogram_command, static) = {
+  .path = "set node histogram",
+  .short_help = "set node histogram on|off",
+  .function = set_node_histogram,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_node_histogram_bucket (u8 * s, va_list * args)
+{
+  u32 bucket = va_arg (*args, u32);
+
+  if (bucket == 0)
+    return format (s, "< 2");
+  if (bucket == VLIB_NODE_HISTOGRAM_N_BUCKETS - 1)
+    return format (s, ">= %lld", 1ULL << bucket);
+  return format (s, "[%lld, %lld)", 1ULL << bucket, 1ULL << (bucket + 1));
+}
+
+static clib_error_t *
+show_node_histogram (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_simple_counter_main_t *cm = &tm->main_loop_histogram;
+  u32 i, j, index = 0, node_index = ~0;
+  counter_t *counts, total;
+  u8 *s = 0;
+
+  if (unformat (input, "%U", unformat_vlib_node, vm, &node_index))
+    {
+      cm = &tm->node_dispatch_histogram;
+      index = node_index;
+    }
+  else if (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    return clib_error_return (0, "unknown input `%U'",
+			      format_unformat_error, input);
+
+  if (!vm->node_histogram_enable)
+    vlib_cli_output (vm, "Histograms are not being collected");
+
+  if (vec_len (cm->counters) == 0 ||
+      (index + 1) * VLIB_NODE_HISTOGRAM_N_BUCKETS > vec_len (cm->counters[0]))
+    return 0;
+
+  if (node_index == ~0)
+    vlib_cli_output (vm, "Main loop time");
+  else
+    vlib_cli_output (vm, "Dispatch time, %U", format_vlib_node_name, vm,
+		     node_index);
+  s = format (s, "%=24s", "clocks");
+  for (j = 0; j < vec_len (cm->counters); j++)
+    s = format (s, "%=12s", vlib_worker_threads[j].name);
+  vlib_cli_output (vm, "%v", s);
+
+  for (i = 0; i < VLIB_NODE_HISTOGRAM_N_BUCKETS; i++)
+    {
+      vec_reset_length (s);
+      s = format (s, "%=24U", format_node_histogram_bucket, i);
+      total = 0;
+      for (j = 0; j < vec_len (cm->counters); j++)
+	{
+	  counts = cm->counters[j];
+	  total += counts[index * VLIB_NODE_HISTOGRAM_N_BUCKETS + i];
+	  s = format (s, "%=12lld",
+		      counts[index * VLIB_NODE_HISTOGRAM_N_BUCKETS + i]);
+	}
+      if (total)
+	vlib_cli_output (vm, "%v", s);
+    }
+
+  vec_free (s);
+  return 0;
+}
+
+/*?
+ * Display the per thread histogram of the dispatch time of the given
+ * node, or of the main loop iteration time when no node is given. The
+ * main loop time of the main thread includes the time spent waiting
+ * for input in the main thread's epoll.
+ *
+ * @cliexpar
+ * @cliexstart{show node histogram ip4-lookup}
+ * Dispatch time, ip4-lookup
+ *          clocks             vpp_main   vpp_wk_0
+ *      [256, 512)                  0        1482
+ *      [512, 1024)                 0       20113
+ *     [1024, 2048)                 0         931
+ *    [262144, 524288)              0           2
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_histogram_command, static) = {
+  .path = "show node histogram",
+  .short_help = "show node histogram [<node-name>]",
+  .function = show_node_histogram,
+};
+/* *INDENT-ON* */
+
 /* Dummy function to get us linked in. */
 void
 vlib_node_cli_reference (void)
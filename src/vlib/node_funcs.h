@@ -1164,6 +1164,13 @@ void vlib_start_process (vlib_main_t * vm, uword process_index);
 /* Sync up runtime and main node stats. */
 void vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n);
 
+/* Size the node dispatch time histograms to the registered nodes. */
+void vlib_node_histogram_validate (vlib_main_t * vm);
+
+/* Start or stop collecting node dispatch and main loop time histograms,
+   on all threads. Called with the worker barrier held. */
+void vlib_node_histogram_enable_disable (vlib_main_t * vm, int enable);
+
 /* Node graph initialization function. */
 clib_error_t *vlib_node_main_init (vlib_main_t * vm);
 
@@ -65,6 +65,19 @@ elog_global_id_for_msg_name (const char *msg_name)
   return r;
 }
 
+static inline void
+barrier_histogram_add (vlib_simple_counter_main_t * cm, f64 t)
+{
+  u64 usec = (u64) (1000000.0 * t);
+  u32 bucket;
+
+  /* Bucket 0 is sub-microsecond, bucket n covers [2^(n-1), 2^n) usec */
+  bucket = usec ? min_log2 (usec) + 1 : 0;
+  bucket = clib_min (bucket, VLIB_BARRIER_HISTOGRAM_N_BUCKETS - 1);
+
+  vlib_increment_simple_counter (cm, 0 /* main thread */ , bucket, 1);
+}
+
 static inline void
 barrier_trace_sync (f64 t_entry, f64 t_open, f64 t_closed)
 {
@@ -1199,6 +1212,26 @@ vlib_worker_thread_node_refork (void)
 					 CLIB_CACHE_LINE_BYTES);
 }
 
+/*
+ * Each thread logs dispatch events to its own ring, on its track. The
+ * rings are allocated the first time dispatch tracing is turned on,
+ * with the workers at the barrier.
+ */
+void
+vlib_worker_thread_elog_rings_init (vlib_main_t * vm)
+{
+  vlib_worker_thread_t *w;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (vec_len (vm->elog_main.thread_rings) == vec_len (vlib_worker_threads))
+    return;
+
+  vec_foreach (w, vlib_worker_threads)
+    elog_thread_ring_add (&vm->elog_main, w - vlib_worker_threads,
+			  &w->elog_track);
+}
+
 void
 vlib_worker_thread_node_runtime_update (void)
 {
@@ -1447,6 +1480,7 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *func_name)
 
   t_closed = now - vm->barrier_epoch;
 
+  barrier_histogram_add (&vlib_thread_main.barrier_sync_histogram, t_closed);
   barrier_trace_sync (t_entry, t_open, t_closed);
 
 }
@@ -1553,6 +1587,9 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
   t_closed_total = now - vm->barrier_epoch;
 
+  barrier_histogram_add (&vlib_thread_main.barrier_hold_histogram,
+			 t_closed_total);
+
   minimum_open = t_closed_total * BARRIER_MINIMUM_OPEN_FACTOR;
 
   if (minimum_open > BARRIER_MINIMUM_OPEN_LIMIT)
@@ -1569,6 +1606,112 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
 }
 
+/*
+ * Quiescent-state based deferred reclamation.
+ *
+ * Workers announce a quiescent state once per main loop iteration by
+ * copying the current grace-period epoch into their own
+ * vlib_worker_thread_t. A control-plane update which has unlinked an
+ * object from all data-plane reachable structures hands the free over
+ * to vlib_call_after_grace_period(), which starts a new epoch. Once
+ * every worker has announced that epoch, no worker can still hold a
+ * reference to the object and the callback runs on the main thread.
+ * Unlike the barrier, workers never stop forwarding.
+ */
+
+static u64
+vlib_grace_period_quiescent_epoch (void)
+{
+  u64 epoch = vlib_thread_main.grace_period_epoch;
+  int i;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      if (vlib_mains[i] == 0)
+	continue;
+      epoch = clib_min (epoch,
+			clib_atomic_load_acq_n
+			(&vlib_worker_threads[i].quiescent_epoch));
+    }
+
+  return epoch;
+}
+
+void
+vlib_call_after_grace_period (vlib_main_t * vm,
+			      vlib_grace_period_callback_fn_t * fn, void *arg)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_grace_period_callback_t *cb;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  vec_add2 (tm->grace_period_callbacks, cb, 1);
+  cb->fn = fn;
+  cb->arg = arg;
+  cb->epoch = tm->grace_period_epoch + 1;
+
+  /* Order the caller's unlink before the new epoch becomes visible */
+  clib_atomic_store_rel_n (&tm->grace_period_epoch, cb->epoch);
+}
+
+void
+vlib_wait_for_grace_period (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  f64 deadline;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  /* No workers, or workers parked at the barrier: nothing to wait for */
+  if (vec_len (vlib_mains) < 2 || vlib_worker_threads[0].recursion_level > 0)
+    return;
+
+  epoch = tm->grace_period_epoch + 1;
+  clib_atomic_store_rel_n (&tm->grace_period_epoch, epoch);
+
+  deadline = vlib_time_now (vm) + BARRIER_SYNC_TIMEOUT;
+
+  while (vlib_grace_period_quiescent_epoch () < epoch)
+    {
+      if (vlib_time_now (vm) > deadline)
+	{
+	  fformat (stderr, "%s: worker thread deadlock\n", __FUNCTION__);
+	  os_panic ();
+	}
+    }
+}
+
+void
+vlib_worker_thread_grace_period_poll (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_grace_period_callback_t *ready = 0, *cb;
+  u64 epoch;
+  u32 n_ready = 0;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  epoch = vlib_grace_period_quiescent_epoch ();
+
+  /* Callbacks are queued in epoch order */
+  while (n_ready < vec_len (tm->grace_period_callbacks)
+	 && tm->grace_period_callbacks[n_ready].epoch <= epoch)
+    n_ready++;
+
+  if (n_ready == 0)
+    return;
+
+  /* Callbacks may defer more work, so detach the ready ones first */
+  vec_add (ready, tm->grace_period_callbacks, n_ready);
+  vec_delete (tm->grace_period_callbacks, n_ready, 0);
+
+  vec_foreach (cb, ready) cb->fn (cb->arg);
+
+  vec_free (ready);
+}
+
 /*
  * Check the frame queue to see if any frames are available.
  * If so, pull the packets off the frames and put them to
@@ -1814,12 +1957,43 @@ vlib_rpc_call_main_thread (void *callback, u8 * args, u32 arg_size)
 clib_error_t *
 threads_init (vlib_main_t * vm)
 {
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  u32 i;
+
+  tm->barrier_sync_histogram.name = "barrier sync time";
+  tm->barrier_sync_histogram.stat_segment_name = "/sys/barrier/sync-time";
+  tm->barrier_hold_histogram.name = "barrier hold time";
+  tm->barrier_hold_histogram.stat_segment_name = "/sys/barrier/hold-time";
+  tm->node_dispatch_histogram.name = "node dispatch time";
+  tm->node_dispatch_histogram.stat_segment_name = "/sys/node/dispatch-time";
+  tm->main_loop_histogram.name = "main loop time";
+  tm->main_loop_histogram.stat_segment_name = "/sys/main-loop/time";
+
+  vlib_validate_simple_counter (&tm->barrier_sync_histogram,
+				VLIB_BARRIER_HISTOGRAM_N_BUCKETS - 1);
+  vlib_validate_simple_counter (&tm->barrier_hold_histogram,
+				VLIB_BARRIER_HISTOGRAM_N_BUCKETS - 1);
+
+  for (i = 0; i < VLIB_BARRIER_HISTOGRAM_N_BUCKETS; i++)
+    {
+      vlib_zero_simple_counter (&tm->barrier_sync_histogram, i);
+      vlib_zero_simple_counter (&tm->barrier_hold_histogram, i);
+    }
+
   return 0;
 }
 
 VLIB_INIT_FUNCTION (threads_init);
 
 
+static u8 *
+format_barrier_bucket (u8 * s, va_list * args)
+{
+  u32 bucket = va_arg (*args, u32);
+
+  return format (s, "[%lld, %lld)", 1ULL << (bucket - 1), 1ULL << bucket);
+}
+
 static clib_error_t *
 show_clock_command_fn (vlib_main_t * vm,
 		       unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -1858,6 +2032,61 @@ VLIB_CLI_COMMAND (f_command, static) =
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_barrier_histogram_command_fn (vlib_main_t * vm,
+				   unformat_input_t * input,
+				   vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  counter_t sync, hold;
+  int i;
+
+  vlib_cli_output (vm, "Barrier syncs %lld, grace-period epoch %lld, "
+		   "%d deferred callbacks pending",
+		   vlib_worker_threads[0].barrier_sync_count,
+		   tm->grace_period_epoch,
+		   vec_len (tm->grace_period_callbacks));
+  vlib_cli_output (vm, "%=20s%=16s%=16s", "usec", "sync", "hold");
+
+  for (i = 0; i < VLIB_BARRIER_HISTOGRAM_N_BUCKETS; i++)
+    {
+      sync = vlib_get_simple_counter (&tm->barrier_sync_histogram, i);
+      hold = vlib_get_simple_counter (&tm->barrier_hold_histogram, i);
+      if (sync == 0 && hold == 0)
+	continue;
+      if (i == 0)
+	vlib_cli_output (vm, "%=20s%=16lld%=16lld", "< 1", sync, hold);
+      else
+	vlib_cli_output (vm, "%=20U%=16lld%=16lld", format_barrier_bucket, i,
+			 sync, hold);
+    }
+  return 0;
+}
+
+/*?
+ * Display log2 histograms of the time taken for all workers to reach
+ * the barrier (sync) and of the total time the barrier was held closed
+ * (hold). The same histograms are exported in the stats segment as
+ * /sys/barrier/sync-time and /sys/barrier/hold-time.
+ *
+ * @cliexpar
+ * @cliexstart{show barrier histogram}
+ * Barrier syncs 312, grace-period epoch 0, 0 deferred callbacks pending
+ *        usec              sync            hold
+ *      [8, 16)              301              12
+ *      [16, 32)              11             247
+ *      [32, 64)              0               53
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_barrier_histogram_command, static) =
+{
+  .path = "show barrier histogram",
+  .short_help = "show barrier histogram",
+  .function = show_barrier_histogram_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -112,6 +112,11 @@ typedef struct
   int core_id;
   int socket_id;
   pthread_t thread_id;
+
+  /* Third cache line, written only by the owning thread */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  /* Last grace-period epoch observed in a quiescent state */
+  volatile u64 quiescent_epoch;
 } vlib_worker_thread_t;
 
 extern vlib_worker_thread_t *vlib_worker_threads;
@@ -185,6 +190,8 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm);
 
 void vlib_worker_thread_node_runtime_update (void);
 
+void vlib_worker_thread_elog_rings_init (vlib_main_t * vm);
+
 void vlib_create_worker_threads (vlib_main_t * vm, int n,
 				 void (*thread_function) (void *));
 
@@ -208,6 +215,29 @@ void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm,
 void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 
+/* Quiescent-state based deferred reclamation */
+typedef void (vlib_grace_period_callback_fn_t) (void *arg);
+
+typedef struct
+{
+  vlib_grace_period_callback_fn_t *fn;
+  void *arg;
+  /* Run once every worker has announced this epoch */
+  u64 epoch;
+} vlib_grace_period_callback_t;
+
+void vlib_call_after_grace_period (vlib_main_t * vm,
+				   vlib_grace_period_callback_fn_t * fn,
+				   void *arg);
+void vlib_wait_for_grace_period (vlib_main_t * vm);
+void vlib_worker_thread_grace_period_poll (vlib_main_t * vm);
+
+/* Barrier histograms are log2 (microseconds) buckets */
+#define VLIB_BARRIER_HISTOGRAM_N_BUCKETS 24
+
+/* Node dispatch and main loop histograms are log2 (clocks) buckets */
+#define VLIB_NODE_HISTOGRAM_N_BUCKETS 32
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -337,6 +367,26 @@ typedef struct
   /* callbacks */
   vlib_thread_callbacks_t cb;
   int extern_thread_mgmt;
+
+  /* Grace-period epoch, bumped by the main thread on each deferral */
+  volatile u64 grace_period_epoch;
+
+  /* Pending deferred callbacks, in epoch order */
+  vlib_grace_period_callback_t *grace_period_callbacks;
+
+  /* Time taken for all workers to reach the barrier */
+  vlib_simple_counter_main_t barrier_sync_histogram;
+
+  /* Total time the barrier was held closed */
+  vlib_simple_counter_main_t barrier_hold_histogram;
+
+  /* Per thread node dispatch time, VLIB_NODE_HISTOGRAM_N_BUCKETS
+     buckets per node index */
+  vlib_simple_counter_main_t node_dispatch_histogram;
+
+  /* Per thread main loop iteration time, VLIB_NODE_HISTOGRAM_N_BUCKETS
+     buckets */
+  vlib_simple_counter_main_t main_loop_histogram;
 } vlib_thread_main_t;
 
 extern vlib_thread_main_t vlib_thread_main;
@@ -438,6 +488,20 @@ vlib_worker_thread_barrier_check (void)
 	vm->time_last_barrier_release = vlib_time_now (vm);
       }
 
+      /*
+       * Likewise, the offset of this thread's time stamp counter from
+       * thread-0's, so that the events of its elog ring merge in order.
+       */
+      {
+	elog_main_t *em = &vlib_global_main.elog_main;
+
+	if (thread_index < vec_len (em->thread_rings))
+	  em->thread_rings[thread_index].cpu_time_offset =
+	    (i64) (vlib_global_main.clib_time.init_cpu_time -
+		   vm->clib_time.init_cpu_time) +
+	    (i64) (vm->time_offset * vm->clib_time.clocks_per_second);
+      }
+
       if (CLIB_DEBUG > 0)
 	vm->parked_at_barrier = 0;
       clib_atomic_fetch_add (vlib_worker_threads->workers_at_barrier, -1);
@@ -496,6 +560,21 @@ vlib_worker_thread_barrier_check (void)
     }
 }
 
+/** Announce a quiescent state for the calling worker.
+    Called once per main loop iteration, at a point where the worker
+    holds no references to objects retired via
+    vlib_call_after_grace_period. */
+static_always_inline void
+vlib_worker_thread_quiescent_state (vlib_main_t * vm)
+{
+  vlib_worker_thread_t *w = vlib_worker_threads + vm->thread_index;
+  u64 epoch = vlib_thread_main.grace_period_epoch;
+
+  /* Only dirty the cache line when a new epoch has been started */
+  if (PREDICT_FALSE (w->quiescent_epoch != epoch))
+    clib_atomic_store_rel_n (&w->quiescent_epoch, epoch);
+}
+
 always_inline vlib_main_t *
 vlib_get_worker_vlib_main (u32 worker_index)
 {
@@ -41,6 +41,7 @@
 #include <vlib/threads.h>
 
 u8 *vnet_trace_dummy;
+vlib_is_packet_traced_fn_t *vlib_is_packet_traced_fn;
 
 /* Helper function for nodes which only trace buffer data. */
 void
@@ -122,6 +123,7 @@ clear_trace_buffer (void)
     tm = &this_vlib_main->trace_main;
 
     tm->trace_enable = 0;
+    tm->filter_classify_enable = 0;
 
     for (i = 0; i < vec_len (tm->trace_buffer_pool); i++)
       if (! pool_is_free_index (tm->trace_buffer_pool, i))
@@ -359,6 +361,8 @@ cli_add_trace_buffer (vlib_main_t * vm,
   vlib_trace_main_t *tm;
   vlib_trace_node_t *tn;
   u32 node_index, add;
+  u32 thread_index = ~0;
+  u32 filter_table_index = ~0;
   u8 verbose = 0;
   clib_error_t *error = 0;
 
@@ -375,6 +379,11 @@ cli_add_trace_buffer (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "verbose"))
 	verbose = 1;
+      else if (unformat (line_input, "thread %d", &thread_index))
+	;
+      else if (unformat (line_input, "filter classify-table %d",
+			 &filter_table_index))
+	;
       else
 	{
 	  error = clib_error_create ("expected NODE COUNT, got `%U'",
@@ -383,11 +392,31 @@ cli_add_trace_buffer (vlib_main_t * vm,
 	}
     }
 
+  if (thread_index != ~0 && thread_index >= vec_len (vlib_mains))
+    {
+      error = clib_error_create ("thread %d does not exist", thread_index);
+      goto done;
+    }
+
+  if (filter_table_index != ~0 && vlib_is_packet_traced_fn == 0)
+    {
+      error = clib_error_create ("packet classifier not available");
+      goto done;
+    }
+
   /* *INDENT-OFF* */
   foreach_vlib_main ((
     {
+      if (thread_index != ~0 && this_vlib_main->thread_index != thread_index)
+        continue;
       tm = &this_vlib_main->trace_main;
       tm->verbose = verbose;
+      /* the filter stays in place until the trace is cleared */
+      if (filter_table_index != ~0)
+        {
+          tm->filter_classify_enable = 1;
+          tm->filter_classify_table_index = filter_table_index;
+        }
       vec_validate (tm->nodes, node_index);
       tn = tm->nodes + node_index;
       tn->limit += add;
@@ -404,7 +433,8 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (add_trace_cli,static) = {
   .path = "trace add",
-  .short_help = "Trace given number of packets",
+  .short_help = "trace add <node> <count> [thread <n>] "
+    "[filter classify-table <index>] [verbose]",
   .function = cli_add_trace_buffer,
 };
 /* *INDENT-ON* */
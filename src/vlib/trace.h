@@ -87,8 +87,22 @@ typedef struct
 
   /* verbosity */
   int verbose;
+
+  /* only trace packets matching the classify table chain starting at
+     filter_classify_table_index, see vlib_trace_buffer */
+  int filter_classify_enable;
+  u32 filter_classify_table_index;
 } vlib_trace_main_t;
 
+/*
+ * Input trace filter: returns non-zero if the packet matches the
+ * classify table chain starting at table_index. Provided by vnet, which
+ * owns the classifier.
+ */
+typedef int (vlib_is_packet_traced_fn_t) (vlib_buffer_t * b,
+					  u32 table_index);
+extern vlib_is_packet_traced_fn_t *vlib_is_packet_traced_fn;
+
 format_function_t format_vlib_trace;
 
 #endif /* included_vlib_trace_h */
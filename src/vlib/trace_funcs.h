@@ -109,8 +109,13 @@ vlib_trace_next_frame (vlib_main_t * vm,
 
 void trace_apply_filter (vlib_main_t * vm);
 
-/* Mark buffer as traced and allocate trace buffer. */
-always_inline void
+/*
+ * Mark buffer as traced and allocate trace buffer. Returns 0, and leaves
+ * the buffer alone, if tracing is off or the packet does not pass the
+ * input filter: callers only add a trace and consume the node trace
+ * count when the buffer was traced.
+ */
+always_inline int
 vlib_trace_buffer (vlib_main_t * vm,
 		   vlib_node_runtime_t * r,
 		   u32 next_index, vlib_buffer_t * b, int follow_chain)
@@ -119,7 +124,11 @@ vlib_trace_buffer (vlib_main_t * vm,
   vlib_trace_header_t **h;
 
   if (PREDICT_FALSE (tm->trace_enable == 0))
-    return;
+    return 0;
+
+  if (PREDICT_FALSE (tm->filter_classify_enable) &&
+      !vlib_is_packet_traced_fn (b, tm->filter_classify_table_index))
+    return 0;
 
   /*
    * Apply filter to existing traces to keep number of allocated traces low.
@@ -141,6 +150,8 @@ vlib_trace_buffer (vlib_main_t * vm,
       b->trace_index = h - tm->trace_buffer_pool;
     }
   while (follow_chain && (b = vlib_get_next_buffer (vm, b)));
+
+  return 1;
 }
 
 always_inline void
@@ -67,13 +67,13 @@
   _(18, IS_DVR, "dvr", 1)                               \
   _(19, QOS_DATA_VALID, "qos-data-valid", 0)            \
   _(20, GSO, "gso", 0)                                  \
-  _(21, AVAIL1, "avail1", 1)                            \
-  _(22, AVAIL2, "avail2", 1)                            \
-  _(23, AVAIL3, "avail3", 1)                            \
-  _(24, AVAIL4, "avail4", 1)                            \
-  _(25, AVAIL5, "avail5", 1)                            \
-  _(26, AVAIL6, "avail6", 1)                            \
-  _(27, AVAIL7, "avail7", 1)
+  _(21, LATENCY_STAMPED, "latency-stamped", 1)         \
+  _(22, AVAIL1, "avail1", 1)                            \
+  _(23, AVAIL2, "avail2", 1)                            \
+  _(24, AVAIL3, "avail3", 1)                            \
+  _(25, AVAIL4, "avail4", 1)                            \
+  _(26, AVAIL5, "avail5", 1)                            \
+  _(27, AVAIL6, "avail6", 1)
 
 /*
  * Please allocate the FIRST available bit, redefine
@@ -83,8 +83,7 @@
 
 #define VNET_BUFFER_FLAGS_ALL_AVAIL                                     \
   (VNET_BUFFER_F_AVAIL1 | VNET_BUFFER_F_AVAIL2 | VNET_BUFFER_F_AVAIL3 | \
-   VNET_BUFFER_F_AVAIL4 | VNET_BUFFER_F_AVAIL5 | VNET_BUFFER_F_AVAIL6 | \
-   VNET_BUFFER_F_AVAIL7)
+   VNET_BUFFER_F_AVAIL4 | VNET_BUFFER_F_AVAIL5 | VNET_BUFFER_F_AVAIL6)
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -423,6 +422,9 @@ typedef struct
     };
     u32 unused[8];
   };
+
+  /* Time the packet was received, valid with VNET_BUFFER_F_LATENCY_STAMPED */
+  u64 latency_timestamp;
 } vnet_buffer_opaque2_t;
 
 #define vnet_buffer2(b) ((vnet_buffer_opaque2_t *) (b)->opaque2)
@@ -435,7 +437,12 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque2_t) <=
 	       STRUCT_SIZE_OF (vlib_buffer_t, opaque2),
 	       "VNET buffer opaque2 meta-data too large for vlib_buffer");
 
-#define gso_mtu_sz(b) (vnet_buffer2(b)->gso_size + vnet_buffer2(b)->gso_l4_hdr_sz + vnet_buffer(b)->l4_hdr_offset)
+/* IP length of the segments of a GSO packet. The header offsets are
+   from the start of the buffer, so only their difference counts. */
+#define gso_mtu_sz(b) (vnet_buffer2(b)->gso_size + \
+		       vnet_buffer2(b)->gso_l4_hdr_sz + \
+		       vnet_buffer(b)->l4_hdr_offset - \
+		       vnet_buffer(b)->l3_hdr_offset)
 
 
 format_function_t format_vnet_buffer;
@@ -18,6 +18,7 @@
 #include <vnet/api_errno.h>	/* for API error numbers */
 #include <vnet/l2/l2_classify.h>	/* for L2_INPUT_CLASSIFY_NEXT_xxx */
 #include <vnet/fib/fib_table.h>
+#include <vnet/pcap_capture.h>
 
 vnet_classify_main_t vnet_classify_main;
 
@@ -140,6 +141,11 @@ vnet_classify_new_table (vnet_classify_main_t * cm,
   t->skip_n_vectors = skip_n_vectors;
   t->entries_per_page = 2;
 
+  t->filter_mask = clib_min (nbuckets, VNET_CLASSIFY_FILTER_MAX_BITS) - 1;
+  clib_bitmap_alloc (t->filter, t->filter_mask + 1);
+  clib_bitmap_zero (t->filter);
+  vec_validate (t->filter_counts, t->filter_mask);
+
 #if USE_DLMALLOC == 0
   t->mheap = mheap_alloc (0 /* use VM */ , memory_size);
 #else
@@ -169,6 +175,9 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
   if (pool_is_free_index (cm->tables, table_index))
     return;
 
+  /* Packet capture must not match against a freed table */
+  vnet_pcap_classify_table_delete (vlib_get_main (), table_index);
+
   t = pool_elt_at_index (cm->tables, table_index);
   if (del_chain && t->next_table_index != ~0)
     /* Recursively delete the entire chain */
@@ -176,6 +185,8 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
 
   vec_free (t->mask);
   vec_free (t->buckets);
+  clib_bitmap_free (t->filter);
+  vec_free (t->filter_counts);
 #if USE_DLMALLOC == 0
   mheap_free (t->mheap);
 #else
@@ -416,6 +427,30 @@ vnet_classify_entry_release_resource (vnet_classify_entry_t * e)
     }
 }
 
+/*
+ * Account for a session added to or deleted from a bucket in the
+ * prefilter. A filter bit is cleared once the last session of the
+ * buckets folded onto it goes away.
+ */
+static void
+vnet_classify_filter_update (vnet_classify_table_t * t, u32 bucket_index,
+			     u32 old_active_elements, u32 new_active_elements)
+{
+  u32 i = bucket_index & t->filter_mask;
+
+  if (new_active_elements > old_active_elements)
+    t->filter_counts[i]++;
+  else if (new_active_elements < old_active_elements)
+    {
+      ASSERT (t->filter_counts[i]);
+      if (--t->filter_counts[i] == 0)
+	clib_bitmap_set_no_check (t->filter, i, 0);
+    }
+  else if (t->filter_counts[i] == 0)
+    /* nothing was added after all */
+    clib_bitmap_set_no_check (t->filter, i, 0);
+}
+
 int
 vnet_classify_add_del (vnet_classify_table_t * t,
 		       vnet_classify_entry_t * add_v, int is_add)
@@ -433,6 +468,7 @@ vnet_classify_add_del (vnet_classify_table_t * t,
   u8 *key_minus_skip;
   int resplit_once = 0;
   int mark_bucket_linear;
+  u32 active_elements;
 
   ASSERT ((add_v->flags & VNET_CLASSIFY_ENTRY_FREE) == 0);
 
@@ -449,6 +485,13 @@ vnet_classify_add_del (vnet_classify_table_t * t,
   while (clib_atomic_test_and_set (t->writer_lock))
     ;
 
+  /* Another writer may have changed the count until we held the lock */
+  active_elements = t->active_elements;
+
+  /* Let lookups through the prefilter before the session shows up */
+  if (is_add)
+    clib_bitmap_set_no_check (t->filter, bucket_index & t->filter_mask, 1);
+
   /* First elt in the bucket? */
   if (b->offset == 0)
     {
@@ -640,6 +683,8 @@ expand_ok:
   vnet_classify_entry_free (t, v, old_log2_pages);
 
 unlock:
+  vnet_classify_filter_update (t, bucket_index, active_elements,
+			       t->active_elements);
   CLIB_MEMORY_BARRIER ();
   t->writer_lock[0] = 0;
   return rv;
@@ -745,6 +790,9 @@ format_classify_table (u8 * s, va_list * args)
   s = format (s, "    %lld active elements\n", active_elements);
   s = format (s, "    %d free lists\n", vec_len (t->freelists));
   s = format (s, "    %d linear-search buckets\n", t->linear_buckets);
+  s = format (s, "    prefilter %d/%d bits set%s\n",
+	      clib_bitmap_count_set_bits (t->filter), t->filter_mask + 1,
+	      t->next_has_same_mask ? ", next table shares the mask" : "");
   return s;
 }
 
@@ -789,13 +837,44 @@ vnet_classify_add_del_table (vnet_classify_main_t * cm,
 
 	  t->next_table_index = next_table_index;
 	}
+      vnet_classify_compile_chains (cm);
       return 0;
     }
 
   vnet_classify_delete_table_index (cm, *table_index, del_chain);
+  vnet_classify_compile_chains (cm);
   return 0;
 }
 
+/**
+ * Compile the table chains for the data plane: flag the tables whose
+ * next table has the same mask, skip and match vectors, so that chain
+ * lookups hash a packet once for the whole run of such tables.
+ * Called whenever tables are added, linked or deleted.
+ */
+void
+vnet_classify_compile_chains (vnet_classify_main_t * cm)
+{
+  vnet_classify_table_t *t, *next;
+
+  /* *INDENT-OFF* */
+  pool_foreach (t, cm->tables,
+  ({
+    t->next_has_same_mask = 0;
+    if (t->next_table_index != ~0 &&
+        !pool_is_free_index (cm->tables, t->next_table_index))
+      {
+        next = pool_elt_at_index (cm->tables, t->next_table_index);
+        t->next_has_same_mask =
+          (next->skip_n_vectors == t->skip_n_vectors &&
+           next->match_n_vectors == t->match_n_vectors &&
+           !memcmp (next->mask, t->mask,
+                    t->match_n_vectors * sizeof (u32x4)));
+      }
+  }));
+  /* *INDENT-ON* */
+}
+
 #define foreach_tcp_proto_field                 \
 _(src)                                          \
 _(dst)
@@ -2421,6 +2500,20 @@ unformat_l2_output_next_node (unformat_input_t * input, va_list * args)
   return 0;
 }
 
+/* vlib input trace filter */
+static int
+vnet_is_packet_traced (vlib_buffer_t * b, u32 table_index)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+
+  /* the table may have gone since the trace was added */
+  if (pool_is_free_index (cm->tables, table_index))
+    return 0;
+
+  return vnet_classify_chain_match (cm, table_index,
+				    vlib_buffer_get_current (b));
+}
+
 static clib_error_t *
 vnet_classify_init (vlib_main_t * vm)
 {
@@ -2442,6 +2535,8 @@ vnet_classify_init (vlib_main_t * vm)
 
   vnet_classify_register_unformat_acl_next_index_fn (unformat_acl_next_node);
 
+  vlib_is_packet_traced_fn = vnet_is_packet_traced;
+
   return 0;
 }
 
@@ -31,6 +31,7 @@
 #include <vppinfra/error.h>
 #include <vppinfra/hash.h>
 #include <vppinfra/cache.h>
+#include <vppinfra/bitmap.h>
 #include <vppinfra/xxhash.h>
 
 extern vlib_node_registration_t ip4_classify_node;
@@ -173,6 +174,18 @@ typedef struct
   /* Miss next index, return if next_table_index = 0 */
   u32 miss_next_index;
 
+  /* Compiled chain: the next table has the same mask, skip and match
+     vectors, so the hash of a packet for this table is valid there too */
+  u8 next_has_same_mask;
+
+  /* Prefilter, one bit per bucket folded onto at most
+     VNET_CLASSIFY_FILTER_MAX_BITS bits, clear if no session can match */
+  uword *filter;
+  u32 filter_mask;
+
+  /* Number of sessions per prefilter bit */
+  u32 *filter_counts;
+
   /* Per-bucket working copies, one per thread */
   vnet_classify_entry_t **working_copies;
   int *working_copy_lengths;
@@ -214,6 +227,113 @@ u8 *format_classify_table (u8 * s, va_list * args);
 
 u64 vnet_classify_hash_packet (vnet_classify_table_t * t, u8 * h);
 
+#ifdef CLIB_HAVE_VEC256
+/*
+ * Wide vector kernels, used by the AVX2 and AVX-512 variants of the
+ * classify nodes. They process the match vectors 32 or 64 octets at a
+ * time and do not need data, mask or key to be aligned.
+ */
+#define vnet_classify_u32x4(p, i) u32x4_load_unaligned ((u8 *) (p) + (i) * 16)
+#define vnet_classify_u32x8(p, i) u32x8_load_unaligned ((u8 *) (p) + (i) * 16)
+
+/** XOR the masked match vectors of the packet data together */
+static_always_inline u32x4
+vnet_classify_masked_xor_wide (u8 * d, u8 * m, u32 n_vectors)
+{
+  u32x8 r8 = { 0 };
+  u32x4 r4 = { 0 };
+
+#ifdef CLIB_HAVE_VEC512
+  if (n_vectors >= 4)
+    {
+      u32x16 r16 = u32x16_load_unaligned (d) & u32x16_load_unaligned (m);
+      r8 = u32x16_extract_lo (r16) ^ u32x16_extract_hi (r16);
+      if (n_vectors == 5)
+	r4 = vnet_classify_u32x4 (d, 4) & vnet_classify_u32x4 (m, 4);
+      return r4 ^ u32x8_extract_lo (r8) ^ u32x8_extract_hi (r8);
+    }
+#endif
+
+  switch (n_vectors)
+    {
+    case 5:
+      r4 = vnet_classify_u32x4 (d, 4) & vnet_classify_u32x4 (m, 4);
+      /* FALLTHROUGH */
+    case 4:
+      r8 = vnet_classify_u32x8 (d, 2) & vnet_classify_u32x8 (m, 2);
+      r8 ^= vnet_classify_u32x8 (d, 0) & vnet_classify_u32x8 (m, 0);
+      break;
+    case 3:
+      r4 = vnet_classify_u32x4 (d, 2) & vnet_classify_u32x4 (m, 2);
+      /* FALLTHROUGH */
+    case 2:
+      r8 = vnet_classify_u32x8 (d, 0) & vnet_classify_u32x8 (m, 0);
+      break;
+    case 1:
+      r4 = vnet_classify_u32x4 (d, 0) & vnet_classify_u32x4 (m, 0);
+      break;
+    default:
+      abort ();
+    }
+
+  return r4 ^ u32x8_extract_lo (r8) ^ u32x8_extract_hi (r8);
+}
+
+/** Check if the masked match vectors of the packet data equal a key */
+static_always_inline int
+vnet_classify_masked_key_match_wide (u8 * d, u8 * m, u8 * k, u32 n_vectors)
+{
+  u32x8 r8 = { 0 };
+  u32x4 r4 = { 0 };
+
+#ifdef CLIB_HAVE_VEC512
+  if (n_vectors >= 4)
+    {
+      u32x16 r16 = ((u32x16_load_unaligned (d) & u32x16_load_unaligned (m))
+		    ^ u32x16_load_unaligned (k));
+      if (n_vectors == 5)
+	r4 = ((vnet_classify_u32x4 (d, 4) & vnet_classify_u32x4 (m, 4))
+	      ^ vnet_classify_u32x4 (k, 4));
+      return u32x16_is_all_zero (r16) && u32x4_is_all_zero (r4);
+    }
+#endif
+
+  switch (n_vectors)
+    {
+    case 5:
+      r4 = ((vnet_classify_u32x4 (d, 4) & vnet_classify_u32x4 (m, 4))
+	    ^ vnet_classify_u32x4 (k, 4));
+      /* FALLTHROUGH */
+    case 4:
+      r8 = ((vnet_classify_u32x8 (d, 2) & vnet_classify_u32x8 (m, 2))
+	    ^ vnet_classify_u32x8 (k, 2));
+      r8 |= ((vnet_classify_u32x8 (d, 0) & vnet_classify_u32x8 (m, 0))
+	     ^ vnet_classify_u32x8 (k, 0));
+      break;
+    case 3:
+      r4 = ((vnet_classify_u32x4 (d, 2) & vnet_classify_u32x4 (m, 2))
+	    ^ vnet_classify_u32x4 (k, 2));
+      /* FALLTHROUGH */
+    case 2:
+      r8 = ((vnet_classify_u32x8 (d, 0) & vnet_classify_u32x8 (m, 0))
+	    ^ vnet_classify_u32x8 (k, 0));
+      break;
+    case 1:
+      r4 = ((vnet_classify_u32x4 (d, 0) & vnet_classify_u32x4 (m, 0))
+	    ^ vnet_classify_u32x4 (k, 0));
+      break;
+    default:
+      abort ();
+    }
+
+  return u32x4_is_all_zero (r4 | u32x8_extract_lo (r8) |
+			    u32x8_extract_hi (r8));
+}
+
+#undef vnet_classify_u32x4
+#undef vnet_classify_u32x8
+#endif /* CLIB_HAVE_VEC256 */
+
 static inline u64
 vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 {
@@ -227,6 +347,11 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 
   ASSERT (t);
   mask = t->mask;
+#ifdef CLIB_HAVE_VEC256
+  xor_sum.as_u32x4 =
+    vnet_classify_masked_xor_wide (h + t->skip_n_vectors * sizeof (u32x4),
+				   (u8 *) mask, t->match_n_vectors);
+#else /* CLIB_HAVE_VEC256 */
 #ifdef CLIB_HAVE_VEC128
   if (U32X4_ALIGNED (h))
     {				//SSE can't handle unaligned data
@@ -284,10 +409,20 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 	  abort ();
 	}
     }
+#endif /* CLIB_HAVE_VEC256 */
 
   return clib_xxhash (xor_sum.as_u64[0] ^ xor_sum.as_u64[1]);
 }
 
+#define VNET_CLASSIFY_FILTER_MAX_BITS (1 << 16)
+
+/** Check if sessions of a table may match a packet with this hash */
+static inline int
+vnet_classify_filter_test (vnet_classify_table_t * t, u64 hash)
+{
+  return clib_bitmap_get_no_check (t->filter, hash & t->filter_mask);
+}
+
 static inline void
 vnet_classify_prefetch_bucket (vnet_classify_table_t * t, u64 hash)
 {
@@ -369,18 +504,24 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 				 u8 * h, u64 hash, f64 now)
 {
   vnet_classify_entry_t *v;
-  u32x4 *mask, *key;
+  u32x4 *mask;
+#ifndef CLIB_HAVE_VEC256
+  u32x4 *key;
   union
   {
     u32x4 as_u32x4;
     u64 as_u64[2];
   } result __attribute__ ((aligned (sizeof (u32x4))));
+#endif
   vnet_classify_bucket_t *b;
   u32 value_index;
   u32 bucket_index;
   u32 limit;
   int i;
 
+  if (!vnet_classify_filter_test (t, hash))
+    return 0;
+
   bucket_index = hash & (t->nbuckets - 1);
   b = &t->buckets[bucket_index];
   mask = t->mask;
@@ -401,6 +542,23 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 
   v = vnet_classify_entry_at_index (t, v, value_index);
 
+#ifdef CLIB_HAVE_VEC256
+  h += t->skip_n_vectors * sizeof (u32x4);
+  for (i = 0; i < limit; i++)
+    {
+      if (vnet_classify_masked_key_match_wide (h, (u8 *) mask, (u8 *) v->key,
+					       t->match_n_vectors))
+	{
+	  if (PREDICT_TRUE (now))
+	    {
+	      v->hits++;
+	      v->last_heard = now;
+	    }
+	  return (v);
+	}
+      v = vnet_classify_entry_at_index (t, v, 1);
+    }
+#else /* CLIB_HAVE_VEC256 */
 #ifdef CLIB_HAVE_VEC128
   if (U32X4_ALIGNED (h))
     {
@@ -503,9 +661,136 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 	  v = vnet_classify_entry_at_index (t, v, 1);
 	}
     }
+#endif /* CLIB_HAVE_VEC256 */
   return 0;
 }
 
+#define VNET_CLASSIFY_BATCH_SIZE 16
+
+/**
+ * Look up packets in the classify table chains starting at their
+ * table index (~0 for none). The chains of all the packets are walked
+ * in lock step, so that hashing and bucket and entry prefetches of the
+ * packets still missing overlap, one table of their chains at a time.
+ * Tables whose prefilter rules out a match are skipped without touching
+ * their buckets, and the hash is reused along runs of tables with the
+ * same mask.
+ * On return entries[i] is the matching entry of packet i or 0, and
+ * table_indices[i] the index of the table it matched in or the last
+ * table of the chain it missed. Returns the number of matches found past
+ * the first table of a chain.
+ */
+static_always_inline u32
+vnet_classify_find_entry_batch (vnet_classify_main_t * cm, u8 ** h,
+				u32 * table_indices,
+				vnet_classify_entry_t ** entries, u32 n,
+				f64 now)
+{
+  u8 active[VNET_CLASSIFY_BATCH_SIZE], next_active[VNET_CLASSIFY_BATCH_SIZE];
+  u8 probe[VNET_CLASSIFY_BATCH_SIZE], hash_valid[VNET_CLASSIFY_BATCH_SIZE];
+  vnet_classify_table_t *tables[VNET_CLASSIFY_BATCH_SIZE], *t;
+  u64 hashes[VNET_CLASSIFY_BATCH_SIZE];
+  u32 chain_hits = 0, n_active, n_next_active, n_probe, n_done = 0;
+  u32 i, j, k;
+
+  while (n_done < n)
+    {
+      u32 n_batch = clib_min (n - n_done, VNET_CLASSIFY_BATCH_SIZE);
+      n_active = 0;
+
+      for (i = 0; i < n_batch; i++)
+	{
+	  entries[i] = 0;
+	  hash_valid[i] = 0;
+	  if (table_indices[i] != ~0)
+	    active[n_active++] = i;
+	}
+
+      for (j = 0; n_active; j++)
+	{
+	  /* hash with the current table of each packet, prefetch buckets
+	     of the tables which may match */
+	  n_next_active = n_probe = 0;
+	  for (i = 0; i < n_active; i++)
+	    {
+	      k = active[i];
+	      t = tables[k] = pool_elt_at_index (cm->tables, table_indices[k]);
+	      if (!hash_valid[k])
+		hashes[k] = vnet_classify_hash_packet_inline (t, h[k]);
+	      if (vnet_classify_filter_test (t, hashes[k]))
+		{
+		  vnet_classify_prefetch_bucket (t, hashes[k]);
+		  probe[n_probe++] = k;
+		}
+	      else if (t->next_table_index != ~0)
+		{
+		  hash_valid[k] = t->next_has_same_mask;
+		  table_indices[k] = t->next_table_index;
+		  next_active[n_next_active++] = k;
+		}
+	    }
+
+	  for (i = 0; i < n_probe; i++)
+	    vnet_classify_prefetch_entry (tables[probe[i]], hashes[probe[i]]);
+
+	  /* search, on a miss move on to the next table of the chain */
+	  for (i = 0; i < n_probe; i++)
+	    {
+	      k = probe[i];
+	      t = tables[k];
+	      entries[k] = vnet_classify_find_entry_inline (t, h[k],
+							    hashes[k], now);
+	      if (entries[k])
+		chain_hits += j > 0;
+	      else if (t->next_table_index != ~0)
+		{
+		  hash_valid[k] = t->next_has_same_mask;
+		  table_indices[k] = t->next_table_index;
+		  next_active[n_next_active++] = k;
+		}
+	    }
+
+	  n_active = n_next_active;
+	  clib_memcpy_fast (active, next_active, n_active);
+	}
+
+      h += n_batch;
+      table_indices += n_batch;
+      entries += n_batch;
+      n_done += n_batch;
+    }
+
+  return chain_hits;
+}
+
+/*
+ * Returns true if the packet at h matches a session of the table chain
+ * starting at table_index. Session hit counters are left alone, so this
+ * may be used as a read-only filter from any thread.
+ */
+static inline int
+vnet_classify_chain_match (vnet_classify_main_t * cm, u32 table_index,
+			   u8 * h)
+{
+  vnet_classify_table_t *t;
+  int hash_valid = 0;
+  u64 hash = 0;
+
+  while (table_index != ~0)
+    {
+      t = pool_elt_at_index (cm->tables, table_index);
+      if (!hash_valid)
+	hash = vnet_classify_hash_packet_inline (t, h);
+      if (vnet_classify_find_entry_inline (t, h, hash, 0 /* now */ ))
+	return 1;
+      hash_valid = t->next_has_same_mask;
+      table_index = t->next_table_index;
+    }
+  return 0;
+}
+
+void vnet_classify_compile_chains (vnet_classify_main_t * cm);
+
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t * cm,
 						u8 * mask, u32 nbuckets,
 						u32 memory_size,
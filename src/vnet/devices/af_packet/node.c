@@ -25,6 +25,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
+#include <vnet/latency.h>
 #include <vnet/ethernet/packet.h>
 
 #include <vnet/devices/af_packet/af_packet.h>
@@ -288,6 +289,7 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	    }
 	  n_rx_packets++;
 	  n_rx_bytes += tph->tp_snaplen;
+	  vnet_latency_stamp (vm, &first_bi0, 1);
 	  to_next[0] = first_bi0;
 	  to_next += 1;
 	  n_left_to_next--;
@@ -309,11 +311,11 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  /* trace */
 	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b0);
-	  if (PREDICT_FALSE (n_trace > 0))
+	  if (PREDICT_FALSE (n_trace > 0) &&
+	      vlib_trace_buffer (vm, node, next0, first_b0,	/* follow_chain */
+				 0))
 	    {
 	      af_packet_input_trace_t *tr;
-	      vlib_trace_buffer (vm, node, next0, first_b0,	/* follow_chain */
-				 0);
 	      vlib_set_trace_count (vm, node, --n_trace);
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
@@ -201,11 +201,11 @@ netmap_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b0);
 	      if (PREDICT_FALSE (n_trace > 0))
 		{
-		  if (PREDICT_TRUE (first_b0 != 0))
+		  if (PREDICT_TRUE (first_b0 != 0) &&
+		      vlib_trace_buffer (vm, node, next0, first_b0,
+					 /* follow_chain */ 0))
 		    {
 		      netmap_input_trace_t *tr;
-		      vlib_trace_buffer (vm, node, next0, first_b0,
-					 /* follow_chain */ 0);
 		      vlib_set_trace_count (vm, node, --n_trace);
 		      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 		      tr->next_index = next0;
@@ -28,6 +28,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
+#include <vnet/latency.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/udp/udp_packet.h>
@@ -309,11 +310,10 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  /* trace */
 	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
 
-	  if (PREDICT_FALSE (n_trace > 0))
+	  if (PREDICT_FALSE (n_trace > 0) &&
+	      vlib_trace_buffer (vm, node, next0, b0, /* follow_chain */ 0))
 	    {
 	      virtio_input_trace_t *tr;
-	      vlib_trace_buffer (vm, node, next0, b0,
-				 /* follow_chain */ 0);
 	      vlib_set_trace_count (vm, node, --n_trace);
 	      tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
 	      tr->next_index = next0;
@@ -323,6 +323,7 @@ virtio_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	    }
 
 	  /* enqueue buffer */
+	  vnet_latency_stamp (vm, &bi0, 1);
 	  to_next[0] = bi0;
 	  vring->desc_in_use--;
 	  to_next += 1;
@@ -38,6 +38,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/devices/devices.h>
 #include <vnet/feature/feature.h>
+#include <vnet/latency.h>
 
 #include <vnet/devices/virtio/vhost_user.h>
 #include <vnet/devices/virtio/vhost_user_inline.h>
@@ -429,6 +430,7 @@ vhost_user_if_input (vlib_main_t * vm,
       bi_current = cpu->rx_buffers[cpu->rx_buffers_len];
       b_head = b_current = vlib_get_buffer (vm, bi_current);
       to_next[0] = bi_current;	//We do that now so we can forget about bi_current
+      vnet_latency_stamp (vm, to_next, 1);
       to_next++;
       n_left_to_next--;
 
@@ -444,11 +446,11 @@ vhost_user_if_input (vlib_main_t * vm,
       b_head->total_length_not_including_first_buffer = 0;
       b_head->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
 
-      if (PREDICT_FALSE (n_trace))
-	{
-	  //TODO: next_index is not exactly known at that point
+      //TODO: next_index is not exactly known at that point
+      if (PREDICT_FALSE (n_trace) &&
 	  vlib_trace_buffer (vm, node, next_index, b_head,
-			     /* follow_chain */ 0);
+			     /* follow_chain */ 0))
+	{
 	  vhost_trace_t *t0 =
 	    vlib_add_trace (vm, node, b_head, sizeof (t0[0]));
 	  vhost_user_rx_trace (t0, vui, qid, b_head, txvq, last_avail_idx);
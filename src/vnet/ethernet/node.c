@@ -44,6 +44,7 @@
 #include <vnet/devices/pipe/pipe.h>
 #include <vppinfra/sparse_vec.h>
 #include <vnet/l2/l2_bvi.h>
+#include <vnet/pcap_capture.h>
 
 #define foreach_ethernet_input_next		\
   _ (PUNT, "error-punt")			\
@@ -1003,12 +1004,8 @@ ethernet_input_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  from++;
 	  b0 = vlib_get_buffer (vm, bi0);
 
-	  if (vm->pcap[VLIB_RX].pcap_sw_if_index == 0 ||
-	      vm->pcap[VLIB_RX].pcap_sw_if_index
-	      == vnet_buffer (b0)->sw_if_index[VLIB_RX])
-	    {
-	      pcap_add_buffer (&vm->pcap[VLIB_RX].pcap_main, vm, bi0, 512);
-	    }
+	  vnet_pcap_add_buffer (vm, VLIB_RX, bi0,
+				vnet_buffer (b0)->sw_if_index[VLIB_RX]);
 	  n_left--;
 	}
     }
@@ -16,6 +16,7 @@
 #include <vlib/vlib.h>
 #include <vnet/pg/pg.h>
 #include <vnet/geneve/geneve.h>
+#include <vppinfra/lookup_cache_16_8.h>
 
 typedef struct
 {
@@ -66,6 +67,17 @@ validate_geneve_fib (vlib_buffer_t * b, geneve_tunnel_t * t, u32 is_ip4)
   return (fib_index == t->encap_fib_index);
 }
 
+/*
+ * Node runtime data. The first byte keeps the stats sw_if_index of the
+ * last packet of the previous frame.
+ */
+typedef struct
+{
+  u8 stats_sw_if_index;
+  /* ip4 tunnel lookup cache gate, kept across frames */
+  clib_lookup_cache_16_8_gate_t gate4;
+} geneve_input_runtime_t;
+
 always_inline uword
 geneve_input (vlib_main_t * vm,
 	      vlib_node_runtime_t * node,
@@ -77,13 +89,19 @@ geneve_input (vlib_main_t * vm,
   vnet_interface_main_t *im = &vnm->interface_main;
   u32 last_tunnel_index = ~0;
   geneve4_tunnel_key_t last_key4;
+  geneve_input_runtime_t *rt = (void *) node->runtime_data;
+  clib_lookup_cache_16_8_t cache4;
+  u32 n_key_changes4 = 0;
   geneve6_tunnel_key_t last_key6;
   u32 pkts_decapsulated = 0;
   u32 thread_index = vm->thread_index;
   u32 stats_sw_if_index, stats_n_packets, stats_n_bytes;
 
   if (is_ip4)
-    last_key4.as_u64 = ~0;
+    {
+      last_key4.as_u64 = ~0;
+      clib_lookup_cache_16_8_init (&cache4, &rt->gate4);
+    }
   else
     clib_memset (&last_key6, 0xff, sizeof (last_key6));
 
@@ -111,6 +129,7 @@ geneve_input (vlib_main_t * vm,
 	  u32 tunnel_index0, tunnel_index1;
 	  geneve_tunnel_t *t0, *t1, *mt0 = NULL, *mt1 = NULL;
 	  geneve4_tunnel_key_t key4_0, key4_1;
+	  clib_bihash_kv_16_8_t kv0, kv1;
 	  geneve6_tunnel_key_t key6_0, key6_1;
 	  u32 error0, error1;
 	  u32 sw_if_index0, sw_if_index1, len0, len1;
@@ -222,15 +241,23 @@ geneve_input (vlib_main_t * vm,
 	      /* Make sure GENEVE tunnel exist according to packet SIP and VNI */
 	      if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
 		{
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_FALSE (p0 == NULL))
+		  kv0.key[0] = key4_0.as_u64;
+		  kv0.key[1] = 0;
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv0))
 		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace0;
+		      p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
+		      if (PREDICT_FALSE (p0 == NULL))
+			{
+			  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+			  next0 = GENEVE_INPUT_NEXT_DROP;
+			  goto trace0;
+			}
+		      kv0.value = p0[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv0);
 		    }
 		  last_key4.as_u64 = key4_0.as_u64;
-		  tunnel_index0 = last_tunnel_index = p0[0];
+		  tunnel_index0 = last_tunnel_index = kv0.value;
 		}
 	      else
 		tunnel_index0 = last_tunnel_index;
@@ -389,15 +416,23 @@ geneve_input (vlib_main_t * vm,
 	      /* Make sure unicast GENEVE tunnel exist by packet SIP and VNI */
 	      if (PREDICT_FALSE (key4_1.as_u64 != last_key4.as_u64))
 		{
-		  p1 = hash_get (vxm->geneve4_tunnel_by_key, key4_1.as_u64);
-		  if (PREDICT_FALSE (p1 == NULL))
+		  kv1.key[0] = key4_1.as_u64;
+		  kv1.key[1] = 0;
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv1))
 		    {
-		      error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next1 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace1;
+		      p1 = hash_get (vxm->geneve4_tunnel_by_key, key4_1.as_u64);
+		      if (PREDICT_FALSE (p1 == NULL))
+			{
+			  error1 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+			  next1 = GENEVE_INPUT_NEXT_DROP;
+			  goto trace1;
+			}
+		      kv1.value = p1[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv1);
 		    }
 		  last_key4.as_u64 = key4_1.as_u64;
-		  tunnel_index1 = last_tunnel_index = p1[0];
+		  tunnel_index1 = last_tunnel_index = kv1.value;
 		}
 	      else
 		tunnel_index1 = last_tunnel_index;
@@ -552,6 +587,7 @@ geneve_input (vlib_main_t * vm,
 	  u32 tunnel_index0;
 	  geneve_tunnel_t *t0, *mt0 = NULL;
 	  geneve4_tunnel_key_t key4_0;
+	  clib_bihash_kv_16_8_t kv0;
 	  geneve6_tunnel_key_t key6_0;
 	  u32 error0;
 	  u32 sw_if_index0, len0;
@@ -626,15 +662,23 @@ geneve_input (vlib_main_t * vm,
 	      /* Make sure unicast GENEVE tunnel exist by packet SIP and VNI */
 	      if (PREDICT_FALSE (key4_0.as_u64 != last_key4.as_u64))
 		{
-		  p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
-		  if (PREDICT_FALSE (p0 == NULL))
+		  kv0.key[0] = key4_0.as_u64;
+		  kv0.key[1] = 0;
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv0))
 		    {
-		      error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
-		      next0 = GENEVE_INPUT_NEXT_DROP;
-		      goto trace00;
+		      p0 = hash_get (vxm->geneve4_tunnel_by_key, key4_0.as_u64);
+		      if (PREDICT_FALSE (p0 == NULL))
+			{
+			  error0 = GENEVE_ERROR_NO_SUCH_TUNNEL;
+			  next0 = GENEVE_INPUT_NEXT_DROP;
+			  goto trace00;
+			}
+		      kv0.value = p0[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv0);
 		    }
 		  last_key4.as_u64 = key4_0.as_u64;
-		  tunnel_index0 = last_tunnel_index = p0[0];
+		  tunnel_index0 = last_tunnel_index = kv0.value;
 		}
 	      else
 		tunnel_index0 = last_tunnel_index;
@@ -791,6 +835,10 @@ geneve_input (vlib_main_t * vm,
       node->runtime_data[0] = stats_sw_if_index;
     }
 
+  if (is_ip4)
+    clib_lookup_cache_16_8_gate_update (&rt->gate4, &cache4,
+					from_frame->n_vectors, n_key_changes4);
+
   return from_frame->n_vectors;
 }
 
@@ -820,6 +868,7 @@ VLIB_REGISTER_NODE (geneve4_input_node) = {
   .name = "geneve4-input",
   /* Takes a vector of packets. */
   .vector_size = sizeof (u32),
+  .runtime_data_bytes = sizeof (geneve_input_runtime_t),
   .n_errors = GENEVE_N_ERROR,
   .error_strings = geneve_error_strings,
   .n_next_nodes = GENEVE_INPUT_N_NEXT,
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/gro/gro.h>
+
+gro_main_t gro_main;
+
+int
+vnet_gro_enable_disable (u32 sw_if_index, f64 flush_timeout, int is_enable)
+{
+  gro_main_t *gm = &gro_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  int rv;
+
+  if (pool_is_free_index (vnm->interface_main.sw_interfaces, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  if (flush_timeout < 0 || flush_timeout > GRO_MAX_FLUSH_TIMEOUT)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  vec_validate (gm->flush_timeout_by_sw_if_index, sw_if_index);
+  gm->flush_timeout_by_sw_if_index[sw_if_index] = flush_timeout;
+
+  if (!clib_bitmap_get (gm->enabled_by_sw_if_index, sw_if_index) ==
+      !is_enable)
+    return 0;
+
+  rv = vnet_feature_enable_disable ("ip4-unicast", "ip4-gro", sw_if_index,
+				    is_enable, 0, 0);
+  if (rv)
+    return rv;
+
+  gm->enabled_by_sw_if_index =
+    clib_bitmap_set (gm->enabled_by_sw_if_index, sw_if_index, is_enable);
+
+  /* interface-output only segments super-segments sent to interfaces
+     without GSO support while some interface uses GSO */
+  if (is_enable)
+    vnm->interface_main.gso_interface_count++;
+  else
+    vnm->interface_main.gso_interface_count--;
+
+  return 0;
+}
+
+static clib_error_t *
+set_interface_gro_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  clib_error_t *error = 0;
+  u32 sw_if_index = ~0;
+  u32 timeout_usec = 0;
+  int is_enable = 1;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "flush-timeout %u", &timeout_usec))
+	;
+      else if (unformat (line_input, "disable"))
+	is_enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "interface not specified");
+      goto done;
+    }
+
+  rv = vnet_gro_enable_disable (sw_if_index, timeout_usec * 1e-6, is_enable);
+
+  switch (rv)
+    {
+    case 0:
+      break;
+
+    case VNET_API_ERROR_INVALID_VALUE:
+      error = clib_error_return (0, "flush timeout must not exceed %u usec",
+				 (u32) (GRO_MAX_FLUSH_TIMEOUT * 1e6));
+      break;
+
+    default:
+      error = clib_error_return (0, "vnet_gro_enable_disable returned %d",
+				 rv);
+      break;
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Coalesce in-order TCP segments received on an interface into
+ * super-segments, before the ip4 lookup. Segments are held until the end
+ * of the frame, or until the flush timeout, in microseconds, expires.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface gro GigabitEthernet2/0/0 flush-timeout 50}
+ * @cliexcmd{set interface gro GigabitEthernet2/0/0 disable}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_gro_command, static) =
+{
+  .path = "set interface gro",
+  .short_help =
+    "set interface gro <interface> [flush-timeout <usec>] [disable]",
+  .function = set_interface_gro_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+gro_init (vlib_main_t * vm)
+{
+  gro_main_t *gm = &gro_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  vec_validate_aligned (gm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (gro_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
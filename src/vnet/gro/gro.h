@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_gro_h__
+#define __included_gro_h__
+
+#include <vnet/vnet.h>
+
+/*
+ * Receive side coalescing of TCP segments (GRO).
+ *
+ * The ip4-gro feature, enabled per rx interface on the ip4-unicast arc,
+ * chains in-order segments of a TCP flow into a single super-segment
+ * carrying the same GSO metadata as the ones tcp-output builds, so that
+ * lookup, rewrite and tcp-input run once per super-segment. Interfaces
+ * without GSO support segment them again in interface-output.
+ *
+ * Segments are only merged once their TCP checksum is known to be good,
+ * either flagged so by the driver or verified here.
+ *
+ * Flows are held in a small per-thread table, and flushed when a segment
+ * does not continue them, at the end of the frame, or, when the rx
+ * interface has a flush timeout, once the timeout expires. Expired flows
+ * of idle threads are flushed by the ip4-gro-flush input node, which only
+ * polls while flows are held.
+ */
+
+#define GRO_FLOW_TABLE_SIZE 8
+#define GRO_MAX_SEGMENTS 64
+#define GRO_MAX_FLUSH_TIMEOUT 1e-3
+
+typedef struct
+{
+  /* flow key, as found in the ip4 and tcp headers */
+  u64 addresses;
+  u32 ports;
+  u32 sw_if_index;
+
+  /* first and last buffers of the chain */
+  u32 bi;
+  u32 last_bi;
+
+  /* host byte order */
+  u32 next_seq;
+
+  /* payload of the first segment */
+  u16 gso_size;
+  u16 n_segments;
+  /* ip4 length of the super-segment */
+  u32 length;
+  u32 next_index;
+  f64 expires;
+} gro_flow_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  gro_flow_t flows[GRO_FLOW_TABLE_SIZE];
+  u32 n_flows;
+  u8 flush_node_polling;
+} gro_per_thread_data_t;
+
+typedef struct
+{
+  /* per rx interface, in seconds */
+  f64 *flush_timeout_by_sw_if_index;
+  uword *enabled_by_sw_if_index;
+
+  gro_per_thread_data_t *per_thread_data;
+} gro_main_t;
+
+extern gro_main_t gro_main;
+extern vlib_node_registration_t ip4_gro_node;
+extern vlib_node_registration_t ip4_gro_flush_node;
+
+int vnet_gro_enable_disable (u32 sw_if_index, f64 flush_timeout,
+			     int is_enable);
+
+#endif /* __included_gro_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/ip/ip.h>
+#include <vnet/tcp/tcp_packet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/gro/gro.h>
+
+#define foreach_ip4_gro_action		\
+_(PASS, "pass")				\
+_(NEW_FLOW, "new flow")			\
+_(MERGE, "merged")
+
+typedef enum
+{
+#define _(sym,str) IP4_GRO_ACTION_##sym,
+  foreach_ip4_gro_action
+#undef _
+} ip4_gro_action_t;
+
+typedef struct
+{
+  u32 sw_if_index;
+  u32 next_index;
+  u16 n_segments;
+  u8 action;
+} ip4_gro_trace_t;
+
+static u8 *
+format_ip4_gro_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  ip4_gro_trace_t *t = va_arg (*args, ip4_gro_trace_t *);
+  static char *actions[] = {
+#define _(sym,str) str,
+    foreach_ip4_gro_action
+#undef _
+  };
+
+  s = format (s, "IP4_GRO: sw_if_index %d next-index %d %s",
+	      t->sw_if_index, t->next_index, actions[t->action]);
+  if (t->action != IP4_GRO_ACTION_PASS)
+    s = format (s, ", %u segments", t->n_segments);
+  return s;
+}
+
+#define foreach_ip4_gro_error					\
+_(MERGED, "segments merged")					\
+_(TIMEOUT, "flows flushed on timeout")				\
+_(BAD_CHECKSUM, "segments with bad tcp checksum not merged")
+
+typedef enum
+{
+#define _(sym,str) IP4_GRO_ERROR_##sym,
+  foreach_ip4_gro_error
+#undef _
+    IP4_GRO_N_ERROR,
+} ip4_gro_error_t;
+
+static char *ip4_gro_error_strings[] = {
+#define _(sym,string) string,
+  foreach_ip4_gro_error
+#undef _
+};
+
+/* tcp payload of a segment which may be merged, 0 otherwise */
+static_always_inline u32
+gro_segment_payload (vlib_buffer_t * b, ip4_header_t * ip,
+		     tcp_header_t * tcp)
+{
+  u32 ip_len, hdr_len;
+
+  if (b->flags & (VLIB_BUFFER_NEXT_PRESENT | VNET_BUFFER_F_GSO))
+    return 0;
+
+  /* no SYN, FIN, RST or URG */
+  if ((tcp->flags & ~TCP_FLAG_PSH) != TCP_FLAG_ACK)
+    return 0;
+
+  ip_len = clib_net_to_host_u16 (ip->length);
+  hdr_len = sizeof (ip4_header_t) + tcp_header_bytes (tcp);
+  if (ip_len <= hdr_len || ip_len > b->current_length)
+    return 0;
+
+  return ip_len - hdr_len;
+}
+
+static_always_inline u32
+gro_flow_find (gro_per_thread_data_t * ptd, u64 addresses, u32 ports,
+	       u32 sw_if_index)
+{
+  gro_flow_t *f;
+  u32 i;
+
+  for (i = 0; i < ptd->n_flows; i++)
+    {
+      f = ptd->flows + i;
+      if (f->addresses == addresses && f->ports == ports &&
+	  f->sw_if_index == sw_if_index)
+	return i;
+    }
+  return ~0;
+}
+
+/* a segment continues a flow if it is the next in sequence, is not
+   bigger than the first one and carries the same headers otherwise */
+static_always_inline int
+gro_segment_continues_flow (vlib_main_t * vm, gro_flow_t * f,
+			    ip4_header_t * ip, tcp_header_t * tcp,
+			    u32 payload)
+{
+  vlib_buffer_t *hb;
+  ip4_header_t *hip;
+  tcp_header_t *htcp;
+  u32 opt_len;
+
+  if (clib_net_to_host_u32 (tcp->seq_number) != f->next_seq ||
+      payload > f->gso_size || f->length + payload > 0xffff ||
+      f->n_segments >= GRO_MAX_SEGMENTS)
+    return 0;
+
+  hb = vlib_get_buffer (vm, f->bi);
+  hip = vlib_buffer_get_current (hb);
+  htcp = ip4_next_header (hip);
+
+  if (ip->tos != hip->tos || ip->ttl != hip->ttl ||
+      tcp->ack_number != htcp->ack_number || tcp->window != htcp->window ||
+      tcp->data_offset_and_reserved != htcp->data_offset_and_reserved)
+    return 0;
+
+  opt_len = tcp_header_bytes (tcp) - sizeof (tcp_header_t);
+  return opt_len == 0 || memcmp (tcp + 1, htcp + 1, opt_len) == 0;
+}
+
+static_always_inline void
+gro_flow_merge (vlib_main_t * vm, gro_flow_t * f, u32 bi, vlib_buffer_t * b,
+		tcp_header_t * tcp, u32 payload)
+{
+  vlib_buffer_t *hb = vlib_get_buffer (vm, f->bi);
+  vlib_buffer_t *lb = vlib_get_buffer (vm, f->last_bi);
+  ip4_header_t *hip = vlib_buffer_get_current (hb);
+  tcp_header_t *htcp = ip4_next_header (hip);
+
+  /* chain the payload only */
+  vlib_buffer_advance (b, sizeof (ip4_header_t) + tcp_header_bytes (tcp));
+  b->current_length = payload;
+
+  lb->next_buffer = bi;
+  lb->flags |= VLIB_BUFFER_NEXT_PRESENT;
+  hb->total_length_not_including_first_buffer += payload;
+  htcp->flags |= tcp->flags & TCP_FLAG_PSH;
+
+  f->last_bi = bi;
+  f->next_seq += payload;
+  f->length += payload;
+  f->n_segments++;
+}
+
+/* turn the chain into a super-segment and hand it to the next node */
+static_always_inline u32
+gro_flow_flush (vlib_main_t * vm, gro_per_thread_data_t * ptd, u32 fi,
+		u32 * to, u16 * nexts)
+{
+  gro_flow_t *f = ptd->flows + fi;
+  vlib_buffer_t *b = vlib_get_buffer (vm, f->bi);
+
+  if (f->n_segments > 1)
+    {
+      ip4_header_t *ip = vlib_buffer_get_current (b);
+      tcp_header_t *tcp = ip4_next_header (ip);
+
+      ip->length = clib_host_to_net_u16 (f->length);
+      ip->checksum = ip4_header_checksum (ip);
+
+      /* offsets from the start of the buffer, see gso_mtu_sz () */
+      vnet_buffer (b)->l3_hdr_offset = (u8 *) ip - b->data;
+      vnet_buffer (b)->l4_hdr_offset = (u8 *) tcp - b->data;
+      vnet_buffer2 (b)->gso_size = f->gso_size;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_header_bytes (tcp);
+
+      /* all segments had a good checksum, the merged one has to be
+         computed again if the packet is segmented or leaves as is */
+      b->flags |= (VNET_BUFFER_F_GSO | VNET_BUFFER_F_IS_IP4 |
+		   VNET_BUFFER_F_L3_HDR_OFFSET_VALID |
+		   VNET_BUFFER_F_L4_HDR_OFFSET_VALID |
+		   VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+		   VNET_BUFFER_F_L4_CHECKSUM_CORRECT |
+		   VNET_BUFFER_F_OFFLOAD_IP_CKSUM |
+		   VNET_BUFFER_F_OFFLOAD_TCP_CKSUM);
+    }
+
+  to[0] = f->bi;
+  nexts[0] = f->next_index;
+
+  /* keep the table dense */
+  ptd->flows[fi] = ptd->flows[--ptd->n_flows];
+  return 1;
+}
+
+static_always_inline u32
+gro_flush_expired (vlib_main_t * vm, gro_per_thread_data_t * ptd, f64 now,
+		   u32 * to, u16 * nexts)
+{
+  u32 i, n_out = 0;
+
+  for (i = ptd->n_flows; i > 0; i--)
+    if (ptd->flows[i - 1].expires <= now)
+      n_out += gro_flow_flush (vm, ptd, i - 1, to + n_out, nexts + n_out);
+  return n_out;
+}
+
+/* the flush node only polls while this thread holds flows */
+static_always_inline void
+gro_update_flush_node (vlib_main_t * vm, gro_per_thread_data_t * ptd)
+{
+  u8 polling = ptd->n_flows != 0;
+
+  if (polling == ptd->flush_node_polling)
+    return;
+
+  vlib_node_set_state (vm, ip4_gro_flush_node.index, polling ?
+		       VLIB_NODE_STATE_POLLING : VLIB_NODE_STATE_DISABLED);
+  ptd->flush_node_polling = polling;
+}
+
+VLIB_NODE_FN (ip4_gro_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
+			     vlib_frame_t * frame)
+{
+  gro_main_t *gm = &gro_main;
+  gro_per_thread_data_t *ptd = vec_elt_at_index (gm->per_thread_data,
+						 vm->thread_index);
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 to[VLIB_FRAME_SIZE + GRO_FLOW_TABLE_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE + GRO_FLOW_TABLE_SIZE];
+  u32 n_left, *from, n_out = 0, n_merged = 0, n_bad = 0;
+  f64 now = vlib_time_now (vm);
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  /* flows which timed out since the last frame go first */
+  if (ptd->n_flows)
+    n_out = gro_flush_expired (vm, ptd, now, to, nexts);
+
+  while (n_left > 0)
+    {
+      ip4_header_t *ip0;
+      tcp_header_t *tcp0;
+      gro_flow_t *f;
+      u32 next0, sw_if_index0, payload0, fi;
+      u64 addresses0;
+      u32 ports0;
+      u8 action0 = IP4_GRO_ACTION_PASS;
+      u16 n_segments0 = 1;
+
+      if (n_left > 2)
+	{
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  CLIB_PREFETCH (b[1]->data + b[1]->current_data,
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	}
+
+      ip0 = vlib_buffer_get_current (b[0]);
+      tcp0 = ip4_next_header (ip0);
+      sw_if_index0 = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
+      vnet_feature_next (&next0, b[0]);
+
+      if (ip0->protocol != IP_PROTOCOL_TCP ||
+	  ip0->ip_version_and_header_length != 0x45 || ip4_is_fragment (ip0))
+	goto pass;
+
+      addresses0 = ((u64) ip0->src_address.as_u32 << 32) |
+	ip0->dst_address.as_u32;
+      ports0 = ((u32) tcp0->src_port << 16) | tcp0->dst_port;
+      fi = ptd->n_flows ?
+	gro_flow_find (ptd, addresses0, ports0, sw_if_index0) : ~0;
+
+      payload0 = gro_segment_payload (b[0], ip0, tcp0);
+      if (payload0 && !(b[0]->flags & VNET_BUFFER_F_L4_CHECKSUM_COMPUTED))
+	ip4_tcp_udp_validate_checksum (vm, b[0]);
+      if (payload0 && !(b[0]->flags & VNET_BUFFER_F_L4_CHECKSUM_CORRECT))
+	{
+	  n_bad++;
+	  payload0 = 0;
+	}
+
+      if (fi != ~0)
+	{
+	  f = ptd->flows + fi;
+	  if (payload0 &&
+	      gro_segment_continues_flow (vm, f, ip0, tcp0, payload0))
+	    {
+	      gro_flow_merge (vm, f, from[0], b[0], tcp0, payload0);
+	      action0 = IP4_GRO_ACTION_MERGE;
+	      n_segments0 = f->n_segments;
+	      n_merged++;
+
+	      /* a short or pushed segment ends the burst */
+	      if (payload0 < f->gso_size || (tcp0->flags & TCP_FLAG_PSH))
+		n_out += gro_flow_flush (vm, ptd, fi, to + n_out,
+					 nexts + n_out);
+	      goto next;
+	    }
+
+	  /* anything else of the flow must follow what is held */
+	  n_out += gro_flow_flush (vm, ptd, fi, to + n_out, nexts + n_out);
+	}
+
+      if (payload0 == 0 || (tcp0->flags & TCP_FLAG_PSH))
+	goto pass;
+
+      if (ptd->n_flows == GRO_FLOW_TABLE_SIZE)
+	n_out += gro_flow_flush (vm, ptd, 0, to + n_out, nexts + n_out);
+
+      /* hold the segment as the head of a new flow */
+      f = ptd->flows + ptd->n_flows++;
+      f->addresses = addresses0;
+      f->ports = ports0;
+      f->sw_if_index = sw_if_index0;
+      f->bi = f->last_bi = from[0];
+      f->next_seq = clib_net_to_host_u32 (tcp0->seq_number) + payload0;
+      f->gso_size = payload0;
+      f->n_segments = 1;
+      f->length = clib_net_to_host_u16 (ip0->length);
+      f->next_index = next0;
+      f->expires = now + gm->flush_timeout_by_sw_if_index[sw_if_index0];
+
+      /* drop any l2 padding */
+      b[0]->current_length = f->length;
+      b[0]->total_length_not_including_first_buffer = 0;
+      b[0]->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+      action0 = IP4_GRO_ACTION_NEW_FLOW;
+      goto next;
+
+    pass:
+      to[n_out] = from[0];
+      nexts[n_out++] = next0;
+
+    next:
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  ip4_gro_trace_t *t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->sw_if_index = sw_if_index0;
+	  t->next_index = next0;
+	  t->action = action0;
+	  t->n_segments = n_segments0;
+	}
+
+      from += 1;
+      b += 1;
+      n_left -= 1;
+    }
+
+  /* flows without a flush timeout do not outlive the frame */
+  if (ptd->n_flows)
+    n_out += gro_flush_expired (vm, ptd, now, to + n_out, nexts + n_out);
+
+  gro_update_flush_node (vm, ptd);
+
+  if (n_out)
+    vlib_buffer_enqueue_to_next (vm, node, to, nexts, n_out);
+
+  vlib_node_increment_counter (vm, node->node_index, IP4_GRO_ERROR_MERGED,
+			       n_merged);
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP4_GRO_ERROR_BAD_CHECKSUM, n_bad);
+
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip4_gro_node) =
+{
+  .name = "ip4-gro",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip4_gro_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+
+  .n_errors = ARRAY_LEN (ip4_gro_error_strings),
+  .error_strings = ip4_gro_error_strings,
+};
+
+VNET_FEATURE_INIT (ip4_gro, static) =
+{
+  .arc_name = "ip4-unicast",
+  .node_name = "ip4-gro",
+  .runs_before = VNET_FEATURES ("ip4-lookup"),
+  .runs_after = VNET_FEATURES ("ip4-inacl", "ip4-policer-classify"),
+};
+/* *INDENT-ON* */
+
+/*
+ * Flushes the flows of idle threads once their timeout expired. The held
+ * buffers carry next indices of ip4-gro, so they are sent to the
+ * corresponding nodes directly.
+ */
+VLIB_NODE_FN (ip4_gro_flush_node) (vlib_main_t * vm,
+				   vlib_node_runtime_t * node,
+				   vlib_frame_t * frame)
+{
+  gro_main_t *gm = &gro_main;
+  gro_per_thread_data_t *ptd = vec_elt_at_index (gm->per_thread_data,
+						 vm->thread_index);
+  u32 to[GRO_FLOW_TABLE_SIZE];
+  u16 nexts[GRO_FLOW_TABLE_SIZE];
+  vlib_node_t *gro_node;
+  u32 i, j, n_out;
+
+  n_out = gro_flush_expired (vm, ptd, vlib_time_now (vm), to, nexts);
+  if (n_out == 0)
+    goto done;
+
+  gro_node = vlib_get_node (vm, ip4_gro_node.index);
+
+  for (i = 0; i < n_out; i++)
+    {
+      vlib_frame_t *f;
+      u32 *to_next;
+
+      if (to[i] == ~0)
+	continue;
+
+      f = vlib_get_frame_to_node (vm, gro_node->next_nodes[nexts[i]]);
+      to_next = vlib_frame_vector_args (f);
+
+      /* and the other flows going the same way */
+      for (j = i; j < n_out; j++)
+	if (to[j] != ~0 && nexts[j] == nexts[i])
+	  {
+	    to_next[f->n_vectors++] = to[j];
+	    if (j != i)
+	      to[j] = ~0;
+	  }
+      vlib_put_frame_to_node (vm, gro_node->next_nodes[nexts[i]], f);
+    }
+
+  vlib_node_increment_counter (vm, ip4_gro_node.index, IP4_GRO_ERROR_TIMEOUT,
+			       n_out);
+
+done:
+  gro_update_flush_node (vm, ptd);
+  return n_out;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip4_gro_flush_node) =
+{
+  .name = "ip4-gro-flush",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -52,6 +52,7 @@
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/l2/l2_output.h>
 #include <vnet/l2/l2_input.h>
+#include <vnet/pcap_capture.h>
 
 static int
 compare_interface_names (void *a1, void *a2)
@@ -1717,6 +1718,10 @@ pcap_trace_command_internal (vlib_main_t * vm,
   u8 *filename;
   u8 *chroot_filename = 0;
   u32 max = 0;
+  u32 n_files = 0;
+  uword ring_size = VNET_PCAP_DEFAULT_RING_SIZE;
+  u32 filter_table_index = vm->pcap[rx_tx].pcap_filter_table_index;
+  u64 n_packets, n_dropped;
   int enabled = 0;
   int errorFlag = 0;
   clib_error_t *error = 0;
@@ -1746,22 +1751,13 @@ pcap_trace_command_internal (vlib_main_t * vm,
 	{
 	  if (vm->pcap[rx_tx].pcap_enable)
 	    {
+	      vnet_pcap_capture_disable (vm, rx_tx);
 	      vlib_cli_output
 		(vm, "captured %d pkts...",
 		 vm->pcap[rx_tx].pcap_main.n_packets_captured);
 	      if (vm->pcap[rx_tx].pcap_main.n_packets_captured)
-		{
-		  vm->pcap[rx_tx].pcap_main.n_packets_to_capture =
-		    vm->pcap[rx_tx].pcap_main.n_packets_captured;
-		  error = pcap_write (&vm->pcap[rx_tx].pcap_main);
-		  if (error)
-		    clib_error_report (error);
-		  else
-		    vlib_cli_output (vm, "saved to %s...",
-				     vm->pcap[rx_tx].pcap_main.file_name);
-		}
-
-	      vm->pcap[rx_tx].pcap_enable = 0;
+		vlib_cli_output (vm, "saved to %s...",
+				 vm->pcap[rx_tx].pcap_main.file_name);
 	    }
 	  else
 	    {
@@ -1783,6 +1779,42 @@ pcap_trace_command_internal (vlib_main_t * vm,
 	    }
 	  vm->pcap[rx_tx].pcap_main.n_packets_to_capture = max;
 	}
+      else if (unformat (line_input, "rotate %d", &n_files)
+	       || unformat (line_input, "ring-size %U",
+			    unformat_memory_size, &ring_size)
+	       || unformat (line_input, "filter classify-table %d",
+			    &filter_table_index))
+	{
+	  if (vm->pcap[rx_tx].pcap_enable)
+	    {
+	      vlib_cli_output
+		(vm, "can't change capture settings while capture active...");
+	      errorFlag = 1;
+	      break;
+	    }
+	  if (ring_size < VNET_PCAP_MIN_RING_SIZE ||
+	      ring_size > VNET_PCAP_MAX_RING_SIZE)
+	    {
+	      error = clib_error_return (0, "ring-size must be in [%U, %U]",
+					 format_memory_size,
+					 (uword) VNET_PCAP_MIN_RING_SIZE,
+					 format_memory_size,
+					 (uword) VNET_PCAP_MAX_RING_SIZE);
+	      errorFlag = 1;
+	      break;
+	    }
+	}
+      else if (unformat (line_input, "filter none"))
+	{
+	  if (vm->pcap[rx_tx].pcap_enable)
+	    {
+	      vlib_cli_output
+		(vm, "can't change capture settings while capture active...");
+	      errorFlag = 1;
+	      break;
+	    }
+	  filter_table_index = ~0;
+	}
       else if (unformat (line_input, "intfc %U",
 			 unformat_vnet_sw_interface, vnm,
 			 &vm->pcap[rx_tx].pcap_sw_if_index))
@@ -1844,6 +1876,13 @@ pcap_trace_command_internal (vlib_main_t * vm,
 			       pcap_main.file_name : (u8 *) "/tmp/vpe.pcap");
 	    }
 
+	  if (vm->pcap[rx_tx].pcap_filter_table_index != ~0)
+	    vlib_cli_output (vm, "filtered by classify table %d",
+			     vm->pcap[rx_tx].pcap_filter_table_index);
+	  if (vm->pcap[rx_tx].pcap_n_files > 1)
+	    vlib_cli_output (vm, "rotating %d files",
+			     vm->pcap[rx_tx].pcap_n_files);
+
 	  if (vm->pcap[rx_tx].pcap_enable == 0)
 	    {
 	      vlib_cli_output (vm, "pcap %s capture is off...",
@@ -1857,6 +1896,9 @@ pcap_trace_command_internal (vlib_main_t * vm,
 			       vm->pcap[rx_tx].
 			       pcap_main.n_packets_to_capture);
 	    }
+	  vnet_pcap_capture_counters (rx_tx, &n_packets, &n_dropped);
+	  vlib_cli_output (vm, "%lld pkts captured, %lld dropped, ring full",
+			   n_packets, n_dropped);
 	  break;
 	}
 
@@ -1884,20 +1926,24 @@ pcap_trace_command_internal (vlib_main_t * vm,
 
       if (max)
 	vm->pcap[rx_tx].pcap_main.n_packets_to_capture = max;
+      if (n_files)
+	vm->pcap[rx_tx].pcap_n_files = n_files;
+      vm->pcap[rx_tx].pcap_filter_table_index = filter_table_index;
 
       if (enabled)
 	{
 	  if (vm->pcap[rx_tx].pcap_main.file_name == 0)
 	    vm->pcap[rx_tx].pcap_main.file_name
 	      = (char *) format (0, "/tmp/vpe.pcap%c", 0);
+	  if (vm->pcap[rx_tx].pcap_main.n_packets_to_capture == 0)
+	    vm->pcap[rx_tx].pcap_main.n_packets_to_capture =
+	      PCAP_DEF_PKT_TO_CAPTURE;
 
-	  vm->pcap[rx_tx].pcap_main.n_packets_captured = 0;
 	  vm->pcap[rx_tx].pcap_main.packet_type = PCAP_PACKET_TYPE_ethernet;
-	  if (vm->pcap[rx_tx].pcap_main.lock == 0)
-	    clib_spinlock_init (&(vm->pcap[rx_tx].pcap_main.lock));
-	  vm->pcap[rx_tx].pcap_enable = 1;
-	  vlib_cli_output (vm, "pcap %s capture on...",
-			   rx_tx == VLIB_RX ? "rx" : "tx");
+	  error = vnet_pcap_capture_enable (vm, rx_tx, ring_size);
+	  if (error == 0)
+	    vlib_cli_output (vm, "pcap %s capture on...",
+			     rx_tx == VLIB_RX ? "rx" : "tx");
 	}
     }
   else if (chroot_filename)
@@ -1931,11 +1977,25 @@ pcap_tx_trace_command_fn (vlib_main_t * vm,
  *
  * - <b>on|off</b> - Used to start or stop a packet capture.
  *
- * - <b>max <nn></b> - Depth of local buffer. Once '<em>nn</em>' number
- *   of packets have been received, buffer is flushed to file. Once another
- *   '<em>nn</em>' number of packets have been received, buffer is flushed
- *   to file, overwriting previous write. If not entered, value defaults
- *   to 100. Can only be updated if packet capture is off.
+ * - <b>max <nn></b> - Number of packets written to the file. Once
+ *   '<em>nn</em>' packets have been captured, the capture stops, unless
+ *   files are rotated. If not entered, value defaults to 1000. Can only
+ *   be updated if packet capture is off.
+ *
+ * - <b>rotate <nn></b> - Once the file is full, rename it with a '.1'
+ *   suffix, shifting older files up to '.<em>nn-1</em>', and carry on
+ *   capturing into a new file. Can only be updated if packet capture is
+ *   off.
+ *
+ * - <b>filter classify-table <index>|none</b> - Only capture packets
+ *   matching a session of the given classify table, or of the tables
+ *   chained to it. Sessions match from the ethernet header. Can only be
+ *   updated if packet capture is off.
+ *
+ * - <b>ring-size <size></b> - Size of the per-thread capture rings,
+ *   drained into the file every millisecond. Packets are dropped from
+ *   the capture, and counted, when a ring is full. Defaults to 2m, from
+ *   64k to 1g.
  *
  * - <b>intfc <interface>|any</b> - Used to specify a given interface,
  *   or use '<em>any</em>' to run packet capture on all interfaces.
@@ -1955,6 +2015,9 @@ pcap_tx_trace_command_fn (vlib_main_t * vm,
  *   the local buffer. All additional attributes entered on command line
  *   with '<em>status</em>' will be ignored and not applied.
  *
+ * Each thread captures into its own ring, without locking, and the rings
+ * are written to file by the main thread.
+ *
  * @cliexpar
  * Example of how to display the status of a tx packet capture when off:
  * @cliexstart{pcap tx trace status}
@@ -1981,13 +2044,17 @@ pcap_tx_trace_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (pcap_tx_trace_command, static) = {
     .path = "pcap tx trace",
     .short_help =
-    "pcap tx trace [on|off] [max <nn>] [intfc <interface>|any] [file <name>] [status]",
+    "pcap tx trace [on|off] [max <nn>] [intfc <interface>|any] [file <name>] "
+    "[rotate <nn>] [filter classify-table <index>|none] [ring-size <size>] "
+    "[status]",
     .function = pcap_tx_trace_command_fn,
 };
 VLIB_CLI_COMMAND (pcap_rx_trace_command, static) = {
     .path = "pcap rx trace",
     .short_help =
-    "pcap rx trace [on|off] [max <nn>] [intfc <interface>|any] [file <name>] [status]",
+    "pcap rx trace [on|off] [max <nn>] [intfc <interface>|any] [file <name>] "
+    "[rotate <nn>] [filter classify-table <index>|none] [ring-size <size>] "
+    "[status]",
     .function = pcap_rx_trace_command_fn,
 };
 /* *INDENT-ON* */
@@ -43,6 +43,8 @@
 #include <vnet/ip/ip6.h>
 #include <vnet/udp/udp_packet.h>
 #include <vnet/feature/feature.h>
+#include <vnet/pcap_capture.h>
+#include <vnet/latency.h>
 
 typedef struct
 {
@@ -232,11 +234,10 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
 static_always_inline u16
 tso_alloc_tx_bufs (vlib_main_t * vm,
 		   vnet_interface_per_thread_data_t * ptd,
-		   vlib_buffer_t * b0, u16 l4_hdr_sz)
+		   vlib_buffer_t * b0, u16 l234_sz)
 {
   u32 n_bytes_b0 = vlib_buffer_length_in_chain (vm, b0);
   u16 gso_size = vnet_buffer2 (b0)->gso_size;
-  u16 l234_sz = vnet_buffer (b0)->l4_hdr_offset + l4_hdr_sz;
   /* rounded-up division */
   u16 n_bufs = (n_bytes_b0 - l234_sz + (gso_size - 1)) / gso_size;
   u16 n_alloc;
@@ -253,15 +254,21 @@ tso_alloc_tx_bufs (vlib_main_t * vm,
   return 1;
 }
 
+/*
+ * Segments keep the super-segment's current_data, so the l3/l4 header
+ * offsets in the copied opaque remain valid. Locally originated packets,
+ * e.g., tcp super-segments, do not start at data[0].
+ */
 static_always_inline void
 tso_init_buf_from_template_base (vlib_buffer_t * nb0, vlib_buffer_t * b0,
 				 u32 flags, u16 length)
 {
-  nb0->current_data = 0;
+  nb0->current_data = b0->current_data;
   nb0->total_length_not_including_first_buffer = 0;
   nb0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID | flags;
   clib_memcpy_fast (&nb0->opaque, &b0->opaque, sizeof (nb0->opaque));
-  clib_memcpy_fast (nb0->data, b0->data, length);
+  clib_memcpy_fast (vlib_buffer_get_current (nb0),
+		    vlib_buffer_get_current (b0), length);
   nb0->current_length = length;
 }
 
@@ -275,8 +282,9 @@ tso_init_buf_from_template (vlib_main_t * vm, vlib_buffer_t * nb0,
 
   *p_dst_left =
     clib_min (gso_size,
-	      vlib_buffer_get_default_data_size (vm) - template_data_sz);
-  *p_dst_ptr = nb0->data + template_data_sz;
+	      vlib_buffer_get_default_data_size (vm) - nb0->current_data -
+	      template_data_sz);
+  *p_dst_ptr = vlib_buffer_get_current (nb0) + template_data_sz;
 
   tcp_header_t *tcp =
     (tcp_header_t *) (nb0->data + vnet_buffer (nb0)->l4_hdr_offset);
@@ -296,12 +304,12 @@ tso_fixup_segmented_buf (vlib_buffer_t * b0, u8 tcp_flags, int is_ip6)
 
   if (is_ip6)
     ip6->payload_length =
-      clib_host_to_net_u16 (b0->current_length -
-			    vnet_buffer (b0)->l4_hdr_offset);
+      clib_host_to_net_u16 (b0->current_length + b0->current_data -
+			    l4_hdr_offset);
   else
     ip4->length =
-      clib_host_to_net_u16 (b0->current_length -
-			    vnet_buffer (b0)->l3_hdr_offset);
+      clib_host_to_net_u16 (b0->current_length + b0->current_data -
+			    l3_hdr_offset);
 }
 
 /**
@@ -322,7 +330,6 @@ tso_segment_buffer (vlib_main_t * vm, vnet_interface_per_thread_data_t * ptd,
   int is_ip4 = sb0->flags & VNET_BUFFER_F_IS_IP4;
   int is_ip6 = sb0->flags & VNET_BUFFER_F_IS_IP6;
   ASSERT (is_ip4 || is_ip6);
-  ASSERT (sb0->flags & VNET_BUFFER_F_L2_HDR_OFFSET_VALID);
   ASSERT (sb0->flags & VNET_BUFFER_F_L3_HDR_OFFSET_VALID);
   ASSERT (sb0->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID);
   u16 gso_size = vnet_buffer2 (sb0)->gso_size;
@@ -342,16 +349,18 @@ tso_segment_buffer (vlib_main_t * vm, vnet_interface_per_thread_data_t * ptd,
 
   u32 default_bflags =
     sb0->flags & ~(VNET_BUFFER_F_GSO | VLIB_BUFFER_NEXT_PRESENT);
-  u16 l234_sz = vnet_buffer (sb0)->l4_hdr_offset + l4_hdr_sz;
+  /* headers size, relative to the start of the packet */
+  u16 l234_sz = vnet_buffer (sb0)->l4_hdr_offset + l4_hdr_sz -
+    sb0->current_data;
   int first_data_size = clib_min (gso_size, sb0->current_length - l234_sz);
   next_tcp_seq += first_data_size;
 
-  if (PREDICT_FALSE (!tso_alloc_tx_bufs (vm, ptd, sb0, l4_hdr_sz)))
+  if (PREDICT_FALSE (!tso_alloc_tx_bufs (vm, ptd, sb0, l234_sz)))
     return 0;
 
   vlib_buffer_t *b0 = vlib_get_buffer (vm, ptd->split_buffers[0]);
   tso_init_buf_from_template_base (b0, sb0, default_bflags,
-				   l4_hdr_sz + first_data_size);
+				   l234_sz + first_data_size);
 
   u32 total_src_left = n_bytes_b0 - l234_sz - first_data_size;
   if (total_src_left)
@@ -366,9 +375,8 @@ tso_segment_buffer (vlib_main_t * vm, vnet_interface_per_thread_data_t * ptd,
       vlib_buffer_t *cdb0;
       u16 dbi = 1;		/* the buffer [0] is b0 */
 
-      src_ptr = sb0->data + l234_sz + first_data_size;
+      src_ptr = vlib_buffer_get_current (sb0) + l234_sz + first_data_size;
       src_left = sb0->current_length - l234_sz - first_data_size;
-      b0->current_length = l234_sz + first_data_size;
 
       tso_fixup_segmented_buf (b0, tcp_flags_no_fin_psh, is_ip6);
       if (do_tx_offloads)
@@ -409,7 +417,7 @@ tso_segment_buffer (vlib_main_t * vm, vnet_interface_per_thread_data_t * ptd,
 		  csbi0 = next_bi;
 		  csb0 = vlib_get_buffer (vm, csbi0);
 		  src_left = csb0->current_length;
-		  src_ptr = csb0->data;
+		  src_ptr = vlib_buffer_get_current (csb0);
 		}
 	      else
 		{
@@ -834,9 +842,7 @@ static_always_inline void vnet_interface_pcap_tx_trace
       if (sw_if_index_from_buffer)
 	sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_TX];
 
-      if (vm->pcap[VLIB_TX].pcap_sw_if_index == 0 ||
-	  vm->pcap[VLIB_TX].pcap_sw_if_index == sw_if_index)
-	pcap_add_buffer (&vm->pcap[VLIB_TX].pcap_main, vm, bi0, 512);
+      vnet_pcap_add_buffer (vm, VLIB_TX, bi0, sw_if_index);
       from++;
       n_left_from--;
     }
@@ -882,6 +888,9 @@ vnet_interface_output_node (vlib_main_t * vm, vlib_node_runtime_t * node,
   vnet_interface_pcap_tx_trace (vm, node, frame,
 				0 /* sw_if_index_from_buffer */ );
 
+  vnet_latency_record (vm, vlib_frame_vector_args (frame), frame->n_vectors,
+		       rt->sw_if_index);
+
   if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD)
     return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
 					      /* do_tx_offloads */ 0);
@@ -16,6 +16,7 @@
  * flow_report.c
  */
 #include <vnet/ipfix-export/flow_report.h>
+#include <vnet/ip/ip.h>
 #include <vnet/api_errno.h>
 
 flow_report_main_t flow_report_main;
@@ -250,6 +251,229 @@ vnet_flow_rewrite_generic_callback (flow_report_main_t * frm,
   return rewrite;
 }
 
+/*
+ * Per thread export engine. Records are written in place in per thread
+ * buffers, each holding a data set of one template, and the ipfix
+ * packets are batched in a per thread frame to ip4-lookup.
+ */
+
+static_always_inline flow_report_per_thread_t *
+flow_report_get_per_thread (vlib_main_t * vm)
+{
+  return vec_elt_at_index (flow_report_main.per_thread, vm->thread_index);
+}
+
+/*
+ * Returns non-zero if the calling thread exceeds the records per second
+ * limit, and accounts the record otherwise. Up to one second worth of
+ * records can be sent in a burst.
+ */
+int
+vnet_flow_report_rate_limited (vlib_main_t * vm)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  flow_report_per_thread_t *pt = flow_report_get_per_thread (vm);
+  f64 rate = frm->max_records_per_sec;
+  f64 now;
+
+  if (PREDICT_TRUE (rate == 0))
+    return 0;
+
+  now = vlib_time_now (vm);
+  pt->tokens = clib_min (pt->tokens + (now - pt->tokens_time) * rate, rate);
+  pt->tokens_time = now;
+  if (pt->tokens < 1.0)
+    {
+      pt->records_dropped++;
+      return 1;
+    }
+  pt->tokens -= 1.0;
+  return 0;
+}
+
+/* Hand the calling thread's frame of ipfix packets to ip4-lookup */
+void
+vnet_flow_report_put_frame (vlib_main_t * vm)
+{
+  flow_report_per_thread_t *pt = flow_report_get_per_thread (vm);
+
+  if (pt->frame == 0)
+    return;
+  vlib_put_frame_to_node (vm, ip4_lookup_node.index, pt->frame);
+  pt->frame = 0;
+}
+
+/* Add an ipfix packet to the calling thread's frame */
+void
+vnet_flow_report_enqueue (vlib_main_t * vm, u32 bi)
+{
+  flow_report_per_thread_t *pt = flow_report_get_per_thread (vm);
+  u32 *to_next;
+
+  if (PREDICT_FALSE (pt->frame == 0))
+    pt->frame = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
+
+  to_next = vlib_frame_vector_args (pt->frame);
+  to_next[pt->frame->n_vectors++] = bi;
+  pt->packets++;
+
+  if (pt->frame->n_vectors == VLIB_FRAME_SIZE)
+    vnet_flow_report_put_frame (vm);
+}
+
+static vlib_buffer_t *
+flow_report_record_buffer_alloc (vlib_main_t * vm,
+				 flow_report_record_buffer_t * rb,
+				 u32 stream_index, u16 template_id)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  flow_report_stream_t *stream = &frm->streams[stream_index];
+  ip4_ipfix_template_packet_t *tp;
+  ipfix_message_header_t *h;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  vlib_buffer_t *b0;
+  u32 bi0;
+
+  if (vlib_buffer_alloc (vm, &bi0, 1) != 1)
+    return 0;
+
+  b0 = vlib_get_buffer (vm, bi0);
+  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b0);
+  b0->current_data = 0;
+  b0->current_length = sizeof (*ip) + sizeof (*udp) + sizeof (*h) +
+    sizeof (ipfix_set_header_t);
+  b0->flags |= (VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_FLOW_REPORT);
+  vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
+  vnet_buffer (b0)->sw_if_index[VLIB_TX] = frm->fib_index;
+
+  tp = vlib_buffer_get_current (b0);
+  ip = (ip4_header_t *) & tp->ip4;
+  udp = (udp_header_t *) (ip + 1);
+  h = (ipfix_message_header_t *) (udp + 1);
+
+  clib_memset (ip, 0, sizeof (*ip));
+  ip->ip_version_and_header_length = 0x45;
+  ip->ttl = 254;
+  ip->protocol = IP_PROTOCOL_UDP;
+  ip->src_address.as_u32 = frm->src_address.as_u32;
+  ip->dst_address.as_u32 = frm->ipfix_collector.as_u32;
+  udp->src_port = clib_host_to_net_u16 (stream->src_port);
+  udp->dst_port = clib_host_to_net_u16 (frm->collector_port);
+  udp->checksum = 0;
+  h->domain_id = clib_host_to_net_u32 (stream->domain_id);
+
+  rb->buffer = b0;
+  rb->stream_index = stream_index;
+  rb->template_id = template_id;
+  rb->n_records = 0;
+  return b0;
+}
+
+/*
+ * Reserve room for a record of record_len bytes in a data set of
+ * template_id, returns where to write the record or 0 if it is dropped.
+ * The buffer is sent first if the record does not fit in it.
+ */
+u8 *
+vnet_flow_report_record_add (vlib_main_t * vm,
+			     flow_report_record_buffer_t * rb,
+			     u32 stream_index, u16 template_id,
+			     u16 record_len)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  flow_report_per_thread_t *pt;
+  vlib_buffer_t *b0 = rb->buffer;
+  u8 *record;
+
+  if (vnet_flow_report_rate_limited (vm))
+    return 0;
+
+  if (b0 && (b0->current_length + record_len > frm->path_mtu
+	     || rb->template_id != template_id
+	     || rb->stream_index != stream_index))
+    {
+      vnet_flow_report_record_buffer_send (vm, rb);
+      b0 = 0;
+    }
+
+  pt = flow_report_get_per_thread (vm);
+  if (PREDICT_FALSE (b0 == 0))
+    {
+      b0 = flow_report_record_buffer_alloc (vm, rb, stream_index,
+					    template_id);
+      if (b0 == 0)
+	{
+	  pt->records_dropped++;
+	  return 0;
+	}
+    }
+
+  record = vlib_buffer_get_current (b0) + b0->current_length;
+  b0->current_length += record_len;
+  rb->n_records++;
+  pt->records++;
+  return record;
+}
+
+/* Complete the headers of the buffer and enqueue it */
+void
+vnet_flow_report_record_buffer_send (vlib_main_t * vm,
+				     flow_report_record_buffer_t * rb)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  vlib_buffer_t *b0 = rb->buffer;
+  flow_report_stream_t *stream;
+  ip4_ipfix_template_packet_t *tp;
+  ipfix_message_header_t *h;
+  ipfix_set_header_t *s;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+  u32 sequence_number;
+
+  if (b0 == 0)
+    return;
+  rb->buffer = 0;
+
+  tp = vlib_buffer_get_current (b0);
+  ip = (ip4_header_t *) & tp->ip4;
+  udp = (udp_header_t *) (ip + 1);
+  h = (ipfix_message_header_t *) (udp + 1);
+  s = (ipfix_set_header_t *) (h + 1);
+
+  h->export_time = clib_host_to_net_u32 ((u32)
+					 (((f64) frm->unix_time_0) +
+					  (vlib_time_now (vm) -
+					   frm->vlib_time_0)));
+
+  /* RFC 7011 section 3.1: the sequence number counts data records */
+  stream = &frm->streams[rb->stream_index];
+  sequence_number = clib_atomic_fetch_add (&stream->sequence_number,
+					   rb->n_records);
+  h->sequence_number = clib_host_to_net_u32 (sequence_number);
+
+  s->set_id_length = ipfix_set_id_length (rb->template_id,
+					  b0->current_length -
+					  (sizeof (*ip) + sizeof (*udp) +
+					   sizeof (*h)));
+  h->version_length = version_length (b0->current_length -
+				      (sizeof (*ip) + sizeof (*udp)));
+
+  ip->length = clib_host_to_net_u16 (b0->current_length);
+  ip->checksum = ip4_header_checksum (ip);
+  udp->length = clib_host_to_net_u16 (b0->current_length - sizeof (*ip));
+
+  if (frm->udp_checksum)
+    {
+      /* RFC 7011 section 10.3.2. */
+      udp->checksum = ip4_tcp_udp_compute_checksum (vm, b0, ip);
+      if (udp->checksum == 0)
+	udp->checksum = 0xffff;
+    }
+
+  vnet_flow_report_enqueue (vm, vlib_get_buffer_index (vm, b0));
+}
+
 static uword
 flow_report_process (vlib_main_t * vm,
 		     vlib_node_runtime_t * rt, vlib_frame_t * f)
@@ -284,6 +508,8 @@ flow_report_process (vlib_main_t * vm,
       event_type = vlib_process_get_events (vm, &event_data);
       vec_reset_length (event_data);
 
+      /* Template and data packets of all the reports share the frames */
+      nf = 0;
       vec_foreach (fr, frm->reports)
       {
 	now = vlib_time_now (vm);
@@ -301,9 +527,18 @@ flow_report_process (vlib_main_t * vm,
 	if (rv < 0)
 	  continue;
 
-	nf = vlib_get_frame_to_node (vm, ip4_lookup_node_index);
-	nf->n_vectors = 0;
-	to_next = vlib_frame_vector_args (nf);
+	/* Leave room for the template and a first data packet */
+	if (nf && nf->n_vectors >= VLIB_FRAME_SIZE - 1)
+	  {
+	    vlib_put_frame_to_node (vm, ip4_lookup_node_index, nf);
+	    nf = 0;
+	  }
+	if (nf == 0)
+	  {
+	    nf = vlib_get_frame_to_node (vm, ip4_lookup_node_index);
+	    nf->n_vectors = 0;
+	  }
+	to_next = vlib_frame_vector_args (nf) + nf->n_vectors;
 
 	if (template_bi != ~0)
 	  {
@@ -314,9 +549,9 @@ flow_report_process (vlib_main_t * vm,
 
 	nf = fr->flow_data_callback (frm, fr,
 				     nf, to_next, ip4_lookup_node_index);
-	if (nf)
-	  vlib_put_frame_to_node (vm, ip4_lookup_node_index, nf);
       }
+      if (nf)
+	vlib_put_frame_to_node (vm, ip4_lookup_node_index, nf);
     }
 
   return 0;			/* not so much */
@@ -494,6 +729,7 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
   src.as_u32 = 0;
   u32 path_mtu = 512;		// RFC 7011 section 10.3.3.
   u32 template_interval = 20;
+  u32 max_records_per_sec = 0;
   u8 udp_checksum = 0;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
@@ -518,6 +754,8 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (input, "udp-checksum"))
 	udp_checksum = 1;
+      else if (unformat (input, "rate-limit %u", &max_records_per_sec))
+	;
       else
 	break;
     }
@@ -544,6 +782,7 @@ set_ipfix_exporter_command_fn (vlib_main_t * vm,
   frm->path_mtu = path_mtu;
   frm->template_interval = template_interval;
   frm->udp_checksum = udp_checksum;
+  frm->max_records_per_sec = max_records_per_sec;
 
   if (collector.as_u32)
     vlib_cli_output (vm, "Collector %U, src address %U, "
@@ -569,13 +808,57 @@ VLIB_CLI_COMMAND (set_ipfix_exporter_command, static) = {
                   "collector <ip4-address> [port <port>] "
                   "src <ip4-address> [fib-id <fib-id>] "
                   "[path-mtu <path-mtu>] "
-                  "[template-interval <template-interval>]",
-                  "[udp-checksum]",
+                  "[template-interval <template-interval>] "
+                  "[udp-checksum] [rate-limit <records-per-sec>]",
     .function = set_ipfix_exporter_command_fn,
 };
 /* *INDENT-ON* */
 
 
+static clib_error_t *
+show_ipfix_exporter_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  flow_report_main_t *frm = &flow_report_main;
+  flow_report_per_thread_t *pt;
+
+  if (frm->ipfix_collector.as_u32 == 0)
+    vlib_cli_output (vm, "IPFIX Collector is disabled");
+  else
+    vlib_cli_output (vm, "Collector %U:%u, src address %U, path MTU %u, "
+		     "template resend interval %us",
+		     format_ip4_address, &frm->ipfix_collector,
+		     frm->collector_port, format_ip4_address,
+		     &frm->src_address, frm->path_mtu,
+		     frm->template_interval);
+  if (frm->max_records_per_sec)
+    vlib_cli_output (vm, "Rate limit %u records/sec per thread",
+		     frm->max_records_per_sec);
+
+  vec_foreach (pt, frm->per_thread)
+    vlib_cli_output (vm, "Thread %d: %llu records, %llu dropped, "
+		     "%llu data packets", pt - frm->per_thread, pt->records,
+		     pt->records_dropped, pt->packets);
+  return 0;
+}
+
+/*?
+ * Display the IPFIX exporter configuration, and per thread the data
+ * records exported, the records dropped by the rate limiter or for lack
+ * of buffers, and the data packets they were sent in.
+ *
+ * @cliexpar
+ * @cliexcmd{show ipfix exporter}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_ipfix_exporter_command, static) = {
+    .path = "show ipfix exporter",
+    .short_help = "show ipfix exporter",
+    .function = show_ipfix_exporter_command_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 ipfix_flush_command_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -604,6 +887,10 @@ flow_report_init (vlib_main_t * vm)
   frm->vlib_time_0 = vlib_time_now (frm->vlib_main);
   frm->fib_index = ~0;
 
+  vec_validate_aligned (frm->per_thread,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
   return 0;
 }
 
@@ -108,6 +108,36 @@ typedef struct flow_report
   vnet_flow_data_callback_t *flow_data_callback;
 } flow_report_t;
 
+/*
+ * Records of one template under construction in a buffer, owned by a
+ * thread. The buffer is sent once the next record does not fit in the
+ * path MTU, or when it is flushed.
+ */
+typedef struct
+{
+  vlib_buffer_t *buffer;
+  u32 stream_index;
+  u16 template_id;
+  u16 n_records;
+} flow_report_record_buffer_t;
+
+/* Per thread export state */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* frame of ipfix packets to ip4-lookup */
+  vlib_frame_t *frame;
+
+  /* rate limiter, in records */
+  f64 tokens;
+  f64 tokens_time;
+
+  /* counters */
+  u64 records;
+  u64 records_dropped;
+  u64 packets;
+} flow_report_per_thread_t;
+
 typedef struct flow_report_main
 {
   flow_report_t *reports;
@@ -128,6 +158,12 @@ typedef struct flow_report_main
   /* UDP checksum calculation enable flag */
   u8 udp_checksum;
 
+  /* per thread records per second limit, 0 for none */
+  u32 max_records_per_sec;
+
+  /* per thread export state */
+  flow_report_per_thread_t *per_thread;
+
   /* time scale transform. Joy. */
   u32 unix_time_0;
   f64 vlib_time_0;
@@ -166,6 +202,20 @@ void vnet_flow_reports_reset (flow_report_main_t * frm);
 
 void vnet_stream_reset (flow_report_main_t * frm, u32 stream_index);
 
+u8 *vnet_flow_report_record_add (vlib_main_t * vm,
+				 flow_report_record_buffer_t * rb,
+				 u32 stream_index, u16 template_id,
+				 u16 record_len);
+
+void vnet_flow_report_record_buffer_send (vlib_main_t * vm,
+					  flow_report_record_buffer_t * rb);
+
+int vnet_flow_report_rate_limited (vlib_main_t * vm);
+
+void vnet_flow_report_enqueue (vlib_main_t * vm, u32 bi);
+
+void vnet_flow_report_put_frame (vlib_main_t * vm);
+
 int vnet_stream_change (flow_report_main_t * frm,
 			u32 old_domain_id, u16 old_src_port,
 			u32 new_domain_id, u16 new_src_port);
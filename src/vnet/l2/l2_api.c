@@ -75,6 +75,8 @@ _(BRIDGE_FLAGS, bridge_flags)                                   \
 _(L2_INTERFACE_VLAN_TAG_REWRITE, l2_interface_vlan_tag_rewrite) \
 _(L2_INTERFACE_PBB_TAG_REWRITE, l2_interface_pbb_tag_rewrite)   \
 _(BRIDGE_DOMAIN_SET_MAC_AGE, bridge_domain_set_mac_age)         \
+_(BRIDGE_DOMAIN_SET_LEARN_LIMIT, bridge_domain_set_learn_limit) \
+_(SW_INTERFACE_SET_L2_LEARN_LIMIT, sw_interface_set_l2_learn_limit) \
 _(SW_INTERFACE_SET_VPATH, sw_interface_set_vpath)               \
 _(BVI_CREATE, bvi_create)                                       \
 _(BVI_DELETE, bvi_delete)
@@ -428,6 +430,49 @@ out:
   REPLY_MACRO (VL_API_BRIDGE_DOMAIN_SET_MAC_AGE_REPLY);
 }
 
+static void
+  vl_api_bridge_domain_set_learn_limit_t_handler
+  (vl_api_bridge_domain_set_learn_limit_t * mp)
+{
+  bd_main_t *bdm = &bd_main;
+  vl_api_bridge_domain_set_learn_limit_reply_t *rmp;
+  int rv = 0;
+  u32 bd_id = ntohl (mp->bd_id);
+  uword *p;
+
+  if (bd_id == 0)
+    {
+      rv = VNET_API_ERROR_BD_NOT_MODIFIABLE;
+      goto out;
+    }
+
+  p = hash_get (bdm->bd_index_by_bd_id, bd_id);
+  if (p == 0)
+    {
+      rv = VNET_API_ERROR_NO_SUCH_ENTRY;
+      goto out;
+    }
+  rv = l2learn_set_bd_learn_limit (*p, ntohl (mp->learn_limit));
+out:
+  REPLY_MACRO (VL_API_BRIDGE_DOMAIN_SET_LEARN_LIMIT_REPLY);
+}
+
+static void
+  vl_api_sw_interface_set_l2_learn_limit_t_handler
+  (vl_api_sw_interface_set_l2_learn_limit_t * mp)
+{
+  vl_api_sw_interface_set_l2_learn_limit_reply_t *rmp;
+  int rv = 0;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = l2learn_set_sw_if_learn_limit (ntohl (mp->sw_if_index),
+				      ntohl (mp->learn_limit));
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_SW_INTERFACE_SET_L2_LEARN_LIMIT_REPLY);
+}
+
 static void
 vl_api_bridge_domain_add_del_t_handler (vl_api_bridge_domain_add_del_t * mp)
 {
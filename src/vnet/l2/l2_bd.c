@@ -127,6 +127,9 @@ bd_delete (bd_main_t * bdm, u32 bd_index)
   /* free BD tag */
   vec_free (bd->bd_tag);
 
+  /* remove the learn limit, the counter is reset by the flush scan */
+  l2learn_set_bd_learn_limit (bd_index, 0);
+
   /* free memory used by BD */
   vec_free (bd->members);
   bd_free_ip_mac_tables (bd);
@@ -708,6 +711,54 @@ VLIB_CLI_COMMAND (bd_mac_age_cli, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+bd_learn_limit (vlib_main_t * vm,
+		unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  bd_main_t *bdm = &bd_main;
+  u32 bd_id, limit;
+  uword *p;
+
+  if (!unformat (input, "%d", &bd_id))
+    return clib_error_return (0, "expecting bridge-domain id but got `%U'",
+			      format_unformat_error, input);
+
+  if (bd_id == 0)
+    return clib_error_return (0,
+			      "No operations on the default bridge domain are supported");
+
+  p = hash_get (bdm->bd_index_by_bd_id, bd_id);
+
+  if (p == 0)
+    return clib_error_return (0, "No such bridge domain %d", bd_id);
+
+  if (!unformat (input, "%u", &limit))
+    return clib_error_return (0, "expecting limit but got `%U'",
+			      format_unformat_error, input);
+
+  l2learn_set_bd_learn_limit (p[0], limit);
+
+  return 0;
+}
+
+/*?
+ * Limit the number of macs dynamically learned in a bridge-domain. Once
+ * the limit is reached new source macs are not learned in the
+ * bridge-domain until some of the learned macs age out or are flushed.
+ * A limit of 0, the default, removes the limit.
+ *
+ * @cliexpar
+ * Example of how to learn at most 1000 macs in bridge-domain 200:
+ * @cliexcmd{set bridge-domain learn-limit 200 1000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (bd_learn_limit_cli, static) = {
+  .path = "set bridge-domain learn-limit",
+  .short_help = "set bridge-domain learn-limit <bridge-domain-id> <limit>",
+  .function = bd_learn_limit,
+};
+/* *INDENT-ON* */
+
 /*?
  * Modify whether or not an existing bridge-domain should terminate and respond
  * to ARP Requests. ARP Termination is disabled by default.
@@ -1138,6 +1189,28 @@ bd_show (vlib_main_t * vm, unformat_input_t * input, vlib_cli_command_t * cmd)
 	      vlib_cli_output (vm, "\n  BD-Tag: %s", bd_config->bd_tag);
 
 	    }
+
+	  if (detail)
+	    {
+	      l2learn_main_t *lm = &l2learn_main;
+	      u32 limit = bd_index < vec_len (lm->bd_learn_limits) ?
+		lm->bd_learn_limits[bd_index] : 0;
+	      u64 learned = 0;
+
+	      if (bd_index <
+		  vlib_simple_counter_n_counters
+		  (&lm->bd_learn_counters.learned))
+		learned = l2learn_get_count (&lm->bd_learn_counters,
+					     bd_index);
+
+	      if (limit)
+		as = format (as, "%u", limit);
+	      else
+		as = format (as, "none");
+	      vlib_cli_output (vm, "\n  Learned MACs: %llu, limit: %v",
+			       learned, as);
+	      vec_reset_length (as);
+	    }
 	}
     }
   vec_free (as);
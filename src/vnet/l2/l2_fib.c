@@ -348,6 +348,7 @@ l2fib_clear_table (void)
   BV (clib_bihash_init) (&mp->mac_table, "l2fib mac table",
 			 L2FIB_NUM_BUCKETS, L2FIB_MEMORY_SIZE);
   l2learn_main.global_learn_count = 0;
+  l2learn_zero_counters ();
 }
 
 /** Clear all entries in L2FIB.
@@ -415,9 +416,13 @@ l2fib_add_entry (const u8 * mac, u32 bd_index,
     {
       /* decrement counter if overwriting a learned mac  */
       result.raw = kv.value;
-      if ((!l2fib_entry_result_is_set_AGE_NOT (&result))
-	  && (lm->global_learn_count))
-	lm->global_learn_count--;
+      if (!l2fib_entry_result_is_set_AGE_NOT (&result))
+	{
+	  if (lm->global_learn_count)
+	    lm->global_learn_count--;
+	  l2learn_count (vlib_get_thread_index (), bd_index,
+			 result.fields.sw_if_index, -1);
+	}
     }
 
   /* set up result */
@@ -699,10 +704,14 @@ l2fib_del_entry (const u8 * mac, u32 bd_index, u32 sw_if_index)
   if ((sw_if_index != 0) && (sw_if_index != result.fields.sw_if_index))
     return 1;
 
-  /* decrement counter if dynamically learned mac */
-  if ((!l2fib_entry_result_is_set_AGE_NOT (&result)) &&
-      (l2learn_main.global_learn_count))
-    l2learn_main.global_learn_count--;
+  /* decrement counters if dynamically learned mac */
+  if (!l2fib_entry_result_is_set_AGE_NOT (&result))
+    {
+      if (l2learn_main.global_learn_count)
+	l2learn_main.global_learn_count--;
+      l2learn_count (vlib_get_thread_index (), bd_index,
+		     result.fields.sw_if_index, -1);
+    }
 
   /* Remove entry from hash table */
   BV (clib_bihash_add_del) (&mp->mac_table, &kv, 0 /* is_add */ );
@@ -982,40 +991,198 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
+/*
+ * MAC events are accumulated in messages of up to max_macs_in_event
+ * entries which are sent to the client as they fill up
+ */
+typedef struct
+{
+  vl_api_l2_macs_event_t *mp;
+  vl_api_registration_t *reg;
+  u32 client;
+  u32 client_index;
+  u32 evt_idx;
+} l2fib_mac_evt_ctx_t;
+
+static_always_inline void
+l2fib_mac_evt_init (l2fib_mac_evt_ctx_t * ctx)
+{
+  l2learn_main_t *lm = &l2learn_main;
+
+  clib_memset (ctx, 0, sizeof (*ctx));
+  ctx->client = lm->client_pid;
+  ctx->client_index = lm->client_index;
+  if (ctx->client)
+    {
+      ctx->mp = allocate_mac_evt_buf (ctx->client, ctx->client_index);
+      ctx->reg = vl_api_client_index_to_registration (ctx->client_index);
+    }
+}
+
+static_always_inline void
+l2fib_mac_evt_add (l2fib_mac_evt_ctx_t * ctx, l2fib_entry_key_t * key,
+		   u32 sw_if_index, l2_mac_event_action_t action)
+{
+  l2fib_main_t *fm = &l2fib_main;
+
+  if (PREDICT_FALSE (ctx->evt_idx >= fm->max_macs_in_event))
+    {
+      /* event message full, send it and start a new one */
+      if (ctx->reg && vl_api_can_send_msg (ctx->reg))
+	{
+	  ctx->mp->n_macs = htonl (ctx->evt_idx);
+	  vl_api_send_msg (ctx->reg, (u8 *) ctx->mp);
+	  ctx->mp = allocate_mac_evt_buf (ctx->client, ctx->client_index);
+	}
+      else
+	{
+	  if (ctx->reg)
+	    clib_warning ("MAC event to pid %d queue stuffed!"
+			  " %d MAC entries lost", ctx->client, ctx->evt_idx);
+	}
+      ctx->evt_idx = 0;
+    }
+
+  /* copy mac entry to event msg */
+  clib_memcpy_fast (ctx->mp->mac[ctx->evt_idx].mac_addr, key->fields.mac, 6);
+  ctx->mp->mac[ctx->evt_idx].action = action;
+  ctx->mp->mac[ctx->evt_idx].sw_if_index = htonl (sw_if_index);
+  ctx->evt_idx++;
+}
+
+static_always_inline void
+l2fib_mac_evt_flush (l2fib_mac_evt_ctx_t * ctx)
+{
+  if (!ctx->mp)
+    return;
+
+  /*  send any outstanding mac event message else free message buffer */
+  if (ctx->evt_idx)
+    {
+      if (ctx->reg && vl_api_can_send_msg (ctx->reg))
+	{
+	  ctx->mp->n_macs = htonl (ctx->evt_idx);
+	  vl_api_send_msg (ctx->reg, (u8 *) ctx->mp);
+	}
+      else
+	{
+	  if (ctx->reg)
+	    clib_warning ("MAC event to pid %d queue stuffed!"
+			  " %d MAC entries lost", ctx->client, ctx->evt_idx);
+	  vl_msg_api_free (ctx->mp);
+	}
+    }
+  else
+    vl_msg_api_free (ctx->mp);
+  ctx->mp = 0;
+}
+
+/**
+ * Report the learn or move of a mac to the event client, if the event is
+ * still pending, and clear the event flags of the entry.
+ * Returns 1 if an event was reported.
+ */
+static_always_inline int
+l2fib_mac_evt_learn (l2fib_mac_evt_ctx_t * ctx, l2fib_entry_key_t * key,
+		     l2fib_entry_result_t * result)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  BVT (clib_bihash_kv) kv;
+
+  if (!ctx->client || !l2fib_entry_result_is_set_LRN_EVT (result))
+    return 0;
+
+  l2fib_mac_evt_add (ctx, key, result->fields.sw_if_index,
+		     l2fib_entry_result_is_set_LRN_MOV (result) ?
+		     MAC_EVENT_ACTION_MOVE : MAC_EVENT_ACTION_ADD);
+
+  /* clear event bits and update mac entry */
+  l2fib_entry_result_clear_LRN_EVT (result);
+  l2fib_entry_result_clear_LRN_MOV (result);
+  kv.key = key->raw;
+  kv.value = result->raw;
+  BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
+  return 1;
+}
+
+/**
+ * Track a learned mac in the time bucket of the minute it expires in,
+ * given the mac age of its bridge domain
+ */
+static_always_inline void
+l2fib_age_wheel_add (l2fib_main_t * fm, l2fib_entry_key_t * key,
+		     l2fib_entry_result_t * result, u8 mac_age)
+{
+  u8 expiry = result->fields.timestamp + mac_age;
+  vec_add1 (fm->age_wheel[expiry], key->raw);
+}
+
+static void
+l2fib_age_wheel_reset (l2fib_main_t * fm, f64 now)
+{
+  int i;
+
+  for (i = 0; i < L2FIB_AGE_WHEEL_SIZE; i++)
+    vec_reset_length (fm->age_wheel[i]);
+  fm->age_wheel_minute = (u8) (now / 60);
+}
+
+/**
+ * Discard all pending learn records. Used before a full scan, which
+ * handles both events and aging of all entries.
+ */
+static void
+l2fib_learn_rings_reset (l2fib_main_t * fm)
+{
+  l2fib_learn_ring_t *r;
+
+  vec_foreach (r, fm->learn_rings)
+  {
+    r->overflow = 0;
+    r->head = r->tail;
+  }
+}
+
+static_always_inline void
+l2fib_scan_yield (vlib_main_t * vm, f64 * last_start, f64 * accum_t)
+{
+  /* allow no more than 20us without a pause */
+  f64 delta_t = vlib_time_now (vm) - *last_start;
+  if (delta_t > 20e-6)
+    {
+      vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
+      *last_start = vlib_time_now (vm);
+      *accum_t += delta_t;
+    }
+}
+
+/**
+ * Walk the whole mac table to report pending learn events, age out macs
+ * and rebuild the aging time buckets. Used when aging is (re)configured,
+ * to flush macs, or when learn records were lost.
+ */
 static_always_inline f64
-l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
+l2fib_scan (vlib_main_t * vm, f64 start_time)
 {
   l2fib_main_t *fm = &l2fib_main;
-  l2learn_main_t *lm = &l2learn_main;
 
   BVT (clib_bihash) * h = &fm->mac_table;
   int i, j, k;
   f64 last_start = start_time;
   f64 accum_t = 0;
-  f64 delta_t = 0;
-  u32 evt_idx = 0;
   u32 learn_count = 0;
-  u32 client = lm->client_pid;
-  u32 cl_idx = lm->client_index;
-  vl_api_l2_macs_event_t *mp = 0;
-  vl_api_registration_t *reg = 0;
+  l2learn_resync_t bd_resync, sw_if_resync;
+  l2fib_mac_evt_ctx_t evt;
 
-  if (client)
-    {
-      mp = allocate_mac_evt_buf (client, cl_idx);
-      reg = vl_api_client_index_to_registration (lm->client_index);
-    }
+  l2fib_mac_evt_init (&evt);
+  l2learn_resync_start (&bd_resync, &l2learn_main.bd_learn_counters);
+  l2learn_resync_start (&sw_if_resync, &l2learn_main.sw_if_learn_counters);
+  l2fib_learn_rings_reset (fm);
+  l2fib_age_wheel_reset (fm, start_time);
 
   for (i = 0; i < h->nbuckets; i++)
     {
-      /* allow no more than 20us without a pause */
-      delta_t = vlib_time_now (vm) - last_start;
-      if (delta_t > 20e-6)
-	{
-	  vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
-	  last_start = vlib_time_now (vm);
-	  accum_t += delta_t;
-	}
+      l2fib_scan_yield (vm, &last_start, &accum_t);
 
       if (i < (h->nbuckets - 3))
 	{
@@ -1045,59 +1212,24 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      l2fib_entry_result_t result = {.raw = v->kvp[k].value };
 
 	      if (!l2fib_entry_result_is_set_AGE_NOT (&result))
-		learn_count++;
-
-	      if (client)
 		{
-		  if (PREDICT_FALSE (evt_idx >= fm->max_macs_in_event))
-		    {
-		      /* event message full, send it and start a new one */
-		      if (reg && vl_api_can_send_msg (reg))
-			{
-			  mp->n_macs = htonl (evt_idx);
-			  vl_api_send_msg (reg, (u8 *) mp);
-			  mp = allocate_mac_evt_buf (client, cl_idx);
-			}
-		      else
-			{
-			  if (reg)
-			    clib_warning ("MAC event to pid %d queue stuffed!"
-					  " %d MAC entries lost", client,
-					  evt_idx);
-			}
-		      evt_idx = 0;
-		    }
-
-		  if (l2fib_entry_result_is_set_LRN_EVT (&result))
-		    {
-		      /* copy mac entry to event msg */
-		      clib_memcpy_fast (mp->mac[evt_idx].mac_addr,
-					key.fields.mac, 6);
-		      mp->mac[evt_idx].action =
-			l2fib_entry_result_is_set_LRN_MOV (&result) ?
-			MAC_EVENT_ACTION_MOVE : MAC_EVENT_ACTION_ADD;
-		      mp->mac[evt_idx].sw_if_index =
-			htonl (result.fields.sw_if_index);
-		      /* clear event bits and update mac entry */
-		      l2fib_entry_result_clear_LRN_EVT (&result);
-		      l2fib_entry_result_clear_LRN_MOV (&result);
-		      BVT (clib_bihash_kv) kv;
-		      kv.key = key.raw;
-		      kv.value = result.raw;
-		      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
-		      evt_idx++;
-		      continue;	/* skip aging */
-		    }
+		  learn_count++;
+		  l2learn_resync_count (&bd_resync, key.fields.bd_index, 1);
+		  l2learn_resync_count (&sw_if_resync,
+					result.fields.sw_if_index, 1);
 		}
 
-	      if (event_only || l2fib_entry_result_is_set_AGE_NOT (&result))
+	      /* skip aging of just learned macs, but keep tracking them */
+	      int skip_aging = l2fib_mac_evt_learn (&evt, &key, &result);
+
+	      if (l2fib_entry_result_is_set_AGE_NOT (&result))
 		continue;	/* skip aging - static_mac always age_not */
 
 	      /* start aging processing */
 	      u32 bd_index = key.fields.bd_index;
 	      u32 sw_if_index = result.fields.sw_if_index;
 	      u16 sn = l2fib_cur_seq_num (bd_index, sw_if_index).as_u16;
-	      if (result.fields.sn.as_u16 != sn)
+	      if (!skip_aging && result.fields.sn.as_u16 != sn)
 		goto age_out;	/* stale mac */
 
 	      l2_bridge_domain_t *bd_config =
@@ -1109,25 +1241,27 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      i16 delta = (u8) (start_time / 60) - result.fields.timestamp;
 	      delta += delta < 0 ? 256 : 0;
 
-	      if (delta < bd_config->mac_age)
-		continue;	/* still valid */
-
-	    age_out:
-	      if (client)
+	      if (skip_aging || delta < bd_config->mac_age)
 		{
-		  /* copy mac entry to event msg */
-		  clib_memcpy_fast (mp->mac[evt_idx].mac_addr, key.fields.mac,
-				    6);
-		  mp->mac[evt_idx].action = MAC_EVENT_ACTION_DELETE;
-		  mp->mac[evt_idx].sw_if_index =
-		    htonl (result.fields.sw_if_index);
-		  evt_idx++;
+		  /* still valid */
+		  l2fib_age_wheel_add (fm, &key, &result, bd_config->mac_age);
+		  continue;
 		}
+
+	    age_out:
+	      if (evt.client)
+		l2fib_mac_evt_add (&evt, &key, result.fields.sw_if_index,
+				   MAC_EVENT_ACTION_DELETE);
 	      /* delete mac entry */
 	      BVT (clib_bihash_kv) kv;
 	      kv.key = key.raw;
 	      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
 	      learn_count--;
+	      l2learn_count (vm->thread_index, key.fields.bd_index,
+			     result.fields.sw_if_index, -1);
+	      l2learn_resync_count (&bd_resync, key.fields.bd_index, -1);
+	      l2learn_resync_count (&sw_if_resync,
+				    result.fields.sw_if_index, -1);
 	      /*
 	       * Note: we may have just freed the bucket's backing
 	       * storage, so check right here...
@@ -1141,31 +1275,171 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       ;
     }
 
-  /* keep learn count consistent */
+  /* keep learn counts consistent, counts of macs learned or aged out by
+   * workers during the scan are resynchronized by the next one */
   l2learn_main.global_learn_count = learn_count;
+  l2learn_resync_end (&bd_resync, &l2learn_main.bd_learn_counters);
+  l2learn_resync_end (&sw_if_resync, &l2learn_main.sw_if_learn_counters);
+
+  l2fib_mac_evt_flush (&evt);
+  return vlib_time_now (vm) - last_start + accum_t;
+}
+
+/**
+ * Process the macs learned or moved by workers since the last call:
+ * report pending learn events and, if aging is enabled, start tracking
+ * them in the aging time buckets.
+ * Returns 1 if a learn ring overflowed, in which case a full scan is
+ * needed to catch up.
+ */
+static int
+l2fib_learn_rings_drain (vlib_main_t * vm, l2fib_mac_evt_ctx_t * evt,
+			 u8 track_age, f64 * duration)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  f64 last_start = vlib_time_now (vm), accum_t = 0;
+  l2fib_entry_result_t result;
+  l2fib_entry_key_t key;
+  l2_bridge_domain_t *bd_config;
+  BVT (clib_bihash_kv) kv;
+  l2fib_learn_ring_t *r;
+  int overflow = 0;
+  u32 head, tail;
+
+  vec_foreach (r, fm->learn_rings)
+  {
+    overflow |= r->overflow;
+    head = r->head;
+    tail = r->tail;
+    /* keys written before tail was advanced */
+    CLIB_MEMORY_BARRIER ();
+
+    while (head != tail)
+      {
+	if ((head & 255) == 0)
+	  l2fib_scan_yield (vm, &last_start, &accum_t);
+
+	kv.key = r->keys[head++ & (L2FIB_LEARN_RING_SIZE - 1)];
+	if (BV (clib_bihash_search) (&fm->mac_table, &kv, &kv))
+	  continue;		/* already deleted */
+
+	key.raw = kv.key;
+	result.raw = kv.value;
+	l2fib_mac_evt_learn (evt, &key, &result);
 
-  if (mp)
+	if (!track_age || l2fib_entry_result_is_set_AGE_NOT (&result))
+	  continue;
+
+	bd_config = vec_elt_at_index (l2input_main.bd_configs,
+				      key.fields.bd_index);
+	if (bd_config->mac_age)
+	  l2fib_age_wheel_add (fm, &key, &result, bd_config->mac_age);
+      }
+
+    r->head = head;
+  }
+
+  *duration = vlib_time_now (vm) - last_start + accum_t;
+  return overflow;
+}
+
+static int
+l2fib_key_cmp (void *a1, void *a2)
+{
+  u64 *k1 = a1, *k2 = a2;
+  return (*k1 > *k2) - (*k1 < *k2);
+}
+
+/**
+ * Age the macs tracked in the time buckets of all minutes since the last
+ * call. Macs refreshed since they were tracked are moved to the bucket of
+ * their new expiry minute, others are deleted.
+ */
+static f64
+l2fib_age_wheel_expire (vlib_main_t * vm, f64 start_time,
+			l2fib_mac_evt_ctx_t * evt)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  f64 last_start = start_time, accum_t = 0;
+  u8 now = (u8) (start_time / 60);
+  l2fib_entry_result_t result;
+  l2_bridge_domain_t *bd_config;
+  l2fib_entry_key_t key;
+  BVT (clib_bihash_kv) kv;
+  u64 *keys, last_key;
+  i16 delta;
+  u16 sn;
+  int i;
+
+  while (fm->age_wheel_minute != now)
     {
-      /*  send any outstanding mac event message else free message buffer */
-      if (evt_idx)
+      fm->age_wheel_minute++;
+      keys = fm->age_wheel[fm->age_wheel_minute];
+      if (vec_len (keys) == 0)
+	continue;
+      fm->age_wheel[fm->age_wheel_minute] = 0;
+
+      /* a mac can be tracked more than once, e.g., if relearned */
+      vec_sort_with_function (keys, l2fib_key_cmp);
+      last_key = ~0ULL;
+
+      for (i = 0; i < vec_len (keys); i++)
 	{
-	  if (reg && vl_api_can_send_msg (reg))
-	    {
-	      mp->n_macs = htonl (evt_idx);
-	      vl_api_send_msg (reg, (u8 *) mp);
-	    }
-	  else
+	  if ((i & 255) == 0)
+	    l2fib_scan_yield (vm, &last_start, &accum_t);
+
+	  if (keys[i] == last_key)
+	    continue;
+	  last_key = kv.key = keys[i];
+	  if (BV (clib_bihash_search) (&fm->mac_table, &kv, &kv))
+	    continue;		/* already deleted */
+
+	  key.raw = kv.key;
+	  result.raw = kv.value;
+	  if (l2fib_entry_result_is_set_AGE_NOT (&result))
+	    continue;		/* provisioned since learned */
+
+	  sn = l2fib_cur_seq_num (key.fields.bd_index,
+				  result.fields.sw_if_index).as_u16;
+	  if (result.fields.sn.as_u16 != sn)
+	    goto age_out;	/* stale mac */
+
+	  bd_config = vec_elt_at_index (l2input_main.bd_configs,
+					key.fields.bd_index);
+	  if (bd_config->mac_age == 0)
+	    continue;		/* aging disabled on the bridge domain */
+
+	  delta = now - result.fields.timestamp;
+	  delta += delta < 0 ? 256 : 0;
+	  if (delta < bd_config->mac_age)
 	    {
-	      if (reg)
-		clib_warning ("MAC event to pid %d queue stuffed!"
-			      " %d MAC entries lost", client, evt_idx);
-	      vl_msg_api_free (mp);
+	      /* refreshed, track in the bucket of its new expiry */
+	      l2fib_age_wheel_add (fm, &key, &result, bd_config->mac_age);
+	      continue;
 	    }
+
+	age_out:
+	  if (evt->client)
+	    l2fib_mac_evt_add (evt, &key, result.fields.sw_if_index,
+			       MAC_EVENT_ACTION_DELETE);
+	  BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
+	  if (l2learn_main.global_learn_count)
+	    l2learn_main.global_learn_count--;
+	  l2learn_count (vm->thread_index, key.fields.bd_index,
+			 result.fields.sw_if_index, -1);
+	}
+
+      /* reuse the bucket's vector unless it was refilled meanwhile */
+      if (fm->age_wheel[fm->age_wheel_minute] == 0)
+	{
+	  vec_reset_length (keys);
+	  fm->age_wheel[fm->age_wheel_minute] = keys;
 	}
       else
-	vl_msg_api_free (mp);
+	vec_free (keys);
     }
-  return delta_t + accum_t;
+
+  return vlib_time_now (vm) - last_start + accum_t;
 }
 
 static uword
@@ -1175,8 +1449,10 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
   uword event_type, *event_data = 0;
   l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
+  l2fib_mac_evt_ctx_t evt;
   bool enabled = 0;
   f64 start_time, next_age_scan_time = CLIB_TIME_MAX;
+  f64 drain_duration;
 
   while (1)
     {
@@ -1184,24 +1460,31 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	vlib_process_wait_for_event_or_clock (vm, fm->event_scan_delay);
       else if (enabled)
 	{
+	  /* keep up with workers' learn rings in between aging ticks */
 	  f64 t = next_age_scan_time - vlib_time_now (vm);
-	  vlib_process_wait_for_event_or_clock (vm, t);
+	  vlib_process_wait_for_event_or_clock
+	    (vm, clib_min (t, L2FIB_EVENT_SCAN_DELAY_DEFAULT));
 	}
       else
-	vlib_process_wait_for_event (vm);
+	/* still wake up to publish the learned mac counts */
+	vlib_process_wait_for_event_or_clock (vm,
+					      L2LEARN_EXPORT_INTERVAL);
 
       event_type = vlib_process_get_events (vm, &event_data);
       vec_reset_length (event_data);
 
       start_time = vlib_time_now (vm);
       enum
-      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_MAC_FULL,
+	SCAN_DISABLE } scan = SCAN_MAC_FULL;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
-	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
+	  if (start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  else
+	    scan = SCAN_MAC_AGE;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1220,23 +1503,40 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	  ASSERT (0);
 	}
 
-      if (scan == SCAN_MAC_EVENT)
-	l2fib_main.evt_scan_duration = l2fib_scan (vm, start_time, 1);
-      else
+      if (scan == SCAN_MAC_EVENT || scan == SCAN_MAC_AGE)
 	{
-	  if (scan == SCAN_MAC_AGE)
-	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
-	  if (scan == SCAN_DISABLE)
-	    {
-	      l2fib_main.age_scan_duration = 0;
-	      l2fib_main.evt_scan_duration = 0;
-	    }
-	  /* schedule next scan */
-	  if (enabled)
-	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL;
+	  /* learn records are processed incrementally unless some were
+	   * lost, then fall back to a full scan */
+	  l2fib_mac_evt_init (&evt);
+	  if (l2fib_learn_rings_drain (vm, &evt, enabled, &drain_duration))
+	    scan = SCAN_MAC_FULL;
+	  else if (scan == SCAN_MAC_AGE && enabled)
+	    l2fib_main.age_scan_duration = drain_duration +
+	      l2fib_age_wheel_expire (vm, start_time, &evt);
 	  else
-	    next_age_scan_time = CLIB_TIME_MAX;
+	    l2fib_main.evt_scan_duration = drain_duration;
+	  l2fib_mac_evt_flush (&evt);
 	}
+
+      if (scan == SCAN_MAC_FULL)
+	l2fib_main.age_scan_duration = l2fib_scan (vm, start_time);
+      l2learn_export_counters ();
+
+      if (scan == SCAN_MAC_EVENT)
+	continue;
+
+      if (scan == SCAN_DISABLE)
+	{
+	  l2fib_learn_rings_reset (fm);
+	  l2fib_age_wheel_reset (fm, start_time);
+	  l2fib_main.age_scan_duration = 0;
+	  l2fib_main.evt_scan_duration = 0;
+	}
+      /* schedule next scan */
+      if (enabled)
+	next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL;
+      else
+	next_age_scan_time = CLIB_TIME_MAX;
     }
   return 0;
 }
@@ -1254,6 +1554,7 @@ l2fib_init (vlib_main_t * vm)
 {
   l2fib_main_t *mp = &l2fib_main;
   l2fib_entry_key_t test_key;
+  l2fib_learn_ring_t *ring;
   u8 test_mac[6];
 
   mp->vlib_main = vm;
@@ -1263,6 +1564,13 @@ l2fib_init (vlib_main_t * vm)
   BV (clib_bihash_init) (&mp->mac_table, "l2fib mac table",
 			 L2FIB_NUM_BUCKETS, L2FIB_MEMORY_SIZE);
 
+  /* Rings of learned macs, one per thread */
+  vec_validate_aligned (mp->learn_rings,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ring, mp->learn_rings)
+    vec_validate (ring->keys, L2FIB_LEARN_RING_SIZE - 1);
+
   /* verify the key constructor is good, since it is endian-sensitive */
   clib_memset (test_mac, 0, sizeof (test_mac));
   test_mac[0] = 0x11;
@@ -39,12 +39,42 @@
 /* MAC event learn limit is 1000 unless specified by MAC event client */
 #define L2FIB_EVENT_LEARN_LIMIT_DEFAULT	(1000)
 
+/* Per thread ring of learned or moved MAC keys, must be a power of 2 */
+#define L2FIB_LEARN_RING_SIZE		(64 << 10)
+
+/* Number of aging time buckets, one per minute of the u8 entry timestamp */
+#define L2FIB_AGE_WHEEL_SIZE		(256)
+
+/*
+ * Ring of MAC keys learned or moved by a worker thread. Single producer,
+ * the l2-learn node, and single consumer, the mac age scanner process.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 tail;
+  /* set by the producer if keys were dropped because the ring was full */
+  volatile u8 overflow;
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 head;
+  u64 *keys;
+} l2fib_learn_ring_t;
+
 typedef struct
 {
 
   /* hash table */
   BVT (clib_bihash) mac_table;
 
+  /* per thread rings of learned or moved macs */
+  l2fib_learn_ring_t *learn_rings;
+
+  /* aging time buckets, vectors of keys indexed by expiry minute */
+  u64 *age_wheel[L2FIB_AGE_WHEEL_SIZE];
+
+  /* last minute whose time bucket was expired */
+  u8 age_wheel_minute;
+
   /* per swif vector of sequence number for interface based flush of MACs */
   u8 *swif_seq_num;
 
@@ -187,6 +217,23 @@ l2fib_entry_result_clear_bits (l2fib_entry_result_t * r,
   r->fields.flags &= ~bits;
 }
 
+/**
+ * Record a learned or moved mac for the mac age scanner process.
+ * Must be called after the mac table has been updated.
+ */
+always_inline void
+l2fib_learn_ring_add (l2fib_learn_ring_t * r, u64 key)
+{
+  if (PREDICT_FALSE (r->tail - r->head >= L2FIB_LEARN_RING_SIZE))
+    {
+      r->overflow = 1;
+      return;
+    }
+  r->keys[r->tail & (L2FIB_LEARN_RING_SIZE - 1)] = key;
+  CLIB_MEMORY_STORE_BARRIER ();
+  r->tail++;
+}
+
 /* L2 MAC event entry action enums (see mac_entry definition in l2.api) */
 typedef enum
 {
@@ -32,6 +32,7 @@
 #include <vnet/l2/l2_bvi.h>
 #include <vnet/l2/l2_fib.h>
 #include <vnet/l2/l2_bd.h>
+#include <vnet/l2/l2_learn.h>
 
 #include <vppinfra/error.h>
 #include <vppinfra/hash.h>
@@ -716,6 +717,7 @@ set_int_l2_mode (vlib_main_t * vm, vnet_main_t * vnet_main,	/*           */
 	  /* Set up bridge domain */
 	  bd_config = l2input_bd_config (bd_index);
 	  bd_validate (bd_config);
+	  l2learn_validate_counters (bd_index, sw_if_index);
 
 	  /* TODO: think: add l2fib entry even for non-bvi interface? */
 
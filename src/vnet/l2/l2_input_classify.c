@@ -126,12 +126,6 @@ static char *l2_input_classify_error_strings[] = {
  *	- Used to steer traffic when the classifier misses
  *
  * @em Sets:
- * - <code>vnet_buffer (b0)->l2_classify.table_index</code>
- * 	- Classifier table index of the first classifier table in
- *	the classifier table chain
- * - <code>vnet_buffer (b0)->l2_classify.hash</code>
- * 	- Bounded-index extensible hash corresponding to the
- *	masked fields in the current packet
  * - <code>vnet_buffer (b0)->l2.feature_bitmap</code>
  * 	- Used to steer packets across l2 features enabled on the interface
  * - <code>vnet_buffer (b0)->l2_classify.opaque_index</code>
@@ -148,17 +142,22 @@ VLIB_NODE_FN (l2_input_classify_node) (vlib_main_t * vm,
 				       vlib_node_runtime_t * node,
 				       vlib_frame_t * frame)
 {
-  u32 n_left_from, *from, *to_next;
-  l2_input_classify_next_t next_index;
+  u32 n_left_from, *from;
   l2_input_classify_main_t *cm = &l2_input_classify_main;
   vnet_classify_main_t *vcm = cm->vnet_classify_main;
   l2_input_classify_runtime_t *rt =
     (l2_input_classify_runtime_t *) node->runtime_data;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+  u8 *h[VNET_CLASSIFY_BATCH_SIZE];
+  u32 table_indices[VNET_CLASSIFY_BATCH_SIZE];
+  vnet_classify_entry_t *entries[VNET_CLASSIFY_BATCH_SIZE];
   u32 hits = 0;
   u32 misses = 0;
   u32 chain_hits = 0;
   f64 now;
   u32 n_next_nodes;
+  u32 i, n_batch;
 
   n_next_nodes = node->n_next_nodes;
 
@@ -166,201 +165,59 @@ VLIB_NODE_FN (l2_input_classify_node) (vlib_main_t * vm,
 
   n_left_from = frame->n_vectors;
   from = vlib_frame_vector_args (frame);
-
-  /* First pass: compute hash */
-
-  while (n_left_from >= 4)
-    {
-      vlib_buffer_t *b0, *b1;
-      u32 bi0, bi1;
-      ethernet_header_t *h0, *h1;
-      u32 sw_if_index0, sw_if_index1;
-      u16 type0, type1;
-      int type_index0, type_index1;
-      vnet_classify_table_t *t0, *t1;
-      u32 table_index0, table_index1;
-      u64 hash0, hash1;
-
-
-      /* prefetch next iteration */
-      {
-	vlib_buffer_t *p2, *p3;
-
-	p2 = vlib_get_buffer (vm, from[2]);
-	p3 = vlib_get_buffer (vm, from[3]);
-
-	vlib_prefetch_buffer_header (p2, STORE);
-	CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
-	vlib_prefetch_buffer_header (p3, STORE);
-	CLIB_PREFETCH (p3->data, CLIB_CACHE_LINE_BYTES, STORE);
-      }
-
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
-      h0 = vlib_buffer_get_current (b0);
-
-      bi1 = from[1];
-      b1 = vlib_get_buffer (vm, bi1);
-      h1 = vlib_buffer_get_current (b1);
-
-      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      vnet_buffer (b0)->l2_classify.table_index = ~0;
-
-      sw_if_index1 = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-      vnet_buffer (b1)->l2_classify.table_index = ~0;
-
-      /* Select classifier table based on ethertype */
-      type0 = clib_net_to_host_u16 (h0->type);
-      type1 = clib_net_to_host_u16 (h1->type);
-
-      type_index0 = (type0 == ETHERNET_TYPE_IP4)
-	? L2_INPUT_CLASSIFY_TABLE_IP4 : L2_INPUT_CLASSIFY_TABLE_OTHER;
-      type_index0 = (type0 == ETHERNET_TYPE_IP6)
-	? L2_INPUT_CLASSIFY_TABLE_IP6 : type_index0;
-
-      type_index1 = (type1 == ETHERNET_TYPE_IP4)
-	? L2_INPUT_CLASSIFY_TABLE_IP4 : L2_INPUT_CLASSIFY_TABLE_OTHER;
-      type_index1 = (type1 == ETHERNET_TYPE_IP6)
-	? L2_INPUT_CLASSIFY_TABLE_IP6 : type_index1;
-
-      vnet_buffer (b0)->l2_classify.table_index =
-	table_index0 =
-	rt->l2cm->classify_table_index_by_sw_if_index
-	[type_index0][sw_if_index0];
-
-      if (table_index0 != ~0)
-	{
-	  t0 = pool_elt_at_index (vcm->tables, table_index0);
-
-	  vnet_buffer (b0)->l2_classify.hash = hash0 =
-	    vnet_classify_hash_packet (t0, (u8 *) h0);
-	  vnet_classify_prefetch_bucket (t0, hash0);
-	}
-
-      vnet_buffer (b1)->l2_classify.table_index =
-	table_index1 =
-	rt->l2cm->classify_table_index_by_sw_if_index
-	[type_index1][sw_if_index1];
-
-      if (table_index1 != ~0)
-	{
-	  t1 = pool_elt_at_index (vcm->tables, table_index1);
-
-	  vnet_buffer (b1)->l2_classify.hash = hash1 =
-	    vnet_classify_hash_packet (t1, (u8 *) h1);
-	  vnet_classify_prefetch_bucket (t1, hash1);
-	}
-
-      from += 2;
-      n_left_from -= 2;
-    }
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  b = bufs;
+  next = nexts;
 
   while (n_left_from > 0)
     {
-      vlib_buffer_t *b0;
-      u32 bi0;
-      ethernet_header_t *h0;
-      u32 sw_if_index0;
-      u16 type0;
-      u32 type_index0;
-      vnet_classify_table_t *t0;
-      u32 table_index0;
-      u64 hash0;
-
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
-      h0 = vlib_buffer_get_current (b0);
-
-      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      vnet_buffer (b0)->l2_classify.table_index = ~0;
+      n_batch = clib_min (n_left_from, VNET_CLASSIFY_BATCH_SIZE);
 
       /* Select classifier table based on ethertype */
-      type0 = clib_net_to_host_u16 (h0->type);
+      for (i = 0; i < n_batch; i++)
+	{
+	  ethernet_header_t *h0;
+	  u32 sw_if_index0;
+	  u16 type0;
+	  int type_index0;
 
-      type_index0 = (type0 == ETHERNET_TYPE_IP4)
-	? L2_INPUT_CLASSIFY_TABLE_IP4 : L2_INPUT_CLASSIFY_TABLE_OTHER;
-      type_index0 = (type0 == ETHERNET_TYPE_IP6)
-	? L2_INPUT_CLASSIFY_TABLE_IP6 : type_index0;
+	  if (i + 2 < n_left_from)
+	    {
+	      vlib_prefetch_buffer_header (b[i + 2], STORE);
+	      CLIB_PREFETCH (b[i + 2]->data, CLIB_CACHE_LINE_BYTES, STORE);
+	    }
 
-      vnet_buffer (b0)->l2_classify.table_index =
-	table_index0 = rt->l2cm->classify_table_index_by_sw_if_index
-	[type_index0][sw_if_index0];
+	  h0 = vlib_buffer_get_current (b[i]);
+	  h[i] = (u8 *) h0;
+	  sw_if_index0 = vnet_buffer (b[i])->sw_if_index[VLIB_RX];
+	  type0 = clib_net_to_host_u16 (h0->type);
 
-      if (table_index0 != ~0)
-	{
-	  t0 = pool_elt_at_index (vcm->tables, table_index0);
+	  type_index0 = (type0 == ETHERNET_TYPE_IP4)
+	    ? L2_INPUT_CLASSIFY_TABLE_IP4 : L2_INPUT_CLASSIFY_TABLE_OTHER;
+	  type_index0 = (type0 == ETHERNET_TYPE_IP6)
+	    ? L2_INPUT_CLASSIFY_TABLE_IP6 : type_index0;
 
-	  vnet_buffer (b0)->l2_classify.hash = hash0 =
-	    vnet_classify_hash_packet (t0, (u8 *) h0);
-	  vnet_classify_prefetch_bucket (t0, hash0);
+	  table_indices[i] =
+	    rt->l2cm->classify_table_index_by_sw_if_index
+	    [type_index0][sw_if_index0];
 	}
-      from++;
-      n_left_from--;
-    }
 
-  next_index = node->cached_next_index;
-  from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
+      /* Walk the classify chains of the whole batch together */
+      chain_hits += vnet_classify_find_entry_batch (vcm, h, table_indices,
+						    entries, n_batch, now);
 
-  while (n_left_from > 0)
-    {
-      u32 n_left_to_next;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      /* Not enough load/store slots to dual loop... */
-      while (n_left_from > 0 && n_left_to_next > 0)
+      for (i = 0; i < n_batch; i++)
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
+	  vlib_buffer_t *b0 = b[i];
+	  vnet_classify_entry_t *e0 = entries[i];
+	  vnet_classify_table_t *t0 = 0;
 	  u32 next0 = ~0;	/* next l2 input feature, please... */
-	  ethernet_header_t *h0;
-	  u32 table_index0;
-	  u64 hash0;
-	  vnet_classify_table_t *t0;
-	  vnet_classify_entry_t *e0;
 
-	  if (PREDICT_TRUE (n_left_from > 2))
-	    {
-	      vlib_buffer_t *p2 = vlib_get_buffer (vm, from[2]);
-	      u64 phash2;
-	      u32 table_index2;
-	      vnet_classify_table_t *tp2;
-
-	      /*
-	       * Prefetch table entry two ahead. Buffer / data
-	       * were prefetched above...
-	       */
-	      table_index2 = vnet_buffer (p2)->l2_classify.table_index;
-
-	      if (PREDICT_TRUE (table_index2 != ~0))
-		{
-		  tp2 = pool_elt_at_index (vcm->tables, table_index2);
-		  phash2 = vnet_buffer (p2)->l2_classify.hash;
-		  vnet_classify_prefetch_entry (tp2, phash2);
-		}
-	    }
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  h0 = vlib_buffer_get_current (b0);
-	  table_index0 = vnet_buffer (b0)->l2_classify.table_index;
-	  e0 = 0;
 	  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
 
-	  if (PREDICT_TRUE (table_index0 != ~0))
+	  if (PREDICT_TRUE (table_indices[i] != ~0))
 	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
-	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	      t0 = pool_elt_at_index (vcm->tables, table_indices[i]);
 	      if (e0)
 		{
 		  vnet_buffer (b0)->l2_classify.opaque_index
@@ -372,34 +229,9 @@ VLIB_NODE_FN (l2_input_classify_node) (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
-		    {
-		      if (t0->next_table_index != ~0)
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
+		  next0 = (t0->miss_next_index < n_next_nodes) ?
+		    t0->miss_next_index : next0;
+		  misses++;
 		}
 	    }
 
@@ -420,20 +252,21 @@ VLIB_NODE_FN (l2_input_classify_node) (vlib_main_t * vm,
 	      l2_input_classify_trace_t *t =
 		vlib_add_trace (vm, node, b0, sizeof (*t));
 	      t->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	      t->table_index = table_index0;
+	      t->table_index = table_indices[i];
 	      t->next_index = next0;
 	      t->session_offset = e0 ? vnet_classify_get_offset (t0, e0) : 0;
 	    }
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+	  next[i] = next0;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      b += n_batch;
+      next += n_batch;
+      n_left_from -= n_batch;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   vlib_node_increment_counter (vm, node->node_index,
 			       L2_INPUT_CLASSIFY_ERROR_MISS, misses);
   vlib_node_increment_counter (vm, node->node_index,
@@ -82,6 +82,7 @@ _(MISS,              "L2 learn misses")			\
 _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
+_(BD_INTF_LIMIT,     "L2 not learned due to bd or interface limit") \
 _(HIT_UPDATE,        "L2 learn hit updates")		\
 _(FILTER_DROP,       "L2 filter mac drops")
 
@@ -118,8 +119,12 @@ l2learn_process (vlib_node_runtime_t * node,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
 		 u32 * count,
-		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp)
+		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp,
+		 l2fib_learn_ring_t * ring, u32 thread_index)
 {
+  u32 bd_index0 = vnet_buffer (b0)->l2.bd_index;
+  int is_learn_or_move = 1;
+
   /* Set up the default next node (typically L2FWD) */
   *next0 = vnet_l2_feature_next (b0, msm->feat_next_node_index,
 				 L2INPUT_FEAT_LEARN);
@@ -147,6 +152,7 @@ l2learn_process (vlib_node_runtime_t * node,
 
       counter_base[L2LEARN_ERROR_HIT_UPDATE] += 1;
       *count += 1;
+      is_learn_or_move = 0;
     }
   else if (result0->raw == ~0)
     {
@@ -169,8 +175,17 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
+      if (PREDICT_FALSE (l2learn_bd_or_sw_if_limit_reached (bd_index0,
+							     sw_if_index0)))
+	{
+	  /* Bridge domain or interface limit reached */
+	  counter_base[L2LEARN_ERROR_BD_INTF_LIMIT] += 1;
+	  return;
+	}
+
       /* It is ok to learn */
       msm->global_learn_count++;
+      l2learn_count (thread_index, bd_index0, sw_if_index0, 1);
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       if (msm->client_pid != 0)
@@ -203,15 +218,34 @@ l2learn_process (vlib_node_runtime_t * node,
 
       /*
        * TODO: may want to rate limit mac moves
-       * TODO: check global/bridge domain/interface learn limits
        */
-      result0->fields.sw_if_index = sw_if_index0;
       if (l2fib_entry_result_is_set_AGE_NOT (result0))
 	{
 	  /* The mac was provisioned */
+	  if (PREDICT_FALSE (l2learn_bd_or_sw_if_limit_reached (bd_index0,
+								 sw_if_index0)))
+	    {
+	      counter_base[L2LEARN_ERROR_BD_INTF_LIMIT] += 1;
+	      return;
+	    }
 	  msm->global_learn_count++;
+	  l2learn_count (thread_index, bd_index0, sw_if_index0, 1);
 	  l2fib_entry_result_clear_AGE_NOT (result0);
 	}
+      else
+	{
+	  /* Only the interface changes, so does its learned mac count */
+	  if (PREDICT_FALSE (l2learn_limit_reached
+			     (&msm->sw_if_learn_counters,
+			      msm->sw_if_learn_limits, sw_if_index0)))
+	    {
+	      counter_base[L2LEARN_ERROR_BD_INTF_LIMIT] += 1;
+	      return;
+	    }
+	  l2learn_count (thread_index, ~0, result0->fields.sw_if_index, -1);
+	  l2learn_count (thread_index, ~0, sw_if_index0, 1);
+	}
+      result0->fields.sw_if_index = sw_if_index0;
       if (msm->client_pid != 0)
 	l2fib_entry_result_set_bits (result0,
 				     (L2FIB_ENTRY_RESULT_FLAG_LRN_EVT |
@@ -232,6 +266,10 @@ l2learn_process (vlib_node_runtime_t * node,
   kv.value = result0->raw;
   BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
 
+  /* Let the mac age scanner track the entry and report the event */
+  if (is_learn_or_move)
+    l2fib_learn_ring_add (ring, kv.key);
+
   /* Invalidate the cache */
   cached_key->raw = ~0;
 }
@@ -249,6 +287,9 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   l2fib_entry_key_t cached_key;
   l2fib_entry_result_t cached_result;
   u8 timestamp = (u8) (vlib_time_now (vm) / 60);
+  u32 thread_index = vm->thread_index;
+  l2fib_learn_ring_t *ring = vec_elt_at_index (l2fib_main.learn_rings,
+					       thread_index);
   u32 count = 0;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
   u16 nexts[VLIB_FRAME_SIZE], *next;
@@ -356,19 +397,23 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &count, &result0, next, timestamp, ring,
+		       thread_index);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[1], sw_if_index1, &key1, &cached_key,
-		       &count, &result1, next + 1, timestamp);
+		       &count, &result1, next + 1, timestamp, ring,
+		       thread_index);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[2], sw_if_index2, &key2, &cached_key,
-		       &count, &result2, next + 2, timestamp);
+		       &count, &result2, next + 2, timestamp, ring,
+		       thread_index);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[3], sw_if_index3, &key3, &cached_key,
-		       &count, &result3, next + 3, timestamp);
+		       &count, &result3, next + 3, timestamp, ring,
+		       thread_index);
 
       next += 4;
       b += 4;
@@ -406,7 +451,8 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &count, &result0, next, timestamp, ring,
+		       thread_index);
 
       next += 1;
       b += 1;
@@ -471,11 +517,204 @@ l2learn_init (vlib_main_t * vm)
    */
   mp->global_learn_limit = L2LEARN_DEFAULT_LIMIT;
 
+  mp->bd_learn_counters.count.name = "l2 learned macs per bridge domain";
+  mp->bd_learn_counters.count.stat_segment_name = "/l2/learn/bd";
+  mp->sw_if_learn_counters.count.name = "l2 learned macs per interface";
+  mp->sw_if_learn_counters.count.stat_segment_name = "/l2/learn/interface";
+  l2learn_validate_counters (0, 0);
+
   return 0;
 }
 
 VLIB_INIT_FUNCTION (l2learn_init);
 
+static void
+l2learn_counters_validate (l2learn_counters_t * lc, u32 index)
+{
+  vlib_validate_simple_counter (&lc->learned, index);
+  vlib_validate_simple_counter (&lc->unlearned, index);
+  vlib_validate_simple_counter (&lc->count, index);
+}
+
+/**
+ * Make sure the learned mac counters of a bridge domain and an interface
+ * exist, so the data plane can account for them. Main thread only.
+ */
+void
+l2learn_validate_counters (u32 bd_index, u32 sw_if_index)
+{
+  l2learn_main_t *mp = &l2learn_main;
+
+  if (bd_index != ~0)
+    l2learn_counters_validate (&mp->bd_learn_counters, bd_index);
+  if (sw_if_index != ~0)
+    l2learn_counters_validate (&mp->sw_if_learn_counters, sw_if_index);
+}
+
+/*
+ * Make learned minus unlearned equal count, knowing the sums of the per
+ * thread counters. The learn and unlearn counts only grow, so the
+ * difference is added to one of this thread's counters.
+ */
+static void
+l2learn_counters_correct (l2learn_counters_t * lc, u32 index, u64 count,
+			  u64 learned, u64 unlearned)
+{
+  u32 thread_index = vlib_get_thread_index ();
+
+  if (learned < unlearned + count)
+    vlib_increment_simple_counter (&lc->learned, thread_index, index,
+				   unlearned + count - learned);
+  else if (learned > unlearned + count)
+    vlib_increment_simple_counter (&lc->unlearned, thread_index, index,
+				   learned - unlearned - count);
+}
+
+static void
+l2learn_counters_zero (l2learn_counters_t * lc)
+{
+  u32 i, n = vlib_simple_counter_n_counters (&lc->learned);
+
+  for (i = 0; i < n; i++)
+    l2learn_counters_correct (lc, i, 0,
+			      vlib_get_simple_counter (&lc->learned, i),
+			      vlib_get_simple_counter (&lc->unlearned, i));
+}
+
+/**
+ * Reset all learned mac counts, e.g. when the l2fib is flushed.
+ * Workers must be stopped.
+ */
+void
+l2learn_zero_counters (void)
+{
+  l2learn_main_t *mp = &l2learn_main;
+
+  l2learn_counters_zero (&mp->bd_learn_counters);
+  l2learn_counters_zero (&mp->sw_if_learn_counters);
+  l2learn_export_counters ();
+}
+
+static void
+l2learn_counters_export (l2learn_counters_t * lc)
+{
+  u32 i, n = vlib_simple_counter_n_counters (&lc->count);
+
+  for (i = 0; i < n; i++)
+    vlib_set_simple_counter (&lc->count, 0, i, l2learn_get_count (lc, i));
+}
+
+/**
+ * Publish the learned mac counts to the stats segment. The exported
+ * counters are gauges, only written by the main thread, in its own
+ * counters. Main thread only.
+ */
+void
+l2learn_export_counters (void)
+{
+  l2learn_main_t *mp = &l2learn_main;
+
+  l2learn_counters_export (&mp->bd_learn_counters);
+  l2learn_counters_export (&mp->sw_if_learn_counters);
+}
+
+/**
+ * Start resynchronizing learned mac counters with the mac table, before
+ * walking it. Workers keep learning, so remember how many learns and
+ * unlearns each counter has seen.
+ */
+void
+l2learn_resync_start (l2learn_resync_t * rs, l2learn_counters_t * lc)
+{
+  u32 i, n = vlib_simple_counter_n_counters (&lc->learned);
+
+  clib_memset (rs, 0, sizeof (*rs));
+  vec_resize (rs->activity, n);
+  for (i = 0; i < n; i++)
+    rs->activity[i] = (vlib_get_simple_counter (&lc->learned, i) +
+		       vlib_get_simple_counter (&lc->unlearned, i));
+}
+
+/**
+ * Finish resynchronizing learned mac counters with the macs counted while
+ * walking the mac table. A counter is only set to the table count if no
+ * mac was learned or unlearned in the meantime, but the macs aged out by
+ * the walk itself, otherwise the table count may be outdated and the
+ * counter is left alone until the next walk. Main thread only.
+ */
+void
+l2learn_resync_end (l2learn_resync_t * rs, l2learn_counters_t * lc)
+{
+  u32 i;
+
+  for (i = 0; i < vec_len (rs->activity); i++)
+    {
+      u64 learned = vlib_get_simple_counter (&lc->learned, i);
+      u64 unlearned = vlib_get_simple_counter (&lc->unlearned, i);
+      u64 aged = i < vec_len (rs->aged) ? rs->aged[i] : 0;
+      u64 count = i < vec_len (rs->counts) ? rs->counts[i] : 0;
+
+      if (learned + unlearned == rs->activity[i] + aged)
+	l2learn_counters_correct (lc, i, count, learned, unlearned);
+    }
+
+  vec_free (rs->activity);
+  vec_free (rs->counts);
+  vec_free (rs->aged);
+}
+
+/**
+ * Account for a mac found, or aged out if n is negative, while walking
+ * the mac table. Aged out macs are unlearned by the caller.
+ */
+void
+l2learn_resync_count (l2learn_resync_t * rs, u32 index, i32 n)
+{
+  vec_validate (rs->counts, index);
+  rs->counts[index] += n;
+  if (n < 0)
+    {
+      vec_validate (rs->aged, index);
+      rs->aged[index] -= n;
+    }
+}
+
+/**
+ * Set the maximum number of macs learned in a bridge domain, 0 for no limit
+ */
+int
+l2learn_set_bd_learn_limit (u32 bd_index, u32 limit)
+{
+  l2learn_main_t *mp = &l2learn_main;
+
+  if (bd_index == ~0)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  vec_validate (mp->bd_learn_limits, bd_index);
+  mp->bd_learn_limits[bd_index] = limit;
+  l2learn_validate_counters (bd_index, ~0);
+
+  return 0;
+}
+
+/**
+ * Set the maximum number of macs learned on an interface, 0 for no limit
+ */
+int
+l2learn_set_sw_if_learn_limit (u32 sw_if_index, u32 limit)
+{
+  l2learn_main_t *mp = &l2learn_main;
+
+  if (!vnet_sw_interface_is_api_valid (mp->vnet_main, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  vec_validate (mp->sw_if_learn_limits, sw_if_index);
+  mp->sw_if_learn_limits[sw_if_index] = limit;
+  l2learn_validate_counters (~0, sw_if_index);
+
+  return 0;
+}
+
 
 /**
  * Set subinterface learn enable/disable.
@@ -531,6 +770,50 @@ VLIB_CLI_COMMAND (int_learn_cli, static) = {
 /* *INDENT-ON* */
 
 
+/**
+ * Set subinterface learn limit.
+ * The CLI format is:
+ *    set interface l2 learn-limit <interface> <limit>
+ */
+static clib_error_t *
+int_learn_limit (vlib_main_t * vm,
+		 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index, limit;
+
+  if (!unformat_user (input, unformat_vnet_sw_interface, vnm, &sw_if_index))
+    return clib_error_return (0, "unknown interface `%U'",
+			      format_unformat_error, input);
+
+  if (!unformat (input, "%u", &limit))
+    return clib_error_return (0, "expecting limit but got `%U'",
+			      format_unformat_error, input);
+
+  if (l2learn_set_sw_if_learn_limit (sw_if_index, limit))
+    return clib_error_return (0, "invalid interface");
+
+  return 0;
+}
+
+/*?
+ * Limit the number of macs dynamically learned on an interface. Once the
+ * limit is reached new source macs seen on the interface are not learned
+ * until some of the learned macs age out or are flushed. A limit of 0
+ * removes the limit.
+ *
+ * @cliexpar
+ * Example of how to learn at most 100 macs on an interface:
+ * @cliexcmd{set interface l2 learn-limit GigabitEthernet0/8/0 100}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (int_learn_limit_cli, static) = {
+  .path = "set interface l2 learn-limit",
+  .short_help = "set interface l2 learn-limit <interface> <limit>",
+  .function = int_learn_limit,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 l2learn_config (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -21,6 +21,34 @@
 #include <vlib/vlib.h>
 #include <vnet/ethernet/ethernet.h>
 
+/**
+ * Number of macs dynamically learned per bridge domain or per interface.
+ * A mac may be unlearned on another thread than the one which learned it,
+ * so each thread counts learns and unlearns apart, the counts only grow
+ * and the number of macs is their difference summed over threads.
+ */
+typedef struct
+{
+  vlib_simple_counter_main_t learned;
+  vlib_simple_counter_main_t unlearned;
+
+  /* the difference, set by the main thread in its own counters only and
+   * exported to the stats segment */
+  vlib_simple_counter_main_t count;
+} l2learn_counters_t;
+
+/**
+ * Counts taken while walking the mac table to resynchronize the learned
+ * mac counters with it, see l2learn_resync_end
+ */
+typedef struct
+{
+  /* learns plus unlearns per counter when the walk started */
+  u64 *activity;
+  /* macs found in the mac table, and aged out by the walk */
+  u64 *counts;
+  u64 *aged;
+} l2learn_resync_t;
 
 typedef struct
 {
@@ -38,6 +66,16 @@ typedef struct
   u32 client_pid;
   u32 client_index;
 
+  /* maximum number of dynamically learned macs per bridge domain and
+   * per interface, indexed by bd_index and sw_if_index, 0 for no limit */
+  u32 *bd_learn_limits;
+  u32 *sw_if_learn_limits;
+
+  /* number of dynamically learned macs per bridge domain and per
+   * interface */
+  l2learn_counters_t bd_learn_counters;
+  l2learn_counters_t sw_if_learn_counters;
+
   /* Next nodes for each feature */
   u32 feat_next_node_index[32];
 
@@ -48,10 +86,85 @@ typedef struct
 
 #define L2LEARN_DEFAULT_LIMIT (L2FIB_NUM_BUCKETS * 64)
 
+/* seconds between updates of the learned mac counts in the stats segment */
+#define L2LEARN_EXPORT_INTERVAL (1.0)
+
 extern l2learn_main_t l2learn_main;
 
 extern vlib_node_registration_t l2fib_mac_age_scanner_process_node;
 
+void l2learn_validate_counters (u32 bd_index, u32 sw_if_index);
+void l2learn_zero_counters (void);
+void l2learn_export_counters (void);
+void l2learn_resync_start (l2learn_resync_t * rs, l2learn_counters_t * lc);
+void l2learn_resync_count (l2learn_resync_t * rs, u32 index, i32 n);
+void l2learn_resync_end (l2learn_resync_t * rs, l2learn_counters_t * lc);
+int l2learn_set_bd_learn_limit (u32 bd_index, u32 limit);
+int l2learn_set_sw_if_learn_limit (u32 sw_if_index, u32 limit);
+
+always_inline void
+l2learn_counters_add (l2learn_counters_t * lc, u32 thread_index, u32 index,
+		      i32 n)
+{
+  if (PREDICT_FALSE (index >= vec_len (lc->learned.counters[thread_index])))
+    return;
+  if (n > 0)
+    vlib_increment_simple_counter (&lc->learned, thread_index, index, n);
+  else
+    vlib_increment_simple_counter (&lc->unlearned, thread_index, index, -n);
+}
+
+/**
+ * Account for n macs learned, or unlearned if n is negative, in a bridge
+ * domain on an interface
+ */
+always_inline void
+l2learn_count (u32 thread_index, u32 bd_index, u32 sw_if_index, i32 n)
+{
+  l2learn_main_t *lm = &l2learn_main;
+
+  l2learn_counters_add (&lm->bd_learn_counters, thread_index, bd_index, n);
+  l2learn_counters_add (&lm->sw_if_learn_counters, thread_index,
+			sw_if_index, n);
+}
+
+/**
+ * Number of macs learned in a bridge domain or on an interface. The
+ * difference is clamped in case it is read while a learn and the matching
+ * unlearn race on different threads.
+ */
+always_inline u64
+l2learn_get_count (l2learn_counters_t * lc, u32 index)
+{
+  u64 unlearned = vlib_get_simple_counter (&lc->unlearned, index);
+  u64 learned = vlib_get_simple_counter (&lc->learned, index);
+
+  return learned > unlearned ? learned - unlearned : 0;
+}
+
+always_inline int
+l2learn_limit_reached (l2learn_counters_t * lc, u32 * limits, u32 index)
+{
+  if (PREDICT_TRUE (index >= vec_len (limits) || limits[index] == 0))
+    return 0;
+  return l2learn_get_count (lc, index) >= limits[index];
+}
+
+/**
+ * Check if learning one more mac in a bridge domain on an interface
+ * would exceed their learn limits
+ */
+always_inline int
+l2learn_bd_or_sw_if_limit_reached (u32 bd_index, u32 sw_if_index)
+{
+  l2learn_main_t *lm = &l2learn_main;
+
+  return (l2learn_limit_reached (&lm->bd_learn_counters,
+				 lm->bd_learn_limits, bd_index) ||
+	  l2learn_limit_reached (&lm->sw_if_learn_counters,
+				 lm->sw_if_learn_limits, sw_if_index));
+}
+
 typedef enum
 {
   L2_MAC_AGE_PROCESS_EVENT_START = 1,
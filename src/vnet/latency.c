@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/latency.h>
+
+vnet_latency_main_t vnet_latency_main;
+
+static void
+vnet_latency_validate (vnet_main_t * vnm)
+{
+  vnet_latency_main_t *lm = &vnet_latency_main;
+
+  vlib_validate_simple_counter (&lm->histogram,
+				pool_len (vnm->interface_main.sw_interfaces) *
+				VNET_LATENCY_HISTOGRAM_N_BUCKETS - 1);
+}
+
+void
+vnet_latency_enable_disable (int enable)
+{
+  vnet_latency_main_t *lm = &vnet_latency_main;
+
+  if (enable)
+    {
+      vnet_latency_validate (vnet_get_main ());
+      vlib_clear_simple_counters (&lm->histogram);
+    }
+  lm->enable = enable;
+}
+
+static clib_error_t *
+vnet_latency_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index,
+				   u32 is_add)
+{
+  if (is_add && vnet_latency_main.enable)
+    vnet_latency_validate (vnm);
+  return 0;
+}
+
+VNET_SW_INTERFACE_ADD_DEL_FUNCTION (vnet_latency_sw_interface_add_del);
+
+static clib_error_t *
+set_packet_latency_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  int enable;
+
+  if (unformat (input, "on"))
+    enable = 1;
+  else if (unformat (input, "off"))
+    enable = 0;
+  else
+    return clib_error_return (0, "expected on or off, got `%U'",
+			      format_unformat_error, input);
+
+  vnet_latency_enable_disable (enable);
+  return 0;
+}
+
+/*?
+ * Start or stop measuring the time packets spend in vpp. Device input
+ * nodes stamp the packets they receive and interface-output counts the
+ * time since the stamp, per output interface, in a log2 histogram.
+ * Starting the measurement clears the histograms. They are exported in
+ * the stats segment as /if/tx-latency, where the buckets of sw_if_index
+ * n are counters [32 * n, 32 * n + 31]. Bucket 0 counts times below 2
+ * clocks, bucket b times in [2^b, 2^(b+1)) clocks.
+ *
+ * @cliexpar
+ * @cliexcmd{set packet latency on}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_packet_latency_command, static) = {
+  .path = "set packet latency",
+  .short_help = "set packet latency on|off",
+  .function = set_packet_latency_command_fn,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_latency_bucket (u8 * s, va_list * args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  u32 bucket = va_arg (*args, u32);
+  f64 usec_per_clock = 1e6 / vm->clib_time.clocks_per_second;
+
+  if (bucket == VNET_LATENCY_HISTOGRAM_N_BUCKETS - 1)
+    return format (s, ">= %.3f", (f64) (1ULL << bucket) * usec_per_clock);
+  return format (s, "[%.3f, %.3f)",
+		 bucket ? (f64) (1ULL << bucket) * usec_per_clock : 0.0,
+		 (f64) (1ULL << (bucket + 1)) * usec_per_clock);
+}
+
+static clib_error_t *
+show_packet_latency_command_fn (vlib_main_t * vm, unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  vnet_latency_main_t *lm = &vnet_latency_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 i, j, index, sw_if_index = ~0;
+  counter_t *counts, total;
+  u8 *s = 0;
+
+  if (!unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		 &sw_if_index))
+    return clib_error_return (0, "interface expected, got `%U'",
+			      format_unformat_error, input);
+
+  if (!lm->enable)
+    vlib_cli_output (vm, "Packet latency is not being measured");
+
+  index = sw_if_index * VNET_LATENCY_HISTOGRAM_N_BUCKETS;
+  if (vec_len (lm->histogram.counters) == 0 ||
+      index >= vec_len (lm->histogram.counters[0]))
+    return 0;
+
+  vlib_cli_output (vm, "Latency to %U", format_vnet_sw_if_index_name, vnm,
+		   sw_if_index);
+  s = format (s, "%=28s", "usec");
+  for (j = 0; j < vec_len (lm->histogram.counters); j++)
+    s = format (s, "%=12s", vlib_worker_threads[j].name);
+  vlib_cli_output (vm, "%v", s);
+
+  for (i = 0; i < VNET_LATENCY_HISTOGRAM_N_BUCKETS; i++)
+    {
+      vec_reset_length (s);
+      s = format (s, "%=28U", format_latency_bucket, vm, i);
+      total = 0;
+      for (j = 0; j < vec_len (lm->histogram.counters); j++)
+	{
+	  counts = lm->histogram.counters[j];
+	  total += counts[index + i];
+	  s = format (s, "%=12lld", counts[index + i]);
+	}
+      if (total)
+	vlib_cli_output (vm, "%v", s);
+    }
+
+  vec_free (s);
+  return 0;
+}
+
+/*?
+ * Display the per thread histogram of the time packets sent to the
+ * interface spent in vpp, from their input node to interface-output.
+ * The thread is the one which sent the packet.
+ *
+ * @cliexpar
+ * @cliexstart{show packet latency GigabitEthernet0/8/0}
+ * Latency to GigabitEthernet0/8/0
+ *             usec               vpp_main   vpp_wk_0    vpp_wk_1
+ *        [2.048, 4.096)              0        31877       30125
+ *        [4.096, 8.192)              0         1093        1422
+ *       [8.192, 16.384)              0           17          12
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_packet_latency_command, static) = {
+  .path = "show packet latency",
+  .short_help = "show packet latency <interface>",
+  .function = show_packet_latency_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+vnet_latency_init (vlib_main_t * vm)
+{
+  vnet_latency_main_t *lm = &vnet_latency_main;
+
+  lm->histogram.name = "tx latency";
+  lm->histogram.stat_segment_name = "/if/tx-latency";
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vnet_latency_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
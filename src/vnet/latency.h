@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_vnet_latency_h__
+#define __included_vnet_latency_h__
+
+#include <vnet/vnet.h>
+
+/*
+ * Packet latency measurement.
+ *
+ * When enabled, device input nodes stamp the packets they receive with
+ * the time their dispatch started, and interface-output counts the time
+ * since the stamp in a log2 (clocks) histogram of the output interface.
+ * The stamp is kept in the head buffer, so the time spent in handoff
+ * queues is included, which assumes the time stamp counters of the
+ * cores are in sync. Packets built anew on the way, e.g. fragments,
+ * are not stamped. When disabled, the cost is one test per frame.
+ */
+
+#define VNET_LATENCY_HISTOGRAM_N_BUCKETS 32
+
+typedef struct
+{
+  /* Stamping and recording are on */
+  int enable;
+
+  /* Per thread, VNET_LATENCY_HISTOGRAM_N_BUCKETS buckets per
+     output sw_if_index */
+  vlib_simple_counter_main_t histogram;
+} vnet_latency_main_t;
+
+extern vnet_latency_main_t vnet_latency_main;
+
+/* Called with the worker barrier held */
+void vnet_latency_enable_disable (int enable);
+
+static_always_inline void
+vnet_latency_stamp (vlib_main_t * vm, u32 * buffers, u32 n_buffers)
+{
+  vlib_buffer_t *b;
+
+  if (PREDICT_TRUE (vnet_latency_main.enable == 0))
+    return;
+
+  while (n_buffers > 0)
+    {
+      b = vlib_get_buffer (vm, buffers[0]);
+      b->flags |= VNET_BUFFER_F_LATENCY_STAMPED;
+      vnet_buffer2 (b)->latency_timestamp = vm->cpu_time_last_node_dispatch;
+      buffers++;
+      n_buffers--;
+    }
+}
+
+static_always_inline void
+vnet_latency_record (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
+		     u32 sw_if_index)
+{
+  vnet_latency_main_t *lm = &vnet_latency_main;
+  vlib_buffer_t *b;
+  u64 now, t;
+  u32 bucket;
+
+  if (PREDICT_TRUE (lm->enable == 0))
+    return;
+
+  now = clib_cpu_time_now ();
+  while (n_buffers > 0)
+    {
+      b = vlib_get_buffer (vm, buffers[0]);
+      buffers++;
+      n_buffers--;
+
+      if (!(b->flags & VNET_BUFFER_F_LATENCY_STAMPED))
+	continue;
+
+      /* Stamped on a core slightly ahead */
+      t = vnet_buffer2 (b)->latency_timestamp;
+      t = now > t ? now - t : 0;
+
+      bucket = clib_min (min_log2 (t | 1),
+			 VNET_LATENCY_HISTOGRAM_N_BUCKETS - 1);
+      vlib_increment_simple_counter (&lm->histogram, vm->thread_index,
+				     sw_if_index *
+				     VNET_LATENCY_HISTOGRAM_N_BUCKETS +
+				     bucket, 1);
+    }
+}
+
+#endif /* __included_vnet_latency_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
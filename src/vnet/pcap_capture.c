@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <vnet/pcap_capture.h>
+
+/* how often the writer drains the capture rings, in seconds */
+#define VNET_PCAP_WRITER_INTERVAL 1e-3
+
+vlib_node_registration_t vnet_pcap_writer_node;
+
+static void
+vnet_pcap_set_enable (int rx_tx, int enable)
+{
+  int i;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    vlib_mains[i]->pcap[rx_tx].pcap_enable = enable;
+}
+
+/* keep the last pcap_n_files files: name, name.1, ... */
+static void
+vnet_pcap_rotate (vnet_pcap_t * pp)
+{
+  char *name = pp->pcap_main.file_name;
+  u8 *from, *to;
+  int i;
+
+  for (i = pp->pcap_n_files - 1; i > 0; i--)
+    {
+      if (i > 1)
+	from = format (0, "%s.%d%c", name, i - 1, 0);
+      else
+	from = format (0, "%s%c", name, 0);
+      to = format (0, "%s.%d%c", name, i, 0);
+      /* older files may not exist yet */
+      (void) rename ((char *) from, (char *) to);
+      vec_free (from);
+      vec_free (to);
+    }
+}
+
+/*
+ * Write out what the threads captured. Returns 0 once the capture is
+ * over: the file is full and is not rotated, or could not be written.
+ */
+static int
+vnet_pcap_drain (vlib_main_t * vm, int rx_tx)
+{
+  vnet_pcap_t *pp = &vm->pcap[rx_tx];
+  pcap_main_t *pm = &pp->pcap_main;
+  clib_error_t *error;
+  pcap_ring_t *r;
+  int i;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      r = &vlib_mains[i]->pcap[rx_tx].pcap_ring;
+      if (r->data == 0)
+	continue;
+
+      while (r->tail != clib_atomic_load_acq_n (&r->head))
+	{
+	  error = pcap_ring_write (pm, r);
+	  if (error)
+	    {
+	      clib_error_report (error);
+	      return 0;
+	    }
+
+	  /* pcap_ring_write closes the file once it is full */
+	  if (pm->flags & PCAP_MAIN_INIT_DONE)
+	    break;
+	  if (pp->pcap_n_files <= 1)
+	    return 0;
+	  vnet_pcap_rotate (pp);
+	}
+    }
+  return 1;
+}
+
+static void
+vnet_pcap_stop (vlib_main_t * vm, int rx_tx)
+{
+  vnet_pcap_t *pp = &vm->pcap[rx_tx];
+  int i;
+
+  vnet_pcap_set_enable (rx_tx, 0);
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    if (vlib_mains[i]->pcap[rx_tx].pcap_ring.data)
+      pcap_ring_discard (&vlib_mains[i]->pcap[rx_tx].pcap_ring);
+  if (pp->pcap_main.flags & PCAP_MAIN_INIT_DONE)
+    pcap_close (&pp->pcap_main);
+}
+
+static uword
+vnet_pcap_writer_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			  vlib_frame_t * f)
+{
+  uword *event_data = 0;
+  int rx_tx, active;
+
+  while (1)
+    {
+      active = (vm->pcap[VLIB_RX].pcap_enable ||
+		vm->pcap[VLIB_TX].pcap_enable);
+      if (active)
+	vlib_process_wait_for_event_or_clock (vm,
+					      VNET_PCAP_WRITER_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      /* the only event is a capture starting */
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      for (rx_tx = 0; rx_tx < VLIB_N_RX_TX; rx_tx++)
+	{
+	  if (!vm->pcap[rx_tx].pcap_enable || vnet_pcap_drain (vm, rx_tx))
+	    continue;
+
+	  vlib_worker_thread_barrier_sync (vm);
+	  vnet_pcap_stop (vm, rx_tx);
+	  vlib_worker_thread_barrier_release (vm);
+	}
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (vnet_pcap_writer_node) = {
+  .function = vnet_pcap_writer_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "pcap-writer-process",
+};
+/* *INDENT-ON* */
+
+/*
+ * Start capturing on all threads, with the file, interface and filter
+ * set in the main thread's vm->pcap[rx_tx]. Called with the worker
+ * barrier held.
+ */
+clib_error_t *
+vnet_pcap_capture_enable (vlib_main_t * vm, int rx_tx, u32 ring_size)
+{
+  vnet_pcap_t *pp = &vm->pcap[rx_tx];
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_pcap_t *tp;
+  int i;
+
+  if (pp->pcap_filter_table_index != ~0 &&
+      pool_is_free_index (cm->tables, pp->pcap_filter_table_index))
+    return clib_error_return (0, "classify table %d does not exist",
+			      pp->pcap_filter_table_index);
+
+  ring_size = clib_max (ring_size, VNET_PCAP_MIN_RING_SIZE);
+  pp->pcap_main.n_packets_captured = 0;
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      tp = &vlib_mains[i]->pcap[rx_tx];
+      tp->pcap_sw_if_index = pp->pcap_sw_if_index;
+      tp->pcap_filter_table_index = pp->pcap_filter_table_index;
+
+      if (tp->pcap_ring.data && tp->pcap_ring.mask + 1 < ring_size)
+	pcap_ring_free (&tp->pcap_ring);
+      if (tp->pcap_ring.data == 0)
+	pcap_ring_alloc (&tp->pcap_ring, ring_size);
+      tp->pcap_ring.n_packets = tp->pcap_ring.n_dropped = 0;
+    }
+
+  vnet_pcap_set_enable (rx_tx, 1);
+  vlib_process_signal_event (vm, vnet_pcap_writer_node.index, 0, 0);
+  return 0;
+}
+
+/*
+ * Stop capturing, and write out what was captured so far. Called with
+ * the worker barrier held.
+ */
+void
+vnet_pcap_capture_disable (vlib_main_t * vm, int rx_tx)
+{
+  vnet_pcap_set_enable (rx_tx, 0);
+  vnet_pcap_drain (vm, rx_tx);
+  vnet_pcap_stop (vm, rx_tx);
+}
+
+/*
+ * Stop the captures filtered by a classify table chain holding
+ * table_index, which is about to be deleted. Called with the worker
+ * barrier held.
+ */
+void
+vnet_pcap_classify_table_delete (vlib_main_t * vm, u32 table_index)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_table_t *t;
+  vnet_pcap_t *pp;
+  int rx_tx;
+  u32 ti;
+
+  for (rx_tx = 0; rx_tx < VLIB_N_RX_TX; rx_tx++)
+    {
+      pp = &vm->pcap[rx_tx];
+      ti = pp->pcap_filter_table_index;
+      while (ti != ~0 && !pool_is_free_index (cm->tables, ti))
+	{
+	  if (ti == table_index)
+	    {
+	      if (pp->pcap_enable)
+		{
+		  clib_warning ("classify table %d deleted, pcap %s capture "
+				"stopped", table_index,
+				rx_tx == VLIB_RX ? "rx" : "tx");
+		  vnet_pcap_capture_disable (vm, rx_tx);
+		}
+	      pp->pcap_filter_table_index = ~0;
+	      break;
+	    }
+	  t = pool_elt_at_index (cm->tables, ti);
+	  ti = t->next_table_index;
+	}
+    }
+}
+
+void
+vnet_pcap_capture_counters (int rx_tx, u64 * n_packets, u64 * n_dropped)
+{
+  int i;
+
+  *n_packets = *n_dropped = 0;
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      *n_packets += vlib_mains[i]->pcap[rx_tx].pcap_ring.n_packets;
+      *n_dropped += vlib_mains[i]->pcap[rx_tx].pcap_ring.n_dropped;
+    }
+}
+
+static clib_error_t *
+vnet_pcap_capture_init (vlib_main_t * vm)
+{
+  vm->pcap[VLIB_RX].pcap_filter_table_index = ~0;
+  vm->pcap[VLIB_TX].pcap_filter_table_index = ~0;
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vnet_pcap_capture_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
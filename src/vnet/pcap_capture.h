@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_vnet_pcap_capture_h__
+#define __included_vnet_pcap_capture_h__
+
+#include <vnet/vnet.h>
+#include <vnet/classify/vnet_classify.h>
+#include <vppinfra/pcap_funcs.h>
+
+/*
+ * pcap rx / tx capture.
+ *
+ * Each thread adds the packets it captures to its own ring, without
+ * locking, and the pcap writer process on the main thread drains the
+ * rings into the capture file. Once the file holds the requested number
+ * of packets it is rotated, or the capture stops. Packets are dropped
+ * from the capture, and counted, when a ring is full.
+ */
+
+#define VNET_PCAP_DEFAULT_RING_SIZE (1 << 21)
+#define VNET_PCAP_MIN_RING_SIZE (1 << 16)
+#define VNET_PCAP_MAX_RING_SIZE (1 << 30)
+#define VNET_PCAP_SNAPLEN 512
+
+clib_error_t *vnet_pcap_capture_enable (vlib_main_t * vm, int rx_tx,
+					u32 ring_size);
+void vnet_pcap_capture_disable (vlib_main_t * vm, int rx_tx);
+void vnet_pcap_capture_counters (int rx_tx, u64 * n_packets,
+				 u64 * n_dropped);
+void vnet_pcap_classify_table_delete (vlib_main_t * vm, u32 table_index);
+
+/*
+ * Capture a packet received on (VLIB_RX) or sent to (VLIB_TX)
+ * sw_if_index, if it is on the captured interface and matches the
+ * capture filter. The packet must start with its ethernet header.
+ */
+static_always_inline void
+vnet_pcap_add_buffer (vlib_main_t * vm, int rx_tx, u32 bi, u32 sw_if_index)
+{
+  vnet_pcap_t *pp = &vm->pcap[rx_tx];
+  vlib_buffer_t *b;
+
+  if (pp->pcap_sw_if_index != 0 && pp->pcap_sw_if_index != sw_if_index)
+    return;
+
+  if (pp->pcap_filter_table_index != ~0)
+    {
+      b = vlib_get_buffer (vm, bi);
+      if (!vnet_classify_chain_match (&vnet_classify_main,
+				      pp->pcap_filter_table_index,
+				      vlib_buffer_get_current (b)))
+	return;
+    }
+
+  pcap_ring_add_buffer (&pp->pcap_ring, vm, bi, VNET_PCAP_SNAPLEN);
+}
+
+#endif /* __included_vnet_pcap_capture_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -41,6 +41,7 @@
 
 #include <vnet/vnet.h>
 #include <vnet/pg/pg.h>
+#include <vlib/node_bench.h>
 
 #include <strings.h>
 #include <vppinfra/pcap.h>
@@ -183,18 +184,22 @@ format_pg_stream (u8 * s, va_list * va)
   s = format (s, "%-16v%=12s%=16Ld",
 	      t->name,
 	      pg_stream_is_enabled (t) ? "Yes" : "No",
-	      t->n_packets_generated);
+	      pg_stream_n_packets_generated (t));
 
   int indent = format_get_indent (s);
 
   s = format (s, "limit %Ld, ", t->n_packets_limit);
   s = format (s, "rate %.2e pps, ", t->rate_packets_per_second);
+  if (t->rate_bits_per_second > 0)
+    s = format (s, "rate %.2e bps, ", t->rate_bits_per_second);
   s = format (s, "size %d%c%d, ",
 	      t->min_packet_bytes,
 	      t->packet_size_edit_type == PG_EDIT_RANDOM ? '+' : '-',
 	      t->max_packet_bytes);
   s = format (s, "buffer-size %d, ", t->buffer_bytes);
   s = format (s, "worker %d, ", t->worker_index);
+  if (t->prebuilt_buffers)
+    s = format (s, "prebuilt %d, workers %d, ", t->n_prebuilt, t->n_shards);
 
   if (verbose)
     {
@@ -284,9 +289,21 @@ unformat_pg_stream_parameter (unformat_input_t * input, va_list * args)
   if (unformat (input, "limit %f", &x))
     s->n_packets_limit = x;
 
+  else if (unformat (input, "rate %f bps", &x))
+    s->rate_bits_per_second = x;
+
+  else if (unformat (input, "rate %f pps", &x))
+    s->rate_packets_per_second = x;
+
   else if (unformat (input, "rate %f", &x))
     s->rate_packets_per_second = x;
 
+  else if (unformat (input, "prebuilt %d", &s->n_prebuilt))
+    ;
+
+  else if (unformat (input, "workers %d", &s->n_shards))
+    ;
+
   else if (unformat (input, "size %d-%d", &s->min_packet_bytes,
 		     &s->max_packet_bytes))
     s->packet_size_edit_type = PG_EDIT_INCREMENT;
@@ -316,9 +333,13 @@ validate_stream (pg_stream_t * s)
   if (s->buffer_bytes == 0)
     return clib_error_create ("buffer-size must be positive");
 
-  if (s->rate_packets_per_second < 0)
+  if (s->rate_packets_per_second < 0 || s->rate_bits_per_second < 0)
     return clib_error_create ("negative rate");
 
+  if (s->n_shards > 1 && s->n_prebuilt == 0)
+    return clib_error_create ("only prebuilt streams can use several "
+			      "workers");
+
   return 0;
 }
 
@@ -450,8 +471,7 @@ new_stream (vlib_main_t * vm,
   if (error)
     return error;
 
-  pg_stream_add (pg, &s);
-  return 0;
+  return pg_stream_add (pg, &s);
 
 done:
   pg_stream_free (&s);
@@ -473,7 +493,13 @@ VLIB_CLI_COMMAND (new_stream_cli, static) = {
   "interface STRING     interface for stream output \n"
   "node NODE-NAME       node for stream output\n"
   "data STRING          specifies packet data\n"
-  "pcap FILENAME        read packet data from pcap file\n",
+  "pcap FILENAME        read packet data from pcap file\n"
+  "rate RATE [pps|bps]  packet or bit rate, bits counted from the\n"
+  "                     ethernet header using the average packet size\n"
+  "prebuilt N           build N packets once and replay them, the\n"
+  "                     payload past the first 256 bytes is shared\n"
+  "                     and must not be rewritten in place\n"
+  "workers N            shard a prebuilt stream over N workers\n",
 };
 /* *INDENT-ON* */
 
@@ -548,6 +574,100 @@ VLIB_CLI_COMMAND (change_stream_parameters_cli, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+pg_benchmark_cmd_fn (vlib_main_t * vm,
+		     unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  pg_main_t *pg = &pg_main;
+  vlib_node_bench_args_t _a = { 0 }, *a = &_a;
+  vlib_node_bench_result_t r;
+  clib_error_t *error;
+  u32 stream_index;
+  pg_stream_t *s;
+  int advance = 0, json = 0;
+
+  if (!unformat (input, "%U", unformat_hash_vec_string,
+		 pg->stream_index_by_name, &stream_index))
+    return clib_error_create ("expecting stream name; got `%U'",
+			      format_unformat_error, input);
+
+  a->node_index = ~0;
+  a->n_frames = 1000;
+  a->n_warmup_frames = 100;
+  a->frame_size = VLIB_FRAME_SIZE;
+  a->use_pmc = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "node %U", unformat_vlib_node, vm, &a->node_index))
+	;
+      else if (unformat (input, "frames %d", &a->n_frames))
+	;
+      else if (unformat (input, "warmup %d", &a->n_warmup_frames))
+	;
+      else if (unformat (input, "vector-size %d", &a->frame_size))
+	;
+      else if (unformat (input, "advance %d", &advance))
+	;
+      else if (unformat (input, "no-pmc"))
+	a->use_pmc = 0;
+      else if (unformat (input, "json"))
+	json = 1;
+      else
+	return clib_error_create ("unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (a->node_index == ~0)
+    return clib_error_return (0, "node to benchmark must be specified");
+
+  s = pool_elt_at_index (pg->streams, stream_index);
+  if (s->prebuilt_buffers == 0)
+    return clib_error_return (0, "stream %v is not prebuilt", s->name);
+  a->template_buffers = s->prebuilt_buffers;
+  a->advance = advance;
+
+  error = vlib_node_bench (vm, a, &r);
+  if (!error)
+    vlib_cli_output (vm, "%U", format_vlib_node_bench_result, vm, &r, json);
+  vlib_node_bench_result_free (&r);
+  return error;
+}
+
+/*?
+ * Measure the cost of a single graph node, without any interface
+ * involved. The node is called over frames of copies of the packets of
+ * a prebuilt stream, so the header distribution is the one of the
+ * stream edits or pcap file. The packets the node enqueues are counted
+ * by next node and freed. Reports clocks and nanoseconds per packet,
+ * vectors per call, the next nodes and, when the kernel allows perf
+ * events, per packet cpu cycles, instructions, branch and cache
+ * misses. The '<em>json</em>' output is meant for tracking regressions.
+ *
+ * The '<em>advance</em>' option skips the given number of bytes of the
+ * packets, e.g. 14 to feed the ethernet frames of a stream to an ip4
+ * node. Nodes which hand packets off to other threads are not
+ * supported.
+ *
+ * @cliexpar
+ * @cliexstart{packet-generator benchmark s0 node ip4-lookup advance 14}
+ * ip4-lookup: 256000 packets in 1000 calls, 256.00 vectors/call
+ *   12.41 clocks/packet, 4.96 ns/packet
+ *   next nodes:
+ *     ip4-rewrite                    256000
+ *   hardware counters not available
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (pg_benchmark_cmd, static) = {
+  .path = "packet-generator benchmark",
+  .short_help = "packet-generator benchmark <stream-name> node <node-name> "
+    "[frames <n>] [warmup <n>] [vector-size <n>] [advance <bytes>] "
+    "[no-pmc] [json]",
+  .function = pg_benchmark_cmd_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 pg_capture_cmd_fn (vlib_main_t * vm,
 		   unformat_input_t * input, vlib_cli_command_t * cmd)
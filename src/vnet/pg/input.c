@@ -51,6 +51,10 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/feature/feature.h>
 #include <vnet/devices/devices.h>
+#include <vnet/flow/flow.h>
+#include <vnet/latency.h>
+#include <vnet/udp/udp_packet.h>
+#include <vnet/vxlan/vxlan_packet.h>
 
 static int
 validate_buffer_data2 (vlib_buffer_t * b, pg_stream_t * s,
@@ -894,6 +898,8 @@ pg_generate_set_lengths (pg_main_t * pg,
       length_sum = v_min * n_buffers;
     }
 
+  /* Prebuilt packets are counted as they are injected */
+  if (!(s->flags & PG_STREAM_FLAGS_IS_PREBUILDING))
   {
     vnet_main_t *vnm = vnet_get_main ();
     vnet_interface_main_t *im = &vnm->interface_main;
@@ -1289,14 +1295,17 @@ pg_stream_fill_replay (pg_main_t * pg, pg_stream_t * s, u32 n_alloc)
     }
 
   /* Update the interface counters */
-  si = vnet_get_sw_interface (vnm, s->sw_if_index[VLIB_RX]);
-  l = 0;
-  for (i = 0; i < n_alloc; i++)
-    l += vlib_buffer_index_length_in_chain (vm, buffers[i]);
-  vlib_increment_combined_counter (im->combined_sw_if_counters
-				   + VNET_INTERFACE_COUNTER_RX,
-				   vlib_get_thread_index (),
-				   si->sw_if_index, n_alloc, l);
+  if (!(s->flags & PG_STREAM_FLAGS_IS_PREBUILDING))
+    {
+      si = vnet_get_sw_interface (vnm, s->sw_if_index[VLIB_RX]);
+      l = 0;
+      for (i = 0; i < n_alloc; i++)
+	l += vlib_buffer_index_length_in_chain (vm, buffers[i]);
+      vlib_increment_combined_counter (im->combined_sw_if_counters
+				       + VNET_INTERFACE_COUNTER_RX,
+				       vlib_get_thread_index (),
+				       si->sw_if_index, n_alloc, l);
+    }
 
   s->current_replay_packet_index += n_alloc;
   s->current_replay_packet_index %= vec_len (s->replay_packet_templates);
@@ -1395,6 +1404,152 @@ pg_stream_fill (pg_main_t * pg, pg_stream_t * s, u32 n_buffers)
   return n_in_fifo + n_added;
 }
 
+/*
+ * Build the ring of a prebuilt stream: packets are generated once, from
+ * the edits or the pcap file, and kept. The part of a packet past its
+ * first PG_PREBUILT_HEAD_BYTES is moved to a buffer of its own, which
+ * the injected packets share.
+ */
+clib_error_t *
+pg_stream_prebuild (pg_main_t * pg, pg_stream_t * s)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u64 n_packets_limit = s->n_packets_limit;
+  clib_error_t *error = 0;
+  pg_buffer_index_t *bi;
+  vlib_buffer_t *b, *t;
+  u32 i, n, bi0, ti;
+
+  s->flags |= PG_STREAM_FLAGS_IS_PREBUILDING;
+  s->n_packets_limit = s->n_prebuilt;
+  s->n_packets_generated = 0;
+
+  while (s->n_packets_generated < s->n_prebuilt)
+    {
+      n = clib_min (s->n_prebuilt - s->n_packets_generated, VLIB_FRAME_SIZE);
+      n = clib_min (pg_stream_fill (pg, s, n), n);
+      if (n == 0)
+	break;
+
+      for (i = 0; i < n; i++)
+	{
+	  clib_fifo_sub1 (s->buffer_indices[0].buffer_fifo, bi0);
+	  vec_add1 (s->prebuilt_buffers, bi0);
+	}
+      /* Chained buffers are reached from their head */
+      if (s->replay_packet_templates == 0)
+	for (bi = s->buffer_indices + 1; bi < vec_end (s->buffer_indices);
+	     bi++)
+	  clib_fifo_advance_head (bi->buffer_fifo, n);
+
+      s->n_packets_generated += n;
+    }
+
+  s->flags &= ~PG_STREAM_FLAGS_IS_PREBUILDING;
+  s->n_packets_limit = n_packets_limit;
+  s->n_packets_generated = 0;
+
+  if (vec_len (s->prebuilt_buffers) < s->n_prebuilt)
+    return clib_error_return (0, "only %d of %d packets could be built",
+			      vec_len (s->prebuilt_buffers), s->n_prebuilt);
+
+  for (i = 0; i < vec_len (s->prebuilt_buffers); i++)
+    {
+      b = vlib_get_buffer (vm, s->prebuilt_buffers[i]);
+      /* Validates the total length of the chain */
+      vlib_buffer_length_in_chain (vm, b);
+      if (b->current_length <= PG_PREBUILT_HEAD_BYTES)
+	continue;
+
+      if (vlib_buffer_alloc_from_pool (vm, &ti, 1,
+				       b->buffer_pool_index) != 1)
+	{
+	  error = clib_error_return (0, "buffer allocation failure");
+	  break;
+	}
+
+      t = vlib_get_buffer (vm, ti);
+      t->current_data = 0;
+      t->current_length = b->current_length - PG_PREBUILT_HEAD_BYTES;
+      clib_memcpy_fast (t->data,
+			vlib_buffer_get_current (b) + PG_PREBUILT_HEAD_BYTES,
+			t->current_length);
+      t->flags = (b->flags & VLIB_BUFFER_NEXT_PRESENT) |
+	VLIB_BUFFER_TOTAL_LENGTH_VALID;
+      t->next_buffer = b->next_buffer;
+      t->total_length_not_including_first_buffer =
+	b->total_length_not_including_first_buffer;
+
+      b->current_length = PG_PREBUILT_HEAD_BYTES;
+      b->flags |= VLIB_BUFFER_NEXT_PRESENT;
+      b->next_buffer = ti;
+      b->total_length_not_including_first_buffer += t->current_length;
+    }
+
+  return error;
+}
+
+/*
+ * Inject packets of the prebuilt ring. The metadata and headers of each
+ * packet are copied into a new buffer, the rest of the packet is shared
+ * with the ring by taking a reference on it. Features which rewrite the
+ * payload past the copied headers in place, e.g. in place encryption,
+ * would change the ring: prebuilt streams are not safe with them. Ring
+ * packets with too many packets in flight are skipped.
+ */
+static u32
+pg_prebuilt_inject (vlib_main_t * vm, pg_stream_t * s,
+		    pg_stream_shard_t * ps, u32 * buffers, u32 n_buffers)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_interface_main_t *im = &vnm->interface_main;
+  u32 n_ring = vec_len (s->prebuilt_buffers);
+  vlib_buffer_t *p0, *b0, *t0;
+  u32 i, n_alloc, n_inject = 0, n_bytes = 0;
+
+  p0 = vlib_get_buffer (vm, s->prebuilt_buffers[0]);
+  n_alloc = vlib_buffer_alloc_from_pool (vm, buffers, n_buffers,
+					 p0->buffer_pool_index);
+
+  for (i = 0; i < n_alloc; i++)
+    {
+      p0 = vlib_get_buffer (vm, s->prebuilt_buffers[ps->prebuilt_index]);
+      ps->prebuilt_index += s->n_shards;
+      if (ps->prebuilt_index >= n_ring)
+	ps->prebuilt_index %= n_ring;
+
+      t0 = 0;
+      if (p0->flags & VLIB_BUFFER_NEXT_PRESENT)
+	{
+	  t0 = vlib_get_buffer (vm, p0->next_buffer);
+	  if (PREDICT_FALSE (t0->ref_count >= PG_PREBUILT_MAX_REF_COUNT))
+	    continue;
+	}
+
+      if (PREDICT_TRUE (n_inject + 1 < n_alloc))
+	vlib_prefetch_buffer_with_index (vm, buffers[n_inject + 1], STORE);
+
+      b0 = vlib_get_buffer (vm, buffers[n_inject++]);
+      vlib_buffer_copy_template (b0, p0);
+      b0->ref_count = 1;
+      b0->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      clib_memcpy_fast (vlib_buffer_get_current (b0),
+			vlib_buffer_get_current (p0), p0->current_length);
+      if (t0)
+	vlib_buffer_attach_clone (vm, b0, t0);
+      n_bytes += vlib_buffer_length_in_chain (vm, b0);
+    }
+
+  if (PREDICT_FALSE (n_inject < n_alloc))
+    vlib_buffer_free_no_next (vm, buffers + n_inject, n_alloc - n_inject);
+
+  vlib_increment_combined_counter (im->combined_sw_if_counters
+				   + VNET_INTERFACE_COUNTER_RX,
+				   vm->thread_index, s->sw_if_index[VLIB_RX],
+				   n_inject, n_bytes);
+  return n_inject;
+}
+
 typedef struct
 {
   u32 stream_index;
@@ -1448,91 +1603,171 @@ format_pg_input_trace (u8 * s, va_list * va)
   return s;
 }
 
-static void
+/* Returns the number of buffers traced, at most n_trace. */
+static u32
 pg_input_trace (pg_main_t * pg,
 		vlib_node_runtime_t * node, u32 stream_index, u32 next_index,
-		u32 * buffers, u32 n_buffers)
+		u32 * buffers, u32 n_buffers, u32 n_trace)
 {
   vlib_main_t *vm = vlib_get_main ();
-  u32 *b, n_left;
+  u32 *b, n_left, n_traced = 0;
 
   n_left = n_buffers;
   b = buffers;
 
-  while (n_left >= 2)
+  while (n_left > 0 && n_traced < n_trace)
     {
-      u32 bi0, bi1;
-      vlib_buffer_t *b0, *b1;
-      pg_input_trace_t *t0, *t1;
+      u32 bi0;
+      vlib_buffer_t *b0;
+      pg_input_trace_t *t0;
 
       bi0 = b[0];
-      bi1 = b[1];
-      b += 2;
-      n_left -= 2;
+      b += 1;
+      n_left -= 1;
 
       b0 = vlib_get_buffer (vm, bi0);
-      b1 = vlib_get_buffer (vm, bi1);
 
-      vlib_trace_buffer (vm, node, next_index, b0, /* follow_chain */ 1);
-      vlib_trace_buffer (vm, node, next_index, b1, /* follow_chain */ 1);
+      if (!vlib_trace_buffer (vm, node, next_index, b0,
+			      /* follow_chain */ 1))
+	continue;
 
+      n_traced++;
       t0 = vlib_add_trace (vm, node, b0, sizeof (t0[0]));
-      t1 = vlib_add_trace (vm, node, b1, sizeof (t1[0]));
 
       t0->stream_index = stream_index;
-      t1->stream_index = stream_index;
-
       t0->packet_length = vlib_buffer_length_in_chain (vm, b0);
-      t1->packet_length = vlib_buffer_length_in_chain (vm, b1);
-
       t0->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      t1->sw_if_index = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-
       clib_memcpy_fast (&t0->buffer, b0,
 			sizeof (b0[0]) - sizeof (b0->pre_data));
-      clib_memcpy_fast (&t1->buffer, b1,
-			sizeof (b1[0]) - sizeof (b1->pre_data));
-
       clib_memcpy_fast (t0->buffer.pre_data, b0->data,
 			sizeof (t0->buffer.pre_data));
-      clib_memcpy_fast (t1->buffer.pre_data, b1->data,
-			sizeof (t1->buffer.pre_data));
     }
 
-  while (n_left >= 1)
-    {
-      u32 bi0;
-      vlib_buffer_t *b0;
-      pg_input_trace_t *t0;
+  return n_traced;
+}
 
-      bi0 = b[0];
-      b += 1;
-      n_left -= 1;
+static_always_inline int
+pg_flow_match_ip4_addr (ip4_address_t * a, ip4_address_and_mask_t * m)
+{
+  return (a->as_u32 & m->mask.as_u32) == (m->addr.as_u32 & m->mask.as_u32);
+}
 
-      b0 = vlib_get_buffer (vm, bi0);
+static_always_inline int
+pg_flow_match_port (u16 port, ip_port_and_mask_t * m)
+{
+  return (clib_net_to_host_u16 (port) & m->mask) == (m->port & m->mask);
+}
 
-      vlib_trace_buffer (vm, node, next_index, b0, /* follow_chain */ 1);
-      t0 = vlib_add_trace (vm, node, b0, sizeof (t0[0]));
+static int
+pg_flow_match (vnet_flow_t * f, ip4_header_t * ip4, udp_header_t * udp)
+{
+  vnet_flow_ip4_n_tuple_t *t4;
+  vnet_flow_ip4_vxlan_t *v4;
+  vnet_flow_ip4_gtpu_t *g4;
+  vxlan_header_t *vxlan;
+  u32 *teid;
 
-      t0->stream_index = stream_index;
-      t0->packet_length = vlib_buffer_length_in_chain (vm, b0);
-      t0->sw_if_index = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      clib_memcpy_fast (&t0->buffer, b0,
-			sizeof (b0[0]) - sizeof (b0->pre_data));
-      clib_memcpy_fast (t0->buffer.pre_data, b0->data,
-			sizeof (t0->buffer.pre_data));
+  switch (f->type)
+    {
+    case VNET_FLOW_TYPE_IP4_N_TUPLE:
+      t4 = &f->ip4_n_tuple;
+      if (!pg_flow_match_ip4_addr (&ip4->src_address, &t4->src_addr) ||
+	  !pg_flow_match_ip4_addr (&ip4->dst_address, &t4->dst_addr) ||
+	  ip4->protocol != t4->protocol)
+	return 0;
+      if (ip4->protocol != IP_PROTOCOL_UDP &&
+	  ip4->protocol != IP_PROTOCOL_TCP)
+	return 1;
+      /* tcp ports are at the same offsets */
+      return (pg_flow_match_port (udp->src_port, &t4->src_port) &&
+	      pg_flow_match_port (udp->dst_port, &t4->dst_port));
+
+    case VNET_FLOW_TYPE_IP4_VXLAN:
+      v4 = &f->ip4_vxlan;
+      vxlan = (vxlan_header_t *) (udp + 1);
+      return (ip4->protocol == IP_PROTOCOL_UDP &&
+	      ip4->src_address.as_u32 == v4->src_addr.as_u32 &&
+	      ip4->dst_address.as_u32 == v4->dst_addr.as_u32 &&
+	      udp->dst_port == clib_host_to_net_u16 (v4->dst_port) &&
+	      vxlan->flags == VXLAN_FLAGS_I && vnet_get_vni (vxlan) == v4->vni);
+
+    case VNET_FLOW_TYPE_IP4_GTPU:
+      g4 = &f->ip4_gtpu;
+      /* GTPv1-U teid follows the flags, type and length fields */
+      teid = (u32 *) ((u8 *) (udp + 1) + 4);
+      return (ip4->protocol == IP_PROTOCOL_UDP &&
+	      ip4->src_address.as_u32 == g4->src_addr.as_u32 &&
+	      ip4->dst_address.as_u32 == g4->dst_addr.as_u32 &&
+	      udp->dst_port == clib_host_to_net_u16 (g4->dst_port) &&
+	      clib_net_to_host_u32 (*teid) == g4->teid);
+
+    default:
+      return 0;
+    }
+}
+
+/* Mark packets matching the flows enabled on the interface, see
+   pg_flow_ops_fn */
+static void
+pg_flow_mark (vlib_main_t * vm, pg_interface_t * pi, u32 * buffers,
+	      u32 n_buffers)
+{
+  ethernet_header_t *e;
+  ip4_header_t *ip4;
+  udp_header_t *udp;
+  vlib_buffer_t *b;
+  vnet_flow_t *f;
+  u32 i, *fi, offset;
+  u16 type;
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      b = vlib_get_buffer (vm, buffers[i]);
+      b->flow_id = 0;
+
+      e = vlib_buffer_get_current (b);
+      type = clib_net_to_host_u16 (e->type);
+      offset = sizeof (ethernet_header_t);
+      if (type == ETHERNET_TYPE_VLAN)
+	{
+	  ethernet_vlan_header_t *vlan = (void *) (e + 1);
+	  type = clib_net_to_host_u16 (vlan->type);
+	  offset += sizeof (ethernet_vlan_header_t);
+	}
+      if (type != ETHERNET_TYPE_IP4)
+	continue;
+
+      ip4 = vlib_buffer_get_current (b) + offset;
+      offset += ip4_header_bytes (ip4);
+      /* room for udp and a tunnel header */
+      if (b->current_length < offset + sizeof (udp_header_t) + 8 ||
+	  ip4_get_fragment_offset (ip4))
+	continue;
+      udp = vlib_buffer_get_current (b) + offset;
+
+      vec_foreach (fi, pi->flow_indices)
+      {
+	f = vnet_get_flow (fi[0]);
+	if (pg_flow_match (f, ip4, udp))
+	  {
+	    b->flow_id = f->mark_flow_id;
+	    break;
+	  }
+      }
     }
 }
 
 static uword
 pg_generate_packets (vlib_node_runtime_t * node,
 		     pg_main_t * pg,
-		     pg_stream_t * s, uword n_packets_to_generate)
+		     pg_stream_t * s, pg_stream_shard_t * ps,
+		     uword n_packets_to_generate)
 {
   vlib_main_t *vm = vlib_get_main ();
   u32 *to_next, n_this_frame, n_left, n_trace, n_packets_in_fifo;
   uword n_packets_generated;
   pg_buffer_index_t *bi, *bi0;
+  pg_interface_t *pi;
   u32 next_index = s->next_index;
   vnet_feature_main_t *fm = &feature_main;
   vnet_feature_config_main_t *cm;
@@ -1543,8 +1778,12 @@ pg_generate_packets (vlib_node_runtime_t * node,
 
   bi0 = s->buffer_indices;
 
-  n_packets_in_fifo = pg_stream_fill (pg, s, n_packets_to_generate);
-  n_packets_to_generate = clib_min (n_packets_in_fifo, n_packets_to_generate);
+  if (ps == 0)
+    {
+      n_packets_in_fifo = pg_stream_fill (pg, s, n_packets_to_generate);
+      n_packets_to_generate = clib_min (n_packets_in_fifo,
+					n_packets_to_generate);
+    }
   n_packets_generated = 0;
 
   if (PREDICT_FALSE
@@ -1565,7 +1804,6 @@ pg_generate_packets (vlib_node_runtime_t * node,
 	  vlib_next_frame_t *nf;
 	  vlib_frame_t *f;
 	  ethernet_input_frame_t *ef;
-	  pg_interface_t *pi;
 	  vlib_get_new_next_frame (vm, node, next_index, to_next, n_left);
 	  nf = vlib_node_runtime_get_next_frame (vm, node, next_index);
 	  f = vlib_get_frame (vm, nf->frame_index);
@@ -1584,29 +1822,52 @@ pg_generate_packets (vlib_node_runtime_t * node,
       if (n_this_frame > n_left)
 	n_this_frame = n_left;
 
-      start = bi0->buffer_fifo;
-      end = clib_fifo_end (bi0->buffer_fifo);
-      head = clib_fifo_head (bi0->buffer_fifo);
-
-      if (head + n_this_frame <= end)
-	vlib_buffer_copy_indices (to_next, head, n_this_frame);
-      else
+      if (ps)
 	{
-	  u32 n = end - head;
-	  vlib_buffer_copy_indices (to_next + 0, head, n);
-	  vlib_buffer_copy_indices (to_next + n, start, n_this_frame - n);
-	}
-
-      if (s->replay_packet_templates == 0)
-	{
-	  vec_foreach (bi, s->buffer_indices)
-	    clib_fifo_advance_head (bi->buffer_fifo, n_this_frame);
+	  n_this_frame = pg_prebuilt_inject (vm, s, ps, to_next,
+					     n_this_frame);
+	  if (PREDICT_FALSE (n_this_frame == 0))
+	    {
+	      vlib_put_next_frame (vm, node, next_index, n_left);
+	      break;
+	    }
+	  /* Stop at the packets of the ring still in flight */
+	  if (n_this_frame < n_left && n_this_frame < n_packets_to_generate)
+	    n_packets_to_generate = n_this_frame;
 	}
       else
 	{
-	  clib_fifo_advance_head (bi0->buffer_fifo, n_this_frame);
+	  start = bi0->buffer_fifo;
+	  end = clib_fifo_end (bi0->buffer_fifo);
+	  head = clib_fifo_head (bi0->buffer_fifo);
+
+	  if (head + n_this_frame <= end)
+	    vlib_buffer_copy_indices (to_next, head, n_this_frame);
+	  else
+	    {
+	      u32 n = end - head;
+	      vlib_buffer_copy_indices (to_next + 0, head, n);
+	      vlib_buffer_copy_indices (to_next + n, start,
+					n_this_frame - n);
+	    }
+
+	  if (s->replay_packet_templates == 0)
+	    {
+	      vec_foreach (bi, s->buffer_indices)
+		clib_fifo_advance_head (bi->buffer_fifo, n_this_frame);
+	    }
+	  else
+	    {
+	      clib_fifo_advance_head (bi0->buffer_fifo, n_this_frame);
+	    }
 	}
 
+      pi = pool_elt_at_index (pg->interfaces, s->pg_if_index);
+      if (PREDICT_FALSE (vec_len (pi->flow_indices) > 0))
+	pg_flow_mark (vm, pi, to_next, n_this_frame);
+
+      vnet_latency_stamp (vm, to_next, n_this_frame);
+
       if (current_config_index != ~(u32) 0)
 	for (i = 0; i < n_this_frame; i++)
 	  {
@@ -1619,8 +1880,8 @@ pg_generate_packets (vlib_node_runtime_t * node,
       n_trace = vlib_get_trace_count (vm, node);
       if (n_trace > 0)
 	{
-	  u32 n = clib_min (n_trace, n_this_frame);
-	  pg_input_trace (pg, node, s - pg->streams, next_index, to_next, n);
+	  u32 n = pg_input_trace (pg, node, s - pg->streams, next_index,
+				  to_next, n_this_frame, n_trace);
 	  vlib_set_trace_count (vm, node, n_trace - n);
 	}
       n_packets_to_generate -= n_this_frame;
@@ -1644,54 +1905,102 @@ pg_generate_packets (vlib_node_runtime_t * node,
   return n_packets_generated;
 }
 
-static uword
-pg_input_stream (vlib_node_runtime_t * node, pg_main_t * pg, pg_stream_t * s)
+/* Number of packets to generate in this dispatch, at most a frame */
+static_always_inline uword
+pg_n_packets_to_generate (vlib_main_t * vm, f64 rate_packets_per_second,
+			  u64 n_packets_generated, u64 n_packets_limit,
+			  f64 * time_last_generate, f64 * packet_accumulator)
 {
-  vlib_main_t *vm = vlib_get_main ();
   uword n_packets;
   f64 time_now, dt;
 
-  if (s->n_packets_limit > 0 && s->n_packets_generated >= s->n_packets_limit)
-    {
-      pg_stream_enable_disable (pg, s, /* want_enabled */ 0);
-      return 0;
-    }
-
   /* Apply rate limit. */
   time_now = vlib_time_now (vm);
-  if (s->time_last_generate == 0)
-    s->time_last_generate = time_now;
+  if (*time_last_generate == 0)
+    *time_last_generate = time_now;
 
-  dt = time_now - s->time_last_generate;
-  s->time_last_generate = time_now;
+  dt = time_now - *time_last_generate;
+  *time_last_generate = time_now;
 
   n_packets = VLIB_FRAME_SIZE;
-  if (s->rate_packets_per_second > 0)
+  if (rate_packets_per_second > 0)
     {
-      s->packet_accumulator += dt * s->rate_packets_per_second;
-      n_packets = s->packet_accumulator;
+      *packet_accumulator += dt * rate_packets_per_second;
+      n_packets = *packet_accumulator;
 
       /* Never allow accumulator to grow if we get behind. */
-      s->packet_accumulator -= n_packets;
+      *packet_accumulator -= n_packets;
     }
 
   /* Apply fixed limit. */
-  if (s->n_packets_limit > 0
-      && s->n_packets_generated + n_packets > s->n_packets_limit)
-    n_packets = s->n_packets_limit - s->n_packets_generated;
+  if (n_packets_limit > 0 && n_packets_generated + n_packets > n_packets_limit)
+    n_packets = n_packets_limit - n_packets_generated;
 
   /* Generate up to one frame's worth of packets. */
   if (n_packets > VLIB_FRAME_SIZE)
     n_packets = VLIB_FRAME_SIZE;
 
+  return n_packets;
+}
+
+static uword
+pg_input_stream (vlib_node_runtime_t * node, pg_main_t * pg, pg_stream_t * s)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  uword n_packets;
+
+  if (s->n_packets_limit > 0 && s->n_packets_generated >= s->n_packets_limit)
+    {
+      pg_stream_enable_disable (pg, s, /* want_enabled */ 0);
+      return 0;
+    }
+
+  n_packets = pg_n_packets_to_generate (vm, s->rate_packets_per_second,
+				       s->n_packets_generated,
+				       s->n_packets_limit,
+				       &s->time_last_generate,
+				       &s->packet_accumulator);
+
   if (n_packets > 0)
-    n_packets = pg_generate_packets (node, pg, s, n_packets);
+    n_packets = pg_generate_packets (node, pg, s, 0, n_packets);
 
   s->n_packets_generated += n_packets;
 
   return n_packets;
 }
 
+/* Inject the packets of the shard of a prebuilt stream */
+static uword
+pg_input_prebuilt (vlib_node_runtime_t * node, pg_main_t * pg,
+		   pg_stream_t * s, u32 worker_index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u32 n_workers = clib_max (vlib_num_workers (), 1);
+  u32 shard = (worker_index + n_workers - s->worker_index) % n_workers;
+  pg_stream_shard_t *ps = vec_elt_at_index (s->shards, shard);
+  uword n_packets;
+
+  if (ps->n_packets_limit > 0
+      && ps->n_packets_generated >= ps->n_packets_limit)
+    {
+      pg_stream_shard_done (pg, s, shard);
+      return 0;
+    }
+
+  n_packets = pg_n_packets_to_generate (vm, ps->rate_packets_per_second,
+				       ps->n_packets_generated,
+				       ps->n_packets_limit,
+				       &ps->time_last_generate,
+				       &ps->packet_accumulator);
+
+  if (n_packets > 0)
+    n_packets = pg_generate_packets (node, pg, s, ps, n_packets);
+
+  ps->n_packets_generated += n_packets;
+
+  return n_packets;
+}
+
 uword
 pg_input (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
@@ -1706,7 +2015,10 @@ pg_input (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_frame_t * frame)
   /* *INDENT-OFF* */
   clib_bitmap_foreach (i, pg->enabled_streams[worker_index], ({
     pg_stream_t *s = vec_elt_at_index (pg->streams, i);
-    n_packets += pg_input_stream (node, pg, s);
+    if (s->prebuilt_buffers)
+      n_packets += pg_input_prebuilt (node, pg, s, worker_index);
+    else
+      n_packets += pg_input_stream (node, pg, s);
   }));
   /* *INDENT-ON* */
 
@@ -91,6 +91,33 @@ typedef struct
 
 } pg_buffer_index_t;
 
+/* Bytes of a prebuilt packet copied into each packet injected, the rest
+   of the packet is shared with the ring. */
+#define PG_PREBUILT_HEAD_BYTES VLIB_BUFFER_CLONE_HEAD_SIZE
+
+/* Ring packets are skipped while this many injected packets are still
+   referencing them. */
+#define PG_PREBUILT_MAX_REF_COUNT 128
+
+/* State of the worker generating a shard of a prebuilt stream. */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  u64 n_packets_generated;
+
+  /* Share of the stream packet limit and rate. */
+  u64 n_packets_limit;
+  f64 rate_packets_per_second;
+
+  f64 time_last_generate;
+
+  f64 packet_accumulator;
+
+  /* Next packet of the ring to inject. */
+  u32 prebuilt_index;
+} pg_stream_shard_t;
+
 typedef struct pg_stream_t
 {
   /* Stream name. */
@@ -100,6 +127,8 @@ typedef struct pg_stream_t
 
   /* Stream is currently enabled. */
 #define PG_STREAM_FLAGS_IS_ENABLED (1 << 0)
+  /* Packets are generated to build the prebuilt ring. */
+#define PG_STREAM_FLAGS_IS_PREBUILDING (1 << 1)
 
   /* Edit groups are created by each protocol level (e.g. ethernet,
      ip4, tcp, ...). */
@@ -159,6 +188,10 @@ typedef struct pg_stream_t
      Zero means unlimited rate. */
   f64 rate_packets_per_second;
 
+  /* Rate for this stream in bits/second, converted to packets/second
+     with the average packet size. Zero means rate is in packets/second. */
+  f64 rate_bits_per_second;
+
   f64 time_last_generate;
 
   f64 packet_accumulator;
@@ -168,6 +201,21 @@ typedef struct pg_stream_t
   u8 **replay_packet_templates;
   u64 *replay_packet_timestamps;
   u32 current_replay_packet_index;
+
+  /* Replay mode: packets are built once, from the edits or the pcap
+     file, into a ring of n_prebuilt packets which are then injected over
+     and over. Headers are copied into each injected packet, the rest of
+     the packet is shared by reference, so features rewriting the payload
+     in place must not see prebuilt packets. */
+  u32 n_prebuilt;
+  u32 *prebuilt_buffers;
+
+  /* Prebuilt streams may be sharded over n_shards workers, starting at
+     worker_index. Shard i injects packets i, i + n_shards, ... of the
+     ring. */
+  u32 n_shards;
+  u32 n_shards_active;
+  pg_stream_shard_t *shards;
 } pg_stream_t;
 
 always_inline void
@@ -204,6 +252,8 @@ pg_stream_free (pg_stream_t * s)
     vec_free (s->replay_packet_templates[i]);
   vec_free (s->replay_packet_templates);
   vec_free (s->replay_packet_timestamps);
+  vec_free (s->prebuilt_buffers);
+  vec_free (s->shards);
 
   {
     pg_buffer_index_t *bi;
@@ -218,6 +268,23 @@ pg_stream_is_enabled (pg_stream_t * s)
   return (s->flags & PG_STREAM_FLAGS_IS_ENABLED) != 0;
 }
 
+/* Worker generating a shard of a stream */
+always_inline u32
+pg_stream_shard_worker (pg_stream_t * s, u32 shard)
+{
+  return (s->worker_index + shard) % clib_max (vlib_num_workers (), 1);
+}
+
+always_inline u64
+pg_stream_n_packets_generated (pg_stream_t * s)
+{
+  pg_stream_shard_t *ps;
+  u64 n_packets = s->n_packets_generated;
+
+  vec_foreach (ps, s->shards) n_packets += ps->n_packets_generated;
+  return n_packets;
+}
+
 always_inline pg_edit_group_t *
 pg_stream_get_group (pg_stream_t * s, u32 group_index)
 {
@@ -301,6 +368,9 @@ typedef struct
 
   pcap_main_t pcap_main;
   u8 *pcap_file_name;
+
+  /* Flows enabled on this interface, see pg_flow_ops_fn */
+  u32 *flow_indices;
 } pg_interface_t;
 
 /* Per VLIB node data. */
@@ -343,12 +413,16 @@ vlib_node_function_t pg_input, pg_output;
 
 /* Stream add/delete. */
 void pg_stream_del (pg_main_t * pg, uword index);
-void pg_stream_add (pg_main_t * pg, pg_stream_t * s_init);
+clib_error_t *pg_stream_add (pg_main_t * pg, pg_stream_t * s_init);
 void pg_stream_change (pg_main_t * pg, pg_stream_t * s);
 
 /* Enable/disable stream. */
 void pg_stream_enable_disable (pg_main_t * pg, pg_stream_t * s,
 			       int is_enable);
+void pg_stream_shard_done (pg_main_t * pg, pg_stream_t * s, u32 shard);
+
+/* Build the ring of a prebuilt stream. */
+clib_error_t *pg_stream_prebuild (pg_main_t * pg, pg_stream_t * s);
 
 /* Find/create free packet-generator interface index. */
 u32 pg_interface_add_or_get (pg_main_t * pg, uword stream_index);
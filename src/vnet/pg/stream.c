@@ -43,14 +43,61 @@
 #include <vnet/ip/ip.h>
 #include <vnet/mpls/mpls.h>
 #include <vnet/devices/devices.h>
+#include <vnet/flow/flow.h>
+
+/* Enable or disable the stream on a worker. */
+static void
+pg_stream_set_worker (pg_main_t * pg, pg_stream_t * s, u32 worker_index,
+		      int want_enabled)
+{
+  vlib_main_t *vm;
+
+  vec_validate (pg->enabled_streams, worker_index);
+  pg->enabled_streams[worker_index] =
+    clib_bitmap_set (pg->enabled_streams[worker_index], s - pg->streams,
+		     want_enabled);
+
+  if (vlib_num_workers ())
+    vm = vlib_get_worker_vlib_main (worker_index);
+  else
+    vm = vlib_get_main ();
+
+  vlib_node_set_state (vm, pg_input_node.index,
+		       (clib_bitmap_is_zero
+			(pg->enabled_streams[worker_index]) ?
+			VLIB_NODE_STATE_DISABLED : VLIB_NODE_STATE_POLLING));
+}
+
+/* Split the packet limit and rate of a prebuilt stream between its
+   shards, returns the number of shards with packets to generate. */
+static u32
+pg_stream_shards_reset (pg_stream_t * s)
+{
+  pg_stream_shard_t *ps;
+  u32 shard, n_active = 0;
+
+  vec_foreach_index (shard, s->shards)
+  {
+    ps = vec_elt_at_index (s->shards, shard);
+    ps->n_packets_generated = 0;
+    ps->n_packets_limit = s->n_packets_limit / s->n_shards
+      + (shard < s->n_packets_limit % s->n_shards);
+    ps->rate_packets_per_second = s->rate_packets_per_second / s->n_shards;
+    ps->time_last_generate = 0;
+    ps->packet_accumulator = 0;
+    ps->prebuilt_index = shard % vec_len (s->prebuilt_buffers);
+    n_active += s->n_packets_limit == 0 || ps->n_packets_limit > 0;
+  }
+  return n_active;
+}
 
 /* Mark stream active or inactive. */
 void
 pg_stream_enable_disable (pg_main_t * pg, pg_stream_t * s, int want_enabled)
 {
-  vlib_main_t *vm;
   vnet_main_t *vnm = vnet_get_main ();
   pg_interface_t *pi = pool_elt_at_index (pg->interfaces, s->pg_if_index);
+  u32 shard;
 
   want_enabled = want_enabled != 0;
 
@@ -59,18 +106,16 @@ pg_stream_enable_disable (pg_main_t * pg, pg_stream_t * s, int want_enabled)
     return;
 
   if (want_enabled)
-    s->n_packets_generated = 0;
+    {
+      s->n_packets_generated = 0;
+      s->n_shards_active = pg_stream_shards_reset (s);
+    }
 
   /* Toggle enabled flag. */
   s->flags ^= PG_STREAM_FLAGS_IS_ENABLED;
 
   ASSERT (!pool_is_free (pg->streams, s));
 
-  vec_validate (pg->enabled_streams, s->worker_index);
-  pg->enabled_streams[s->worker_index] =
-    clib_bitmap_set (pg->enabled_streams[s->worker_index], s - pg->streams,
-		     want_enabled);
-
   if (want_enabled)
     {
       vnet_hw_interface_set_flags (vnm, pi->hw_if_index,
@@ -80,20 +125,33 @@ pg_stream_enable_disable (pg_main_t * pg, pg_stream_t * s, int want_enabled)
 				   VNET_SW_INTERFACE_FLAG_ADMIN_UP);
     }
 
-  if (vlib_num_workers ())
-    vm = vlib_get_worker_vlib_main (s->worker_index);
-  else
-    vm = vlib_get_main ();
-
-  vlib_node_set_state (vm, pg_input_node.index,
-		       (clib_bitmap_is_zero
-			(pg->enabled_streams[s->worker_index]) ?
-			VLIB_NODE_STATE_DISABLED : VLIB_NODE_STATE_POLLING));
+  for (shard = 0; shard < s->n_shards; shard++)
+    {
+      /* Shards without a share of the packet limit stay idle */
+      if (want_enabled && s->shards && s->n_packets_limit > 0
+	  && s->shards[shard].n_packets_limit == 0)
+	continue;
+      pg_stream_set_worker (pg, s, pg_stream_shard_worker (s, shard),
+			    want_enabled);
+    }
 
   s->packet_accumulator = 0;
   s->time_last_generate = 0;
 }
 
+/*
+ * Called by the worker of a shard of a prebuilt stream once it has
+ * generated its share of the packets. The stream is disabled once all
+ * its shards are done.
+ */
+void
+pg_stream_shard_done (pg_main_t * pg, pg_stream_t * s, u32 shard)
+{
+  pg_stream_set_worker (pg, s, pg_stream_shard_worker (s, shard), 0);
+  if (clib_atomic_sub_fetch (&s->n_shards_active, 1) == 0)
+    s->flags &= ~PG_STREAM_FLAGS_IS_ENABLED;
+}
+
 static u8 *
 format_pg_output_trace (u8 * s, va_list * va)
 {
@@ -139,6 +197,54 @@ pg_interface_admin_up_down (vnet_main_t * vnm, u32 hw_if_index, u32 flags)
   return 0;
 }
 
+/*
+ * Software stand-in for NIC flow offload, so that the users of the flow
+ * infra can be tested without hardware: pg-input marks the packets which
+ * match a flow enabled on the interface. Packets are only marked, redirect
+ * actions are accepted but packets keep following the input path of the
+ * stream, like on a NIC which can only mark.
+ */
+static int
+pg_flow_ops_fn (vnet_main_t * vnm, vnet_flow_dev_op_t op, u32 dev_instance,
+		u32 flow_index, uword * private_data)
+{
+  pg_main_t *pg = &pg_main;
+  pg_interface_t *pi = pool_elt_at_index (pg->interfaces, dev_instance);
+  vnet_flow_t *flow = vnet_get_flow (flow_index);
+  u32 i;
+
+  if (op == VNET_FLOW_DEV_OP_DEL_FLOW)
+    {
+      i = vec_search (pi->flow_indices, flow_index);
+      if (i == ~0)
+	return VNET_FLOW_ERROR_NO_SUCH_ENTRY;
+      vec_del1 (pi->flow_indices, i);
+      return 0;
+    }
+
+  if (op != VNET_FLOW_DEV_OP_ADD_FLOW)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  if ((flow->actions & VNET_FLOW_ACTION_MARK) == 0 ||
+      (flow->actions & ~(VNET_FLOW_ACTION_MARK | VNET_FLOW_ACTION_COUNT |
+			 VNET_FLOW_ACTION_REDIRECT_TO_NODE)))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  switch (flow->type)
+    {
+    case VNET_FLOW_TYPE_IP4_N_TUPLE:
+    case VNET_FLOW_TYPE_IP4_VXLAN:
+    case VNET_FLOW_TYPE_IP4_GTPU:
+      break;
+    default:
+      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+    }
+
+  vec_add1 (pi->flow_indices, flow_index);
+  *private_data = flow_index;
+  return 0;
+}
+
 /* *INDENT-OFF* */
 VNET_DEVICE_CLASS (pg_dev_class) = {
   .name = "pg",
@@ -146,6 +252,7 @@ VNET_DEVICE_CLASS (pg_dev_class) = {
   .format_device_name = format_pg_interface_name,
   .format_tx_trace = format_pg_output_trace,
   .admin_up_down_function = pg_interface_admin_up_down,
+  .flow_ops_function = pg_flow_ops_fn,
 };
 /* *INDENT-ON* */
 
@@ -214,6 +321,9 @@ pg_interface_add_or_get (pg_main_t * pg, uword if_id)
 				   &pi->hw_if_index, pg_eth_flag_change);
       hi = vnet_get_hw_interface (vnm, pi->hw_if_index);
       pi->sw_if_index = hi->sw_if_index;
+      /* redirect actions of flows add their next nodes to pg-input */
+      vnet_hw_interface_set_input_node (vnm, pi->hw_if_index,
+					pg_input_node.index);
 
       hash_set (pg->if_index_by_if_id, if_id, i);
 
@@ -381,10 +491,37 @@ perform_fixed_edits (pg_stream_t * s)
   }
 }
 
-void
+/* Average size of the packets of the stream, for rates in bits/second */
+static f64
+pg_stream_average_packet_bytes (pg_stream_t * s)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u64 n_bytes = 0;
+  u32 i;
+
+  if (s->prebuilt_buffers)
+    {
+      for (i = 0; i < vec_len (s->prebuilt_buffers); i++)
+	n_bytes += vlib_buffer_index_length_in_chain (vm,
+						      s->prebuilt_buffers[i]);
+      return (f64) n_bytes / vec_len (s->prebuilt_buffers);
+    }
+
+  if (s->replay_packet_templates)
+    {
+      for (i = 0; i < vec_len (s->replay_packet_templates); i++)
+	n_bytes += vec_len (s->replay_packet_templates[i]);
+      return (f64) n_bytes / vec_len (s->replay_packet_templates);
+    }
+
+  return 0.5 * (s->min_packet_bytes + s->max_packet_bytes);
+}
+
+clib_error_t *
 pg_stream_add (pg_main_t * pg, pg_stream_t * s_init)
 {
   vlib_main_t *vm = vlib_get_main ();
+  clib_error_t *error;
   pg_stream_t *s;
   uword *p;
 
@@ -461,6 +598,27 @@ pg_stream_add (pg_main_t * pg, pg_stream_t * s_init)
   /* Connect the graph. */
   s->next_index = vlib_node_add_next (vm, device_input_node.index,
 				      s->node_index);
+
+  s->n_shards = clib_max (s->n_shards, 1);
+  if (s->n_prebuilt)
+    {
+      s->n_shards = clib_min (s->n_shards, clib_max (vlib_num_workers (), 1));
+      vec_validate_aligned (s->shards, s->n_shards - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      if ((error = pg_stream_prebuild (pg, s)))
+	{
+	  pg_stream_del (pg, s - pg->streams);
+	  return error;
+	}
+    }
+  else
+    s->n_shards = 1;
+
+  if (s->rate_bits_per_second > 0)
+    s->rate_packets_per_second = s->rate_bits_per_second /
+      (8 * pg_stream_average_packet_bytes (s));
+
+  return 0;
 }
 
 void
@@ -479,6 +637,11 @@ pg_stream_del (pg_main_t * pg, uword index)
     clib_fifo_free (bi->buffer_fifo);
   }
 
+  /* Packets still in flight keep the ring payloads they share */
+  if (s->prebuilt_buffers)
+    vlib_buffer_free (vlib_get_main (), s->prebuilt_buffers,
+		      vec_len (s->prebuilt_buffers));
+
   pg_stream_free (s);
   pool_put (pg->streams, s);
 }
@@ -369,6 +369,11 @@ app_worker_own_session (app_worker_t * app_wrk, session_t * s)
   if (app_worker_alloc_session_fifos (sm, s))
     return -1;
 
+  /* New rx fifo may start smaller than the old one */
+  while (svm_fifo_max_dequeue_cons (rxf) > s->rx_fifo->nitems)
+    if (segment_manager_grow_fifo (sm, s->rx_fifo))
+      return -1;
+
   if (!svm_fifo_is_empty_cons (rxf))
     svm_fifo_clone (s->rx_fifo, rxf);
 
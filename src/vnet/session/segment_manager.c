@@ -31,6 +31,12 @@ static u32 default_fifo_size = 1 << 12;
 static u32 default_segment_size = 1 << 20;
 static u32 default_app_evt_queue_size = 128;
 
+/**
+ * Number of consecutive low occupancy samples after which a growable fifo
+ * is shrunk
+ */
+#define SEGMENT_MANAGER_FIFO_SHRINK_SAMPLES 32
+
 segment_manager_properties_t *
 segment_manager_properties_get (segment_manager_t * sm)
 {
@@ -281,6 +287,22 @@ segment_manager_new ()
   return sm;
 }
 
+/**
+ * Size of newly allocated rx fifos
+ *
+ * If so configured, rx fifos start small and grow up to the size
+ * configured by the app.
+ */
+static u32
+segment_manager_rx_fifo_alloc_size (segment_manager_properties_t * props)
+{
+  u32 init_size = session_main.rx_fifo_initial_size;
+
+  if (!init_size || init_size >= props->rx_fifo_size)
+    return props->rx_fifo_size;
+  return 1 << max_log2 (clib_max (init_size, default_fifo_size));
+}
+
 /**
  * Initializes segment manager based on options provided.
  * Returns error if ssvm segment(s) allocation fails.
@@ -303,7 +325,8 @@ segment_manager_init (segment_manager_t * sm, u32 first_seg_size,
   if (prealloc_fifo_pairs)
     {
       /* Figure out how many segments should be preallocated */
-      rx_rounded_data_size = (1 << (max_log2 (props->rx_fifo_size)));
+      rx_rounded_data_size =
+	(1 << (max_log2 (segment_manager_rx_fifo_alloc_size (props))));
       tx_rounded_data_size = (1 << (max_log2 (props->tx_fifo_size)));
 
       rx_fifo_size = sizeof (svm_fifo_t) + rx_rounded_data_size;
@@ -331,7 +354,7 @@ segment_manager_init (segment_manager_t * sm, u32 first_seg_size,
 	    sm->event_queue = segment_manager_alloc_queue (segment, props);
 
 	  svm_fifo_segment_preallocate_fifo_pairs (segment,
-						   props->rx_fifo_size,
+						   rx_rounded_data_size,
 						   props->tx_fifo_size,
 						   &prealloc_fifo_pairs);
 	  svm_fifo_segment_flags (segment) = FIFO_SEGMENT_F_IS_PREALLOCATED;
@@ -520,9 +543,10 @@ segment_manager_alloc_session_fifos (segment_manager_t * sm,
   segment_manager_properties_t *props;
   u8 added_a_segment = 0;
   u64 segment_handle;
-  u32 sm_index;
+  u32 sm_index, rx_fifo_size;
 
   props = segment_manager_properties_get (sm);
+  rx_fifo_size = segment_manager_rx_fifo_alloc_size (props);
 
   /*
    * Find the first free segment to allocate the fifos in
@@ -531,7 +555,7 @@ segment_manager_alloc_session_fifos (segment_manager_t * sm,
   /* *INDENT-OFF* */
   segment_manager_foreach_segment_w_lock (fifo_segment, sm, ({
     alloc_fail = segment_manager_try_alloc_fifos (fifo_segment,
-                                                  props->rx_fifo_size,
+                                                  rx_fifo_size,
                                                   props->tx_fifo_size,
                                                   rx_fifo, tx_fifo);
     /* Exit with lock held, drop it after notifying app */
@@ -554,6 +578,8 @@ alloc_check:
       (*rx_fifo)->segment_manager = sm_index;
       (*tx_fifo)->segment_index = *fifo_segment_index;
       (*rx_fifo)->segment_index = *fifo_segment_index;
+      if (rx_fifo_size < props->rx_fifo_size)
+	(*rx_fifo)->flags |= SVM_FIFO_F_GROWABLE;
 
       if (added_a_segment)
 	{
@@ -585,7 +611,7 @@ alloc_check:
 	}
       fifo_segment = segment_manager_get_segment_w_lock (sm, new_fs_index);
       alloc_fail = segment_manager_try_alloc_fifos (fifo_segment,
-						    props->rx_fifo_size,
+						    rx_fifo_size,
 						    props->tx_fifo_size,
 						    rx_fifo, tx_fifo);
       added_a_segment = 1;
@@ -645,6 +671,99 @@ segment_manager_dealloc_fifos (svm_fifo_t * rx_fifo, svm_fifo_t * tx_fifo)
     segment_manager_segment_reader_unlock (sm);
 }
 
+/**
+ * Double the size of a fifo by adding a chunk from its segment
+ *
+ * Must be called by the fifo's producer.
+ */
+int
+segment_manager_grow_fifo (segment_manager_t * sm, svm_fifo_t * f)
+{
+  svm_fifo_segment_private_t *fs;
+  svm_fifo_chunk_t *c;
+  int rv = -1;
+
+  if (!svm_fifo_can_grow (f))
+    return -1;
+
+  fs = segment_manager_get_segment_w_lock (sm, f->segment_index);
+  c = svm_fifo_segment_alloc_chunk (fs, f->size);
+  if (c && (rv = svm_fifo_add_chunk (f, c)))
+    svm_fifo_segment_free_chunks (fs, c);
+  segment_manager_segment_reader_unlock (sm);
+
+  return rv;
+}
+
+/**
+ * Free chunk retired by a previous shrink, once the consumer released it
+ */
+static void
+segment_manager_reclaim_fifo_chunk (segment_manager_t * sm, svm_fifo_t * f)
+{
+  svm_fifo_segment_private_t *fs;
+  svm_fifo_chunk_t *c;
+
+  if (!(c = svm_fifo_reclaim_chunk (f)))
+    return;
+
+  fs = segment_manager_get_segment_w_lock (sm, f->segment_index);
+  svm_fifo_segment_free_chunks (fs, c);
+  segment_manager_segment_reader_unlock (sm);
+}
+
+/**
+ * Resize growable fifo ahead of enqueueing n_bytes
+ *
+ * Fifo grows if the enqueue would leave less than a quarter of it free,
+ * which would also limit the window advertised by the transport. It
+ * shrinks if it is found empty after occupancy stayed under a quarter of
+ * its size for a number of consecutive samples. The removed chunk is
+ * returned to the segment only after the consumer let go of it, see
+ * svm_fifo_del_chunk. Must be called by the fifo's producer.
+ */
+void
+segment_manager_tune_fifo (svm_fifo_t * f, u32 n_bytes)
+{
+  segment_manager_properties_t *props;
+  segment_manager_t *sm;
+  u32 cursize;
+
+  if (!(sm = segment_manager_get_if_valid (f->segment_manager)))
+    return;
+
+  if (PREDICT_FALSE (f->retired_chunk != 0))
+    segment_manager_reclaim_fifo_chunk (sm, f);
+
+  cursize = svm_fifo_max_dequeue_prod (f);
+  if (cursize + n_bytes > f->size - (f->size >> 2))
+    {
+      props = segment_manager_properties_get (sm);
+      if (f->size < props->rx_fifo_size)
+	segment_manager_grow_fifo (sm, f);
+      f->n_low_hwm = 0;
+      f->hwm = f->size;
+      return;
+    }
+
+  f->hwm = clib_max (f->hwm, cursize + n_bytes);
+  if (cursize)
+    return;
+
+  /* Empty fifo, sample occupancy since last time it was empty */
+  if (f->hwm < (f->size >> 2) && f->size > f->default_chunk.length)
+    {
+      if (++f->n_low_hwm >= SEGMENT_MANAGER_FIFO_SHRINK_SAMPLES)
+	{
+	  svm_fifo_del_chunk (f);
+	  f->n_low_hwm = 0;
+	}
+    }
+  else
+    f->n_low_hwm = 0;
+  f->hwm = n_bytes;
+}
+
 u32
 segment_manager_evt_q_expected_size (u32 q_len)
 {
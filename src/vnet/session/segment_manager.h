@@ -159,6 +159,8 @@ int segment_manager_try_alloc_fifos (svm_fifo_segment_private_t * fs,
 				     svm_fifo_t ** tx_fifo);
 void segment_manager_dealloc_fifos (svm_fifo_t * rx_fifo,
 				    svm_fifo_t * tx_fifo);
+int segment_manager_grow_fifo (segment_manager_t * sm, svm_fifo_t * f);
+void segment_manager_tune_fifo (svm_fifo_t * f, u32 n_bytes);
 u32 segment_manager_evt_q_expected_size (u32 q_size);
 svm_msg_q_t *segment_manager_alloc_queue (svm_fifo_segment_private_t * fs,
 					  segment_manager_properties_t *
@@ -363,6 +363,10 @@ session_enqueue_stream_connection (transport_connection_t * tc,
 
   if (is_in_order)
     {
+      if (PREDICT_FALSE (s->rx_fifo->flags & SVM_FIFO_F_GROWABLE))
+	segment_manager_tune_fifo (s->rx_fifo,
+				   vlib_buffer_length_in_chain
+				   (vlib_get_main (), b));
       enqueued = svm_fifo_enqueue_nowait (s->rx_fifo,
 					  b->current_length,
 					  vlib_buffer_get_current (b));
@@ -1538,6 +1542,14 @@ session_config_fn (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "evt_qs_memfd_seg"))
 	smm->evt_qs_use_memfd_seg = 1;
+      else if (unformat (input, "rx-fifo-initial-size %U",
+			 unformat_memory_size, &tmp))
+	{
+	  if (tmp >= 0x100000000ULL)
+	    return clib_error_return (0, "memory size %llx (%lld) too large",
+				      tmp, tmp);
+	  smm->rx_fifo_initial_size = tmp;
+	}
       else if (unformat (input, "evt_qs_seg_size %U", unformat_memory_size,
 			 &smm->evt_qs_segment_size))
 	;
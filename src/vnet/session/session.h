@@ -168,6 +168,10 @@ typedef struct session_main_
   /** Preallocate session config parameter */
   u32 preallocated_sessions;
 
+  /** Initial size of rx fifos that grow and shrink with occupancy. If 0,
+   * rx fifos are allocated with the size configured by the app */
+  u32 rx_fifo_initial_size;
+
 #if SESSION_DEBUG
   /**
    * last event poll time by thread
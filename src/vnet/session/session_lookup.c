@@ -74,18 +74,6 @@ typedef CLIB_PACKED (struct {
 }) v6_connection_key_t;
 /* *INDENT-ON* */
 
-typedef clib_bihash_kv_16_8_t session_kv4_t;
-typedef clib_bihash_kv_48_8_t session_kv6_t;
-
-always_inline void
-make_v4_ss_kv (session_kv4_t * kv, ip4_address_t * lcl, ip4_address_t * rmt,
-	       u16 lcl_port, u16 rmt_port, u8 proto)
-{
-  kv->key[0] = (u64) rmt->as_u32 << 32 | (u64) lcl->as_u32;
-  kv->key[1] = (u64) proto << 32 | (u64) rmt_port << 16 | (u64) lcl_port;
-  kv->value = ~0ULL;
-}
-
 always_inline void
 make_v4_listener_kv (session_kv4_t * kv, ip4_address_t * lcl, u16 lcl_port,
 		     u8 proto)
@@ -836,6 +824,73 @@ session_lookup_half_open_connection (u64 handle, u8 proto, u8 is_ip4)
   return 0;
 }
 
+/**
+ * Map established session table value to its transport connection
+ */
+always_inline transport_connection_t *
+session_lookup_established4_i (u64 value, u8 proto, u32 thread_index,
+			       u8 * result)
+{
+  session_t *s;
+
+  if (PREDICT_FALSE ((u32) (value >> 32) != thread_index))
+    {
+      *result = SESSION_LOOKUP_RESULT_WRONG_THREAD;
+      return 0;
+    }
+  s = session_get (value & 0xFFFFFFFFULL, thread_index);
+  return transport_get_connection (proto, s->connection_index, thread_index);
+}
+
+/**
+ * Finish an ip4 lookup that did not match an established session, i.e.,
+ * try half-open connections, the session rules table and listeners.
+ */
+always_inline transport_connection_t *
+session_lookup_not_established4_i (session_table_t * st, session_kv4_t * kv4,
+				   ip4_address_t * lcl, ip4_address_t * rmt,
+				   u16 lcl_port, u16 rmt_port, u8 proto,
+				   u8 * result)
+{
+  session_t *s;
+  u32 action_index;
+  int rv;
+
+  /*
+   * Try half-open connections
+   */
+  rv = clib_bihash_search_inline_16_8 (&st->v4_half_open_hash, kv4);
+  if (rv == 0)
+    return transport_get_half_open (proto, kv4->value & 0xFFFFFFFF);
+
+  /*
+   * Check the session rules table
+   */
+  action_index = session_rules_table_lookup4 (&st->session_rules[proto], lcl,
+					      rmt, lcl_port, rmt_port);
+  if (session_lookup_action_index_is_valid (action_index))
+    {
+      if (action_index == SESSION_RULES_TABLE_ACTION_DROP)
+	{
+	  *result = SESSION_LOOKUP_RESULT_FILTERED;
+	  return 0;
+	}
+      if ((s = session_lookup_action_to_session (action_index,
+						 FIB_PROTOCOL_IP4, proto)))
+	return transport_get_listener (proto, s->connection_index);
+      return 0;
+    }
+
+  /*
+   * If nothing is found, check if any listener is available
+   */
+  s = session_lookup_listener4_i (st, lcl, lcl_port, proto, 1);
+  if (s)
+    return transport_get_listener (proto, s->connection_index);
+
+  return 0;
+}
+
 /**
  * Lookup connection with ip4 and transport layer information
  *
@@ -870,8 +925,6 @@ session_lookup_connection_wt4 (u32 fib_index, ip4_address_t * lcl,
 {
   session_table_t *st;
   session_kv4_t kv4;
-  session_t *s;
-  u32 action_index;
   int rv;
 
   st = session_table_get_for_fib_index (FIB_PROTOCOL_IP4, fib_index);
@@ -884,50 +937,88 @@ session_lookup_connection_wt4 (u32 fib_index, ip4_address_t * lcl,
   make_v4_ss_kv (&kv4, lcl, rmt, lcl_port, rmt_port, proto);
   rv = clib_bihash_search_inline_16_8 (&st->v4_session_hash, &kv4);
   if (rv == 0)
-    {
-      if (PREDICT_FALSE ((u32) (kv4.value >> 32) != thread_index))
-	{
-	  *result = SESSION_LOOKUP_RESULT_WRONG_THREAD;
-	  return 0;
-	}
-      s = session_get (kv4.value & 0xFFFFFFFFULL, thread_index);
-      return transport_get_connection (proto, s->connection_index,
-				       thread_index);
-    }
+    return session_lookup_established4_i (kv4.value, proto, thread_index,
+					  result);
 
-  /*
-   * Try half-open connections
-   */
-  rv = clib_bihash_search_inline_16_8 (&st->v4_half_open_hash, &kv4);
-  if (rv == 0)
-    return transport_get_half_open (proto, kv4.value & 0xFFFFFFFF);
+  return session_lookup_not_established4_i (st, &kv4, lcl, rmt, lcl_port,
+					    rmt_port, proto, result);
+}
 
-  /*
-   * Check the session rules table
-   */
-  action_index = session_rules_table_lookup4 (&st->session_rules[proto], lcl,
-					      rmt, lcl_port, rmt_port);
-  if (session_lookup_action_index_is_valid (action_index))
+/**
+ * Batched lookup of connections with ip4 and transport layer information
+ *
+ * Equivalent to calling @ref session_lookup_connection_wt4 for each key
+ * but consecutive keys of the same fib are resolved against the
+ * established sessions table with one @ref clib_bihash_search_batch_16_8
+ * call, which overlaps the cache misses of large tables. Keys that do not
+ * match an established session fall back to the half-open, rules and
+ * listener lookups.
+ *
+ * @param fib_indices	per key index of fib wherein the connection was
+ * 			received
+ * @param kvs		keys built with @ref make_v4_ss_kv
+ * @param n_keys	number of keys
+ * @param thread_index	thread index for request
+ * @param tcs		per key returned transport connection, 0 if none found
+ * @param results	per key lookup result, see @ref session_lookup_result_t
+ */
+void
+session_lookup_connection_wt4_batch (u32 * fib_indices, session_kv4_t * kvs,
+				     u32 n_keys, u32 thread_index,
+				     transport_connection_t ** tcs,
+				     u8 * results)
+{
+  u8 found[SESSION_LOOKUP_BATCH_SIZE];
+  ip4_address_t lcl, rmt;
+  session_table_t *st;
+  u16 lcl_port, rmt_port;
+  u32 i, n;
+  u8 proto;
+
+  while (n_keys > 0)
     {
-      if (action_index == SESSION_RULES_TABLE_ACTION_DROP)
+      /* Run of keys received in the same fib, i.e., looked up in the
+       * same table */
+      for (n = 1; n < clib_min (n_keys, SESSION_LOOKUP_BATCH_SIZE); n++)
+	if (fib_indices[n] != fib_indices[0])
+	  break;
+
+      st = session_table_get_for_fib_index (FIB_PROTOCOL_IP4,
+					    fib_indices[0]);
+      if (PREDICT_FALSE (!st))
+	clib_memset (found, 0, n);
+      else
+	clib_bihash_search_batch_16_8 (&st->v4_session_hash, kvs, found, n);
+
+      for (i = 0; i < n; i++)
 	{
-	  *result = SESSION_LOOKUP_RESULT_FILTERED;
-	  return 0;
+	  tcs[i] = 0;
+	  results[i] = SESSION_LOOKUP_RESULT_NONE;
+	  if (PREDICT_FALSE (!st))
+	    continue;
+	  proto = kvs[i].key[1] >> 32;
+	  if (found[i])
+	    {
+	      tcs[i] = session_lookup_established4_i (kvs[i].value, proto,
+						      thread_index,
+						      &results[i]);
+	      continue;
+	    }
+	  lcl.as_u32 = kvs[i].key[0];
+	  rmt.as_u32 = kvs[i].key[0] >> 32;
+	  lcl_port = kvs[i].key[1];
+	  rmt_port = kvs[i].key[1] >> 16;
+	  tcs[i] = session_lookup_not_established4_i (st, &kvs[i], &lcl, &rmt,
+						      lcl_port, rmt_port,
+						      proto, &results[i]);
 	}
-      if ((s = session_lookup_action_to_session (action_index,
-						 FIB_PROTOCOL_IP4, proto)))
-	return transport_get_listener (proto, s->connection_index);
-      return 0;
-    }
 
-  /*
-   * If nothing is found, check if any listener is available
-   */
-  s = session_lookup_listener4_i (st, lcl, lcl_port, proto, 1);
-  if (s)
-    return transport_get_listener (proto, s->connection_index);
-
-  return 0;
+      fib_indices += n;
+      kvs += n;
+      tcs += n;
+      results += n;
+      n_keys -= n;
+    }
 }
 
 /**
@@ -29,6 +29,22 @@ typedef enum session_lookup_result_
   SESSION_LOOKUP_RESULT_FILTERED
 } session_lookup_result_t;
 
+/** Number of keys resolved per batched lookup pass, one batch of the
+ * session table bihash. Bounds the number of bucket prefetches in flight. */
+#define SESSION_LOOKUP_BATCH_SIZE BIHASH_SEARCH_BATCH_SIZE
+
+typedef clib_bihash_kv_16_8_t session_kv4_t;
+typedef clib_bihash_kv_48_8_t session_kv6_t;
+
+always_inline void
+make_v4_ss_kv (session_kv4_t * kv, ip4_address_t * lcl, ip4_address_t * rmt,
+	       u16 lcl_port, u16 rmt_port, u8 proto)
+{
+  kv->key[0] = (u64) rmt->as_u32 << 32 | (u64) lcl->as_u32;
+  kv->key[1] = (u64) proto << 32 | (u64) rmt_port << 16 | (u64) lcl_port;
+  kv->value = ~0ULL;
+}
+
 session_t *session_lookup_safe4 (u32 fib_index, ip4_address_t * lcl,
 				 ip4_address_t * rmt, u16 lcl_port,
 				 u16 rmt_port, u8 proto);
@@ -42,6 +58,11 @@ transport_connection_t *session_lookup_connection_wt4 (u32 fib_index,
 						       u16 rmt_port, u8 proto,
 						       u32 thread_index,
 						       u8 * is_filtered);
+void session_lookup_connection_wt4_batch (u32 * fib_indices,
+					  session_kv4_t * kvs, u32 n_keys,
+					  u32 thread_index,
+					  transport_connection_t ** tcs,
+					  u8 * results);
 transport_connection_t *session_lookup_connection4 (u32 fib_index,
 						    ip4_address_t * lcl,
 						    ip4_address_t * rmt,
@@ -348,15 +348,17 @@ session_tx_trace_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_buffer_t *b;
   int i;
 
-  for (i = 0; i < clib_min (n_trace, n_segs); i++)
+  for (i = 0; i < n_segs && n_trace > 0; i++)
     {
       b = vlib_get_buffer (vm, to_next[i - n_segs]);
-      vlib_trace_buffer (vm, node, next_index, b, 1 /* follow_chain */ );
+      if (!vlib_trace_buffer (vm, node, next_index, b, 1 /* follow_chain */ ))
+	continue;
       t = vlib_add_trace (vm, node, b, sizeof (*t));
       t->session_index = s->session_index;
       t->server_thread_index = s->thread_index;
+      n_trace--;
     }
-  vlib_set_trace_count (vm, node, n_trace - i);
+  vlib_set_trace_count (vm, node, n_trace);
 }
 
 always_inline void
@@ -602,6 +604,21 @@ session_tx_set_dequeue_params (vlib_main_t * vm, session_tx_context_t * ctx,
       ctx->max_len_to_snd = ctx->snd_space;
     }
 
+  n_bytes_per_buf = vlib_buffer_get_default_data_size (vm);
+  ASSERT (n_bytes_per_buf > TRANSPORT_MAX_HDRS_LEN);
+
+  /* If egress can segment, build super-segments that are a multiple of
+   * mss and leave it to the interface, or its driver, to cut them */
+  if (transport_connection_is_tx_gso (ctx->tc)
+      && ctx->max_len_to_snd > ctx->snd_mss)
+    {
+      u32 max_gso_sz = clib_min (TRANSPORT_MAX_GSO_SZ,
+				 255 * n_bytes_per_buf -
+				 TRANSPORT_MAX_HDRS_LEN);
+      max_gso_sz -= max_gso_sz % ctx->snd_mss;
+      ctx->snd_mss = clib_min (ctx->max_len_to_snd, max_gso_sz);
+    }
+
   /* Check if we're tx constrained by the node */
   ctx->n_segs_per_evt = ceil ((f64) ctx->max_len_to_snd / ctx->snd_mss);
   if (ctx->n_segs_per_evt > max_segs)
@@ -610,8 +627,6 @@ session_tx_set_dequeue_params (vlib_main_t * vm, session_tx_context_t * ctx,
       ctx->max_len_to_snd = max_segs * ctx->snd_mss;
     }
 
-  n_bytes_per_buf = vlib_buffer_get_default_data_size (vm);
-  ASSERT (n_bytes_per_buf > TRANSPORT_MAX_HDRS_LEN);
   n_bytes_per_seg = TRANSPORT_MAX_HDRS_LEN + ctx->snd_mss;
   ctx->n_bufs_per_seg = ceil ((f64) n_bytes_per_seg / n_bytes_per_buf);
   ctx->deq_per_buf = clib_min (ctx->snd_mss, n_bytes_per_buf);
@@ -199,6 +199,16 @@ transport_connection_is_tx_paced (transport_connection_t * tc)
   return (tc->flags & TRANSPORT_CONNECTION_F_IS_TX_PACED);
 }
 
+/**
+ * Check if transport connection egress supports generic segmentation
+ * offload, i.e., if the transport can be handed super-segments
+ */
+always_inline u8
+transport_connection_is_tx_gso (transport_connection_t * tc)
+{
+  return (tc->flags & TRANSPORT_CONNECTION_F_IS_TX_GSO);
+}
+
 u8 *format_transport_pacer (u8 * s, va_list * args);
 
 /**
@@ -21,6 +21,7 @@
 #include <vnet/tcp/tcp_debug.h>
 
 #define TRANSPORT_MAX_HDRS_LEN    100	/* Max number of bytes for headers */
+#define TRANSPORT_MAX_GSO_SZ      (65535 - TRANSPORT_MAX_HDRS_LEN)	/* Max GSO payload */
 
 typedef enum transport_dequeue_type_
 {
@@ -121,6 +122,7 @@ typedef struct _transport_connection
 } transport_connection_t;
 
 #define TRANSPORT_CONNECTION_F_IS_TX_PACED	1 << 0
+#define TRANSPORT_CONNECTION_F_IS_TX_GSO	1 << 1
 
 typedef enum _transport_proto
 {
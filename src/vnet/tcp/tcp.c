@@ -623,6 +623,39 @@ tcp_enable_pacing (tcp_connection_t * tc)
   tc->mrtt_us = (u32) ~ 0;
 }
 
+/**
+ * Enable TSO if the interface the peer resolves through supports GSO.
+ *
+ * Multipath and unresolved destinations are left alone, since there's no
+ * single egress interface to check.
+ */
+static void
+tcp_connection_check_tso (tcp_connection_t * tc)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_interface_t *hw;
+  fib_node_index_t fei;
+  fib_prefix_t prefix;
+  u32 sw_if_index;
+
+  clib_memset (&prefix, 0, sizeof (prefix));
+  clib_memcpy_fast (&prefix.fp_addr, &tc->c_rmt_ip, sizeof (prefix.fp_addr));
+  prefix.fp_proto = tc->c_is_ip4 ? FIB_PROTOCOL_IP4 : FIB_PROTOCOL_IP6;
+  prefix.fp_len = tc->c_is_ip4 ? 32 : 128;
+
+  fei = fib_table_lookup (tc->c_fib_index, &prefix);
+  if (fei == FIB_NODE_INDEX_INVALID)
+    return;
+
+  sw_if_index = fib_entry_get_resolving_interface (fei);
+  if (sw_if_index == ~0)
+    return;
+
+  hw = vnet_get_sup_hw_interface (vnm, sw_if_index);
+  if (hw->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)
+    tc->c_flags |= TRANSPORT_CONNECTION_F_IS_TX_GSO;
+}
+
 /** Initialize tcp connection variables
  *
  * Should be called after having received a msg from the peer, i.e., a SYN or
@@ -645,6 +678,9 @@ tcp_connection_init_vars (tcp_connection_t * tc)
   if (transport_connection_is_tx_paced (&tc->connection)
       || tcp_main.tx_pacing)
     tcp_enable_pacing (tc);
+
+  if (tcp_main.tso)
+    tcp_connection_check_tso (tc);
 }
 
 static int
@@ -1621,6 +1657,8 @@ tcp_config_fn (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "no-tx-pacing"))
 	tm->tx_pacing = 0;
+      else if (unformat (input, "tso"))
+	tm->tso = 1;
       else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
 			 &tm->cc_algo))
 	;
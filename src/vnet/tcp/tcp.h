@@ -485,6 +485,9 @@ typedef struct _tcp_main
   /** Enable tx pacing for new connections */
   u8 tx_pacing;
 
+  /** Send super-segments on connections whose egress supports GSO */
+  u8 tso;
+
   u8 punt_unknown4;
   u8 punt_unknown6;
 
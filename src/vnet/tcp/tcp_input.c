@@ -3341,6 +3341,19 @@ tcp_input_set_error_next (tcp_main_t * tm, u16 * next, u32 * error, u8 is_ip4)
     }
 }
 
+static inline void
+tcp_input_set_buffer_meta (vlib_buffer_t * b, tcp_header_t * tcp,
+			   int n_advance_bytes, int n_data_bytes)
+{
+  vnet_buffer (b)->tcp.seq_number = clib_net_to_host_u32 (tcp->seq_number);
+  vnet_buffer (b)->tcp.ack_number = clib_net_to_host_u32 (tcp->ack_number);
+  vnet_buffer (b)->tcp.data_offset = n_advance_bytes;
+  vnet_buffer (b)->tcp.data_len = n_data_bytes;
+  vnet_buffer (b)->tcp.seq_end = vnet_buffer (b)->tcp.seq_number
+    + n_data_bytes;
+  vnet_buffer (b)->tcp.flags = 0;
+}
+
 static inline tcp_connection_t *
 tcp_input_lookup_buffer (vlib_buffer_t * b, u8 thread_index, u32 * error,
 			 u8 is_ip4)
@@ -3411,19 +3424,122 @@ tcp_input_lookup_buffer (vlib_buffer_t * b, u8 thread_index, u32 * error,
 					  thread_index, &result);
     }
 
-  vnet_buffer (b)->tcp.seq_number = clib_net_to_host_u32 (tcp->seq_number);
-  vnet_buffer (b)->tcp.ack_number = clib_net_to_host_u32 (tcp->ack_number);
-  vnet_buffer (b)->tcp.data_offset = n_advance_bytes;
-  vnet_buffer (b)->tcp.data_len = n_data_bytes;
-  vnet_buffer (b)->tcp.seq_end = vnet_buffer (b)->tcp.seq_number
-    + n_data_bytes;
-  vnet_buffer (b)->tcp.flags = 0;
+  tcp_input_set_buffer_meta (b, tcp, n_advance_bytes, n_data_bytes);
 
   *error = result ? TCP_ERROR_NONE + result : *error;
 
   return tcp_get_connection_from_transport (tc);
 }
 
+/**
+ * Lookup connections for a vector of ip4 buffers
+ *
+ * Headers are parsed and validated SESSION_LOOKUP_BATCH_SIZE buffers at a
+ * time and the resulting keys are resolved with one batched session
+ * lookup, so that the session table cache misses of a batch overlap.
+ */
+static inline void
+tcp4_input_lookup_buffers (vlib_buffer_t ** b, u32 n_bufs, u32 thread_index,
+			   tcp_connection_t ** tcs, u32 * errors)
+{
+  transport_connection_t *tcs_batch[SESSION_LOOKUP_BATCH_SIZE];
+  u32 fib_indices[SESSION_LOOKUP_BATCH_SIZE];
+  u32 indices[SESSION_LOOKUP_BATCH_SIZE];
+  session_kv4_t kvs[SESSION_LOOKUP_BATCH_SIZE];
+  u8 results[SESSION_LOOKUP_BATCH_SIZE];
+  int n_advance_bytes, n_data_bytes, ip_hdr_bytes;
+  u32 i, j, n, n_keys;
+  tcp_header_t *tcp;
+  ip4_header_t *ip4;
+
+  for (i = 0; i < clib_min (n_bufs, SESSION_LOOKUP_BATCH_SIZE); i++)
+    {
+      vlib_prefetch_buffer_header (b[i], STORE);
+      CLIB_PREFETCH (b[i]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
+    }
+
+  for (i = 0; i < n_bufs; i += n)
+    {
+      n = clib_min (n_bufs - i, SESSION_LOOKUP_BATCH_SIZE);
+      n_keys = 0;
+
+      for (j = i; j < i + n; j++)
+	{
+	  if (j + SESSION_LOOKUP_BATCH_SIZE < n_bufs)
+	    {
+	      vlib_buffer_t *pb = b[j + SESSION_LOOKUP_BATCH_SIZE];
+	      vlib_prefetch_buffer_header (pb, STORE);
+	      CLIB_PREFETCH (pb->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
+	    }
+
+	  tcs[j] = 0;
+	  errors[j] = TCP_ERROR_NO_LISTENER;
+
+	  ip4 = vlib_buffer_get_current (b[j]);
+	  ip_hdr_bytes = ip4_header_bytes (ip4);
+	  if (PREDICT_FALSE (b[j]->current_length
+			     < ip_hdr_bytes + sizeof (*tcp)))
+	    {
+	      errors[j] = TCP_ERROR_LENGTH;
+	      continue;
+	    }
+	  tcp = ip4_next_header (ip4);
+	  vnet_buffer (b[j])->tcp.hdr_offset = (u8 *) tcp - (u8 *) ip4;
+	  n_advance_bytes = (ip_hdr_bytes + tcp_header_bytes (tcp));
+	  n_data_bytes = clib_net_to_host_u16 (ip4->length) - n_advance_bytes;
+
+	  /* Length check. Checksum computed by ipx_local no need to compute
+	   * again */
+	  if (PREDICT_FALSE (n_data_bytes < 0))
+	    {
+	      errors[j] = TCP_ERROR_LENGTH;
+	      continue;
+	    }
+
+	  make_v4_ss_kv (&kvs[n_keys], &ip4->dst_address, &ip4->src_address,
+			 tcp->dst_port, tcp->src_port, TRANSPORT_PROTO_TCP);
+	  fib_indices[n_keys] = vnet_buffer (b[j])->ip.fib_index;
+	  indices[n_keys++] = j;
+
+	  tcp_input_set_buffer_meta (b[j], tcp, n_advance_bytes,
+				     n_data_bytes);
+	}
+
+      session_lookup_connection_wt4_batch (fib_indices, kvs, n_keys,
+					   thread_index, tcs_batch, results);
+
+      for (j = 0; j < n_keys; j++)
+	{
+	  tcs[indices[j]] = tcp_get_connection_from_transport (tcs_batch[j]);
+	  if (results[j])
+	    errors[indices[j]] = TCP_ERROR_NONE + results[j];
+	}
+    }
+}
+
+/**
+ * Lookup connections for a vector of ip6 buffers, one buffer at a time
+ */
+static inline void
+tcp6_input_lookup_buffers (vlib_buffer_t ** b, u32 n_bufs, u32 thread_index,
+			   tcp_connection_t ** tcs, u32 * errors)
+{
+  u32 i;
+
+  for (i = 0; i < n_bufs; i++)
+    {
+      if (i + 2 < n_bufs)
+	{
+	  vlib_prefetch_buffer_header (b[i + 2], STORE);
+	  CLIB_PREFETCH (b[i + 2]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
+	}
+
+      errors[i] = TCP_ERROR_NO_LISTENER;
+      tcs[i] = tcp_input_lookup_buffer (b[i], thread_index, &errors[i],
+					0 /* is_ip4 */ );
+    }
+}
+
 static inline void
 tcp_input_dispatch_buffer (tcp_main_t * tm, tcp_connection_t * tc,
 			   vlib_buffer_t * b, u16 * next, u32 * error)
@@ -3457,6 +3573,8 @@ tcp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 n_left_from, *from, thread_index = vm->thread_index;
   tcp_main_t *tm = vnet_get_tcp_main ();
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  tcp_connection_t *tcs[VLIB_FRAME_SIZE], **tc;
+  u32 errors[VLIB_FRAME_SIZE], *error;
   u16 nexts[VLIB_FRAME_SIZE], *next;
 
   tcp_set_time_now (tcp_get_worker (thread_index));
@@ -3465,87 +3583,32 @@ tcp46_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   n_left_from = frame->n_vectors;
   vlib_get_buffers (vm, from, bufs, n_left_from);
 
+  if (is_ip4)
+    tcp4_input_lookup_buffers (bufs, n_left_from, thread_index, tcs, errors);
+  else
+    tcp6_input_lookup_buffers (bufs, n_left_from, thread_index, tcs, errors);
+
   b = bufs;
   next = nexts;
+  tc = tcs;
+  error = errors;
 
-  while (n_left_from >= 4)
-    {
-      u32 error0 = TCP_ERROR_NO_LISTENER, error1 = TCP_ERROR_NO_LISTENER;
-      tcp_connection_t *tc0, *tc1;
-
-      {
-	vlib_prefetch_buffer_header (b[2], STORE);
-	CLIB_PREFETCH (b[2]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-
-	vlib_prefetch_buffer_header (b[3], STORE);
-	CLIB_PREFETCH (b[3]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-      }
-
-      next[0] = next[1] = TCP_INPUT_NEXT_DROP;
-
-      tc0 = tcp_input_lookup_buffer (b[0], thread_index, &error0, is_ip4);
-      tc1 = tcp_input_lookup_buffer (b[1], thread_index, &error1, is_ip4);
-
-      if (PREDICT_TRUE (!tc0 + !tc1 == 0))
-	{
-	  ASSERT (tcp_lookup_is_valid (tc0, tcp_buffer_hdr (b[0])));
-	  ASSERT (tcp_lookup_is_valid (tc1, tcp_buffer_hdr (b[1])));
-
-	  vnet_buffer (b[0])->tcp.connection_index = tc0->c_c_index;
-	  vnet_buffer (b[1])->tcp.connection_index = tc1->c_c_index;
-
-	  tcp_input_dispatch_buffer (tm, tc0, b[0], &next[0], &error0);
-	  tcp_input_dispatch_buffer (tm, tc1, b[1], &next[1], &error1);
-	}
-      else
-	{
-	  if (PREDICT_TRUE (tc0 != 0))
-	    {
-	      ASSERT (tcp_lookup_is_valid (tc0, tcp_buffer_hdr (b[0])));
-	      vnet_buffer (b[0])->tcp.connection_index = tc0->c_c_index;
-	      tcp_input_dispatch_buffer (tm, tc0, b[0], &next[0], &error0);
-	    }
-	  else
-	    tcp_input_set_error_next (tm, &next[0], &error0, is_ip4);
-
-	  if (PREDICT_TRUE (tc1 != 0))
-	    {
-	      ASSERT (tcp_lookup_is_valid (tc1, tcp_buffer_hdr (b[1])));
-	      vnet_buffer (b[1])->tcp.connection_index = tc1->c_c_index;
-	      tcp_input_dispatch_buffer (tm, tc1, b[1], &next[1], &error1);
-	    }
-	  else
-	    tcp_input_set_error_next (tm, &next[1], &error1, is_ip4);
-	}
-
-      b += 2;
-      next += 2;
-      n_left_from -= 2;
-    }
   while (n_left_from > 0)
     {
-      tcp_connection_t *tc0;
-      u32 error0 = TCP_ERROR_NO_LISTENER;
-
-      if (n_left_from > 1)
-	{
-	  vlib_prefetch_buffer_header (b[1], STORE);
-	  CLIB_PREFETCH (b[1]->data, 2 * CLIB_CACHE_LINE_BYTES, LOAD);
-	}
-
       next[0] = TCP_INPUT_NEXT_DROP;
-      tc0 = tcp_input_lookup_buffer (b[0], thread_index, &error0, is_ip4);
-      if (PREDICT_TRUE (tc0 != 0))
+      if (PREDICT_TRUE (tc[0] != 0))
 	{
-	  ASSERT (tcp_lookup_is_valid (tc0, tcp_buffer_hdr (b[0])));
-	  vnet_buffer (b[0])->tcp.connection_index = tc0->c_c_index;
-	  tcp_input_dispatch_buffer (tm, tc0, b[0], &next[0], &error0);
+	  ASSERT (tcp_lookup_is_valid (tc[0], tcp_buffer_hdr (b[0])));
+	  vnet_buffer (b[0])->tcp.connection_index = tc[0]->c_c_index;
+	  tcp_input_dispatch_buffer (tm, tc[0], b[0], &next[0], &error[0]);
 	}
       else
-	tcp_input_set_error_next (tm, &next[0], &error0, is_ip4);
+	tcp_input_set_error_next (tm, &next[0], &error[0], is_ip4);
 
       b += 1;
       next += 1;
+      tc += 1;
+      error += 1;
       n_left_from -= 1;
     }
 
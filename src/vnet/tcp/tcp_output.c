@@ -1102,6 +1102,15 @@ tcp_push_hdr_i (tcp_connection_t * tc, vlib_buffer_t * b, u32 snd_nxt,
 			     tc->rcv_nxt, tcp_hdr_opts_len, flags,
 			     advertise_wnd);
 
+  /* Super-segment built by the session layer, let egress segment it */
+  if (PREDICT_FALSE (data_len > tc->snd_mss))
+    {
+      ASSERT (transport_connection_is_tx_gso (&tc->connection));
+      b->flags |= VNET_BUFFER_F_GSO;
+      vnet_buffer2 (b)->gso_size = tc->snd_mss;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_hdr_opts_len;
+    }
+
   if (maybe_burst)
     {
       clib_memcpy_fast ((u8 *) (th + 1),
@@ -2035,6 +2044,11 @@ tcp_output_push_ip (vlib_main_t * vm, vlib_buffer_t * b0,
       vnet_buffer (b0)->l4_hdr_offset = (u8 *) th0 - b0->data;
       th0->checksum = 0;
     }
+
+  /* Software segmentation, if needed, relies on valid header offsets */
+  if (PREDICT_FALSE (b0->flags & VNET_BUFFER_F_GSO))
+    b0->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID
+      | VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
 }
 
 always_inline void
@@ -23,6 +23,7 @@
 #include <vlib/vlib.h>
 #include <vnet/pg/pg.h>
 #include <vnet/vxlan-gpe/vxlan_gpe.h>
+#include <vppinfra/lookup_cache_16_8.h>
 
 /**
  * @brief Struct for VXLAN GPE decap packet tracing
@@ -83,6 +84,17 @@ format_vxlan_gpe_with_length (u8 * s, va_list * args)
   return s;
 }
 
+/*
+ * Node runtime data. The first byte keeps the stats sw_if_index of the
+ * last packet of the previous frame.
+ */
+typedef struct
+{
+  u8 stats_sw_if_index;
+  /* ip4 tunnel lookup cache gate, kept across frames */
+  clib_lookup_cache_16_8_gate_t gate4;
+} vxlan_gpe_input_runtime_t;
+
 /**
  * @brief Common processing for IPv4 and IPv6 VXLAN GPE decap dispatch functions
  *
@@ -113,6 +125,9 @@ vxlan_gpe_input (vlib_main_t * vm,
   vnet_interface_main_t *im = &vnm->interface_main;
   u32 last_tunnel_index = ~0;
   vxlan4_gpe_tunnel_key_t last_key4;
+  vxlan_gpe_input_runtime_t *rt = (void *) node->runtime_data;
+  clib_lookup_cache_16_8_t cache4;
+  u32 n_key_changes4 = 0;
   vxlan6_gpe_tunnel_key_t last_key6;
   u32 ip4_pkts_decapsulated = 0;
   u32 ip6_pkts_decapsulated = 0;
@@ -120,7 +135,10 @@ vxlan_gpe_input (vlib_main_t * vm,
   u32 stats_sw_if_index, stats_n_packets, stats_n_bytes;
 
   if (is_ip4)
-    clib_memset (&last_key4, 0xff, sizeof (last_key4));
+    {
+      clib_memset (&last_key4, 0xff, sizeof (last_key4));
+      clib_lookup_cache_16_8_init (&cache4, &rt->gate4);
+    }
   else
     clib_memset (&last_key6, 0xff, sizeof (last_key6));
 
@@ -148,6 +166,7 @@ vxlan_gpe_input (vlib_main_t * vm,
 	  u32 tunnel_index0, tunnel_index1;
 	  vxlan_gpe_tunnel_t *t0, *t1;
 	  vxlan4_gpe_tunnel_key_t key4_0, key4_1;
+	  clib_bihash_kv_16_8_t kv0, kv1;
 	  vxlan6_gpe_tunnel_key_t key6_0, key6_1;
 	  u32 error0, error1;
 	  u32 sw_if_index0, sw_if_index1, len0, len1;
@@ -270,17 +289,25 @@ vxlan_gpe_input (vlib_main_t * vm,
 				 || (key4_0.as_u64[1] !=
 				     last_key4.as_u64[1])))
 		{
-		  p0 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key, &key4_0);
-
-		  if (p0 == 0)
+		  kv0.key[0] = key4_0.as_u64[0];
+		  kv0.key[1] = key4_0.as_u64[1];
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv0))
 		    {
-		      error0 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
-		      goto trace0;
+		      p0 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key,
+					 &key4_0);
+
+		      if (p0 == 0)
+			{
+			  error0 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
+			  goto trace0;
+			}
+		      kv0.value = p0[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv0);
 		    }
-
 		  last_key4.as_u64[0] = key4_0.as_u64[0];
 		  last_key4.as_u64[1] = key4_0.as_u64[1];
-		  tunnel_index0 = last_tunnel_index = p0[0];
+		  tunnel_index0 = last_tunnel_index = kv0.value;
 		}
 	      else
 		tunnel_index0 = last_tunnel_index;
@@ -388,17 +415,25 @@ vxlan_gpe_input (vlib_main_t * vm,
 				 || (key4_1.as_u64[1] !=
 				     last_key4.as_u64[1])))
 		{
-		  p1 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key, &key4_1);
-
-		  if (p1 == 0)
+		  kv1.key[0] = key4_1.as_u64[0];
+		  kv1.key[1] = key4_1.as_u64[1];
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv1))
 		    {
-		      error1 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
-		      goto trace1;
+		      p1 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key,
+					 &key4_1);
+
+		      if (p1 == 0)
+			{
+			  error1 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
+			  goto trace1;
+			}
+		      kv1.value = p1[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv1);
 		    }
-
 		  last_key4.as_u64[0] = key4_1.as_u64[0];
 		  last_key4.as_u64[1] = key4_1.as_u64[1];
-		  tunnel_index1 = last_tunnel_index = p1[0];
+		  tunnel_index1 = last_tunnel_index = kv1.value;
 		}
 	      else
 		tunnel_index1 = last_tunnel_index;
@@ -494,6 +529,7 @@ vxlan_gpe_input (vlib_main_t * vm,
 	  u32 tunnel_index0;
 	  vxlan_gpe_tunnel_t *t0;
 	  vxlan4_gpe_tunnel_key_t key4_0;
+	  clib_bihash_kv_16_8_t kv0;
 	  vxlan6_gpe_tunnel_key_t key6_0;
 	  u32 error0;
 	  u32 sw_if_index0, len0;
@@ -552,17 +588,25 @@ vxlan_gpe_input (vlib_main_t * vm,
 				 || (key4_0.as_u64[1] !=
 				     last_key4.as_u64[1])))
 		{
-		  p0 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key, &key4_0);
-
-		  if (p0 == 0)
+		  kv0.key[0] = key4_0.as_u64[0];
+		  kv0.key[1] = key4_0.as_u64[1];
+		  n_key_changes4++;
+		  if (clib_lookup_cache_16_8_search (&cache4, &kv0))
 		    {
-		      error0 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
-		      goto trace00;
+		      p0 = hash_get_mem (nngm->vxlan4_gpe_tunnel_by_key,
+					 &key4_0);
+
+		      if (p0 == 0)
+			{
+			  error0 = VXLAN_GPE_ERROR_NO_SUCH_TUNNEL;
+			  goto trace00;
+			}
+		      kv0.value = p0[0];
+		      clib_lookup_cache_16_8_add (&cache4, &kv0);
 		    }
-
 		  last_key4.as_u64[0] = key4_0.as_u64[0];
 		  last_key4.as_u64[1] = key4_0.as_u64[1];
-		  tunnel_index0 = last_tunnel_index = p0[0];
+		  tunnel_index0 = last_tunnel_index = kv0.value;
 		}
 	      else
 		tunnel_index0 = last_tunnel_index;
@@ -673,6 +717,10 @@ vxlan_gpe_input (vlib_main_t * vm,
 				       stats_n_packets, stats_n_bytes);
       node->runtime_data[0] = stats_sw_if_index;
     }
+  if (is_ip4)
+    clib_lookup_cache_16_8_gate_update (&rt->gate4, &cache4,
+					from_frame->n_vectors, n_key_changes4);
+
   return from_frame->n_vectors;
 }
 
@@ -745,6 +793,7 @@ VLIB_REGISTER_NODE (vxlan4_gpe_input_node) = {
   .name = "vxlan4-gpe-input",
   /* Takes a vector of packets. */
   .vector_size = sizeof (u32),
+  .runtime_data_bytes = sizeof (vxlan_gpe_input_runtime_t),
   .type = VLIB_NODE_TYPE_INTERNAL,
   .n_errors = ARRAY_LEN(vxlan_gpe_error_strings),
   .error_strings = vxlan_gpe_error_strings,
@@ -18,6 +18,7 @@
 #include <vlib/vlib.h>
 #include <vnet/pg/pg.h>
 #include <vnet/vxlan/vxlan.h>
+#include <vppinfra/lookup_cache_16_8.h>
 
 #ifndef CLIB_MARCH_VARIANT
 vlib_node_registration_t vxlan4_input_node;
@@ -60,8 +61,6 @@ buf_fib_index (vlib_buffer_t * b, u32 is_ip4)
   return vec_elt (fib_index_by_sw_if_index, sw_if_index);
 }
 
-typedef vxlan4_tunnel_key_t last_tunnel_cache4;
-
 static const vxlan_decap_info_t decap_not_found = {
   .sw_if_index = ~0,
   .next_index = VXLAN_INPUT_NEXT_DROP,
@@ -75,13 +74,83 @@ static const vxlan_decap_info_t decap_bad_flags = {
 };
 
 always_inline vxlan_decap_info_t
-vxlan4_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache4 * cache,
-		    u32 fib_index, ip4_header_t * ip4_0,
-		    vxlan_header_t * vxlan0, u32 * stats_sw_if_index)
+vxlan4_find_mcast_tunnel (vxlan_main_t * vxm, vxlan4_tunnel_key_t * key4,
+			  u32 * stats_sw_if_index)
+{
+  ip4_address_t dst = {.as_u32 = key4->key[0] >> 32 };
+  u32 src = (u32) key4->key[0];
+  int rv;
+
+  if (PREDICT_TRUE (!ip4_address_is_multicast (&dst)))
+    return decap_not_found;
+
+  /* search for mcast decap info by mcast address */
+  key4->key[0] = dst.as_u32;
+  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, key4);
+  if (rv != 0)
+    return decap_not_found;
+
+  /* search for unicast tunnel using the mcast tunnel local(src) ip */
+  vxlan_decap_info_t mdi = {.as_u64 = key4->value };
+  key4->key[0] = ((u64) mdi.local_ip.as_u32 << 32) | src;
+  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, key4);
+  if (PREDICT_FALSE (rv != 0))
+    return decap_not_found;
+
+  /* mcast traffic does not update the cache */
+  *stats_sw_if_index = mdi.sw_if_index;
+  vxlan_decap_info_t di = {.as_u64 = key4->value };
+  return di;
+}
+
+/* Trust the tunnel index marked by an offloaded rx flow */
+always_inline int
+vxlan4_find_flow_marked_tunnel (vxlan_main_t * vxm, vlib_buffer_t * b0,
+				vxlan_decap_info_t * di0,
+				u32 * stats_sw_if_index)
 {
+  u32 t_index = b0->flow_id - vxm->flow_id_start;
+
+  if (PREDICT_TRUE (b0->flow_id == 0) ||
+      t_index >= pool_len (vxm->tunnels) ||
+      pool_is_free_index (vxm->tunnels, t_index))
+    return 0;
+
+  vxlan_tunnel_t *t = pool_elt_at_index (vxm->tunnels, t_index);
+  vxlan_decap_info_t di = {
+    .sw_if_index = t->sw_if_index,
+    .next_index = t->decap_next_index,
+  };
+  *di0 = di;
+  *stats_sw_if_index = t->sw_if_index;
+  b0->flow_id = 0;
+  return 1;
+}
+
+/*
+ * Find the tunnel of one ip4 packet, used when packets keep their tunnel
+ * for a while: the previous key is compared, then the cache, which is
+ * off in that case, so that only the key changes are counted.
+ */
+always_inline vxlan_decap_info_t
+vxlan4_find_tunnel (vxlan_main_t * vxm, vxlan4_tunnel_key_t * last4,
+		    clib_lookup_cache_16_8_t * cache, u32 fib_index,
+		    ip4_header_t * ip4_0, vxlan_header_t * vxlan0,
+		    vlib_buffer_t * b0, u32 * stats_sw_if_index,
+		    u32 * n_flow_marked, u32 * n_key_changes)
+{
+  vxlan_decap_info_t di;
+
   if (PREDICT_FALSE (vxlan0->flags != VXLAN_FLAGS_I))
     return decap_bad_flags;
 
+  if (PREDICT_FALSE (vxlan4_find_flow_marked_tunnel (vxm, b0, &di,
+						     stats_sw_if_index)))
+    {
+      *n_flow_marked += 1;
+      return di;
+    }
+
   /* Make sure VXLAN tunnel exist according to packet S/D IP, VRF, and VNI */
   u32 dst = ip4_0->dst_address.as_u32;
   u32 src = ip4_0->src_address.as_u32;
@@ -91,44 +160,149 @@ vxlan4_find_tunnel (vxlan_main_t * vxm, last_tunnel_cache4 * cache,
   };
 
   if (PREDICT_TRUE
-      (key4.key[0] == cache->key[0] && key4.key[1] == cache->key[1]))
+      (key4.key[0] == last4->key[0] && key4.key[1] == last4->key[1]))
     {
-      /* cache hit */
-      vxlan_decap_info_t di = {.as_u64 = cache->value };
+      /* last key hit */
+      di.as_u64 = last4->value;
       *stats_sw_if_index = di.sw_if_index;
       return di;
     }
 
-  int rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
-  if (PREDICT_TRUE (rv == 0))
+  *n_key_changes += 1;
+  if (clib_lookup_cache_16_8_search (cache, &key4) &&
+      clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4))
+    /* try multicast, mcast traffic does not update the caches */
+    return vxlan4_find_mcast_tunnel (vxm, &key4, stats_sw_if_index);
+
+  clib_lookup_cache_16_8_add (cache, &key4);
+  *last4 = key4;
+  di.as_u64 = key4.value;
+  *stats_sw_if_index = di.sw_if_index;
+  return di;
+}
+
+always_inline void
+vxlan4_resolve_misses (vxlan_main_t * vxm, clib_lookup_cache_16_8_t * cache,
+		       vxlan4_tunnel_key_t * keys, u16 * miss, u32 n_miss,
+		       vxlan_decap_info_t * dis, u32 * stats_ifs)
+{
+  u8 found[BIHASH_SEARCH_BATCH_SIZE];
+  u32 i, j;
+
+  clib_bihash_search_batch_16_8 (&vxm->vxlan4_tunnel_by_key, keys, found,
+				 n_miss);
+
+  for (i = 0; i < n_miss; i++)
     {
-      *cache = key4;
-      vxlan_decap_info_t di = {.as_u64 = key4.value };
-      *stats_sw_if_index = di.sw_if_index;
-      return di;
+      j = miss[i];
+      if (PREDICT_TRUE (found[i]))
+	{
+	  clib_lookup_cache_16_8_add (cache, &keys[i]);
+	  dis[j].as_u64 = keys[i].value;
+	  stats_ifs[j] = dis[j].sw_if_index;
+	}
+      else
+	dis[j] = vxlan4_find_mcast_tunnel (vxm, &keys[i], &stats_ifs[j]);
     }
+}
 
-  /* try multicast */
-  if (PREDICT_TRUE (!ip4_address_is_multicast (&ip4_0->dst_address)))
-    return decap_not_found;
+/*
+ * Find the tunnels of a whole frame of ip4 packets, used when packets of
+ * several tunnels are interleaved. Keys are looked up in a small
+ * associative cache, which survives interleaved packets from a few
+ * tunnels, and the misses are resolved in batches so that their bucket
+ * and data fetches overlap. Packets with the same key as the previous one
+ * reuse its result, even if it was not resolved yet.
+ * Returns the number of packets found by their rx flow mark.
+ */
+always_inline u32
+vxlan4_find_tunnels (vxlan_main_t * vxm, clib_lookup_cache_16_8_t * cache,
+		     vlib_buffer_t ** b, u32 n_left,
+		     vxlan_decap_info_t * dis, u32 * stats_ifs,
+		     u32 * n_key_changes)
+{
+  vxlan4_tunnel_key_t keys[BIHASH_SEARCH_BATCH_SIZE], key4, last4;
+  u16 miss[BIHASH_SEARCH_BATCH_SIZE];
+  u8 same_as_prev[VLIB_FRAME_SIZE];
+  u32 i, n_miss = 0, n_same = 0, n_flow_marked = 0;
 
-  /* search for mcast decap info by mcast address */
-  key4.key[0] = dst;
-  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
-  if (rv != 0)
-    return decap_not_found;
+  clib_memset (&last4, 0xff, sizeof last4);
 
-  /* search for unicast tunnel using the mcast tunnel local(src) ip */
-  vxlan_decap_info_t mdi = {.as_u64 = key4.value };
-  key4.key[0] = ((u64) mdi.local_ip.as_u32 << 32) | src;
-  rv = clib_bihash_search_inline_16_8 (&vxm->vxlan4_tunnel_by_key, &key4);
-  if (PREDICT_FALSE (rv != 0))
-    return decap_not_found;
+  for (i = 0; i < n_left; i++)
+    {
+      if (i + 4 < n_left)
+	{
+	  vlib_prefetch_buffer_header (b[i + 4], LOAD);
+	  CLIB_PREFETCH (b[i + 2]->data, CLIB_CACHE_LINE_BYTES, LOAD);
+	}
 
-  /* mcast traffic does not update the cache */
-  *stats_sw_if_index = mdi.sw_if_index;
-  vxlan_decap_info_t di = {.as_u64 = key4.value };
-  return di;
+      /* udp leaves current_data pointing at the vxlan header */
+      vxlan_header_t *vxlan0 = vlib_buffer_get_current (b[i]);
+      ip4_header_t *ip4_0 = (void *) vxlan0 - sizeof (udp_header_t) -
+	sizeof (ip4_header_t);
+
+      same_as_prev[i] = 0;
+      if (PREDICT_FALSE (vxlan0->flags != VXLAN_FLAGS_I))
+	{
+	  dis[i] = decap_bad_flags;
+	  clib_memset (&last4, 0xff, sizeof last4);
+	  continue;
+	}
+
+      if (PREDICT_FALSE (vxlan4_find_flow_marked_tunnel (vxm, b[i], &dis[i],
+							 &stats_ifs[i])))
+	{
+	  clib_memset (&last4, 0xff, sizeof last4);
+	  n_flow_marked++;
+	  continue;
+	}
+
+      /* Make sure VXLAN tunnel exist by packet S/D IP, VRF, and VNI */
+      u32 dst = ip4_0->dst_address.as_u32;
+      u32 src = ip4_0->src_address.as_u32;
+      key4.key[0] = ((u64) dst << 32) | src;
+      key4.key[1] = ((u64) buf_fib_index (b[i], 1) << 32) |
+	vxlan0->vni_reserved;
+
+      if (clib_bihash_key_compare_16_8 (key4.key, last4.key))
+	{
+	  same_as_prev[i] = 1;
+	  n_same++;
+	  continue;
+	}
+      last4 = key4;
+
+      *n_key_changes += 1;
+      if (!clib_lookup_cache_16_8_search (cache, &key4))
+	{
+	  /* cache hit */
+	  dis[i].as_u64 = key4.value;
+	  stats_ifs[i] = dis[i].sw_if_index;
+	  continue;
+	}
+
+      keys[n_miss] = key4;
+      miss[n_miss++] = i;
+      if (n_miss == BIHASH_SEARCH_BATCH_SIZE)
+	{
+	  vxlan4_resolve_misses (vxm, cache, keys, miss, n_miss, dis,
+				 stats_ifs);
+	  n_miss = 0;
+	}
+    }
+
+  if (n_miss)
+    vxlan4_resolve_misses (vxm, cache, keys, miss, n_miss, dis, stats_ifs);
+
+  if (n_same)
+    for (i = 1; i < n_left; i++)
+      if (same_as_prev[i])
+	{
+	  dis[i] = dis[i - 1];
+	  stats_ifs[i] = stats_ifs[i - 1];
+	}
+
+  return n_flow_marked;
 }
 
 typedef vxlan6_tunnel_key_t last_tunnel_cache6;
@@ -198,22 +372,37 @@ vxlan_input (vlib_main_t * vm,
   vnet_interface_main_t *im = &vnm->interface_main;
   vlib_combined_counter_main_t *rx_counter =
     im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX;
-  last_tunnel_cache4 last4;
+  clib_lookup_cache_16_8_gate_t *gate = (void *) node->runtime_data;
+  clib_lookup_cache_16_8_t cache4;
+  vxlan4_tunnel_key_t last4;
   last_tunnel_cache6 last6;
-  u32 pkts_dropped = 0;
+  u32 pkts_dropped = 0, pkts_flow_marked = 0, n_key_changes4 = 0;
+  int is_batched = 0;
   u32 thread_index = vlib_get_thread_index ();
 
-  if (is_ip4)
-    clib_memset (&last4, 0xff, sizeof last4);
-  else
-    clib_memset (&last6, 0xff, sizeof last6);
-
   u32 *from = vlib_frame_vector_args (from_frame);
   u32 n_left_from = from_frame->n_vectors;
 
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
   vlib_get_buffers (vm, from, bufs, n_left_from);
 
+  vxlan_decap_info_t dis[VLIB_FRAME_SIZE], *di = dis;
+  u32 stats_ifs[VLIB_FRAME_SIZE], *stats_if = stats_ifs;
+  if (is_ip4)
+    {
+      clib_memset (&last4, 0xff, sizeof last4);
+      clib_lookup_cache_16_8_init (&cache4, gate);
+      /* keys changed often in the previous frames, find all the tunnels
+       * of the frame first */
+      is_batched = clib_lookup_cache_16_8_is_enabled (&cache4);
+      if (is_batched)
+	pkts_flow_marked = vxlan4_find_tunnels (vxm, &cache4, b, n_left_from,
+						dis, stats_ifs,
+						&n_key_changes4);
+    }
+  else
+    clib_memset (&last6, 0xff, sizeof last6);
+
   u32 stats_if0 = ~0, stats_if1 = ~0;
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
   while (n_left_from >= 4)
@@ -246,15 +435,31 @@ vxlan_input (vlib_main_t * vm,
       vlib_buffer_advance (b[0], sizeof *vxlan0);
       vlib_buffer_advance (b[1], sizeof *vxlan1);
 
-      u32 fi0 = buf_fib_index (b[0], is_ip4);
-      u32 fi1 = buf_fib_index (b[1], is_ip4);
-
-      vxlan_decap_info_t di0 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan0, &stats_if0) :
-	vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
-      vxlan_decap_info_t di1 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi1, ip4_1, vxlan1, &stats_if1) :
-	vxlan6_find_tunnel (vxm, &last6, fi1, ip6_1, vxlan1, &stats_if1);
+      vxlan_decap_info_t di0, di1;
+      if (is_ip4 && is_batched)
+	{
+	  /* ip4 tunnels were found for the whole frame already */
+	  di0 = di[0];
+	  di1 = di[1];
+	  stats_if0 = stats_if[0];
+	  stats_if1 = stats_if[1];
+	}
+      else
+	{
+	  u32 fi0 = buf_fib_index (b[0], is_ip4);
+	  u32 fi1 = buf_fib_index (b[1], is_ip4);
+
+	  di0 = is_ip4 ?
+	    vxlan4_find_tunnel (vxm, &last4, &cache4, fi0, ip4_0, vxlan0,
+				b[0], &stats_if0, &pkts_flow_marked,
+				&n_key_changes4) :
+	    vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
+	  di1 = is_ip4 ?
+	    vxlan4_find_tunnel (vxm, &last4, &cache4, fi1, ip4_1, vxlan1,
+				b[1], &stats_if1, &pkts_flow_marked,
+				&n_key_changes4) :
+	    vxlan6_find_tunnel (vxm, &last6, fi1, ip6_1, vxlan1, &stats_if1);
+	}
 
       /* Prefetch next iteration. */
       CLIB_PREFETCH (b[2]->data, CLIB_CACHE_LINE_BYTES, LOAD);
@@ -331,6 +536,8 @@ vxlan_input (vlib_main_t * vm,
 	}
       b += 2;
       next += 2;
+      di += 2;
+      stats_if += 2;
       n_left_from -= 2;
     }
 
@@ -349,11 +556,22 @@ vxlan_input (vlib_main_t * vm,
       /* pop (ip, udp, vxlan) */
       vlib_buffer_advance (b[0], sizeof (*vxlan0));
 
-      u32 fi0 = buf_fib_index (b[0], is_ip4);
+      vxlan_decap_info_t di0;
+      if (is_ip4 && is_batched)
+	{
+	  di0 = di[0];
+	  stats_if0 = stats_if[0];
+	}
+      else
+	{
+	  u32 fi0 = buf_fib_index (b[0], is_ip4);
 
-      vxlan_decap_info_t di0 = is_ip4 ?
-	vxlan4_find_tunnel (vxm, &last4, fi0, ip4_0, vxlan0, &stats_if0) :
-	vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
+	  di0 = is_ip4 ?
+	    vxlan4_find_tunnel (vxm, &last4, &cache4, fi0, ip4_0, vxlan0,
+				b[0], &stats_if0, &pkts_flow_marked,
+				&n_key_changes4) :
+	    vxlan6_find_tunnel (vxm, &last6, fi0, ip6_0, vxlan0, &stats_if0);
+	}
 
       uword len0 = vlib_buffer_length_in_chain (vm, b[0]);
 
@@ -389,13 +607,21 @@ vxlan_input (vlib_main_t * vm,
 	}
       b += 1;
       next += 1;
+      di += 1;
+      stats_if += 1;
       n_left_from -= 1;
     }
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, from_frame->n_vectors);
+  if (is_ip4)
+    clib_lookup_cache_16_8_gate_update (gate, &cache4,
+					from_frame->n_vectors, n_key_changes4);
   /* Do we still need this now that tunnel tx stats is kept? */
   u32 node_idx = is_ip4 ? vxlan4_input_node.index : vxlan6_input_node.index;
   vlib_node_increment_counter (vm, node_idx, VXLAN_ERROR_DECAPSULATED,
 			       from_frame->n_vectors - pkts_dropped);
+  if (pkts_flow_marked)
+    vlib_node_increment_counter (vm, node_idx, VXLAN_ERROR_FLOW_MARKED,
+				 pkts_flow_marked);
 
   return from_frame->n_vectors;
 }
@@ -425,6 +651,7 @@ VLIB_REGISTER_NODE (vxlan4_input_node) =
 {
   .name = "vxlan4-input",
   .vector_size = sizeof (u32),
+  .runtime_data_bytes = sizeof (clib_lookup_cache_16_8_gate_t),
   .n_errors = VXLAN_N_ERROR,
   .error_strings = vxlan_error_strings,
   .n_next_nodes = VXLAN_INPUT_N_NEXT,
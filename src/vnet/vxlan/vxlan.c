@@ -691,6 +691,7 @@ vxlan_add_del_tunnel_command_fn (vlib_main_t * vm,
   u32 instance = ~0;
   u32 encap_fib_index = 0;
   u32 mcast_sw_if_index = ~0;
+  u32 offload_hw_if_index = ~0;
   u32 decap_next_index = VXLAN_INPUT_NEXT_L2_INPUT;
   u32 vni = 0;
   u32 table_id;
@@ -738,6 +739,10 @@ vxlan_add_del_tunnel_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "vni %d", &vni))
 	;
+      else if (unformat (line_input, "offload %U",
+			 unformat_vnet_hw_interface, vnet_get_main (),
+			 &offload_hw_if_index))
+	;
       else
 	{
 	  parse_error = clib_error_return (0, "parse error: '%U'",
@@ -784,6 +789,9 @@ vxlan_add_del_tunnel_command_fn (vlib_main_t * vm,
   if (vni >> 24)
     return clib_error_return (0, "vni %d out of range", vni);
 
+  if (offload_hw_if_index != ~0 && (ipv6_set || grp_set))
+    return clib_error_return (0, "offload only supports ip4 unicast tunnels");
+
   vnet_vxlan_add_del_tunnel_args_t a = {
     .is_add = is_add,
     .is_ip6 = ipv6_set,
@@ -802,6 +810,11 @@ vxlan_add_del_tunnel_command_fn (vlib_main_t * vm,
       if (is_add)
 	vlib_cli_output (vm, "%U\n", format_vnet_sw_if_index_name,
 			 vnet_get_main (), tunnel_sw_if_index);
+      if (is_add && offload_hw_if_index != ~0 &&
+	  vnet_vxlan_add_del_rx_flow (offload_hw_if_index,
+				      vnet_vxlan_get_tunnel_index
+				      (tunnel_sw_if_index), 1 /* is_add */ ))
+	return clib_error_return (0, "error enabling flow");
       break;
 
     case VNET_API_ERROR_TUNNEL_EXIST:
@@ -842,6 +855,9 @@ vxlan_add_del_tunnel_command_fn (vlib_main_t * vm,
  * @cliexcmd{create vxlan tunnel src 10.0.3.1 dst 10.0.3.3 instance 42}
  * Example of how to create a multicast VXLAN Tunnel with a known name, vxlan_tunnel23:
  * @cliexcmd{create vxlan tunnel src 10.0.3.1 group 239.1.1.1 GigabitEthernet0/8/0 instance 23}
+ * Example of how to create a VXLAN Tunnel which rx packets are marked by
+ * a flow on the underlay interface, for an O(1) tunnel lookup on decap:
+ * @cliexcmd{create vxlan tunnel src 10.0.3.1 dst 10.0.3.3 vni 13 offload GigabitEthernet0/8/0}
  * Example of how to delete a VXLAN Tunnel:
  * @cliexcmd{create vxlan tunnel src 10.0.3.1 dst 10.0.3.3 vni 13 del}
  ?*/
@@ -852,7 +868,8 @@ VLIB_CLI_COMMAND (create_vxlan_tunnel_command, static) = {
   "create vxlan tunnel src <local-vtep-addr>"
   " {dst <remote-vtep-addr>|group <mcast-vtep-addr> <intf-name>} vni <nn>"
   " [instance <id>]"
-  " [encap-vrf-id <nn>] [decap-next [l2|node <name>]] [del]",
+  " [encap-vrf-id <nn>] [decap-next [l2|node <name>]]"
+  " [offload <hw-intf-name>] [del]",
   .function = vxlan_add_del_tunnel_command_fn,
 };
 /* *INDENT-ON* */
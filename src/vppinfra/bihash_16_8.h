@@ -74,6 +74,46 @@ clib_bihash_key_compare_16_8 (u64 * a, u64 * b)
 #endif
 }
 
+#if defined (CLIB_HAVE_VEC512) || defined (CLIB_HAVE_VEC256)
+#define BIHASH_HAVE_PAGE_SEARCH 1
+
+/* Compare key against all BIHASH_KVP_PER_PAGE pairs of a page, returns
+   index of the matching pair or -1 */
+static inline int
+clib_bihash_page_search_16_8 (clib_bihash_kv_16_8_t * kvp, u64 * key)
+{
+  u64 *p = kvp->key;
+#if defined (CLIB_HAVE_VEC512)
+  /* first 64 bytes hold the keys of pairs 0 to 2 in lanes 0-1, 3-4, 6-7 */
+  u64x8 k = { key[0], key[1], 0, key[0], key[1], 0, key[0], key[1] };
+  u32 diff = u64x8_is_zero_mask (u64x8_load_unaligned (p) ^ k);
+  u32 hit = ~(diff | (diff >> 1)) & 0x49;
+
+  if (hit)
+    return count_trailing_zeros (hit) / 3;
+  return clib_bihash_key_compare_16_8 (p + 9, key) ? 3 : -1;
+#else
+  /* byte masks of matching u64s, 12 u64s hold the 4 pairs */
+  u64x4 k0 = { key[0], key[1], 0, key[0] };
+  u64x4 k1 = { key[1], 0, key[0], key[1] };
+  u64x4 k2 = { 0, key[0], key[1], 0 };
+  u32 m0 = u8x32_msb_mask ((u8x32) (u64x4_load_unaligned (p) == k0));
+  u32 m1 = u8x32_msb_mask ((u8x32) (u64x4_load_unaligned (p + 4) == k1));
+  u32 m2 = u8x32_msb_mask ((u8x32) (u64x4_load_unaligned (p + 8) == k2));
+
+  if ((m0 & 0xffff) == 0xffff)
+    return 0;
+  if ((m0 >> 24) == 0xff && (m1 & 0xff) == 0xff)
+    return 1;
+  if ((m1 >> 16) == 0xffff)
+    return 2;
+  if (((m2 >> 8) & 0xffff) == 0xffff)
+    return 3;
+  return -1;
+#endif
+}
+#endif
+
 #undef __included_bihash_template_h__
 #include <vppinfra/bihash_template.h>
 
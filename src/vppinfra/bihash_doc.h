@@ -165,6 +165,22 @@ void clib_bihash_prefetch_data (clib_bihash * h, u64 hash);
 int clib_bihash_search_inline_2
   (clib_bihash * h, clib_bihash_kv * search_key, clib_bihash_kv * valuep);
 
+/** Search a bi-hash table for a vector of keys
+
+    Hashes are computed and buckets prefetched for groups of
+    BIHASH_SEARCH_BATCH_SIZE keys, then bucket data is prefetched and
+    finally keys are compared, so that cache misses of a group overlap.
+
+    @param h - the bi-hash table to search
+    @param key_results - vector of (key,value) pairs containing the search
+     keys. Values of keys that are found are set.
+    @param found - per key result, 1 if found, 0 otherwise
+    @param n_keys - number of keys
+    @returns number of keys found
+*/
+u32 clib_bihash_search_batch
+  (clib_bihash * h, clib_bihash_kv * key_results, u8 * found, u32 n_keys);
+
 /** Visit active (key,value) pairs in a bi-hash table
 
     @param h - the bi-hash table to search
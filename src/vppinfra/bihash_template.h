@@ -401,6 +401,96 @@ static inline int BV (clib_bihash_search_inline_2)
 						     valuep);
 }
 
+#ifndef BIHASH_SEARCH_BATCH_SIZE
+#define BIHASH_SEARCH_BATCH_SIZE 16
+#endif
+
+static inline int BV (clib_bihash_search_page)
+  (BVT (clib_bihash_value) * v, int limit, BVT (clib_bihash_kv) * search_key)
+{
+  int i;
+
+#ifdef BIHASH_HAVE_PAGE_SEARCH
+  /* Variant provides a compare of a whole page at once */
+  if (PREDICT_TRUE (limit == BIHASH_KVP_PER_PAGE))
+    return BV (clib_bihash_page_search) (v->kvp, search_key->key);
+#endif
+
+  for (i = 0; i < limit; i++)
+    if (BV (clib_bihash_key_compare) (v->kvp[i].key, search_key->key))
+      return i;
+  return -1;
+}
+
+static inline u32 BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * key_results, u8 * found,
+   u32 n_keys)
+{
+  u64 hashes[BIHASH_SEARCH_BATCH_SIZE], hash;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_bucket) * b;
+  u32 i, n, n_found = 0;
+  int j, limit;
+
+  while (n_keys > 0)
+    {
+      n = clib_min (n_keys, BIHASH_SEARCH_BATCH_SIZE);
+
+      /* Hash all keys and prefetch their buckets */
+      for (i = 0; i < n; i++)
+	{
+	  hashes[i] = BV (clib_bihash_hash) (&key_results[i]);
+	  BV (clib_bihash_prefetch_bucket) (h, hashes[i]);
+	}
+
+      /* Buckets of the first keys should be in cache, prefetch data */
+      for (i = 0; i < n; i++)
+	BV (clib_bihash_prefetch_data) (h, hashes[i]);
+
+      /* Compare keys */
+      for (i = 0; i < n; i++)
+	{
+	  found[i] = 0;
+	  b = &h->buckets[hashes[i] & (h->nbuckets - 1)];
+
+	  if (PREDICT_FALSE (BV (clib_bihash_bucket_is_empty) (b)))
+	    continue;
+
+	  if (PREDICT_FALSE (b->lock))
+	    {
+	      volatile BVT (clib_bihash_bucket) * bv = b;
+	      while (bv->lock)
+		CLIB_PAUSE ();
+	    }
+
+	  hash = hashes[i] >> h->log2_nbuckets;
+	  v = BV (clib_bihash_get_value) (h, b->offset);
+
+	  /* If the bucket has unresolvable collisions, use linear search */
+	  limit = BIHASH_KVP_PER_PAGE;
+	  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
+	  if (PREDICT_FALSE (b->linear_search))
+	    limit <<= b->log2_pages;
+
+	  j = BV (clib_bihash_search_page) (v, limit, &key_results[i]);
+	  if (j >= 0)
+	    {
+	      key_results[i].value = v->kvp[j].value;
+	      found[i] = 1;
+	      n_found++;
+	    }
+	}
+
+      key_results += n;
+      found += n;
+      n_keys -= n;
+    }
+
+  return n_found;
+}
+
+/* Page search support is per variant */
+#undef BIHASH_HAVE_PAGE_SEARCH
 
 #endif /* __included_bihash_template_h__ */
 
@@ -475,9 +475,21 @@ elog_nsec_per_clock (elog_main_t * em)
 					    &em->init_time));
 }
 
+static void
+elog_thread_ring_alloc (elog_main_t * em, elog_thread_ring_t * r)
+{
+  vec_free (r->event_ring);
+  r->n_total_events = 0;
+  r->event_ring_size = em->event_ring_size;
+  vec_resize_aligned (r->event_ring, r->event_ring_size,
+		      CLIB_CACHE_LINE_BYTES);
+}
+
 void
 elog_alloc (elog_main_t * em, u32 n_events)
 {
+  elog_thread_ring_t *r;
+
   if (em->event_ring)
     vec_free (em->event_ring);
 
@@ -487,6 +499,28 @@ elog_alloc (elog_main_t * em, u32 n_events)
   /* Leave an empty ievent at end so we can always speculatively write
      and event there (possibly a long form event). */
   vec_resize_aligned (em->event_ring, n_events, CLIB_CACHE_LINE_BYTES);
+
+  /* Thread rings are the size of the main ring */
+  vec_foreach (r, em->thread_rings) elog_thread_ring_alloc (em, r);
+}
+
+void
+elog_thread_ring_add (elog_main_t * em, u32 thread_index,
+		      elog_track_t * track)
+{
+  elog_thread_ring_t *r;
+  word track_index;
+
+  track_index = (word) track->track_index_plus_one - 1;
+  if (track_index < 0)
+    track_index = elog_track_register (em, track);
+
+  vec_validate_aligned (em->thread_rings, thread_index,
+			CLIB_CACHE_LINE_BYTES);
+  r = vec_elt_at_index (em->thread_rings, thread_index);
+  r->track_index = track_index;
+  r->cpu_time_offset = 0;
+  elog_thread_ring_alloc (em, r);
 }
 
 void
@@ -512,10 +546,8 @@ elog_init (elog_main_t * em, u32 n_events)
 
 /* Returns number of events in ring and start index. */
 static uword
-elog_event_range (elog_main_t * em, uword * lo)
+elog_ring_event_range (u64 i, uword l, uword * lo)
 {
-  uword l = em->event_ring_size;
-  u64 i = em->n_total_events;
 
   /* Ring never wrapped? */
   if (i <= (u64) l)
@@ -532,30 +564,60 @@ elog_event_range (elog_main_t * em, uword * lo)
     }
 }
 
-elog_event_t *
-elog_peek_events (elog_main_t * em)
+static elog_event_t *
+elog_peek_ring_events (elog_main_t * em, elog_event_t * es,
+		       elog_event_t * ring, uword ring_size,
+		       u64 n_total_events, i64 cpu_time_offset)
 {
-  elog_event_t *e, *f, *es = 0;
+  elog_event_t *e, *f;
   uword i, j, n;
 
-  n = elog_event_range (em, &j);
+  n = elog_ring_event_range (n_total_events, ring_size, &j);
   for (i = 0; i < n; i++)
     {
       vec_add2 (es, e, 1);
-      f = vec_elt_at_index (em->event_ring, j);
+      f = vec_elt_at_index (ring, j);
       e[0] = f[0];
 
       /* Convert absolute time from cycles to seconds from start. */
       e->time =
-	(e->time_cycles -
-	 em->init_time.cpu) * em->cpu_timer.seconds_per_clock;
+	(f64) ((i64) (e->time_cycles - em->init_time.cpu) +
+	       cpu_time_offset) * em->cpu_timer.seconds_per_clock;
 
-      j = (j + 1) & (em->event_ring_size - 1);
+      j = (j + 1) & (ring_size - 1);
     }
 
   return es;
 }
 
+static int elog_cmp (void *a1, void *a2);
+
+elog_event_t *
+elog_peek_events (elog_main_t * em)
+{
+  elog_thread_ring_t *r;
+  elog_event_t *es = 0;
+  uword n_ring_events = 0;
+
+  es = elog_peek_ring_events (em, es, em->event_ring, em->event_ring_size,
+			      em->n_total_events, 0);
+
+  vec_foreach (r, em->thread_rings)
+  {
+    if (r->n_total_events == 0)
+      continue;
+    es = elog_peek_ring_events (em, es, r->event_ring, r->event_ring_size,
+				r->n_total_events, r->cpu_time_offset);
+    n_ring_events += 1;
+  }
+
+  /* Interleave the events of the rings */
+  if (n_ring_events)
+    vec_sort_with_function (es, elog_cmp);
+
+  return es;
+}
+
 /* Add a formatted string to the string table. */
 u32
 elog_string (elog_main_t * em, char *fmt, ...)
@@ -1059,6 +1121,117 @@ unserialize_elog_time_stamp (serialize_main_t * m, va_list * va)
   unserialize (m, unserialize_64, &st->cpu);
 }
 
+static u8 *
+format_elog_json_string (u8 * s, va_list * args)
+{
+  u8 *str = va_arg (*args, u8 *);
+  uword i, len = va_arg (*args, uword);
+
+  for (i = 0; i < len; i++)
+    {
+      if (str[i] == '"' || str[i] == '\\')
+	s = format (s, "\\%c", str[i]);
+      else if (str[i] < 0x20)
+	s = format (s, "\\u%04x", str[i]);
+      else
+	vec_add1 (s, str[i]);
+    }
+  return s;
+}
+
+/*
+ * Chrome trace event format: each event is an instant event named by
+ * its formatted text, on the thread of its track, with its time in
+ * microseconds.
+ */
+u8 *
+format_elog_chrome_trace (u8 * s, va_list * args)
+{
+  elog_main_t *em = va_arg (*args, elog_main_t *);
+  elog_event_t *e, *es = va_arg (*args, elog_event_t *);
+  elog_event_type_t *t;
+  elog_track_t *track;
+  u8 *name = 0;
+  char *cat;
+
+  s = format (s, "{\"traceEvents\":[\n");
+
+  vec_foreach (track, em->tracks)
+  {
+    s = format (s, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+		"\"tid\":%d,\"args\":{\"name\":\"%U\"}},\n",
+		(int) (track - em->tracks), format_elog_json_string,
+		track->name, (uword) strlen (track->name));
+  }
+
+  vec_foreach (e, es)
+  {
+    t = vec_elt_at_index (em->event_types, e->type);
+    cat = t->function ? t->function : "elog";
+    vec_reset_length (name);
+    name = format (name, "%U", format_elog_event, em, e);
+    s = format (s, "{\"name\":\"%U\",\"cat\":\"%U\",\"ph\":\"i\","
+		"\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n",
+		format_elog_json_string, name, (uword) vec_len (name),
+		format_elog_json_string, cat, (uword) strlen (cat),
+		e->track, e->time * 1e6);
+  }
+
+  /* No trailing comma in JSON arrays */
+  if (vec_len (s) >= 2 && s[vec_len (s) - 2] == ',')
+    _vec_len (s) -= 2;
+  s = format (s, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+  vec_free (name);
+  return s;
+}
+
+#ifdef CLIB_UNIX
+
+#include <unistd.h>
+#include <fcntl.h>
+
+clib_error_t *
+elog_write_chrome_trace (elog_main_t * em, char *clib_file, int flush_ring)
+{
+  clib_error_t *error = 0;
+  uword n_done = 0;
+  u8 *s;
+  int fd, n;
+
+  /* Free old events (cached) in case they have changed. */
+  if (flush_ring)
+    vec_free (em->events);
+  elog_get_events (em);
+
+  /* SMP logs can easily have local time paradoxes... */
+  vec_sort_with_function (em->events, elog_cmp);
+
+  fd = open (clib_file, O_CREAT | O_TRUNC | O_WRONLY, 0664);
+  if (fd < 0)
+    return clib_error_return_unix (0, "open `%s'", clib_file);
+
+  s = format (0, "%U", format_elog_chrome_trace, em, em->events);
+  while (n_done < vec_len (s))
+    {
+      n = write (fd, s + n_done, vec_len (s) - n_done);
+      if (n < 0)
+	{
+	  if (!unix_error_is_fatal (errno))
+	    continue;
+	  error = clib_error_return_unix (0, "write `%s'", clib_file);
+	  break;
+	}
+      n_done += n;
+    }
+
+  vec_free (s);
+  close (fd);
+  return error;
+}
+
+#endif /* CLIB_UNIX */
+
 static char *elog_serialize_magic = "elog v0";
 
 void
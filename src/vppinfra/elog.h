@@ -128,6 +128,33 @@ typedef struct
   u64 os_nsec;
 } elog_time_stamp_t;
 
+/** Per thread event ring.
+
+    Each thread logs to its own ring with plain stores, so logging
+    costs no atomic operation and no cache line is shared between
+    threads. Rings are merged with the main ring, in time order, when
+    events are collected. */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /** Number of events logged to the ring, by its thread only. */
+  u64 n_total_events;
+
+  /** Power of 2 size of the ring. */
+  u64 event_ring_size;
+
+  /** Vector of events (circular buffer). */
+  elog_event_t *event_ring;
+
+  /** Track of the ring events. */
+  u32 track_index;
+
+  /** CPU clock cycles to add to the thread time stamps to bring them
+     to the clock of the thread which initialized the log. */
+  i64 cpu_time_offset;
+} elog_thread_ring_t;
+
 typedef struct
 {
   /** Total number of events in buffer. */
@@ -177,6 +204,9 @@ typedef struct
 
   /** Vector of events converted to generic form after collection. */
   elog_event_t *events;
+
+  /** Vector of per thread event rings, indexed by thread index. */
+  elog_thread_ring_t *thread_rings;
 } elog_main_t;
 
 /** @brief Return number of events in the event-log buffer
@@ -187,7 +217,12 @@ typedef struct
 always_inline uword
 elog_n_events_in_buffer (elog_main_t * em)
 {
-  return clib_min (em->n_total_events, em->event_ring_size);
+  elog_thread_ring_t *r;
+  uword n = clib_min (em->n_total_events, em->event_ring_size);
+
+  vec_foreach (r, em->thread_rings)
+    n += clib_min (r->n_total_events, r->event_ring_size);
+  return n;
 }
 
 /** @brief Return number of events which can fit in the event buffer
@@ -197,7 +232,7 @@ elog_n_events_in_buffer (elog_main_t * em)
 always_inline uword
 elog_buffer_capacity (elog_main_t * em)
 {
-  return em->event_ring_size;
+  return em->event_ring_size * (1 + vec_len (em->thread_rings));
 }
 
 /** @brief Reset the event buffer
@@ -206,8 +241,11 @@ elog_buffer_capacity (elog_main_t * em)
 always_inline void
 elog_reset_buffer (elog_main_t * em)
 {
+  elog_thread_ring_t *r;
+
   em->n_total_events = 0;
   em->n_total_events_disable_limit = ~0;
+  vec_foreach (r, em->thread_rings) r->n_total_events = 0;
 }
 
 /** @brief Enable or disable event logging
@@ -216,8 +254,11 @@ elog_reset_buffer (elog_main_t * em)
 always_inline void
 elog_enable_disable (elog_main_t * em, int is_enabled)
 {
+  elog_thread_ring_t *r;
+
   em->n_total_events = 0;
   em->n_total_events_disable_limit = is_enabled ? ~0 : 0;
+  vec_foreach (r, em->thread_rings) r->n_total_events = 0;
 }
 
 /** @brief disable logging after specified number of ievents have been logged.
@@ -432,6 +473,64 @@ elog_data_inline (elog_main_t * em, elog_event_type_t * type,
   return elog_event_data_inline (em, type, track, clib_cpu_time_now ());
 }
 
+/** @brief Allocate an event in a per thread ring, to be filled in by
+    the caller
+
+    Not normally called directly; this function underlies the
+    ELOG_THREAD_DATA macro. Only the thread owning the ring may log to
+    it. Threads without a ring log to the main ring, on the default
+    track.
+
+    @param em elog_main_t *
+    @param thread_index u32 index of the calling thread
+    @param type elog_event_type_t * type
+    @param cpu_time u64 current cpu tick value
+    @returns event to be filled in
+*/
+always_inline void *
+elog_thread_event_data_inline (elog_main_t * em, u32 thread_index,
+			       elog_event_type_t * type, u64 cpu_time)
+{
+  elog_thread_ring_t *r;
+  elog_event_t *e;
+  word type_index;
+
+  /* Return the user dummy memory to scribble data into. */
+  if (PREDICT_FALSE (!elog_is_enabled (em)))
+    return em->dummy_event.data;
+
+  if (PREDICT_FALSE (thread_index >= vec_len (em->thread_rings)))
+    return elog_event_data (em, type, &em->default_track, cpu_time);
+
+  type_index = (word) type->type_index_plus_one - 1;
+  if (PREDICT_FALSE (type_index < 0))
+    type_index = elog_event_type_register (em, type);
+
+  r = vec_elt_at_index (em->thread_rings, thread_index);
+  e = r->event_ring + (r->n_total_events++ & (r->event_ring_size - 1));
+
+  e->time_cycles = cpu_time;
+  e->type = type_index;
+  e->track = r->track_index;
+
+  /* Return user data for caller to fill in. */
+  return e->data;
+}
+
+/** @brief Allocate an event in the calling thread ring
+    @param em elog_main_t *
+    @param thread_index u32 index of the calling thread
+    @param type elog_event_type_t * type
+    @return event data to be filled in by the caller
+*/
+always_inline void *
+elog_thread_data (elog_main_t * em, u32 thread_index,
+		  elog_event_type_t * type)
+{
+  return elog_thread_event_data_inline (em, thread_index, type,
+					clib_cpu_time_now ());
+}
+
 /* Macro shorthands for generating/declaring events. */
 #define __ELOG_TYPE_VAR(f) f
 #define __ELOG_TRACK_VAR(f) f
@@ -477,6 +576,10 @@ elog_data_inline (elog_main_t * em, elog_event_type_t * type,
 #define ELOG_TRACK_DATA_INLINE(em,f,track) \
   elog_data_inline ((em), &__ELOG_TYPE_VAR(f), &__ELOG_TRACK_VAR(track))
 
+/* Return data pointer to fill in, in the ring of the calling thread. */
+#define ELOG_THREAD_DATA(em,f,thread_index) \
+  elog_thread_data ((em), (thread_index), &__ELOG_TYPE_VAR(f))
+
 /* Shorthand with default track. */
 #define ELOG_DATA(em,f) elog_data ((em), &__ELOG_TYPE_VAR (f), &(em)->default_track)
 #define ELOG_DATA_INLINE(em,f) elog_data_inline ((em), &__ELOG_TYPE_VAR (f), &(em)->default_track)
@@ -524,6 +627,18 @@ void unserialize_elog_main (serialize_main_t * m, va_list * va);
 void elog_init (elog_main_t * em, u32 n_events);
 void elog_alloc (elog_main_t * em, u32 n_events);
 
+/** @brief Add an event ring for a thread
+    @param em elog_main_t *
+    @param thread_index u32 index of the thread logging to the ring
+    @param track elog_track_t * track of the ring events
+    @note must not be called while threads are logging to their rings
+*/
+void elog_thread_ring_add (elog_main_t * em, u32 thread_index,
+			   elog_track_t * track);
+
+/* Format events as Chrome trace event JSON, with the track as thread. */
+u8 *format_elog_chrome_trace (u8 * s, va_list * args);
+
 #ifdef CLIB_UNIX
 always_inline clib_error_t *
 elog_write_file (elog_main_t * em, char *clib_file, int flush_ring)
@@ -540,6 +655,16 @@ elog_write_file (elog_main_t * em, char *clib_file, int flush_ring)
   return error;
 }
 
+/** @brief Save the events in Chrome trace event format
+    @param em elog_main_t *
+    @param clib_file char * name of the file to write
+    @param flush_ring int collect the events logged since last collected
+    @return error, or zero
+    @note the file can be loaded in chrome://tracing or Perfetto
+*/
+clib_error_t *elog_write_chrome_trace (elog_main_t * em, char *clib_file,
+				       int flush_ring);
+
 always_inline clib_error_t *
 elog_read_file (elog_main_t * em, char *clib_file)
 {
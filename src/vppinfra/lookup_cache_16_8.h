@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_lookup_cache_16_8_h__
+#define __included_lookup_cache_16_8_h__
+
+#include <vppinfra/bihash_16_8.h>
+
+/*
+ * Small set associative cache of 16_8 key/value pairs, meant to live on
+ * the stack of a node function for the duration of a frame. It replaces
+ * the single "last key" caches of tunnel decap nodes, which stop hitting
+ * as soon as packets from a few tunnels are interleaved in a frame.
+ *
+ * Ways of a set are replaced round robin, so each set keeps its most
+ * recently inserted keys. Free entries are all ones, like free bihash
+ * entries, so an all ones key must never be searched.
+ *
+ * Callers should still check the previous key first, it is cheaper when
+ * packets of a tunnel come in a row, and only search the cache when it
+ * differs. With more active keys than entries the cache misses more than
+ * it hits, it then stops searching and caching for the rest of the frame.
+ *
+ * Whether a frame uses the cache at all is decided by a gate kept across
+ * frames, e.g. in the node runtime data, from the miss rates measured on
+ * the previous frames: the cache is only enabled when packets keep
+ * changing keys, and left off for a while after it thrashed, longer each
+ * time it thrashes again right after being enabled. When the cache is
+ * off searches always miss, so the caller is left with its plain last key
+ * compare, and only has to count the key changes for the gate.
+ */
+
+#define CLIB_LOOKUP_CACHE_16_8_LOG2_N_SETS 3
+#define CLIB_LOOKUP_CACHE_16_8_N_SETS (1 << CLIB_LOOKUP_CACHE_16_8_LOG2_N_SETS)
+#define CLIB_LOOKUP_CACHE_16_8_N_WAYS 4
+#define CLIB_LOOKUP_CACHE_16_8_N_ENTRIES \
+  (CLIB_LOOKUP_CACHE_16_8_N_SETS * CLIB_LOOKUP_CACHE_16_8_N_WAYS)
+
+/* At most 63 frames are left without the cache after it thrashed */
+#define CLIB_LOOKUP_CACHE_16_8_LOG2_MAX_FRAMES_OFF 6
+
+typedef struct
+{
+  /* next frames use the cache */
+  u8 is_enabled;
+  /* times the cache thrashed in a row */
+  u8 n_thrash;
+  /* frames to go before the cache may be enabled again */
+  u16 n_frames_off;
+} clib_lookup_cache_16_8_gate_t;
+
+typedef struct
+{
+  clib_bihash_kv_16_8_t
+    kv[CLIB_LOOKUP_CACHE_16_8_N_SETS][CLIB_LOOKUP_CACHE_16_8_N_WAYS];
+  /* next way to replace in each set */
+  u8 victim[CLIB_LOOKUP_CACHE_16_8_N_SETS];
+  u8 is_enabled;
+  /* missed more than it hit in this frame */
+  u8 is_thrashing;
+  /* searches and misses of the frame */
+  u16 n_search;
+  u16 n_miss;
+} clib_lookup_cache_16_8_t;
+
+static_always_inline void
+clib_lookup_cache_16_8_init (clib_lookup_cache_16_8_t * c,
+			     clib_lookup_cache_16_8_gate_t * g)
+{
+  c->is_enabled = g->is_enabled;
+  c->is_thrashing = 0;
+  c->n_search = c->n_miss = 0;
+  if (c->is_enabled)
+    {
+      clib_memset (c->kv, 0xff, sizeof (c->kv));
+      clib_memset (c->victim, 0, sizeof (c->victim));
+    }
+}
+
+static_always_inline int
+clib_lookup_cache_16_8_is_enabled (clib_lookup_cache_16_8_t * c)
+{
+  return c->is_enabled;
+}
+
+/*
+ * Decide whether the next frames use the cache, from a frame of n_packets
+ * of which n_key_changes had another key than the previous one
+ */
+static_always_inline void
+clib_lookup_cache_16_8_gate_update (clib_lookup_cache_16_8_gate_t * g,
+				    clib_lookup_cache_16_8_t * c,
+				    u32 n_packets, u32 n_key_changes)
+{
+  if (PREDICT_FALSE (c->is_thrashing))
+    {
+      g->n_thrash = clib_min (g->n_thrash + 1,
+			      CLIB_LOOKUP_CACHE_16_8_LOG2_MAX_FRAMES_OFF);
+      g->n_frames_off = (1 << g->n_thrash) - 1;
+      g->is_enabled = 0;
+    }
+  else if (PREDICT_FALSE (g->n_frames_off))
+    g->n_frames_off--;
+  else
+    {
+      if (c->is_enabled)
+	g->n_thrash = 0;
+      /* the last key compare is enough unless keys change often */
+      g->is_enabled = 4 * n_key_changes > n_packets;
+    }
+}
+
+static_always_inline u32
+clib_lookup_cache_16_8_set (clib_bihash_kv_16_8_t * kv)
+{
+  u64 h = kv->key[0] ^ kv->key[1];
+
+  h ^= h >> 32;
+  h ^= h >> 16;
+  h ^= h >> 8;
+  return (h ^ (h >> CLIB_LOOKUP_CACHE_16_8_LOG2_N_SETS)) &
+    (CLIB_LOOKUP_CACHE_16_8_N_SETS - 1);
+}
+
+/* Returns 0 and fills in kv->value on hit, -1 on miss */
+static_always_inline int
+clib_lookup_cache_16_8_search (clib_lookup_cache_16_8_t * c,
+			       clib_bihash_kv_16_8_t * kv)
+{
+  clib_bihash_kv_16_8_t *e;
+  int i;
+
+  if (PREDICT_FALSE (!c->is_enabled))
+    return -1;
+
+  c->n_search++;
+  e = c->kv[clib_lookup_cache_16_8_set (kv)];
+  for (i = 0; i < CLIB_LOOKUP_CACHE_16_8_N_WAYS; i++)
+    if (clib_bihash_key_compare_16_8 (e[i].key, kv->key))
+      {
+	kv->value = e[i].value;
+	return 0;
+      }
+
+  /* Too many keys interleaved in this frame, turn the cache off */
+  if (PREDICT_FALSE (++c->n_miss > CLIB_LOOKUP_CACHE_16_8_N_ENTRIES
+		     && 2 * c->n_miss > c->n_search))
+    {
+      c->is_enabled = 0;
+      c->is_thrashing = 1;
+    }
+  return -1;
+}
+
+static_always_inline void
+clib_lookup_cache_16_8_add (clib_lookup_cache_16_8_t * c,
+			    clib_bihash_kv_16_8_t * kv)
+{
+  u32 set;
+  u8 way;
+
+  if (PREDICT_FALSE (!c->is_enabled))
+    return;
+
+  set = clib_lookup_cache_16_8_set (kv);
+  way = c->victim[set] & (CLIB_LOOKUP_CACHE_16_8_N_WAYS - 1);
+
+  c->kv[set][way] = *kv;
+  c->victim[set] = way + 1;
+}
+
+#endif /* __included_lookup_cache_16_8_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -79,6 +79,45 @@ pcap_close (pcap_main_t * pm)
   return 0;
 }
 
+static clib_error_t *
+pcap_open_for_write (pcap_main_t * pm)
+{
+  pcap_file_header_t fh;
+  int n;
+
+  if (!pm->file_name)
+    pm->file_name = "/tmp/vnet.pcap";
+
+  pm->file_descriptor =
+    open (pm->file_name, O_CREAT | O_TRUNC | O_WRONLY, 0664);
+  if (pm->file_descriptor < 0)
+    return clib_error_return_unix (0, "failed to open `%s'", pm->file_name);
+
+  pm->flags |= PCAP_MAIN_INIT_DONE;
+  pm->n_packets_captured = 0;
+  pm->n_pcap_data_written = 0;
+  clib_spinlock_init (&pm->lock);
+
+  /* Write file header. */
+  clib_memset (&fh, 0, sizeof (fh));
+  fh.magic = 0xa1b2c3d4;
+  fh.major_version = 2;
+  fh.minor_version = 4;
+  fh.time_zone = 0;
+  fh.max_packet_size_in_bytes = 1 << 16;
+  fh.packet_type = pm->packet_type;
+  n = write (pm->file_descriptor, &fh, sizeof (fh));
+  if (n != sizeof (fh))
+    {
+      if (n < 0)
+	return clib_error_return_unix (0, "write file header `%s'",
+				       pm->file_name);
+      return clib_error_return (0, "short write of file header `%s'",
+				pm->file_name);
+    }
+  return 0;
+}
+
 /**
  * @brief Write PCAP file
  *
@@ -92,47 +131,9 @@ pcap_write (pcap_main_t * pm)
 
   if (!(pm->flags & PCAP_MAIN_INIT_DONE))
     {
-      pcap_file_header_t fh;
-      int n;
-
-      if (!pm->file_name)
-	pm->file_name = "/tmp/vnet.pcap";
-
-      pm->file_descriptor =
-	open (pm->file_name, O_CREAT | O_TRUNC | O_WRONLY, 0664);
-      if (pm->file_descriptor < 0)
-	{
-	  error =
-	    clib_error_return_unix (0, "failed to open `%s'", pm->file_name);
-	  goto done;
-	}
-
-      pm->flags |= PCAP_MAIN_INIT_DONE;
-      pm->n_packets_captured = 0;
-      pm->n_pcap_data_written = 0;
-      clib_spinlock_init (&pm->lock);
-
-      /* Write file header. */
-      clib_memset (&fh, 0, sizeof (fh));
-      fh.magic = 0xa1b2c3d4;
-      fh.major_version = 2;
-      fh.minor_version = 4;
-      fh.time_zone = 0;
-      fh.max_packet_size_in_bytes = 1 << 16;
-      fh.packet_type = pm->packet_type;
-      n = write (pm->file_descriptor, &fh, sizeof (fh));
-      if (n != sizeof (fh))
-	{
-	  if (n < 0)
-	    error =
-	      clib_error_return_unix (0, "write file header `%s'",
-				      pm->file_name);
-	  else
-	    error =
-	      clib_error_return (0, "short write of file header `%s'",
-				 pm->file_name);
-	  goto done;
-	}
+      error = pcap_open_for_write (pm);
+      if (error)
+	goto done;
     }
 
   while (vec_len (pm->pcap_data) > pm->n_pcap_data_written)
@@ -169,6 +170,114 @@ done:
   return error;
 }
 
+/**
+ * @brief Allocate a capture ring
+ *
+ * The ring is rounded up to a power of 2 in size.
+ *
+ */
+void
+pcap_ring_alloc (pcap_ring_t * r, u32 n_bytes)
+{
+  n_bytes = 1 << max_log2 (n_bytes);
+  clib_memset (r, 0, sizeof (*r));
+  r->data = clib_mem_alloc_aligned (n_bytes, CLIB_CACHE_LINE_BYTES);
+  r->mask = n_bytes - 1;
+}
+
+void
+pcap_ring_free (pcap_ring_t * r)
+{
+  clib_mem_free (r->data);
+  clib_memset (r, 0, sizeof (*r));
+}
+
+static_always_inline void
+pcap_ring_peek (pcap_ring_t * r, u64 offset, void *dst, u32 n_bytes)
+{
+  u32 i = offset & r->mask;
+  u32 n = clib_min (n_bytes, r->mask + 1 - i);
+
+  clib_memcpy_fast (dst, r->data + i, n);
+  if (n < n_bytes)
+    clib_memcpy_fast (dst + n, r->data, n_bytes - n);
+}
+
+/**
+ * @brief Write records queued in a capture ring to the PCAP file
+ *
+ * Called by the ring consumer. Records are written, and counted in
+ * @c n_packets_captured, until @c n_packets_to_capture is reached, in
+ * which case the file is closed and the remaining records are left in
+ * the ring.
+ *
+ * @return rc - clib_error_t
+ *
+ */
+clib_error_t *
+pcap_ring_write (pcap_main_t * pm, pcap_ring_t * r)
+{
+  clib_error_t *error = 0;
+  pcap_packet_header_t h;
+  u64 head = clib_atomic_load_acq_n (&r->head);
+  u64 tail = r->tail, end = tail;
+
+  if (tail == head)
+    return 0;
+
+  if (!(pm->flags & PCAP_MAIN_INIT_DONE))
+    {
+      error = pcap_open_for_write (pm);
+      if (error)
+	goto done;
+    }
+
+  while (end < head && pm->n_packets_captured < pm->n_packets_to_capture)
+    {
+      pcap_ring_peek (r, end, &h, sizeof (h));
+      end += sizeof (h) + h.n_packet_bytes_stored_in_file;
+      pm->n_packets_captured++;
+    }
+
+  while (tail < end)
+    {
+      u32 i = tail & r->mask;
+      int n = clib_min (end - tail, r->mask + 1 - i);
+
+      n = write (pm->file_descriptor, r->data + i, n);
+      if (n < 0)
+	{
+	  if (!unix_error_is_fatal (errno))
+	    continue;
+	  error = clib_error_return_unix (0, "write `%s'", pm->file_name);
+	  /* drop what could not be written */
+	  tail = end;
+	  break;
+	}
+      tail += n;
+    }
+
+  /* hand the space back to the producer */
+  clib_atomic_store_rel_n (&r->tail, tail);
+
+  if (pm->n_packets_captured >= pm->n_packets_to_capture)
+    pcap_close (pm);
+
+done:
+  if (error && pm->file_descriptor >= 0)
+    pcap_close (pm);
+  return error;
+}
+
+/**
+ * @brief Discard records queued in a capture ring
+ */
+void
+pcap_ring_discard (pcap_ring_t * r)
+{
+  clib_atomic_store_rel_n (&r->tail, clib_atomic_load_acq_n (&r->head));
+}
+
 /**
  * @brief Read PCAP file
  *
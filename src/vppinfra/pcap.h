@@ -193,6 +193,32 @@ typedef struct
   u32 min_packet_bytes, max_packet_bytes;
 } pcap_main_t;
 
+/**
+ * @brief Single producer, single consumer ring of pcap records
+ *
+ * Filled without locking by the thread capturing packets, and drained
+ * into a pcap file by a writer, see pcap_ring_write. Records are stored
+ * back to back, in file format, and may wrap around the end of the ring.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** Bytes added by the producer. */
+  u64 head;
+
+  /** Packets added, and dropped because the ring was full. */
+  u64 n_packets;
+  u64 n_dropped;
+
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  /** Bytes consumed by the writer. */
+  u64 tail;
+
+  /** Ring data, a power of 2 in size. */
+  u8 *data;
+  u32 mask;
+} pcap_ring_t;
+
 #endif /* included_vppinfra_pcap_h */
 
 /*
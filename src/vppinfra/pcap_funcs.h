@@ -22,6 +22,17 @@ clib_error_t *pcap_write (pcap_main_t * pm);
 /** Read data from file. */
 clib_error_t *pcap_read (pcap_main_t * pm);
 
+/** Close output file. */
+clib_error_t *pcap_close (pcap_main_t * pm);
+
+/** Allocate / free a capture ring of at least n_bytes. */
+void pcap_ring_alloc (pcap_ring_t * r, u32 n_bytes);
+void pcap_ring_free (pcap_ring_t * r);
+
+/** Write out records queued in a capture ring, or discard them. */
+clib_error_t *pcap_ring_write (pcap_main_t * pm, pcap_ring_t * r);
+void pcap_ring_discard (pcap_ring_t * r);
+
 /**
  * @brief Add packet
  *
@@ -89,6 +100,73 @@ pcap_add_buffer (pcap_main_t * pm,
     }
 }
 
+static inline void
+pcap_ring_copy (pcap_ring_t * r, u64 offset, void *src, u32 n_bytes)
+{
+  u32 i = offset & r->mask;
+  u32 n = clib_min (n_bytes, r->mask + 1 - i);
+
+  clib_memcpy_fast (r->data + i, src, n);
+  if (PREDICT_FALSE (n < n_bytes))
+    clib_memcpy_fast (r->data, src + n, n_bytes - n);
+}
+
+/**
+ * @brief Add buffer (vlib_buffer_t) to a capture ring
+ *
+ * Lock-free, may only be called by the thread owning the ring. The
+ * packet is dropped if the ring is full.
+ *
+ * @param *r - pcap_ring_t
+ * @param *vm - vlib_main_t
+ * @param buffer_index - u32
+ * @param n_bytes_in_trace - u32
+ *
+ */
+static inline void
+pcap_ring_add_buffer (pcap_ring_t * r,
+		      struct vlib_main_t *vm, u32 buffer_index,
+		      u32 n_bytes_in_trace)
+{
+  vlib_buffer_t *b = vlib_get_buffer (vm, buffer_index);
+  u32 n = vlib_buffer_length_in_chain (vm, b);
+  u32 n_left = clib_min (n_bytes_in_trace, n);
+  u64 head = r->head;
+  pcap_packet_header_t h;
+  f64 time_now;
+
+  if (PREDICT_FALSE (head + sizeof (h) + n_left -
+		     clib_atomic_load_acq_n (&r->tail) > r->mask + 1))
+    {
+      r->n_dropped++;
+      return;
+    }
+
+  time_now = vlib_time_now (vm);
+  h.time_in_sec = time_now;
+  h.time_in_usec = 1e6 * (time_now - h.time_in_sec);
+  h.n_packet_bytes_stored_in_file = n_left;
+  h.n_bytes_in_packet = n;
+  pcap_ring_copy (r, head, &h, sizeof (h));
+  head += sizeof (h);
+
+  while (1)
+    {
+      u32 copy_length = clib_min (n_left, b->current_length);
+      pcap_ring_copy (r, head, b->data + b->current_data, copy_length);
+      head += copy_length;
+      n_left -= copy_length;
+      if (n_left == 0)
+	break;
+      ASSERT (b->flags & VLIB_BUFFER_NEXT_PRESENT);
+      b = vlib_get_buffer (vm, b->next_buffer);
+    }
+
+  r->n_packets++;
+  /* publish the record to the writer */
+  clib_atomic_store_rel_n (&r->head, head);
+}
+
 #endif /* included_vppinfra_pcap_funcs_h */
 
 /*
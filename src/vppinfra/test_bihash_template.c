@@ -146,6 +146,86 @@ test_bihash_stale_overwrite (test_main_t * tm)
   return 0;
 }
 
+static clib_error_t *
+test_bihash_batch (test_main_t * tm)
+{
+  BVT (clib_bihash) * h;
+  BVT (clib_bihash_kv) kv, kvs[256];
+  u32 i, j, n_found, *order = 0, n_errors = 0;
+  u64 before, single_clocks = 0, batch_clocks = 0, total_searches;
+  u8 found[256];
+
+  h = &tm->hash;
+  BV (clib_bihash_init) (h, "test", tm->nbuckets, tm->hash_memory_size);
+
+  fformat (stdout, "Add %d items to %d buckets\n", tm->nitems, tm->nbuckets);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+    again:
+      kv.key = random_u64 (&tm->seed);
+      if (hash_get (tm->key_hash, kv.key))
+	goto again;
+      hash_set (tm->key_hash, kv.key, i + 1);
+      kv.value = i + 1;
+      BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+      vec_add1 (tm->keys, kv.key);
+    }
+
+  /* Search in random order to defeat the caches */
+  for (i = 0; i < ARRAY_LEN (kvs) * 64; i++)
+    vec_add1 (order, random_u64 (&tm->seed) % tm->nitems);
+
+  fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+  fformat (stdout, "Search for items %d times...\n", tm->search_iter);
+
+  for (j = 0; j < tm->search_iter; j++)
+    {
+      for (i = 0; i < vec_len (order); i += ARRAY_LEN (kvs))
+	{
+	  u32 k;
+
+	  before = clib_cpu_time_now ();
+	  for (k = 0; k < ARRAY_LEN (kvs); k++)
+	    {
+	      kv.key = tm->keys[order[i + k]];
+	      if (BV (clib_bihash_search) (h, &kv, &kv) < 0
+		  || kv.value != order[i + k] + 1)
+		n_errors++;
+	    }
+	  single_clocks += clib_cpu_time_now () - before;
+
+	  for (k = 0; k < ARRAY_LEN (kvs); k++)
+	    kvs[k].key = tm->keys[order[i + k]];
+
+	  before = clib_cpu_time_now ();
+	  n_found = BV (clib_bihash_search_batch) (h, kvs, found,
+						    ARRAY_LEN (kvs));
+	  batch_clocks += clib_cpu_time_now () - before;
+
+	  if (n_found != ARRAY_LEN (kvs))
+	    n_errors++;
+	  for (k = 0; k < ARRAY_LEN (kvs); k++)
+	    if (!found[k] || kvs[k].value != order[i + k] + 1)
+	      n_errors++;
+	}
+    }
+
+  total_searches = (u64) tm->search_iter * vec_len (order);
+  fformat (stdout, "%lld searches, %u errors\n", total_searches, n_errors);
+  fformat (stdout, "single: %.2f clocks/search\n",
+	   (f64) single_clocks / total_searches);
+  fformat (stdout, "batch: %.2f clocks/search\n",
+	   (f64) batch_clocks / total_searches);
+
+  vec_free (order);
+  BV (clib_bihash_free) (h);
+
+  if (n_errors)
+    return clib_error_return (0, "%u search errors", n_errors);
+  return 0;
+}
+
 void *
 test_bihash_thread_fn (void *arg)
 {
@@ -492,6 +572,8 @@ test_bihash_main (test_main_t * tm)
 	tm->verbose = 1;
       else if (unformat (i, "stale-overwrite"))
 	which = 3;
+      else if (unformat (i, "batch"))
+	which = 4;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, i);
@@ -521,6 +603,10 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_stale_overwrite (tm);
       break;
 
+    case 4:
+      error = test_bihash_batch (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
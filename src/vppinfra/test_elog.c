@@ -46,11 +46,11 @@ int
 test_elog_main (unformat_input_t * input)
 {
   clib_error_t *error = 0;
-  u32 i, n_iter, seed, max_events;
+  u32 i, n_iter, seed, max_events, n_thread_rings;
   elog_main_t _em, *em = &_em;
   u32 verbose;
   f64 min_sample_time;
-  char *dump_file, *load_file, *merge_file, **merge_files;
+  char *dump_file, *chrome_file, *load_file, *merge_file, **merge_files;
   u8 *tag, **tags;
   f64 align_tweak;
   f64 *align_tweaks;
@@ -60,11 +60,13 @@ test_elog_main (unformat_input_t * input)
   seed = 1;
   verbose = 0;
   dump_file = 0;
+  chrome_file = 0;
   load_file = 0;
   merge_files = 0;
   tags = 0;
   align_tweaks = 0;
   min_sample_time = 2;
+  n_thread_rings = 0;
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
       if (unformat (input, "iter %d", &n_iter))
@@ -73,6 +75,8 @@ test_elog_main (unformat_input_t * input)
 	;
       else if (unformat (input, "dump %s", &dump_file))
 	;
+      else if (unformat (input, "chrome %s", &chrome_file))
+	;
       else if (unformat (input, "load %s", &load_file))
 	;
       else if (unformat (input, "tag %s", &tag))
@@ -86,6 +90,8 @@ test_elog_main (unformat_input_t * input)
 	;
       else if (unformat (input, "sample-time %f", &min_sample_time))
 	;
+      else if (unformat (input, "thread-rings %d", &n_thread_rings))
+	;
       else if (unformat (input, "align-tweak %f", &align_tweak))
 	vec_add1 (align_tweaks, align_tweak);
       else
@@ -140,6 +146,14 @@ test_elog_main (unformat_input_t * input)
 
       elog_init (em, max_events);
       elog_enable_disable (em, 1);
+      for (i = 0; i < n_thread_rings; i++)
+	{
+	  elog_track_t track = { 0 };
+
+	  track.name = (char *) format (0, "thread %d%c", i, 0);
+	  elog_thread_ring_add (em, i, &track);
+	  vec_free (track.name);
+	}
       t[0] = unix_time_now ();
 
       for (i = 0; i < n_iter; i++)
@@ -219,6 +233,16 @@ test_elog_main (unformat_input_t * input)
 	    d = ELOG_DATA (em, e);
 	    d->offset = elog_string (em, "string table %d", i);
 	  }
+
+	  for (j = 0; j < n_thread_rings; j++)
+	    {
+	      ELOG_TYPE_DECLARE (e) =
+	      {
+	      .format = "ring %d iter %d",.format_args = "i4i4",};
+	      u32 *d = ELOG_THREAD_DATA (em, e, j);
+	      d[0] = j;
+	      d[1] = i;
+	    }
 	}
 
       do
@@ -235,6 +259,13 @@ test_elog_main (unformat_input_t * input)
 	   elog_write_file (em, dump_file, 0 /* do not flush ring */ )))
 	goto done;
     }
+  if (chrome_file)
+    {
+      if ((error =
+	   elog_write_chrome_trace (em, chrome_file,
+				    0 /* do not flush ring */ )))
+	goto done;
+    }
 #endif
 
   if (verbose)
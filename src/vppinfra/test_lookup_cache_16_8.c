@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2019 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Compare the tunnel lookup strategies of the decap nodes on frames of
+ * packets interleaved from a few active tunnels, out of a table of 1, 100
+ * or 10k tunnels:
+ *  - single "last key" cache, one bihash search per miss
+ *  - last key, then per frame associative cache, one bihash search per
+ *    miss
+ *  - per frame associative cache, misses resolved in bihash batches
+ *  - the last two, with the cache gated by the miss rates of the previous
+ *    frames, as the decap nodes do
+ */
+
+#include <vppinfra/time.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/error.h>
+#include <vppinfra/random.h>
+
+#include <vppinfra/bihash_16_8.h>
+#include <vppinfra/bihash_template.h>
+#include <vppinfra/lookup_cache_16_8.h>
+
+#include <vppinfra/bihash_template.c>
+
+#define FRAME_SIZE 256
+
+typedef struct
+{
+  u32 seed;
+  u32 n_frames;
+  u32 n_active;
+  u32 n_runs;
+  u32 *n_tunnels;
+  int verbose;
+
+  clib_bihash_16_8_t hash;
+  clib_bihash_kv_16_8_t *tunnels;
+
+  /* kept across frames, like in the decap nodes runtime data */
+  clib_lookup_cache_16_8_gate_t gate;
+
+  /* n_frames * FRAME_SIZE keys */
+  clib_bihash_kv_16_8_t *keys;
+} lookup_cache_test_main_t;
+
+lookup_cache_test_main_t lookup_cache_test_main;
+
+static void
+make_tunnels (lookup_cache_test_main_t * tm, u32 n_tunnels)
+{
+  clib_bihash_kv_16_8_t kv;
+  u32 i, j, *active = 0;
+
+  clib_bihash_init_16_8 (&tm->hash, "tunnels",
+			 clib_max (1, n_tunnels / 2) << 1, 64 << 20);
+
+  /* Same layout as vxlan4 keys: src/dst address, vni and fib index */
+  for (i = 0; i < n_tunnels; i++)
+    {
+      kv.key[0] = ((u64) clib_host_to_net_u32 (0x0a000001) << 32) |
+	clib_host_to_net_u32 (0x0b000000 + i);
+      kv.key[1] = clib_host_to_net_u32 ((i + 1) << 8);
+      kv.value = i;
+      clib_bihash_add_del_16_8 (&tm->hash, &kv, 1 /* is_add */ );
+      vec_add1 (tm->tunnels, kv);
+    }
+
+  /* Each frame carries interleaved packets of a few active tunnels */
+  for (i = 0; i < tm->n_frames; i++)
+    {
+      vec_reset_length (active);
+      for (j = 0; j < clib_min (tm->n_active, n_tunnels); j++)
+	vec_add1 (active, random_u32 (&tm->seed) % n_tunnels);
+
+      for (j = 0; j < FRAME_SIZE; j++)
+	{
+	  kv = tm->tunnels[active[random_u32 (&tm->seed) % vec_len (active)]];
+	  kv.value = ~0ULL;
+	  vec_add1 (tm->keys, kv);
+	}
+    }
+  vec_free (active);
+}
+
+static void
+free_tunnels (lookup_cache_test_main_t * tm)
+{
+  clib_bihash_free_16_8 (&tm->hash);
+  vec_free (tm->tunnels);
+  vec_free (tm->keys);
+}
+
+static u64
+lookup_last_key (lookup_cache_test_main_t * tm, clib_bihash_kv_16_8_t * f)
+{
+  clib_bihash_kv_16_8_t last, kv;
+  u64 sum = 0;
+  int i;
+
+  clib_memset (&last, 0xff, sizeof (last));
+
+  for (i = 0; i < FRAME_SIZE; i++)
+    {
+      kv = f[i];
+      if (PREDICT_FALSE (!clib_bihash_key_compare_16_8 (kv.key, last.key)))
+	{
+	  if (clib_bihash_search_16_8 (&tm->hash, &kv, &kv) < 0)
+	    continue;
+	  last = kv;
+	}
+      sum += last.value;
+    }
+  return sum;
+}
+
+static clib_lookup_cache_16_8_gate_t always_enabled = {.is_enabled = 1 };
+
+/* Same structure as the vxlan-gpe, geneve and gtpu ip4 decap nodes */
+static_always_inline u64
+lookup_cache_inline (lookup_cache_test_main_t * tm,
+		     clib_bihash_kv_16_8_t * f,
+		     clib_lookup_cache_16_8_gate_t * gate)
+{
+  clib_lookup_cache_16_8_t cache;
+  clib_bihash_kv_16_8_t last, kv;
+  u32 n_key_changes = 0;
+  u64 sum = 0;
+  int i;
+
+  clib_memset (&last, 0xff, sizeof (last));
+  clib_lookup_cache_16_8_init (&cache, gate);
+
+  for (i = 0; i < FRAME_SIZE; i++)
+    {
+      kv = f[i];
+      if (PREDICT_FALSE (!clib_bihash_key_compare_16_8 (kv.key, last.key)))
+	{
+	  n_key_changes++;
+	  if (clib_lookup_cache_16_8_search (&cache, &kv))
+	    {
+	      if (clib_bihash_search_16_8 (&tm->hash, &kv, &kv) < 0)
+		continue;
+	      clib_lookup_cache_16_8_add (&cache, &kv);
+	    }
+	  last = kv;
+	}
+      sum += last.value;
+    }
+  clib_lookup_cache_16_8_gate_update (gate, &cache, FRAME_SIZE,
+				      n_key_changes);
+  return sum;
+}
+
+static u64
+lookup_cache (lookup_cache_test_main_t * tm, clib_bihash_kv_16_8_t * f)
+{
+  clib_lookup_cache_16_8_gate_t gate = always_enabled;
+
+  return lookup_cache_inline (tm, f, &gate);
+}
+
+static u64
+lookup_cache_gated (lookup_cache_test_main_t * tm, clib_bihash_kv_16_8_t * f)
+{
+  return lookup_cache_inline (tm, f, &tm->gate);
+}
+
+static void
+resolve_misses (lookup_cache_test_main_t * tm,
+		clib_lookup_cache_16_8_t * cache,
+		clib_bihash_kv_16_8_t * keys, u16 * miss, u32 n_miss,
+		clib_bihash_kv_16_8_t * kv)
+{
+  u8 found[BIHASH_SEARCH_BATCH_SIZE];
+  u32 i;
+
+  clib_bihash_search_batch_16_8 (&tm->hash, keys, found, n_miss);
+  for (i = 0; i < n_miss; i++)
+    {
+      if (!found[i])
+	keys[i].value = 0;
+      else
+	clib_lookup_cache_16_8_add (cache, &keys[i]);
+      kv[miss[i]].value = keys[i].value;
+    }
+}
+
+/* Same structure as the vxlan4 decap pre-pass */
+static_always_inline u64
+lookup_cache_batch_inline (lookup_cache_test_main_t * tm,
+			   clib_bihash_kv_16_8_t * f,
+			   clib_lookup_cache_16_8_t * cache,
+			   u32 * n_key_changes)
+{
+  clib_bihash_kv_16_8_t kv[FRAME_SIZE], keys[BIHASH_SEARCH_BATCH_SIZE];
+  u16 miss[BIHASH_SEARCH_BATCH_SIZE];
+  u8 same_as_prev[FRAME_SIZE];
+  u32 i, n_miss = 0, n_same = 0;
+  u64 sum = 0;
+
+  for (i = 0; i < FRAME_SIZE; i++)
+    {
+      kv[i] = f[i];
+      same_as_prev[i] = 0;
+      if (i && clib_bihash_key_compare_16_8 (kv[i].key, kv[i - 1].key))
+	{
+	  same_as_prev[i] = 1;
+	  n_same++;
+	  continue;
+	}
+
+      *n_key_changes += 1;
+      if (!clib_lookup_cache_16_8_search (cache, &kv[i]))
+	continue;
+
+      keys[n_miss] = kv[i];
+      miss[n_miss++] = i;
+      if (n_miss == BIHASH_SEARCH_BATCH_SIZE)
+	{
+	  resolve_misses (tm, cache, keys, miss, n_miss, kv);
+	  n_miss = 0;
+	}
+    }
+
+  if (n_miss)
+    resolve_misses (tm, cache, keys, miss, n_miss, kv);
+
+  if (n_same)
+    for (i = 1; i < FRAME_SIZE; i++)
+      if (same_as_prev[i])
+	kv[i].value = kv[i - 1].value;
+
+  for (i = 0; i < FRAME_SIZE; i++)
+    sum += kv[i].value;
+  return sum;
+}
+
+static u64
+lookup_cache_batch (lookup_cache_test_main_t * tm, clib_bihash_kv_16_8_t * f)
+{
+  clib_lookup_cache_16_8_t cache;
+  u32 n_key_changes = 0;
+
+  clib_lookup_cache_16_8_init (&cache, &always_enabled);
+  return lookup_cache_batch_inline (tm, f, &cache, &n_key_changes);
+}
+
+/*
+ * Same structure as vxlan4-input: last key per packet unless the gate
+ * enables the cache, then the batched pre-pass
+ */
+static u64
+lookup_cache_batch_gated (lookup_cache_test_main_t * tm,
+			  clib_bihash_kv_16_8_t * f)
+{
+  clib_lookup_cache_16_8_t cache;
+  clib_bihash_kv_16_8_t last, kv;
+  u32 n_key_changes = 0;
+  u64 sum = 0;
+  int i;
+
+  clib_lookup_cache_16_8_init (&cache, &tm->gate);
+  if (clib_lookup_cache_16_8_is_enabled (&cache))
+    sum = lookup_cache_batch_inline (tm, f, &cache, &n_key_changes);
+  else
+    {
+      clib_memset (&last, 0xff, sizeof (last));
+      for (i = 0; i < FRAME_SIZE; i++)
+	{
+	  kv = f[i];
+	  if (PREDICT_FALSE
+	      (!clib_bihash_key_compare_16_8 (kv.key, last.key)))
+	    {
+	      n_key_changes++;
+	      if (clib_bihash_search_16_8 (&tm->hash, &kv, &kv) < 0)
+		continue;
+	      last = kv;
+	    }
+	  sum += last.value;
+	}
+    }
+  clib_lookup_cache_16_8_gate_update (&tm->gate, &cache, FRAME_SIZE,
+				      n_key_changes);
+  return sum;
+}
+
+typedef u64 (lookup_fn_t) (lookup_cache_test_main_t * tm,
+			   clib_bihash_kv_16_8_t * f);
+
+/* Best of n_runs, the others were disturbed */
+static f64
+run_lookups (lookup_cache_test_main_t * tm, lookup_fn_t * fn, u64 * sum)
+{
+  u64 t0, t, best = ~0ULL;
+  u32 i, run;
+
+  for (run = 0; run < tm->n_runs; run++)
+    {
+      /* Warm up the table */
+      fn (tm, tm->keys);
+      clib_memset (&tm->gate, 0, sizeof (tm->gate));
+
+      *sum = 0;
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < tm->n_frames; i++)
+	*sum += fn (tm, tm->keys + i * FRAME_SIZE);
+      t = clib_cpu_time_now () - t0;
+      best = clib_min (best, t);
+    }
+
+  return (f64) best / (tm->n_frames * FRAME_SIZE);
+}
+
+static clib_error_t *
+test_lookup_cache_main (lookup_cache_test_main_t * tm)
+{
+  lookup_fn_t *fns[] = {
+    lookup_last_key, lookup_cache, lookup_cache_batch,
+    lookup_cache_gated, lookup_cache_batch_gated,
+  };
+  u64 sums[ARRAY_LEN (fns)];
+  f64 clocks[ARRAY_LEN (fns)];
+  u32 *n, i;
+
+  fformat (stdout, "%u frames of %u packets from %u active tunnels, "
+	   "best of %u runs\n", tm->n_frames, FRAME_SIZE, tm->n_active,
+	   tm->n_runs);
+  fformat (stdout, "%10s %12s %12s %12s %12s %12s  (clocks/packet)\n",
+	   "tunnels", "last-key", "last+cache", "cache+batch", "gated",
+	   "gated+batch");
+
+  vec_foreach (n, tm->n_tunnels)
+  {
+    make_tunnels (tm, n[0]);
+
+    for (i = 0; i < ARRAY_LEN (fns); i++)
+      {
+	clocks[i] = run_lookups (tm, fns[i], &sums[i]);
+	if (sums[i] != sums[0])
+	  return clib_error_return (0, "%u tunnels: lookup results differ "
+				    "(%llu %llu)", n[0], sums[0], sums[i]);
+      }
+
+    fformat (stdout, "%10u", n[0]);
+    for (i = 0; i < ARRAY_LEN (fns); i++)
+      fformat (stdout, " %12.2f", clocks[i]);
+    fformat (stdout, "\n");
+    if (tm->verbose)
+      fformat (stdout, "%U", format_bihash_16_8, &tm->hash, 0);
+
+    free_tunnels (tm);
+  }
+  return 0;
+}
+
+#ifdef CLIB_UNIX
+int
+main (int argc, char *argv[])
+{
+  lookup_cache_test_main_t *tm = &lookup_cache_test_main;
+  unformat_input_t i;
+  clib_error_t *error;
+  u32 n;
+
+  clib_mem_init (0, 1ULL << 30);
+
+  tm->seed = 0xdaddabed;
+  tm->n_frames = 10000;
+  tm->n_active = 8;
+  tm->n_runs = 5;
+
+  unformat_init_command_line (&i, argv);
+  while (unformat_check_input (&i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (&i, "seed %u", &tm->seed))
+	;
+      else if (unformat (&i, "frames %u", &tm->n_frames))
+	;
+      else if (unformat (&i, "active %u", &tm->n_active))
+	;
+      else if (unformat (&i, "runs %u", &tm->n_runs))
+	;
+      else if (unformat (&i, "tunnels %u", &n))
+	vec_add1 (tm->n_tunnels, n);
+      else if (unformat (&i, "verbose"))
+	tm->verbose = 1;
+      else
+	{
+	  clib_warning ("unknown input '%U'", format_unformat_error, &i);
+	  return 1;
+	}
+    }
+  unformat_free (&i);
+
+  if (tm->n_tunnels == 0)
+    {
+      vec_add1 (tm->n_tunnels, 1);
+      vec_add1 (tm->n_tunnels, 100);
+      vec_add1 (tm->n_tunnels, 10000);
+    }
+  if (tm->n_active == 0)
+    tm->n_active = 1;
+  if (tm->n_runs == 0)
+    tm->n_runs = 1;
+
+  error = test_lookup_cache_main (tm);
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+#endif /* CLIB_UNIX */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
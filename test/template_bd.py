@@ -87,6 +87,35 @@ class BridgeDomain(object):
         pkt = out[0]
         self.assert_eq_pkts(pkt, self.frame_request)
 
+    def check_decap_flow_offload(self, tunnel_type, tunnel, node):
+        """ Decapsulation with the tunnel rx flow offloaded
+        Mark the encapsulated frames from pg0 with a flow and verify receipt
+        of decapsulated frames on pg1, and that the decap node found the
+        tunnel by the flow mark rather than by its key
+        """
+        counter = '/err/%s/packets found by rx flow mark' % node
+        self.vapi.cli("set flow-offload %s hw pg0 rx %s" %
+                      (tunnel_type, tunnel))
+        try:
+            flows = self.vapi.cli("show flow entry")
+            self.assertIn("ipv4-%s" % tunnel_type, flows)
+            self.assertIn("flow-index",
+                          self.vapi.cli("show %s tunnel" % tunnel_type))
+            marked = self.statistics.get_counter(counter)
+
+            self.pg0.add_stream([self.encapsulate(self.frame_request,
+                                                  self.single_tunnel_bd)])
+            self.pg1.enable_capture()
+            self.pg_start()
+
+            out = self.pg1.get_capture(1)
+            self.assert_eq_pkts(out[0], self.frame_request)
+            self.assertEqual(self.statistics.get_counter(counter),
+                             marked + 1)
+        finally:
+            self.vapi.cli("set flow-offload %s hw pg0 rx %s del" %
+                          (tunnel_type, tunnel))
+
     def test_encap(self):
         """ Encapsulation test
         Send frames from pg1
@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
+from framework import VppTestCase
+
+
+class TemplateIp4Udp(VppTestCase):
+    """ Two routed pg interfaces passing ip4 UDP packets from pg0 to pg1 """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TemplateIp4Udp, cls).setUpClass()
+
+        try:
+            cls.create_pg_interfaces(range(2))
+            for i in cls.pg_interfaces:
+                i.admin_up()
+                i.config_ip4()
+                i.resolve_arp()
+        except Exception:
+            super(TemplateIp4Udp, cls).tearDownClass()
+            raise
+
+    @classmethod
+    def tearDownClass(cls):
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TemplateIp4Udp, cls).tearDownClass()
+
+    def create_packet(self, src_ip=None, dst_ip=None, dport=1234, size=100):
+        """
+        UDP packet sent on pg0, to the pg1 remote host by default
+
+        :param src_ip: source address, the pg0 remote host by default
+        :param dst_ip: destination address
+        :param dport: UDP destination port
+        :param size: payload length
+        """
+        return (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                IP(src=src_ip or self.pg0.remote_ip4,
+                   dst=dst_ip or self.pg1.remote_ip4) /
+                UDP(sport=1234, dport=dport) /
+                Raw(b'\xa5' * size))
+
+    def create_stream(self, count, src_ip=None):
+        """
+        Stream of packets from pg0 to pg1, one UDP port per packet
+
+        :param count: number of packets
+        :param src_ip: source address, the pg0 remote host by default
+        """
+        return [self.create_packet(src_ip=src_ip, dport=1234 + i)
+                for i in range(count)]
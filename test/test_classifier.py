@@ -9,7 +9,10 @@ from framework import VppTestCase, VppTestRunner
 from scapy.packet import Raw
 from scapy.layers.l2 import Ether
 from scapy.layers.inet import IP, UDP, TCP
+from scapy.layers.vxlan import VXLAN
 from util import ppp
+from vpp_l2 import L2_PORT_TYPE
+from vpp_lo_interface import VppLoInterface
 
 
 class TestClassifier(VppTestCase):
@@ -258,17 +261,20 @@ class TestClassifier(VppTestCase):
         return ('{!s:0>12}{!s:0>12}{!s:0>4}'.format(
             dst_mac, src_mac, ether_type)).rstrip('0')
 
-    def create_classify_table(self, key, mask, data_offset=0):
+    def create_classify_table(self, key, mask, data_offset=0,
+                              next_table_index=0xFFFFFFFF):
         """Create Classify Table
 
         :param str key: key for classify table (ex, ACL name).
         :param str mask: mask value for interested traffic.
         :param int data_offset:
+        :param int next_table_index: table to try on a miss.
         """
         r = self.vapi.classify_add_del_table(
             is_add=1,
             mask=binascii.unhexlify(mask),
             match_n_vectors=(len(mask) - 1) // 32 + 1,
+            next_table_index=next_table_index,
             miss_next_index=0,
             current_data_flag=1,
             current_data_offset=data_offset)
@@ -429,6 +435,161 @@ class TestClassifierIP(TestClassifier):
         self.pg2.assert_nothing_captured(remark="packets forwarded")
         self.pg3.assert_nothing_captured(remark="packets forwarded")
 
+    def test_iacl_chain(self):
+        """ Chained tables iACL test
+
+        Test scenario for IP ACL with a chain of tables sharing a mask
+            - Create two chained tables with the same source IP mask.
+            - Add the matching session to the second table only.
+            - Send and verify received packets on pg1 interface.
+            - Move the session to the first table and verify again.
+        """
+
+        key = 'ip_src_chain_tail'
+        mask = self.build_ip_mask(src_ip='ffffffff')
+        self.create_classify_table(key, mask)
+        self.create_classify_table(
+            'ip_src_chain', mask,
+            next_table_index=self.acl_tbl_idx.get(key))
+        self.create_classify_session(
+            self.acl_tbl_idx.get(key),
+            self.build_ip_match(src_ip=self.pg0.remote_ip4))
+        self.create_classify_session(
+            self.acl_tbl_idx.get('ip_src_chain'),
+            self.build_ip_match(src_ip=self.pg1.remote_ip4))
+        self.input_acl_set_interface(
+            self.pg0, self.acl_tbl_idx.get('ip_src_chain'))
+        self.acl_active_table = 'ip_src_chain'
+
+        tables = self.vapi.cli("show classify tables verbose index %d" %
+                               self.acl_tbl_idx.get('ip_src_chain'))
+        self.assertIn("next table shares the mask", tables)
+
+        # hit in the second table of the chain
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        pkts = self.pg1.get_capture(len(pkts))
+        self.verify_capture(self.pg1, pkts)
+
+        # delete the sessions so the tables filter everything out,
+        # then hit in the first table
+        self.create_classify_session(
+            self.acl_tbl_idx.get(key),
+            self.build_ip_match(src_ip=self.pg0.remote_ip4), is_add=0)
+        self.create_classify_session(
+            self.acl_tbl_idx.get('ip_src_chain'),
+            self.build_ip_match(src_ip=self.pg1.remote_ip4), is_add=0)
+        self.create_classify_session(
+            self.acl_tbl_idx.get('ip_src_chain'),
+            self.build_ip_match(src_ip=self.pg0.remote_ip4))
+
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        pkts = self.pg1.get_capture(len(pkts))
+        self.verify_capture(self.pg1, pkts)
+        self.pg0.assert_nothing_captured(remark="packets forwarded")
+        self.pg2.assert_nothing_captured(remark="packets forwarded")
+        self.pg3.assert_nothing_captured(remark="packets forwarded")
+
+    def test_ip_classify_l2_offset(self):
+        """ IP classify matches from the L2 header
+
+        Test scenario for ip4-classify on decapsulated frames
+            - Bridge a VXLAN tunnel with a BVI loopback, so that the
+              inner L2 header does not start at the beginning of the
+              buffer data.
+            - Create a table matching the ethertype and the destination
+              address of the inner frame, from the inner L2 header.
+            - Route the destination via the table.
+            - Send encapsulated packets on pg0 and verify that they all
+              hit the table.
+        """
+
+        bd_id = 13
+        vni = 13
+        dst_ip4 = '10.10.10.10'
+        r = self.vapi.vxlan_add_del_tunnel(src_address=self.pg0.local_ip4n,
+                                           dst_address=self.pg0.remote_ip4n,
+                                           is_add=1, vni=vni)
+        vxlan_sw_if_index = r.sw_if_index
+        self.vapi.sw_interface_set_flags(vxlan_sw_if_index, admin_up_down=1)
+        bvi = VppLoInterface(self)
+        bvi.admin_up()
+        self.vapi.sw_interface_set_l2_bridge(
+            rx_sw_if_index=bvi.sw_if_index, bd_id=bd_id,
+            port_type=L2_PORT_TYPE.BVI)
+        self.vapi.sw_interface_set_l2_bridge(
+            rx_sw_if_index=vxlan_sw_if_index, bd_id=bd_id)
+        bvi.config_ip4()
+
+        # ethertype at offset 12, destination address at offset 30
+        mask = '0' * 24 + 'ffff' + '0' * 32 + 'ffffffff'
+        match = '0' * 24 + '0800' + '0' * 32 + \
+            binascii.hexlify(socket.inet_aton(dst_ip4)).decode('ascii')
+        r = self.vapi.classify_add_del_table(
+            is_add=1,
+            mask=binascii.unhexlify(mask),
+            match_n_vectors=(len(mask) - 1) // 32 + 1,
+            miss_next_index=0)
+        table_index = r.new_table_index
+        self.vapi.classify_add_del_session(
+            is_add=1,
+            table_index=table_index,
+            match=binascii.unhexlify(match),
+            opaque_index=0)
+        self.vapi.cli("ip route add %s/32 via classify %d" %
+                      (dst_ip4, table_index))
+
+        try:
+            counter = '/err/ip4-classify/Classify hits'
+            hits = self.statistics.get_counter(counter)
+
+            pkts = []
+            for i in range(5):
+                pkts.append(
+                    Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                    IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4) /
+                    UDP(sport=1234, dport=4789) /
+                    VXLAN(vni=vni) /
+                    Ether(dst=bvi.local_mac, src='00:00:00:00:00:02') /
+                    IP(src=bvi.remote_ip4, dst=dst_ip4) /
+                    UDP(sport=1234, dport=1234) /
+                    Raw('\xa5' * 100))
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+
+            self.assertEqual(self.statistics.get_counter(counter),
+                             hits + len(pkts))
+        finally:
+            self.vapi.cli("ip route del %s/32 via classify %d" %
+                          (dst_ip4, table_index))
+            self.vapi.classify_add_del_session(
+                is_add=0,
+                table_index=table_index,
+                match=binascii.unhexlify(match),
+                opaque_index=0)
+            self.vapi.classify_add_del_table(
+                is_add=0,
+                table_index=table_index,
+                mask=binascii.unhexlify(mask),
+                match_n_vectors=(len(mask) - 1) // 32 + 1)
+            bvi.unconfig_ip4()
+            self.vapi.sw_interface_set_l2_bridge(
+                rx_sw_if_index=vxlan_sw_if_index, bd_id=bd_id, enable=0)
+            self.vapi.sw_interface_set_l2_bridge(
+                rx_sw_if_index=bvi.sw_if_index, bd_id=bd_id,
+                port_type=L2_PORT_TYPE.BVI, enable=0)
+            self.vapi.bridge_domain_add_del(bd_id=bd_id, is_add=0)
+            bvi.remove_vpp_config()
+            self.vapi.vxlan_add_del_tunnel(src_address=self.pg0.local_ip4n,
+                                           dst_address=self.pg0.remote_ip4n,
+                                           is_add=0, vni=vni)
+
 
 class TestClassifierUDP(TestClassifier):
     """ Classifier UDP proto Test Case """
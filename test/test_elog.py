@@ -0,0 +1,43 @@
+#!/usr/bin/env python
+
+import json
+import os
+import unittest
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestElog(TemplateIp4Udp):
+    """ Event logger Test Case """
+
+    def test_elog_chrome_trace(self):
+        """ Dispatch events saved as a Chrome trace """
+        name = "test_elog_%d.json" % os.getpid()
+        path = "/tmp/%s" % name
+
+        self.vapi.cli("event-logger clear")
+        self.vapi.cli("elog trace dispatch")
+        self.send_and_expect(self.pg0, self.create_stream(10), self.pg1)
+        self.vapi.cli("elog trace dispatch disable")
+
+        self.vapi.cli("event-logger save %s chrome" % name)
+        self.addCleanup(os.remove, path)
+        with open(path) as f:
+            trace = json.load(f)
+
+        threads = dict((e["tid"], e["args"]["name"])
+                       for e in trace["traceEvents"] if e["ph"] == "M")
+        events = [e for e in trace["traceEvents"] if e["ph"] == "i"]
+        self.assertIn("main thread", threads.values())
+
+        # dispatch events of the main thread ring, merged in time order
+        lookups = [e for e in events if e["name"].startswith("ip4-lookup")]
+        self.assertGreater(len(lookups), 0)
+        self.assertEqual(threads[lookups[0]["tid"]], "main thread")
+        times = [e["ts"] for e in events]
+        self.assertEqual(times, sorted(times))
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -847,6 +847,130 @@ class Datapath(MethodHolder):
         ipfix.remove_vpp_config()
         self.logger.info("FFP_TEST_FINISH_0002")
 
+    def test_0003(self):
+        """ no timers, 1 in 3 packets sampled, 3 Flows reported out of 9"""
+        self.logger.info("FFP_TEST_START_0003")
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pkts = []
+
+        ipfix = VppCFLOW(test=self)
+        ipfix.add_vpp_config()
+        self.vapi.cli("flowprobe sampling 3")
+        self.vapi.cli("clear flowprobe statistics")
+
+        ipfix_decoder = IPFIXDecoder()
+        # template packet should arrive immediately
+        templates = ipfix.verify_templates(ipfix_decoder)
+
+        self.create_stream(packets=9)
+        capture = self.send_packets()
+
+        # the first of every 3 packets is accounted 3 times
+        self.vapi.cli("ipfix flush")
+        cflow = self.wait_for_cflow_packet(self.collector, templates[1])
+        data = ipfix_decoder.decode_data_set(cflow.getlayer(Set))
+        self.assertEqual(len(data), 3)
+        for rec, p in zip(data, capture[::3]):
+            self.assertEqual(3 * p[IP].len,
+                             int(binascii.hexlify(rec[1]), 16))
+            self.assertEqual(3, int(binascii.hexlify(rec[2]), 16))
+
+        stats = self.vapi.cli("show flowprobe statistics")
+        self.assertIn("9 packets, 3 sampled", stats)
+
+        self.vapi.cli("flowprobe sampling off")
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0003")
+
+    def test_0004(self):
+        """ no timers, exporter rate limit, 3 Flows reported out of 9"""
+        self.logger.info("FFP_TEST_START_0004")
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pkts = []
+
+        ipfix = VppCFLOW(test=self)
+        ipfix.add_vpp_config()
+        self.vapi.cli("set ipfix exporter collector %s src %s "
+                      "path-mtu 1024 template-interval 100 rate-limit 3" %
+                      (self.pg0.remote_ip4, self.pg0.local_ip4))
+
+        ipfix_decoder = IPFIXDecoder()
+        # template packet should arrive immediately
+        templates = ipfix.verify_templates(ipfix_decoder)
+
+        self.create_stream(packets=9)
+        self.send_packets()
+
+        # the burst allows one second worth of records
+        self.vapi.cli("ipfix flush")
+        cflow = self.wait_for_cflow_packet(self.collector, templates[1])
+        data = ipfix_decoder.decode_data_set(cflow.getlayer(Set))
+        self.assertEqual(len(data), 3)
+        self.assertIn("6 dropped", self.vapi.cli("show ipfix exporter"))
+
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0004")
+
+
+class FlowCache(MethodHolder):
+    """Flows evicted from a full flow cache set"""
+
+    @classmethod
+    def setUpConstants(cls):
+        # a flow cache of a single set of 8 flows
+        cls.extra_vpp_punt_config = [
+            "flowprobe", "{", "log2-cache-size", "3", "}"]
+        super(FlowCache, cls).setUpConstants()
+
+    @classmethod
+    def setUpClass(cls):
+        super(FlowCache, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(FlowCache, cls).tearDownClass()
+
+    def test_0001(self):
+        """ 12 Flows in a set of 8, the 4 least recently used evicted"""
+        self.logger.info("FFP_TEST_START_0001")
+        self.pg_enable_capture(self.pg_interfaces)
+
+        ipfix = VppCFLOW(test=self, active=10)
+        ipfix.add_vpp_config()
+        self.vapi.cli("clear flowprobe statistics")
+        errors = self.statistics.get_counter(
+            "/err/flowprobe-l2/Flows evicted from a full set")
+
+        ipfix_decoder = IPFIXDecoder()
+        # template packet should arrive immediately
+        templates = ipfix.verify_templates(ipfix_decoder)
+
+        # one flow per UDP destination port
+        self.pkts = [(Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac) /
+                      IP(src=self.pg1.remote_ip4, dst=self.pg2.remote_ip4) /
+                      UDP(sport=1234, dport=4321 + i) /
+                      Raw(b'\xa5' * 100)) for i in range(12)]
+        capture = self.send_packets()
+
+        self.assertEqual(self.statistics.get_counter(
+            "/err/flowprobe-l2/Flows evicted from a full set") - errors, 4)
+        self.assertIn("12 packets, 12 sampled, 4 evictions",
+                      self.vapi.cli("show flowprobe statistics"))
+
+        # the evicted flows are exported, the others stay in the cache
+        self.vapi.cli("ipfix flush")
+        cflow = self.wait_for_cflow_packet(self.collector, templates[1])
+        data = ipfix_decoder.decode_data_set(cflow.getlayer(Set))
+        self.assertEqual(len(data), 4)
+        for rec, p in zip(data, capture[:4]):
+            self.assertEqual(p[UDP].dport,
+                             int(binascii.hexlify(rec[11]), 16))
+            self.assertEqual(p[IP].len, int(binascii.hexlify(rec[1]), 16))
+            self.assertEqual(1, int(binascii.hexlify(rec[2]), 16))
+
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0001")
+
 
 @unittest.skipUnless(running_extended_tests, "part of extended tests")
 class DisableIPFIX(MethodHolder):
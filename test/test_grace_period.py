@@ -0,0 +1,33 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestGracePeriod(VppTestCase):
+    """ Grace period deferred reclamation Test Case """
+
+    @classmethod
+    def setUpConstants(cls):
+        super(TestGracePeriod, cls).setUpConstants()
+        # the grace period waits on the workers
+        i = cls.vpp_cmdline.index("main-core")
+        cls.vpp_cmdline[i + 2:i + 2] = ["workers", "1"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestGracePeriod, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestGracePeriod, cls).tearDownClass()
+
+    def test_grace_period(self):
+        """ Callbacks run after the workers are quiescent """
+        reply = self.vapi.cli("test grace-period")
+        self.assertIn("grace period test passed, 1 workers", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
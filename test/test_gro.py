@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+
+import unittest
+
+from scapy.layers.inet import IP, TCP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestGRO(VppTestCase):
+    """ TCP receive side coalescing Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestGRO, cls).setUpClass()
+
+        try:
+            cls.create_pg_interfaces(range(2))
+            for i in cls.pg_interfaces:
+                i.admin_up()
+                i.config_ip4()
+                i.resolve_arp()
+            # super-segments leave through a standard MTU
+            cls.vapi.sw_interface_set_mtu(cls.pg1.sw_if_index,
+                                          [1500, 0, 0, 0])
+        except Exception:
+            super(TestGRO, cls).tearDownClass()
+            raise
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.vapi.sw_interface_set_mtu(cls.pg1.sw_if_index, [9000, 0, 0, 0])
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestGRO, cls).tearDownClass()
+
+    def tearDown(self):
+        self.vapi.cli("set interface gro pg0 disable")
+        super(TestGRO, self).tearDown()
+
+    def create_segments(self, seqs, size=1460, sport=1234):
+        pkts = []
+        for seq in seqs:
+            pkts.append(Ether(dst=self.pg0.local_mac,
+                              src=self.pg0.remote_mac) /
+                        IP(src=self.pg0.remote_ip4,
+                           dst=self.pg1.remote_ip4, flags='DF') /
+                        TCP(sport=sport, dport=80, flags='A',
+                            seq=seq * size) /
+                        Raw(b'\xa5' * size))
+        return pkts
+
+    def verify_segments(self, rx, seqs, size=1460):
+        self.assertEqual(len(rx), len(seqs))
+        for p, seq in zip(rx, seqs):
+            self.assertEqual(p[IP].ttl, 63)
+            self.assertEqual(p[IP].len, 40 + size)
+            self.assertEqual(p[TCP].seq, seq * size)
+            self.assertEqual(len(p[Raw]), size)
+            self.assert_checksum_valid(p, 'IP')
+            self.assert_checksum_valid(p, 'TCP')
+
+    def get_gro_counter(self, name):
+        return self.statistics.get_counter('/err/ip4-gro/%s' % name)
+
+    def test_gro_merge(self):
+        """ GRO merges in-order segments """
+        self.vapi.cli("set interface gro pg0")
+        self.assertIn("ip4-gro", self.vapi.cli("show interface features pg0"))
+
+        merged = self.get_gro_counter("segments merged")
+
+        # super-segments are segmented again on the way out of pg1
+        seqs = range(10)
+        rx = self.send_and_expect(self.pg0, self.create_segments(seqs),
+                                  self.pg1)
+        self.verify_segments(rx, seqs)
+        self.assertEqual(self.get_gro_counter("segments merged"),
+                         merged + 9)
+
+        # a gap in the sequence, and a second flow interleaved, are not
+        # merged into the same super-segment and keep their order
+        merged = self.get_gro_counter("segments merged")
+        seqs = [0, 1, 3, 4]
+        rx = self.send_and_expect(self.pg0, self.create_segments(seqs),
+                                  self.pg1)
+        self.verify_segments(rx, seqs)
+        self.assertEqual(self.get_gro_counter("segments merged"),
+                         merged + 2)
+
+        merged = self.get_gro_counter("segments merged")
+        pkts = self.create_segments(range(4))
+        other = self.create_segments(range(4), sport=4321)
+        pkts = [p for pair in zip(pkts, other) for p in pair]
+        rx = self.send_and_expect(self.pg0, pkts, self.pg1)
+        self.assertEqual(self.get_gro_counter("segments merged"),
+                         merged + 6)
+        for sport in (1234, 4321):
+            self.verify_segments([p for p in rx if p[TCP].sport == sport],
+                                 range(4))
+
+        # other traffic is untouched
+        udp = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+               IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+               UDP(sport=1234, dport=80) /
+               Raw(b'\xa5' * 100))
+        self.send_and_expect(self.pg0, udp * 5, self.pg1)
+
+        # once disabled, nothing is merged
+        self.vapi.cli("set interface gro pg0 disable")
+        merged = self.get_gro_counter("segments merged")
+        seqs = range(10)
+        rx = self.send_and_expect(self.pg0, self.create_segments(seqs),
+                                  self.pg1)
+        self.verify_segments(rx, seqs)
+        self.assertEqual(self.get_gro_counter("segments merged"), merged)
+
+    def test_gro_flush_timeout(self):
+        """ GRO flushes held flows on timeout """
+        self.vapi.cli("set interface gro pg0 flush-timeout 100")
+
+        flushed = self.get_gro_counter("flows flushed on timeout")
+
+        seqs = range(5)
+        rx = self.send_and_expect(self.pg0, self.create_segments(seqs),
+                                  self.pg1)
+        self.verify_segments(rx, seqs)
+        self.assertEqual(self.get_gro_counter("flows flushed on timeout"),
+                         flushed + 1)
+
+    def test_gro_mss_egress_mtu(self):
+        """ GSO packets of MSS-sized segments fit a 1500 MTU egress """
+        self.vapi.cli("set interface gro pg0")
+
+        # 1460 bytes of payload and 40 bytes of headers, with DF set
+        merged = self.get_gro_counter("segments merged")
+        seqs = range(8)
+        rx = self.send_and_expect(self.pg0, self.create_segments(seqs),
+                                  self.pg1)
+        self.verify_segments(rx, seqs)
+        self.assertEqual(self.get_gro_counter("segments merged"),
+                         merged + 7)
+        self.pg0.assert_nothing_captured(remark="no ICMP frag-needed")
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -282,6 +282,10 @@ class TestGtpu(BridgeDomain, VppTestCase):
     def tearDownClass(cls):
         super(TestGtpu, cls).tearDownClass()
 
+    def test_decap_flow_offload(self):
+        """ Decapsulation test with the tunnel rx flow offloaded """
+        self.check_decap_flow_offload("gtpu", "gtpu_tunnel0", "gtpu4-input")
+
     # Method to define VPP actions before tear down of the test case.
     #  Overrides tearDown method in VppTestCase class.
     #  @param self The object pointer.
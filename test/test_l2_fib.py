@@ -528,6 +528,125 @@ class TestL2fib(VppTestCase):
             self.assertLess(len(e), ev_macs * 10)
         self.assertEqual(len(learned_macs ^ macs), 0)
 
+    def learned_macs(self, bd_id):
+        """
+        Number of dynamically learned entries in a bridge domain.
+
+        :param int bd_id: BD's id
+        """
+        return len([e for e in self.vapi.l2_fib_table_dump(bd_id=bd_id)
+                    if not e.static_mac])
+
+    def learned_macs_on(self, bd_id, swif):
+        """
+        Number of dynamically learned entries on an interface.
+
+        :param int bd_id: BD's id
+        :param int swif: sw if index
+        """
+        return len([e for e in self.vapi.l2_fib_table_dump(bd_id=bd_id)
+                    if not e.static_mac and e.sw_if_index == swif])
+
+    def learned_count(self, name, index):
+        """
+        Learned mac count of a bridge domain or an interface, as exported
+        to the stats segment.
+
+        :param str name: 'bd' or 'interface'
+        :param int index: bd index or sw if index
+        """
+        counters = self.statistics.get_counter('/l2/learn/%s' % name)
+        return sum(c[index] for c in counters if index < len(c))
+
+    def wait_for_unlearned(self, learned, swif=None, timeout=5, step=0.1):
+        """
+        Wait for the mac age scanner to remove the macs of a flush, which
+        it does in the background, and to publish the learned mac count
+        of the interface.
+
+        :param learned: function returning the learned macs left
+        :param int swif: sw if index, None to skip the published count
+        """
+        while learned() or (swif is not None and
+                            self.learned_count('interface', swif)):
+            self.assertGreater(timeout, 0, "flushed macs not unlearned")
+            self.sleep(step)
+            timeout -= step
+
+    def learn_limit_errors(self):
+        return self.statistics.get_counter(
+            '/err/l2-learn/L2 not learned due to bd or interface limit')
+
+    def test_l2_fib_bd_learn_limit(self):
+        """ L2 FIB - bridge domain mac learn limit
+        """
+        bd1 = 1
+        hosts = self.create_hosts(3, subnet=41)
+
+        self.flush_all()
+        self.vapi.bridge_domain_set_learn_limit(bd_id=bd1, learn_limit=5)
+        self.addCleanup(self.vapi.bridge_domain_set_learn_limit,
+                        bd_id=bd1, learn_limit=0)
+        errors = self.learn_limit_errors()
+
+        # 9 macs seen, only the first 5 are learned
+        self.learn_hosts(bd1, hosts)
+        self.assertEqual(self.learned_macs(bd1), 5)
+        self.assertEqual(self.learn_limit_errors() - errors, 4)
+        out = self.vapi.cli("show bridge-domain %d detail" % bd1)
+        self.assertIn("Learned MACs: 5", out)
+
+        # learning resumes once the learned macs are flushed
+        self.vapi.l2fib_flush_bd(bd1)
+        self.wait_for_unlearned(lambda: self.learned_macs(bd1))
+        out = self.vapi.cli("show bridge-domain %d detail" % bd1)
+        self.assertIn("Learned MACs: 0", out)
+        hosts = self.create_hosts(3, subnet=42)
+        self.learn_hosts(bd1, hosts)
+        self.assertEqual(self.learned_macs(bd1), 5)
+
+        # no limit
+        self.vapi.l2fib_flush_bd(bd1)
+        self.wait_for_unlearned(lambda: self.learned_macs(bd1))
+        self.vapi.bridge_domain_set_learn_limit(bd_id=bd1, learn_limit=0)
+        self.learn_hosts(bd1, hosts)
+        self.assertEqual(self.learned_macs(bd1), 9)
+        self.flush_all()
+
+    def test_l2_fib_int_learn_limit(self):
+        """ L2 FIB - interface mac learn limit
+        """
+        bd1 = 1
+        hosts = self.create_hosts(4, subnet=43)
+        pg_if = self.pg_interfaces[self.bd_ifs(bd1)[0]]
+        swif = pg_if.sw_if_index
+
+        self.flush_all()
+        self.vapi.sw_interface_set_l2_learn_limit(sw_if_index=swif,
+                                                  learn_limit=2)
+        self.addCleanup(self.vapi.sw_interface_set_l2_learn_limit,
+                        sw_if_index=swif, learn_limit=0)
+        errors = self.learn_limit_errors()
+
+        # the other interfaces of the bd are not limited
+        self.learn_hosts(bd1, hosts)
+        self.assertEqual(self.learned_macs(bd1), 10)
+        self.assertEqual(self.learn_limit_errors() - errors, 2)
+        lfs = self.vapi.l2_fib_table_dump(bd_id=bd1)
+        self.assertEqual(len([e for e in lfs
+                              if e.sw_if_index == swif]), 2)
+
+        # the limit set on the cli, learning resumes after a flush
+        self.vapi.l2fib_flush_int(swif)
+        self.wait_for_unlearned(lambda: self.learned_macs_on(bd1, swif),
+                                swif)
+        self.vapi.cli("set interface l2 learn-limit %s 3" % pg_if.name)
+        self.learn_hosts(bd1, hosts)
+        lfs = self.vapi.l2_fib_table_dump(bd_id=bd1)
+        self.assertEqual(len([e for e in lfs
+                              if e.sw_if_index == swif]), 3)
+        self.flush_all()
+
 
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -223,6 +223,44 @@ class TestLB(VppTestCase):
                 "lb vip 90.0.0.0/8 encap gre4 del")
             self.vapi.cli("test lb flowtable flush")
 
+    def test_lb_sticky_table_resize(self):
+        """ Load Balancer sticky table resize """
+        try:
+            self.vapi.cli("lb conf buckets 16")
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gre4")
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u"
+                    % (asid))
+
+            # 16 buckets hold 64 flows: the first stream overflows the
+            # table, the second one lets the sweep notice and grow it
+            self.packets = range(200)
+            for i in range(2):
+                self.pg0.add_stream(self.generatePackets(self.pg0,
+                                                         isv4=True))
+                self.pg_enable_capture(self.pg_interfaces)
+                self.pg_start()
+                self.checkCapture(encap='gre4', isv4=True)
+
+            resizes = self.statistics.get_counter("/lb/sticky/resizes")
+            collisions = self.statistics.get_counter("/lb/sticky/collisions")
+            self.assertGreater(sum(t[0] for t in collisions), 0)
+            self.assertGreater(sum(t[0] for t in resizes), 0)
+            self.logger.info(self.vapi.cli("show lb"))
+
+        finally:
+            self.packets = range(1)
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u del"
+                    % (asid))
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+            self.vapi.cli("lb conf buckets 1024")
+
     def test_lb_ip6_gre4(self):
         """ Load Balancer IP6 GRE4 on vip case """
 
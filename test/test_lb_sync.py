@@ -0,0 +1,202 @@
+import socket
+import unittest
+
+from scapy.layers.inet import IP, UDP
+from scapy.layers.l2 import Ether
+from scapy.packet import Raw
+import six
+
+from framework import VppTestCase, VppTestRunner
+from remote_test import RemoteClass, RemoteVppTestCase
+from vpp_memif import MEMIF_MODE, MEMIF_ROLE, remove_all_memif_vpp_config, \
+    VppSocketFilename, VppMemif
+
+""" TestLBSync is a subclass of VPPTestCase classes.
+
+ TestLBSync checks that the sticky table entries created by a load balancer
+ are exported to a peer load balancer, running in a second VPP instance
+ connected through memif, which imports them in its own sticky table and
+ forwards the flows to the same ASs once the first load balancer fails.
+
+"""
+
+
+class TestLBSync(VppTestCase):
+    """ Load Balancer flow state synchronization Test Case """
+
+    sync_port = 12345
+
+    @classmethod
+    def setUpClass(cls):
+        # fork new process before client connects to VPP
+        cls.remote_test = RemoteClass(RemoteVppTestCase)
+        cls.remote_test.start_remote()
+        cls.remote_test.set_request_timeout(10)
+        super(TestLBSync, cls).setUpClass()
+        cls.remote_test.setUpClass(cls.tempdir)
+
+        cls.ass = range(5)
+        # ASs only the peer has, changing its new flows table
+        cls.extra_ass = range(5, 10)
+        try:
+            cls.create_pg_interfaces(range(2))
+            for i in cls.pg_interfaces:
+                i.admin_up()
+                i.config_ip4()
+                i.resolve_arp()
+            dst4 = socket.inet_pton(socket.AF_INET, "10.0.0.0")
+            cls.vapi.ip_add_del_route(dst_address=dst4, dst_address_length=24,
+                                      next_hop_address=cls.pg1.remote_ip4n)
+            cls.vapi.lb_conf(ip4_src_address="39.40.41.42",
+                             ip6_src_address="2004::1")
+        except Exception:
+            super(TestLBSync, cls).tearDownClass()
+            raise
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.remote_test.tearDownClass()
+        cls.remote_test.quit_remote()
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestLBSync, cls).tearDownClass()
+
+    def tearDown(self):
+        remove_all_memif_vpp_config(self)
+        remove_all_memif_vpp_config(self.remote_test)
+        super(TestLBSync, self).tearDown()
+
+    def configure_lb(self, test):
+        test.vapi.cli("lb vip 90.0.0.0/8 encap gre4")
+        for asid in self.ass:
+            test.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % asid)
+
+    def unconfigure_lb(self, test):
+        for asid in self.ass:
+            test.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % asid)
+        test.vapi.cli("lb vip 90.0.0.0/8 encap gre4 del")
+        test.vapi.cli("test lb flowtable flush")
+
+    def create_flows(self, n):
+        pkts = []
+        for i in range(n):
+            pkts.append(Ether(dst=self.pg0.local_mac,
+                              src=self.pg0.remote_mac) /
+                        IP(dst="90.0.0.%u" % (i + 1),
+                           src="40.0.0.%u" % (i + 1)) /
+                        UDP(sport=10000 + i, dport=20000) /
+                        Raw(b'\xa5' * 100))
+        return pkts
+
+    def get_flow_ass(self, capture):
+        """ AS each flow was sent to, by flow source port """
+        return dict((p[UDP].sport, p[IP].dst) for p in capture)
+
+    def get_sync_counter(self, test, name):
+        for line in test.vapi.cli("show lb sync").splitlines():
+            if line.startswith(name + ":"):
+                return int(line.split(":")[1])
+        return 0
+
+    def test_lb_sync(self):
+        """ Load Balancer sticky entries export over memif """
+        memif = VppMemif(self, MEMIF_ROLE.SLAVE, MEMIF_MODE.ETHERNET)
+
+        remote_socket = VppSocketFilename(self.remote_test, 1,
+                                          b"%s/memif.sock" % six.ensure_binary(
+                                              self.tempdir, encoding='utf-8'))
+        remote_socket.add_vpp_config()
+
+        remote_memif = VppMemif(self.remote_test, MEMIF_ROLE.MASTER,
+                                MEMIF_MODE.ETHERNET, socket_id=1)
+
+        memif.add_vpp_config()
+        memif.config_ip4()
+        memif.admin_up()
+
+        remote_memif.add_vpp_config()
+        remote_memif.config_ip4()
+        remote_memif.admin_up()
+
+        self.assertTrue(memif.wait_for_link_up(5))
+        self.assertTrue(remote_memif.wait_for_link_up(5))
+
+        self.configure_lb(self)
+        self.configure_lb(self.remote_test)
+        lb_configured = True
+        try:
+            self.vapi.cli("lb sync listener %s port %u" %
+                          (memif.ip4_addr, self.sync_port))
+            self.vapi.cli("lb sync peer %s port %u" %
+                          (remote_memif.ip4_addr, self.sync_port))
+            self.remote_test.vapi.cli("lb sync listener %s port %u" %
+                                      (remote_memif.ip4_addr,
+                                       self.sync_port))
+            self.remote_test.vapi.cli("lb sync peer %s port %u" %
+                                      (memif.ip4_addr, self.sync_port))
+
+            n_flows = 20
+            self.pg0.add_stream(self.create_flows(n_flows))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            flow_ass = self.get_flow_ass(self.pg1.get_capture(n_flows))
+
+            # batches are flushed at least once per second
+            for i in range(5):
+                imported = self.get_sync_counter(self.remote_test,
+                                                 "imported")
+                if imported == n_flows:
+                    break
+                self.sleep(1, "waiting for sync batches")
+
+            self.logger.info(self.vapi.cli("show lb sync"))
+            self.logger.info(self.remote_test.vapi.cli("show lb sync"))
+            self.assertEqual(self.get_sync_counter(self, "add-event-send"),
+                             n_flows)
+            self.assertEqual(imported, n_flows)
+            self.assertEqual(self.get_sync_counter(self.remote_test,
+                                                   "unknown-vip-or-as"), 0)
+
+            # the first load balancer fails: the VIP is routed to the peer,
+            # whose new flows table changed, and which sends the flows back
+            # over memif on their way to the ASs. Synced flows must keep
+            # going to the same AS.
+            for asid in self.extra_ass:
+                self.remote_test.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" %
+                                          asid)
+            self.remote_test.vapi.cli("lb conf ip4-src-address 39.40.41.43")
+            self.remote_test.vapi.cli("ip route add 10.0.0.0/24 via %s" %
+                                      memif.ip4_addr)
+            self.unconfigure_lb(self)
+            lb_configured = False
+            self.vapi.cli("ip route add 90.0.0.0/8 via %s" %
+                          remote_memif.ip4_addr)
+
+            self.pg0.add_stream(self.create_flows(n_flows))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            capture = self.pg1.get_capture(n_flows)
+            self.assertEqual(self.get_flow_ass(capture), flow_ass)
+        finally:
+            self.vapi.cli("ip route del 90.0.0.0/8 via %s" %
+                          remote_memif.ip4_addr)
+            self.remote_test.vapi.cli("ip route del 10.0.0.0/24 via %s" %
+                                      memif.ip4_addr)
+            for asid in self.extra_ass:
+                self.remote_test.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del"
+                                          % asid)
+            self.vapi.cli("lb sync peer %s port %u del" %
+                          (remote_memif.ip4_addr, self.sync_port))
+            self.vapi.cli("lb sync listener %s del" % memif.ip4_addr)
+            self.remote_test.vapi.cli("lb sync peer %s port %u del" %
+                                      (memif.ip4_addr, self.sync_port))
+            self.remote_test.vapi.cli("lb sync listener %s del" %
+                                      remote_memif.ip4_addr)
+            if lb_configured:
+                self.unconfigure_lb(self)
+            self.unconfigure_lb(self.remote_test)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
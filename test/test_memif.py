@@ -246,6 +246,9 @@ class TestMemif(VppTestCase):
         self.assertTrue(memif.wait_for_link_up(5))
         self.assertTrue(remote_memif.wait_for_link_up(5))
 
+        self._ping_remote_memif(memif, remote_memif, 10)
+
+    def _ping_remote_memif(self, memif, remote_memif, packet_num, rounds=1):
         # add routing to remote vpp
         dst_addr = socket.inet_pton(socket.AF_INET, self.pg0._local_ip4_subnet)
         dst_addr_len = 24
@@ -255,17 +258,55 @@ class TestMemif(VppTestCase):
                                                next_hop_address=next_hop_addr)
 
         # create ICMP echo-request from local pg to remote memif
-        packet_num = 10
-        pkts = self._create_icmp(self.pg0, remote_memif, packet_num)
-
-        self.pg0.add_stream(pkts)
-        self.pg_enable_capture(self.pg_interfaces)
-        self.pg_start()
-        capture = self.pg0.get_capture(packet_num, timeout=2)
-        seq = 0
-        for c in capture:
-            self._verify_icmp(self.pg0, remote_memif, c, seq)
-            seq += 1
+        for i in range(rounds):
+            pkts = self._create_icmp(self.pg0, remote_memif, packet_num)
+
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            capture = self.pg0.get_capture(packet_num, timeout=2)
+            seq = 0
+            for c in capture:
+                self._verify_icmp(self.pg0, remote_memif, c, seq)
+                seq += 1
+
+        self.remote_test.vapi.ip_add_del_route(dst_address=dst_addr,
+                                               dst_address_length=dst_addr_len,
+                                               next_hop_address=next_hop_addr,
+                                               is_add=0)
+
+    def test_memif_ping_master_zero_copy(self):
+        """ Memif ping, zero-copy master """
+        memif = VppMemif(self, MEMIF_ROLE.SLAVE,  MEMIF_MODE.ETHERNET)
+
+        remote_socket = VppSocketFilename(self.remote_test, 1,
+                                          b"%s/memif.sock" % six.ensure_binary(
+                                              self.tempdir, encoding='utf-8'))
+        remote_socket.add_vpp_config()
+
+        # a zero-copy master posts its own buffers on the slave rings, the
+        # API always creates masters in copy mode
+        remote_memif = VppMemif(self.remote_test, MEMIF_ROLE.MASTER,
+                                MEMIF_MODE.ETHERNET, socket_id=1)
+        self.remote_test.vapi.cli("create interface memif id 0 socket-id 1 "
+                                  "master zero-copy")
+        dump = self.remote_test.vapi.memif_dump()
+        self.assertEqual(len(dump), 1)
+        remote_memif.sw_if_index = dump[0].sw_if_index
+
+        memif.add_vpp_config()
+        memif.config_ip4()
+        memif.admin_up()
+
+        remote_memif.config_ip4()
+        remote_memif.admin_up()
+
+        self.assertTrue(memif.wait_for_link_up(5))
+        self.assertTrue(remote_memif.wait_for_link_up(5))
+        self.assertIn("zero-copy", self.remote_test.vapi.cli("show memif"))
+
+        # enough packets to recycle the buffers of both rings
+        self._ping_remote_memif(memif, remote_memif, 200, rounds=8)
 
 
 if __name__ == '__main__':
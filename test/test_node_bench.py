@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+
+import json
+import unittest
+
+from scapy.utils import wrpcap
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestNodeBench(TemplateIp4Udp):
+    """ Graph node microbenchmark Test Case """
+
+    def add_bench_stream(self, name, dst_ips):
+        pkts = [self.create_packet(dst_ip=dst) for dst in dst_ips]
+        path = "%s/%s.pcap" % (self.tempdir, name)
+        wrpcap(path, pkts)
+        self.vapi.cli("packet-generator new pcap %s source pg0 name %s "
+                      "prebuilt %d" % (path, name, len(pkts)))
+
+    def bench(self, params):
+        reply = self.vapi.cli("packet-generator benchmark %s json" % params)
+        self.logger.info(reply)
+        return json.loads(reply)
+
+    def test_node_bench(self):
+        """ ip4-lookup over a mix of destinations """
+        # one packet out of four has no route
+        self.add_bench_stream("bench", [self.pg1.remote_ip4] * 3 +
+                              ["203.0.113.1"])
+
+        r = self.bench("bench node ip4-lookup advance 14 "
+                       "frames 10 warmup 2 vector-size 64")
+        self.assertEqual(r["node"], "ip4-lookup")
+        self.assertEqual(r["calls"], 10)
+        self.assertEqual(r["packets"], 640)
+        self.assertEqual(r["vectors_per_call"], 64)
+        self.assertGreater(r["clocks_per_packet"], 0)
+        self.assertEqual(r["next_nodes"]["ip4-rewrite"], 480)
+        self.assertEqual(r["next_nodes"]["ip4-drop"], 160)
+
+    def test_node_bench_errors(self):
+        """ Benchmark of a stream which is not prebuilt """
+        self.vapi.cli("packet-generator new {\n"
+                      "  name not-prebuilt\n"
+                      "  limit 1\n"
+                      "  node ip4-input\n"
+                      "  size 64-64\n"
+                      "  data { UDP: 1.2.3.4 -> 5.6.7.8 }\n"
+                      "}")
+        reply = self.vapi.cli("packet-generator benchmark not-prebuilt "
+                              "node ip4-lookup")
+        self.assertIn("is not prebuilt", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestNodeHistogram(TemplateIp4Udp):
+    """ Node dispatch time histograms Test Case """
+
+    def histogram_total(self, name):
+        return sum(sum(t) for t in self.statistics.get_counter(name))
+
+    def test_node_histogram(self):
+        """ Dispatch and main loop histograms in the stats segment """
+        self.vapi.cli("set node histogram on")
+        self.send_and_expect(self.pg0, self.create_stream(10), self.pg1)
+
+        reply = self.vapi.cli("show node histogram ip4-lookup")
+        self.assertIn("Dispatch time, ip4-lookup", reply)
+        self.assertIn("clocks", reply)
+        self.assertGreater(self.histogram_total("/sys/node/dispatch-time"),
+                           0)
+        self.assertGreater(self.histogram_total("/sys/main-loop/time"), 0)
+
+        # nothing is counted once stopped
+        self.vapi.cli("set node histogram off")
+        total = self.histogram_total("/sys/node/dispatch-time")
+        self.send_and_expect(self.pg0, self.create_stream(10), self.pg1)
+        self.assertEqual(self.histogram_total("/sys/node/dispatch-time"),
+                         total)
+        self.assertIn("not being collected",
+                      self.vapi.cli("show node histogram"))
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,36 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+N_BUCKETS = 32
+
+
+class TestPacketLatency(TemplateIp4Udp):
+    """ Packet latency measurement Test Case """
+
+    def latency_total(self, sw_if_index):
+        start = sw_if_index * N_BUCKETS
+        return sum(sum(t[start:start + N_BUCKETS])
+                   for t in self.statistics.get_counter("/if/tx-latency"))
+
+    def test_packet_latency(self):
+        """ Latency from pg-input to interface-output """
+        self.vapi.cli("set packet latency on")
+        self.send_and_expect(self.pg0, self.create_stream(10), self.pg1)
+
+        # only the received packets are stamped
+        self.assertEqual(self.latency_total(self.pg1.sw_if_index), 10)
+        self.assertEqual(self.latency_total(self.pg0.sw_if_index), 0)
+        self.assertIn("Latency to pg1",
+                      self.vapi.cli("show packet latency pg1"))
+
+        self.vapi.cli("set packet latency off")
+        self.send_and_expect(self.pg0, self.create_stream(10), self.pg1)
+        self.assertEqual(self.latency_total(self.pg1.sw_if_index), 10)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+
+import binascii
+import os
+import socket
+import unittest
+
+from scapy.layers.inet import IP, UDP
+from scapy.utils import rdpcap
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestPcap(TemplateIp4Udp):
+    """ pcap rx / tx capture Test Case """
+
+    def pcap_file(self, name):
+        path = "/tmp/%s" % name
+        if os.path.isfile(path):
+            os.remove(path)
+        return path
+
+    def test_pcap_rx(self):
+        """ pcap rx capture """
+        path = self.pcap_file("test_pcap_rx.pcap")
+        self.vapi.cli("pcap rx trace on max 100 intfc pg0 "
+                      "file test_pcap_rx.pcap")
+        pkts = self.create_stream(10)
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+        self.assertIn("10 pkts captured, 0 dropped",
+                      self.vapi.cli("pcap rx trace status"))
+        self.vapi.cli("pcap rx trace off")
+
+        rx = rdpcap(path)
+        self.assertEqual(len(rx), 10)
+        for p, c in zip(pkts, rx):
+            self.assertEqual(p[UDP].dport, c[UDP].dport)
+
+    def test_pcap_tx_filter(self):
+        """ pcap tx capture with a classify filter """
+        # match the ip4 source address, the filter sees the whole frame
+        mask = '00' * 26 + 'ffffffff' + '00' * 2
+        match = ('00' * 26 +
+                 binascii.hexlify(socket.inet_aton("10.0.0.1")).decode() +
+                 '00' * 2)
+        r = self.vapi.classify_add_del_table(
+            is_add=1, mask=binascii.unhexlify(mask), match_n_vectors=2)
+        self.vapi.classify_add_del_session(
+            1, r.new_table_index, binascii.unhexlify(match))
+
+        path = self.pcap_file("test_pcap_tx.pcap")
+        self.vapi.cli("pcap tx trace on max 100 intfc pg1 "
+                      "filter classify-table %d file test_pcap_tx.pcap" %
+                      r.new_table_index)
+        self.send_and_expect(self.pg0,
+                             self.create_stream(5),
+                             self.pg1)
+        self.send_and_expect(self.pg0,
+                             self.create_stream(3, src_ip="10.0.0.1"),
+                             self.pg1)
+        self.vapi.cli("pcap tx trace off")
+        self.vapi.cli("pcap tx trace filter none")
+
+        rx = rdpcap(path)
+        self.assertEqual(len(rx), 3)
+        for p in rx:
+            self.assertEqual(p[IP].src, "10.0.0.1")
+
+    def test_pcap_filter_table_delete(self):
+        """ pcap capture stops when its filter table is deleted """
+        mask = binascii.unhexlify('00' * 26 + 'ffffffff' + '00' * 2)
+        r = self.vapi.classify_add_del_table(
+            is_add=1, mask=mask, match_n_vectors=2)
+
+        self.pcap_file("test_pcap_del.pcap")
+        self.vapi.cli("pcap rx trace on max 100 intfc pg0 "
+                      "filter classify-table %d file test_pcap_del.pcap" %
+                      r.new_table_index)
+        self.vapi.classify_add_del_table(
+            is_add=0, mask=mask, match_n_vectors=2,
+            table_index=r.new_table_index)
+
+        status = self.vapi.cli("pcap rx trace status")
+        self.assertIn("pcap rx capture is off", status)
+        self.assertNotIn("filtered by classify table", status)
+        self.send_and_expect(self.pg0, self.create_stream(5), self.pg1)
+
+    def test_pcap_ring_size(self):
+        """ pcap capture ring size range """
+        for size in ("1k", "2g"):
+            reply = self.vapi.cli("pcap rx trace ring-size %s" % size)
+            self.assertIn("ring-size must be in", reply)
+        self.assertIn("capture is off",
+                      self.vapi.cli("pcap rx trace status"))
+
+    def test_pcap_rotate(self):
+        """ pcap rx capture with file rotation """
+        path = self.pcap_file("test_pcap_rotate.pcap")
+        for i in range(1, 3):
+            self.pcap_file("test_pcap_rotate.pcap.%d" % i)
+
+        self.vapi.cli("pcap rx trace on max 4 rotate 3 intfc pg0 "
+                      "file test_pcap_rotate.pcap")
+        # two full files, then a partial one
+        for count in (4, 4, 2):
+            self.send_and_expect(self.pg0,
+                                 self.create_stream(count),
+                                 self.pg1)
+            # let the writer process rotate the file
+            self.sleep(0.1)
+        self.vapi.cli("pcap rx trace off")
+
+        self.assertEqual(len(rdpcap(path)), 2)
+        self.assertEqual(len(rdpcap(path + ".1")), 4)
+        self.assertEqual(len(rdpcap(path + ".2")), 4)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
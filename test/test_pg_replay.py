@@ -0,0 +1,60 @@
+#!/usr/bin/env python
+
+import time
+import unittest
+
+from scapy.layers.inet import IP, UDP
+from scapy.packet import Raw
+from scapy.utils import wrpcap
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestPgReplay(TemplateIp4Udp):
+    """ Packet generator prebuilt replay Test Case """
+
+    def add_replay_stream(self, name, pkts, params):
+        path = "%s/%s.pcap" % (self.tempdir, name)
+        wrpcap(path, pkts)
+        self.register_capture(name)
+        self.vapi.cli("packet-generator new pcap %s source pg0 name %s %s" %
+                      (path, name, params))
+
+    def test_replay(self):
+        """ Prebuilt ring replayed over and over """
+        # the large packets share their payload with the ring
+        pkts = [self.create_packet(dport=1234 + i, size=size)
+                for i, size in enumerate([100, 1000, 1400])]
+        self.add_replay_stream("replay", pkts, "prebuilt 3 limit 9")
+        self.assertIn("prebuilt 3",
+                      self.vapi.cli("show packet-generator"))
+
+        self.pg1.enable_capture()
+        self.pg_start()
+        rx = self.pg1.get_capture(9)
+
+        for i, p in enumerate(rx):
+            sent = pkts[i % len(pkts)]
+            self.assertEqual(p[UDP].dport, sent[UDP].dport)
+            self.assertEqual(p[Raw].load, sent[Raw].load)
+            self.assertEqual(p[IP].ttl, sent[IP].ttl - 1)
+
+    def test_replay_rate(self):
+        """ Prebuilt ring replayed at a bit rate """
+        pkts = self.create_stream(4)
+        # 4 packets of 142 bytes in about 1s
+        self.add_replay_stream("replay_rate", pkts,
+                               "prebuilt 4 limit 4 rate 4544 bps")
+        self.assertIn("bps", self.vapi.cli("show packet-generator"))
+
+        self.pg1.enable_capture()
+        start = time.time()
+        self.pg_start()
+        self.pg1.get_capture(4, timeout=5)
+        # the first packet is sent after a quarter of a second
+        self.assertGreater(time.time() - start, 0.5)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
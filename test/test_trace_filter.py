@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+
+import binascii
+import socket
+import unittest
+
+from framework import VppTestRunner
+from template_ip4_udp import TemplateIp4Udp
+
+
+class TestTraceFilter(TemplateIp4Udp):
+    """ Packet trace classify filter Test Case """
+
+    def test_trace_filter(self):
+        """ Only packets matching the classify filter are traced """
+        # match the ip4 source address, from the ethernet header
+        mask = '00' * 26 + 'ffffffff' + '00' * 2
+        match = ('00' * 26 +
+                 binascii.hexlify(socket.inet_aton("10.0.0.1")).decode() +
+                 '00' * 2)
+        r = self.vapi.classify_add_del_table(
+            is_add=1, mask=binascii.unhexlify(mask), match_n_vectors=2)
+        self.vapi.classify_add_del_session(
+            1, r.new_table_index, binascii.unhexlify(match))
+
+        self.vapi.cli("clear trace")
+        self.vapi.cli("trace add pg-input 100 filter classify-table %d" %
+                      r.new_table_index)
+
+        # the filter stays in place across further trace adds
+        self.send_and_expect(self.pg0,
+                             self.create_stream(5),
+                             self.pg1)
+        self.send_and_expect(self.pg0,
+                             self.create_stream(3, src_ip="10.0.0.1"),
+                             self.pg1)
+
+        trace = self.vapi.cli("show trace")
+        self.assertEqual(trace.count("Packet "), 3)
+        self.assertNotIn(self.pg0.remote_ip4 + " -> ", trace)
+        self.assertIn("10.0.0.1 -> ", trace)
+
+        # clearing the trace removes the filter
+        self.vapi.cli("clear trace")
+        self.send_and_expect(self.pg0,
+                             self.create_stream(5),
+                             self.pg1)
+        trace = self.vapi.cli("show trace")
+        self.assertEqual(trace.count("Packet "), 5)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
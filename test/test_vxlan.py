@@ -250,6 +250,10 @@ class TestVxlan(BridgeDomain, VppTestCase):
         # TODO: Scapy bug?
         # self.assert_eq_pkts(payload, frame)
 
+    def test_decap_flow_offload(self):
+        """ Decapsulation test with the tunnel rx flow offloaded """
+        self.check_decap_flow_offload("vxlan", "vxlan_tunnel0", "vxlan4-input")
+
     # Method to define VPP actions before tear down of the test case.
     #  Overrides tearDown method in VppTestCase class.
     #  @param self The object pointer.